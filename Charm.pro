@@ -15,6 +15,19 @@ DEFINES += 'CHARM_VERSION=\'\"0.1a\"\''
 DEFINES += 'CHARM_IDLE_TIME=0'
 DEFINES += QT_NO_DBUS QT_NO_PRINTER
 
+# as in the CMake build, the SQLite backup API is used if the library is found:
+packagesExist(sqlite3) {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += sqlite3
+    DEFINES += CHARM_SQLITE_BACKUP
+}
+
+# compressed exports need zlib, which is part of the Android NDK:
+android|packagesExist(zlib) {
+    DEFINES += CHARM_ZLIB
+    LIBS += -lz
+}
+
 SOURCES += $$files(Core/*.cpp)
 SOURCES += \
     Charm/ApplicationCore.cpp \
@@ -38,14 +51,22 @@ SOURCES += \
     Charm/Commands/CommandMakeEvent.cpp \
     Charm/Commands/CommandExportToXml.cpp \
     Charm/Commands/CommandImportFromXml.cpp \
+    Charm/Commands/CommandExportToBinary.cpp \
+    Charm/Commands/CommandImportFromBinary.cpp \
     Charm/Commands/CommandMakeAndActivateEvent.cpp \
     Charm/HttpClient/HttpJob.cpp \
     Charm/HttpClient/GetProjectCodesJob.cpp \
     Charm/HttpClient/UploadTimesheetJob.cpp \
     Charm/Idle/IdleDetector.cpp \
     Charm/Reports/MonthlyTimesheetXmlWriter.cpp \
+    Charm/Reports/ReportCache.cpp \
+    Charm/Reports/ReportGenerator.cpp \
+    Charm/Reports/ReportHtmlWriter.cpp \
+    Charm/Reports/ReportPages.cpp \
+    Charm/Reports/TimeAggregator.cpp \
     Charm/Reports/TimesheetInfo.cpp \
     Charm/Reports/WeeklyTimesheetXmlWriter.cpp \
+    Charm/Reports/YearlyTimesheetXmlWriter.cpp \
     Charm/Widgets/ActivityReport.cpp \
     Charm/Widgets/BillDialog.cpp \
     Charm/Widgets/CharmPreferences.cpp \
@@ -76,6 +97,8 @@ SOURCES += \
     Charm/Widgets/TrayIcon.cpp \
     Charm/Widgets/Timesheet.cpp \
     Charm/Widgets/WeeklyTimesheet.cpp \
+    Charm/Widgets/YearlyTimesheet.cpp \
+    Charm/Widgets/YearlyTimesheetConfigurationDialog.cpp \
 
 SOURCES += \
     Charm/Keychain/keychain.cpp \
@@ -96,8 +119,14 @@ HEADERS += \
     Charm/UndoCharmCommandWrapper.h \
     Charm/ViewFilter.h \
     Charm/Reports/MonthlyTimesheetXmlWriter.h \
+    Charm/Reports/ReportCache.h \
+    Charm/Reports/ReportGenerator.h \
+    Charm/Reports/ReportHtmlWriter.h \
+    Charm/Reports/ReportPages.h \
+    Charm/Reports/TimeAggregator.h \
     Charm/Reports/TimesheetInfo.h \
     Charm/Reports/WeeklyTimesheetXmlWriter.h \
+    Charm/Reports/YearlyTimesheetXmlWriter.h \
     Charm/Widgets/TasksViewDelegate.h \
     Charm/Widgets/IdleCorrectionDialog.h \
     Charm/Widgets/Timesheet.h \
@@ -122,6 +151,8 @@ HEADERS += \
     Charm/Widgets/ExpandStatesHelper.h \
     Charm/Widgets/SelectTaskDialog.h \
     Charm/Widgets/MonthlyTimesheet.h \
+    Charm/Widgets/YearlyTimesheet.h \
+    Charm/Widgets/YearlyTimesheetConfigurationDialog.h \
     Charm/Widgets/EventView.h \
     Charm/Widgets/ConfigurationDialog.h \
     Charm/Widgets/HttpJobProgressDialog.h \
@@ -132,6 +163,8 @@ HEADERS += \
     Charm/Commands/CommandModifyTask.h \
     Charm/Commands/CommandAddTask.h \
     Charm/Commands/CommandExportToXml.h \
+    Charm/Commands/CommandExportToBinary.h \
+    Charm/Commands/CommandImportFromBinary.h \
     Charm/Commands/CommandDeleteTask.h \
     Charm/Commands/CommandModifyEvent.h \
     Charm/Commands/CommandMakeAndActivateEvent.h \
@@ -27,8 +27,10 @@
 #include "Data.h"
 #include "ViewHelpers.h"
 
+#include "Core/CharmCommand.h"
 #include "Core/CharmConstants.h"
 #include "Core/CharmExceptions.h"
+#include "Core/SqLiteBackup.h"
 #include "Core/SqLiteStorage.h"
 
 #include "Idle/IdleDetector.h"
@@ -37,7 +39,9 @@
 #include "Widgets/NotificationPopup.h"
 #include "Widgets/TasksView.h"
 
+#include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
 #include <QTimer>
 #include <QAction>
 #include <QSettings>
@@ -71,6 +75,8 @@
 namespace {
 static const QByteArray StartTaskCommand = QByteArrayLiteral("start-task: ");
 static const QByteArray RaiseWindowCommand = QByteArrayLiteral("raise-window");
+// the number of daily database snapshots kept next to the database:
+static const int KeptDatabaseSnapshots = 7;
 }
 
 ApplicationCore *ApplicationCore::m_instance = nullptr;
@@ -91,6 +97,7 @@ ApplicationCore::ApplicationCore(TaskId startupTask, bool hideAtStart, QObject *
     , m_actionActivityReport(this)
     , m_actionWeeklyTimesheetReport(this)
     , m_actionMonthlyTimesheetReport(this)
+    , m_actionYearlyTimesheetReport(this)
     , m_uiElements(
 {
     &m_timeTracker, &m_tasksView, &m_eventView
@@ -157,6 +164,15 @@ ApplicationCore::ApplicationCore(TaskId startupTask, bool hideAtStart, QObject *
     m_instance = this;
     qRegisterMetaType<State>("State");
     qRegisterMetaType<Event>("Event");
+    qRegisterMetaType<EventList>("EventList");
+    qRegisterMetaType<Task>("Task");
+    qRegisterMetaType<TaskList>("TaskList");
+    qRegisterMetaType<CharmCommand *>("CharmCommand*");
+
+    connect(m_dateChangeWatcher, &DateChangeWatcher::dateChanged,
+            this, &ApplicationCore::slotTakeDatabaseSnapshot);
+    connect(m_dateChangeWatcher, &DateChangeWatcher::dateChanged,
+            this, &ApplicationCore::slotArchiveEvents);
 
     // exit process (app will only exit once controller says it is ready)
     connect(&m_controller, &Controller::readyToQuit,
@@ -165,6 +181,11 @@ ApplicationCore::ApplicationCore(TaskId startupTask, bool hideAtStart, QObject *
     connectControllerAndModel(&m_controller, m_model.charmDataModel());
     Charm::connectControllerAndView(&m_controller, &m_timeTracker);
 
+    // the controller executes commands and talks to the database in its own thread,
+    // from here on, its signals and slots are connected through queued connections:
+    m_storageThread.adopt(&m_controller);
+    m_storageThread.start();
+
     // save the configuration (configuration is managed by the application)
     connect(&m_timeTracker, &CharmWindow::saveConfiguration,
             this, &ApplicationCore::slotSaveConfiguration);
@@ -267,6 +288,9 @@ ApplicationCore::ApplicationCore(TaskId startupTask, bool hideAtStart, QObject *
     m_actionMonthlyTimesheetReport.setShortcut(Qt::CTRL + Qt::Key_M);
     connect(&m_actionMonthlyTimesheetReport, &QAction::triggered,
             &m_timeTracker, &TimeTrackingWindow::slotMonthlyTimesheetReport);
+    m_actionYearlyTimesheetReport.setText(tr("Yearly Timesheet..."));
+    connect(&m_actionYearlyTimesheetReport, &QAction::triggered,
+            &m_timeTracker, &TimeTrackingWindow::slotYearlyTimesheetReport);
 
     // set up idle detection
     m_idleDetector = IdleDetector::createIdleDetector(this);
@@ -372,6 +396,7 @@ void ApplicationCore::createWindowMenu(QMenuBar *menuBar)
     menu->addAction(&m_actionActivityReport);
     menu->addAction(&m_actionWeeklyTimesheetReport);
     menu->addAction(&m_actionMonthlyTimesheetReport);
+    menu->addAction(&m_actionYearlyTimesheetReport);
 #ifndef Q_OS_OSX
     menu->addSeparator();
 #endif
@@ -464,7 +489,9 @@ void ApplicationCore::setState(State state)
         switch (m_state) {
         case StartingUp:
             m_model.charmDataModel()->stateChanged(previous, state);
-            m_controller.stateChanged(previous, state);
+            m_storageThread.runBlocking([&]() {
+                m_controller.stateChanged(previous, state);
+            });
             // FIXME unnecessary?
             // m_mainWindow.stateChanged(previous);
             // m_timeTracker.stateChanged( previous );
@@ -475,7 +502,9 @@ void ApplicationCore::setState(State state)
             break;
         case Connecting:
             m_model.charmDataModel()->stateChanged(previous, state);
-            m_controller.stateChanged(previous, state);
+            m_storageThread.runBlocking([&]() {
+                m_controller.stateChanged(previous, state);
+            });
             // FIXME unnecessary?
             // m_mainWindow.stateChanged(previous);
             // m_timeTracker.stateChanged( previous );
@@ -483,7 +512,11 @@ void ApplicationCore::setState(State state)
             break;
         case Connected:
             m_model.charmDataModel()->stateChanged(previous, state);
-            m_controller.stateChanged(previous, state);
+            m_storageThread.runBlocking([&]() {
+                m_controller.stateChanged(previous, state);
+            });
+            // deliver the initial task and event lists before the startup task is activated:
+            QCoreApplication::sendPostedEvents(m_model.charmDataModel(), QEvent::MetaCall);
             // FIXME unnecessary?
             // m_mainWindow.stateChanged(previous);
             // m_timeTracker.stateChanged( previous );
@@ -494,7 +527,9 @@ void ApplicationCore::setState(State state)
             // m_timeTracker.stateChanged( previous );
             // m_mainWindow.stateChanged(previous);
             m_model.charmDataModel()->stateChanged(previous, state);
-            m_controller.stateChanged(previous, state);
+            m_storageThread.runBlocking([&]() {
+                m_controller.stateChanged(previous, state);
+            });
             enterDisconnectingState();
             break;
         case ShuttingDown:
@@ -502,7 +537,9 @@ void ApplicationCore::setState(State state)
             // m_timeTracker.stateChanged( previous );
             // m_mainWindow.stateChanged(previous);
             m_model.charmDataModel()->stateChanged(previous, state);
-            m_controller.stateChanged(previous, state);
+            m_storageThread.runBlocking([&]() {
+                m_controller.stateChanged(previous, state);
+            });
             enterShuttingDownState();
             break;
         default:
@@ -568,7 +605,11 @@ void ApplicationCore::showInformation(const QString &title, const QString &messa
 void ApplicationCore::enterConnectingState()
 {
     try {
-        if (!m_controller.initializeBackEnd(CHARM_SQLITE_BACKEND_DESCRIPTOR))
+        bool initialized = false;
+        m_storageThread.runBlocking([&]() {
+            initialized = m_controller.initializeBackEnd(CHARM_SQLITE_BACKEND_DESCRIPTOR);
+        });
+        if (!initialized)
             QCoreApplication::quit();
     } catch (const CharmException &e) {
         showCritical(tr("Database Backend Error"),
@@ -580,7 +621,11 @@ void ApplicationCore::enterConnectingState()
     CONFIGURATION.failure = false;
     try
     {
-        if (m_controller.connectToBackend()) {
+        bool connected = false;
+        m_storageThread.runBlocking([&]() {
+            connected = m_controller.connectToBackend();
+        });
+        if (connected) {
             // delay switch to Connected state a bit to show the start screen:
             QTimer::singleShot(0, this, SLOT(slotGoToConnectedState()));
         } else {
@@ -623,6 +668,8 @@ void ApplicationCore::enterConnectedState()
 #ifdef CHARM_CI_SUPPORT
     m_cmdInterface->start();
 #endif
+    slotArchiveEvents();
+    slotTakeDatabaseSnapshot();
 }
 
 void ApplicationCore::leaveConnectedState()
@@ -631,7 +678,9 @@ void ApplicationCore::leaveConnectedState()
     m_cmdInterface->stop();
 #endif
 
-    m_controller.persistMetaData(CONFIGURATION);
+    m_storageThread.runBlocking([this]() {
+        m_controller.persistMetaData(CONFIGURATION);
+    });
 }
 
 void ApplicationCore::enterDisconnectingState()
@@ -750,6 +799,85 @@ void ApplicationCore::slotCurrentBackendStatusChanged(const QString &text)
     m_trayIcon.setToolTip(title);
 }
 
+void ApplicationCore::slotTakeDatabaseSnapshot()
+{
+    // a rolling snapshot of the database is taken in the background once a day:
+    const QString databaseFile = CONFIGURATION.localStorageDatabase;
+    const QDateTime now = QDateTime::currentDateTime();
+    const QDateTime lastSnapshot = SqLiteBackup::lastSnapshotTime(databaseFile);
+    if (m_databaseSnapshot || m_state != Connected || !QFileInfo::exists(databaseFile)
+        || (lastSnapshot.isValid() && lastSnapshot.date() == now.date()))
+        return;
+
+    // the archived events are kept in a database of their own:
+    QStringList files = { databaseFile };
+    const QString archiveFile = SqLiteStorage::archiveFileName(databaseFile);
+    if (QFileInfo::exists(archiveFile))
+        files.append(archiveFile);
+    takeDatabaseSnapshots(files, now);
+}
+
+void ApplicationCore::takeDatabaseSnapshots(const QStringList &files, const QDateTime &time)
+{
+    if (files.isEmpty())
+        return;
+    const QString file = files.first();
+    m_databaseSnapshot = new SqLiteBackup(file, SqLiteBackup::snapshotFileName(file, time), this);
+    connect(m_databaseSnapshot, &SqLiteBackup::completed, this, [this, files, time](bool success) {
+        if (success)
+            SqLiteBackup::removeOldSnapshots(files.first(), KeptDatabaseSnapshots);
+        else
+            qWarning() << "Could not take a snapshot of the database:"
+                       << m_databaseSnapshot->errorString();
+        m_databaseSnapshot->deleteLater();
+        m_databaseSnapshot = nullptr;
+        takeDatabaseSnapshots(files.mid(1), time);
+    });
+    m_databaseSnapshot->start();
+}
+
+void ApplicationCore::slotArchiveEvents()
+{
+    // the cutoff advances with the date, archiving moves the events of one day at a time:
+    if (m_state != Connected)
+        return;
+    const int months = CONFIGURATION.archiveEventsAfterMonths;
+    const QDateTime cutoff(QDate::currentDate().addMonths(-months));
+    try {
+        m_storageThread.runBlocking([this, months, cutoff]() {
+            m_archiveCutoff = m_controller.storage()->archiveCutoff();
+            if (months > 0 && (!m_archiveCutoff.isValid() || cutoff > m_archiveCutoff)
+                && m_controller.archiveEvents(cutoff)) {
+                m_archiveCutoff = m_controller.storage()->archiveCutoff();
+            }
+        });
+    } catch (const CharmException &e) {
+        qWarning() << "Could not archive the events:" << e.what();
+    }
+}
+
+std::function<EventList()> ApplicationCore::archivedEventsReader(const QDateTime &start,
+                                                                 const QDateTime &end)
+{
+    // most reports do not reach into the archive, they do not wait for the storage thread:
+    if (m_state != Connected || !m_archiveCutoff.isValid() || start >= m_archiveCutoff)
+        return std::function<EventList()>();
+    return [this, start, end]() {
+        EventList events;
+        if (!m_storageThread.isRunning())
+            return events;
+        try {
+            m_storageThread.runBlocking([this, &events, start, end]() {
+                events = m_controller.storage()->getEventsInRange(start, end,
+                                                                  SqlStorage::ArchivedEvents);
+            });
+        } catch (const CharmException &e) {
+            qWarning() << "Could not read the archived events:" << e.what();
+        }
+        return events;
+    };
+}
+
 void ApplicationCore::slotStopAllTasks()
 {
     DATAMODEL->endAllEventsRequested();
@@ -771,7 +899,10 @@ void ApplicationCore::slotSaveConfiguration()
     settings.beginGroup(CONFIGURATION.configurationName);
     CONFIGURATION.writeTo(settings);
     if (state() == Connected) {
-        m_controller.persistMetaData(CONFIGURATION);
+        m_storageThread.runBlocking([this]() {
+            m_controller.persistMetaData(CONFIGURATION);
+        });
+        slotArchiveEvents();
 #ifdef CHARM_CI_SUPPORT
         m_cmdInterface->configurationChanged();
 #endif
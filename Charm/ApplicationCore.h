@@ -27,6 +27,7 @@
 
 #include <QMenu>
 #include <QAction>
+#include <QDateTime>
 #include <QLocalServer>
 
 // this is an application, not a library:
@@ -37,6 +38,7 @@
 #include "Core/Controller.h"
 #include "Core/Configuration.h"
 #include "Core/SqlStorage.h"
+#include "Core/StorageThread.h"
 
 #include "Widgets/CharmWindow.h"
 #include "Widgets/EventView.h"
@@ -51,6 +53,7 @@
 class CharmCommandInterface;
 class IdleDetector;
 class QSessionManager;
+class SqLiteBackup;
 class QWinJumpList;
 
 class ApplicationCore : public QObject
@@ -97,6 +100,12 @@ public:
 
     void updateTaskList();
 
+    /** A function that reads the archived events that start in [@p start, @p end), which are
+        not in the model, see Configuration::archiveEventsAfterMonths. It waits for the storage
+        thread, reports call it in their worker thread. Empty if no events in the range have
+        been archived. */
+    std::function<EventList()> archivedEventsReader(const QDateTime &start, const QDateTime &end);
+
 public Q_SLOTS:
     void showMainWindow(ShowMode mode = ShowMode::Show);
 
@@ -118,6 +127,8 @@ private Q_SLOTS:
     void slotShowNotification(const QString &title, const QString &message);
     void slotShowTasksEditor();
     void slotShowEventEditor();
+    void slotTakeDatabaseSnapshot();
+    void slotArchiveEvents();
 
 Q_SIGNALS:
     void goToState(State state);
@@ -132,6 +143,7 @@ private:
     void showInformation(const QString &title, const QString &message);
 
     QString titleString(const QString &text) const;
+    void takeDatabaseSnapshots(const QStringList &files, const QDateTime &time);
     void enterStartingUpState();
     void leaveStartingUpState();
     void enterConfiguringState();
@@ -148,6 +160,8 @@ private:
     State m_state = Constructed;
     ModelConnector m_model;
     Controller m_controller;
+    // declared after the controller, it has to be stopped before the controller is destroyed:
+    StorageThread m_storageThread;
     TrayIcon m_trayIcon;
     QMenu m_systrayContextMenu;
     QAction m_actionAboutDialog;
@@ -162,11 +176,15 @@ private:
     QAction m_actionActivityReport;
     QAction m_actionWeeklyTimesheetReport;
     QAction m_actionMonthlyTimesheetReport;
+    QAction m_actionYearlyTimesheetReport;
     QList<QAction *> m_taskActions;
     EventView m_eventView;
     TasksView m_tasksView;
     QVector<UIStateInterface *> m_uiElements;
     IdleDetector *m_idleDetector = nullptr;
+    SqLiteBackup *m_databaseSnapshot = nullptr;
+    // the archive cutoff of the storage, invalid if nothing has been archived:
+    QDateTime m_archiveCutoff;
     CharmCommandInterface *m_cmdInterface = nullptr;
     QLocalServer m_uniqueApplicationServer;
     TaskId m_startupTask;
@@ -0,0 +1,64 @@
+/*
+  CommandExportToBinary.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "CommandExportToBinary.h"
+
+#include "Core/Controller.h"
+
+#include <QSaveFile>
+
+CommandExportToBinary::CommandExportToBinary(const QString &filename, QObject *parent)
+    : CharmCommand(tr("Export to Binary File"), parent)
+    , m_filename(filename)
+{
+}
+
+CommandExportToBinary::~CommandExportToBinary()
+{
+}
+
+bool CommandExportToBinary::prepare()
+{
+    return true;
+}
+
+bool CommandExportToBinary::execute(Controller *controller)
+{
+    QSaveFile file(m_filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        m_errorString = tr("Could not open %1 for writing: %2").arg(m_filename,
+                                                                    file.errorString());
+        return true;
+    }
+    m_errorString = controller->exportDatabaseToBinary(&file);
+    if (m_errorString.isEmpty() && !file.commit())
+        m_errorString = tr("Could not write %1: %2").arg(m_filename, file.errorString());
+    return true;
+}
+
+bool CommandExportToBinary::finalize()
+{
+    if (!m_errorString.isEmpty())
+        showCritical(tr("Error exporting Database"),
+                     tr("The database could not be exported:\n%1").arg(m_errorString));
+    return m_errorString.isEmpty();
+}
@@ -24,12 +24,10 @@
 
 #include "CommandExportToXml.h"
 
-#include "Core/CharmExceptions.h"
 #include "Core/Controller.h"
+#include "Core/GzipDevice.h"
 
-#include <QDomDocument>
-#include <QFile>
-#include <QTextStream>
+#include <QSaveFile>
 
 CommandExportToXml::CommandExportToXml(QString filename, QObject *parent)
     : CharmCommand(tr("Export to XML"), parent)
@@ -48,21 +46,28 @@ bool CommandExportToXml::prepare()
 
 bool CommandExportToXml::execute(Controller *controller)
 {
-    try {
-        QDomDocument document = controller->exportDatabasetoXml();
-        QFile file(m_filename);
-        if (file.open(QIODevice::WriteOnly)) {
-            QTextStream stream(&file);
-            stream << document.toString(4);
-        } else {
-            m_error = true;
-            m_errorString = tr("Could not open %1 for writing: %2").arg(m_filename,
-                                                                        file.errorString());
-        }
-    }  catch (const XmlSerializationException &e) {
+    QSaveFile file(m_filename);
+    if (!file.open(QIODevice::WriteOnly)) {
         m_error = true;
-        m_errorString = e.what();
+        m_errorString = tr("Could not open %1 for writing: %2").arg(m_filename,
+                                                                    file.errorString());
+        return true;
     }
+    // compress the export if the file name asks for it:
+    GzipDevice device(&file, GzipDevice::compressionForFileName(m_filename));
+    if (!device.open(QIODevice::WriteOnly)) {
+        m_error = true;
+        m_errorString = tr("Could not open %1 for writing: %2").arg(m_filename,
+                                                                    device.errorString());
+        return true;
+    }
+    // the export is streamed into the file, which only replaces the target once complete:
+    m_errorString = controller->exportDatabaseToXml(&device);
+    if (m_errorString.isEmpty() && !device.commit())
+        m_errorString = tr("Could not write %1: %2").arg(m_filename, device.errorString());
+    if (m_errorString.isEmpty() && !file.commit())
+        m_errorString = tr("Could not write %1: %2").arg(m_filename, file.errorString());
+    m_error = !m_errorString.isEmpty();
     return true;
 }
 
@@ -0,0 +1,69 @@
+/*
+  CommandImportFromBinary.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "CommandImportFromBinary.h"
+#include "Core/Controller.h"
+#include "Core/GzipDevice.h"
+
+#include <QFile>
+
+CommandImportFromBinary::CommandImportFromBinary(const QString &filename, QObject *parent)
+    : CharmCommand(tr("Import from Binary File"), parent)
+    , m_filename(filename)
+{
+}
+
+CommandImportFromBinary::~CommandImportFromBinary()
+{
+}
+
+bool CommandImportFromBinary::prepare()
+{
+    return true;
+}
+
+bool CommandImportFromBinary::execute(Controller *controller)
+{
+    QFile file(m_filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_error = tr("Cannot open the specified file: %1").arg(file.errorString());
+        return true;
+    }
+    GzipDevice device(&file);
+    if (!device.open(QIODevice::ReadOnly)) {
+        m_error = tr("Cannot open the specified file: %1").arg(device.errorString());
+        return true;
+    }
+    m_error = controller->importDatabaseFromBinary(&device, [this, &file](qint64, qint64) {
+        emit progress(file.pos(), file.size());
+    });
+    return true;
+}
+
+bool CommandImportFromBinary::finalize()
+{
+    emit finished();
+    if (!m_error.isEmpty())
+        showCritical(tr("Error importing the Database"),
+                     tr("An error has occurred:\n%1").arg(m_error));
+    return true;
+}
@@ -0,0 +1,53 @@
+/*
+  CommandImportFromBinary.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef COMMANDIMPORTFROMBINARY_H
+#define COMMANDIMPORTFROMBINARY_H
+
+#include <Core/CharmCommand.h>
+
+class QObject;
+
+/** Imports a binary database export, see Controller::importDatabaseFromBinary(). */
+class CommandImportFromBinary : public CharmCommand
+{
+    Q_OBJECT
+public:
+    explicit CommandImportFromBinary(const QString &filename, QObject *parent);
+    ~CommandImportFromBinary() override;
+
+    bool prepare() override;
+    bool execute(Controller *) override;
+    bool finalize() override;
+
+Q_SIGNALS:
+    /** Emitted from the thread executing the command while the file is being imported. */
+    void progress(qint64 bytesRead, qint64 bytesTotal);
+    /** Emitted by finalize(), when the import has been completed or has failed. */
+    void finished();
+
+private:
+    QString m_error;
+    QString m_filename;
+};
+
+#endif
@@ -24,8 +24,8 @@
 
 #include "CommandImportFromXml.h"
 #include "Core/Controller.h"
+#include "Core/GzipDevice.h"
 
-#include <QDomDocument>
 #include <QFile>
 
 CommandImportFromXml::CommandImportFromXml(QString filename, QObject *parent)
@@ -46,28 +46,26 @@ bool CommandImportFromXml::prepare()
 bool CommandImportFromXml::execute(Controller *controller)
 {
     QFile file(m_filename);
-    if (file.open(QIODevice::ReadOnly)) {
-        QDomDocument document;
-        QString errorMessage;
-        int errorLine = 0;
-        int errorColumn = 0;
-        if (document.setContent(&file, &errorMessage, &errorLine, &errorColumn)) {
-            m_error = controller->importDatabaseFromXml(document);
-        } else {
-            m_error = tr("Cannot read the XML syntax of the specified file: [%1:%2] %3").arg(QString::number(
-                                                                                                 errorLine),
-                                                                                             QString::number(
-                                                                                                 errorColumn),
-                                                                                             errorMessage);
-        }
-    } else {
+    if (!file.open(QIODevice::ReadOnly)) {
         m_error = tr("Cannot open the specified file: %1").arg(file.errorString());
+        return true;
     }
+    // compressed exports are decompressed on the fly:
+    GzipDevice device(&file);
+    if (!device.open(QIODevice::ReadOnly)) {
+        m_error = tr("Cannot open the specified file: %1").arg(device.errorString());
+        return true;
+    }
+    // the progress is measured in the file, since the decompressed size is not known:
+    m_error = controller->importDatabaseFromXml(&device, [this, &file](qint64, qint64) {
+        emit progress(file.pos(), file.size());
+    });
     return true;
 }
 
 bool CommandImportFromXml::finalize()
 {
+    emit finished();
     // any errors?
     if (!m_error.isEmpty())
         showCritical(tr("Error importing the Database"),
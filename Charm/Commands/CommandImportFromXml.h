@@ -39,6 +39,12 @@ public:
     bool execute(Controller *) override;
     bool finalize() override;
 
+Q_SIGNALS:
+    /** Emitted from the thread executing the command while the file is being imported. */
+    void progress(qint64 bytesRead, qint64 bytesTotal);
+    /** Emitted by finalize(), when the import has been completed or has failed. */
+    void finished();
+
 private:
     QString m_error;
     QString m_filename;
@@ -29,8 +29,7 @@
 
 CommandRelayCommand::CommandRelayCommand(QObject *parent)
     : CharmCommand(tr("Relay"), parent)
-{   // as long as Charm is single-threaded, this does not do anything,
-    // because there will be no repaint
+{   // the wait cursor is shown while the storage thread executes the command
     QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
 }
 
@@ -64,6 +63,11 @@ bool CommandRelayCommand::rollback(Controller *controller)
 bool CommandRelayCommand::finalize()
 {
     QApplication::restoreOverrideCursor();
+    if (!failure().isEmpty()) {
+        m_payload->setFailure(failure());
+        showCritical(tr("Error"), tr("%1 failed:\n%2").arg(m_payload->description(),
+                                                             failure()));
+    }
     m_payload->owner()->commitCommand(m_payload);
-    return true;
+    return failure().isEmpty();
 }
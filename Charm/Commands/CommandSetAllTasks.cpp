@@ -48,5 +48,6 @@ bool CommandSetAllTasks::execute(Controller *controller)
 
 bool CommandSetAllTasks::finalize()
 {
+    emit finished(m_success);
     return m_success;
 }
@@ -39,6 +39,9 @@ public:
     bool execute(Controller *) override;
     bool finalize() override;
 
+Q_SIGNALS:
+    void finished(bool success);
+
 private:
     TaskList m_tasks;
     bool m_success = false;
@@ -0,0 +1,64 @@
+/*
+  ReportCache.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportCache.h"
+
+#include <QTextDocument>
+
+ReportCache::ReportCache(int maxReports)
+    : m_reports(maxReports)
+{
+}
+
+void ReportCache::insert(const QString &key, quint64 revision, const Entry &entry)
+{
+    Q_ASSERT_X(!entry.document.isNull(), Q_FUNC_INFO, "Only built reports can be cached");
+    m_reports.insert(key, new CachedReport { revision, entry });
+}
+
+ReportCache::Entry ReportCache::find(const QString &key, quint64 revision)
+{
+    // QCache::object() also marks the report as the most recently used one:
+    const CachedReport *report = m_reports.object(key);
+    if (!report)
+        return Entry();
+    if (report->revision != revision) {
+        m_reports.remove(key);
+        return Entry();
+    }
+    return report->entry;
+}
+
+bool ReportCache::contains(const QString &key, quint64 revision) const
+{
+    const CachedReport *report = m_reports.object(key);
+    return report && report->revision == revision;
+}
+
+void ReportCache::clear()
+{
+    m_reports.clear();
+}
+
+int ReportCache::size() const
+{
+    return m_reports.size();
+}
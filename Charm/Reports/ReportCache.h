@@ -0,0 +1,70 @@
+/*
+  ReportCache.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPORTCACHE_H
+#define REPORTCACHE_H
+
+#include <QCache>
+#include <QSharedPointer>
+#include <QString>
+
+#include <functional>
+
+class QTextDocument;
+
+/** ReportCache keeps the most recently built report documents, so that going back to a
+    report, for example with the Previous and Next links, does not build it again.
+    Reports are identified by a key that describes the report type, time range and filters,
+    and the revision of the data model they were built from. Reports of an older revision
+    are never returned. */
+class ReportCache
+{
+public:
+    struct Entry {
+        QSharedPointer<QTextDocument> document;
+        /** Restores the state of the report window that belongs to the document. */
+        std::function<void()> finished;
+    };
+
+    explicit ReportCache(int maxReports = 8);
+
+    /** Store the report @p entry for @p key, built from the model at @p revision. */
+    void insert(const QString &key, quint64 revision, const Entry &entry);
+
+    /** The report for @p key at @p revision, or an entry without document if there is none.
+        Reports for @p key of other revisions are removed. */
+    Entry find(const QString &key, quint64 revision);
+
+    bool contains(const QString &key, quint64 revision) const;
+
+    void clear();
+    int size() const;
+
+private:
+    struct CachedReport {
+        quint64 revision;
+        Entry entry;
+    };
+
+    QCache<QString, CachedReport> m_reports;
+};
+
+#endif
@@ -0,0 +1,230 @@
+/*
+  ReportGenerator.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportGenerator.h"
+
+#include "Core/CharmDataModel.h"
+
+#include <QCoreApplication>
+#include <QEvent>
+#include <QTextDocument>
+
+namespace {
+class DocumentEvent : public QEvent
+{
+public:
+    DocumentEvent(const QSharedPointer<ReportGenerator::Request> &request,
+                  QTextDocument *document)
+        : QEvent(eventType())
+        , m_request(request)
+        , m_document(document)
+    {
+    }
+
+    ~DocumentEvent() override
+    {
+        // documents of canceled reports are never taken:
+        delete m_document;
+    }
+
+    static QEvent::Type eventType()
+    {
+        static const int type = QEvent::registerEventType();
+        return static_cast<QEvent::Type>(type);
+    }
+
+    const ReportGenerator::Request *request() const
+    {
+        return m_request.data();
+    }
+
+    QTextDocument *takeDocument()
+    {
+        QTextDocument *document = m_document;
+        m_document = nullptr;
+        return document;
+    }
+
+private:
+    QSharedPointer<ReportGenerator::Request> m_request;
+    QTextDocument *m_document;
+};
+
+class BuildEvent : public QEvent
+{
+public:
+    BuildEvent(const QSharedPointer<ReportGenerator::Request> &request,
+               CharmDataModel *snapshot, const TaskList &tasks,
+               const ReportGenerator::EventSource &readEvents,
+               const QString &styleSheet, const ReportGenerator::Builder &build,
+               QObject *receiver)
+        : QEvent(eventType())
+        , m_request(request)
+        , m_snapshot(snapshot)
+        , m_tasks(tasks)
+        , m_readEvents(readEvents)
+        , m_styleSheet(styleSheet)
+        , m_build(build)
+        , m_receiver(receiver)
+    {
+    }
+
+    static QEvent::Type eventType()
+    {
+        static const int type = QEvent::registerEventType();
+        return static_cast<QEvent::Type>(type);
+    }
+
+    void run()
+    {
+        // a newer request may already be queued behind this one:
+        if (m_request->isCanceled())
+            return;
+        // the snapshot is only used by this request, it is completed before it is read:
+        m_snapshot->setAllTasks(m_tasks);
+        if (m_readEvents) {
+            Q_FOREACH (const Event &event, m_readEvents()) {
+                if (!m_snapshot->eventExists(event.id()))
+                    m_snapshot->addEvent(event);
+            }
+            if (m_request->isCanceled())
+                return;
+        }
+        const QString html = m_build(*m_request);
+        if (m_request->isCanceled())
+            return;
+
+        auto document = new QTextDocument;
+        // NOTE: the style sheet has to be set before the html
+        // code is pushed into the QTextDocument
+        document->setDefaultStyleSheet(m_styleSheet);
+        document->setHtml(html);
+        document->moveToThread(m_receiver->thread());
+        QCoreApplication::postEvent(m_receiver, new DocumentEvent(m_request, document));
+    }
+
+private:
+    QSharedPointer<ReportGenerator::Request> m_request;
+    CharmDataModel *m_snapshot;
+    TaskList m_tasks;
+    ReportGenerator::EventSource m_readEvents;
+    QString m_styleSheet;
+    ReportGenerator::Builder m_build;
+    QObject *m_receiver;
+};
+}
+
+class ReportGenerator::Executor : public QObject
+{
+public:
+    bool event(QEvent *event) override
+    {
+        if (event->type() == BuildEvent::eventType()) {
+            static_cast<BuildEvent *>(event)->run();
+            return true;
+        }
+        return QObject::event(event);
+    }
+};
+
+ReportGenerator::Request::Request(const QSharedPointer<const CharmDataModel> &model)
+    : m_model(model)
+{
+}
+
+const CharmDataModel *ReportGenerator::Request::model() const
+{
+    return m_model.data();
+}
+
+bool ReportGenerator::Request::isCanceled() const
+{
+    return m_canceled.loadAcquire() != 0;
+}
+
+ReportGenerator::ReportGenerator(QObject *parent)
+    : QObject(parent)
+    , m_executor(new Executor)
+{
+    m_thread.setObjectName(QStringLiteral("ReportGenerator"));
+    m_executor->moveToThread(&m_thread);
+    m_thread.start(QThread::LowPriority);
+}
+
+ReportGenerator::~ReportGenerator()
+{
+    cancel();
+    m_thread.quit();
+    m_thread.wait();
+    // documents posted after the last request was canceled are deleted with their events:
+    delete m_executor;
+}
+
+void ReportGenerator::start(const CharmDataModel *model, const QString &styleSheet,
+                            const Builder &build, const Receiver &receive,
+                            const EventSource &readEvents)
+{
+    Q_ASSERT_X(model, Q_FUNC_INFO, "a report needs a data model");
+    cancel();
+
+    // the events are shared with the model, they are copied only if the model changes them
+    // while the report is built. The task tree is built by the worker. The worker may release
+    // the snapshot last, it is deleted in the thread it lives in:
+    CharmDataModel *snapshotModel = model->cloneEvents();
+    const QSharedPointer<const CharmDataModel> snapshot(
+        snapshotModel, [](const CharmDataModel *clone) {
+        const_cast<CharmDataModel *>(clone)->deleteLater();
+    });
+    m_request.reset(new Request(snapshot));
+    m_receive = receive;
+    QCoreApplication::postEvent(m_executor, new BuildEvent(m_request, snapshotModel,
+                                                           model->getAllTasks(), readEvents,
+                                                           styleSheet, build, this));
+}
+
+void ReportGenerator::cancel()
+{
+    if (!m_request)
+        return;
+    m_request->m_canceled.storeRelease(1);
+    m_request.reset();
+    m_receive = Receiver();
+}
+
+bool ReportGenerator::isRunning() const
+{
+    return !m_request.isNull();
+}
+
+bool ReportGenerator::event(QEvent *event)
+{
+    if (event->type() != DocumentEvent::eventType())
+        return QObject::event(event);
+
+    auto documentEvent = static_cast<DocumentEvent *>(event);
+    if (documentEvent->request() == m_request.data()) {
+        const Receiver receive = m_receive;
+        m_request.reset();
+        m_receive = Receiver();
+        receive(documentEvent->takeDocument());
+    }
+    return true;
+}
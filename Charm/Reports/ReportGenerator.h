@@ -0,0 +1,99 @@
+/*
+  ReportGenerator.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPORTGENERATOR_H
+#define REPORTGENERATOR_H
+
+#include <QAtomicInt>
+#include <QObject>
+#include <QSharedPointer>
+#include <QThread>
+
+#include <functional>
+
+#include "Core/Event.h"
+
+class CharmDataModel;
+class QTextDocument;
+
+/** ReportGenerator builds report documents in a worker thread, from a snapshot of the data
+    model taken when the report is requested, so that long reports do not block the GUI.
+    Requesting a new report cancels the one in progress: its result is discarded, and its
+    builder can stop early by checking Request::isCanceled(). */
+class ReportGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** The state a report is built from. */
+    class Request
+    {
+    public:
+        explicit Request(const QSharedPointer<const CharmDataModel> &model);
+
+        /** The snapshot of the data model. Builders must not use the global model. */
+        const CharmDataModel *model() const;
+
+        /** True if a newer report has been requested since, the result will not be used. */
+        bool isCanceled() const;
+
+    private:
+        friend class ReportGenerator;
+        QSharedPointer<const CharmDataModel> m_model;
+        QAtomicInt m_canceled;
+    };
+
+    /** Builds the HTML of the report. Called in the worker thread, it may only use the request
+        and the values it captured. */
+    typedef std::function<QString(const Request &)> Builder;
+    /** Receives the document of a finished report, and takes ownership of it. */
+    typedef std::function<void(QTextDocument *)> Receiver;
+    /** Reads events that are not in the model, like archived events. Called in the worker
+        thread before the report is built, it may block. */
+    typedef std::function<EventList()> EventSource;
+
+    explicit ReportGenerator(QObject *parent = nullptr);
+    ~ReportGenerator() override;
+
+    /** Build a report from a snapshot of @p model. The HTML returned by @p build is laid out
+        with @p styleSheet, and the document is passed to @p receive in the thread of the
+        generator, unless the report is canceled before. The events read by @p readEvents,
+        if set, are added to the snapshot. */
+    void start(const CharmDataModel *model, const QString &styleSheet, const Builder &build,
+               const Receiver &receive, const EventSource &readEvents = EventSource());
+
+    /** Cancel the report in progress, if any. */
+    void cancel();
+
+    /** True from start() until the document has been received, or the report canceled. */
+    bool isRunning() const;
+
+    bool event(QEvent *event) override;
+
+private:
+    class Executor;
+    QThread m_thread;
+    Executor *m_executor;
+    QSharedPointer<Request> m_request;
+    Receiver m_receive;
+};
+
+#endif
@@ -0,0 +1,122 @@
+/*
+  ReportHtmlWriter.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportHtmlWriter.h"
+
+ReportHtmlWriter::ReportHtmlWriter(int expectedSize)
+    : m_writer(&m_html)
+{
+    m_html.reserve(expectedSize);
+}
+
+void ReportHtmlWriter::startReport(const QString &title)
+{
+    // FIXME this is only a rudimentary subset of a valid xhtml 1 document
+    m_writer.writeDTD(QStringLiteral("<!DOCTYPE html>"));
+    m_writer.writeStartElement(QStringLiteral("html"));
+    m_writer.writeAttribute(QStringLiteral("xmlns"), QStringLiteral("http://www.w3.org/1999/xhtml"));
+    m_writer.writeEmptyElement(QStringLiteral("head"));
+    m_writer.writeStartElement(QStringLiteral("body"));
+    m_writer.writeTextElement(QStringLiteral("h1"), title);
+}
+
+QString ReportHtmlWriter::endReport()
+{
+    m_writer.writeEndDocument();
+    return m_html;
+}
+
+void ReportHtmlWriter::startElement(const QString &name)
+{
+    m_writer.writeStartElement(name);
+}
+
+void ReportHtmlWriter::writeAttribute(const QString &name, const QString &value)
+{
+    m_writer.writeAttribute(name, value);
+}
+
+void ReportHtmlWriter::writeText(const QString &text)
+{
+    m_writer.writeCharacters(text);
+}
+
+void ReportHtmlWriter::endElement()
+{
+    m_writer.writeEndElement();
+}
+
+void ReportHtmlWriter::writeTextElement(const QString &name, const QString &text)
+{
+    m_writer.writeTextElement(name, text);
+}
+
+void ReportHtmlWriter::writeEmptyElement(const QString &name)
+{
+    m_writer.writeEmptyElement(name);
+}
+
+void ReportHtmlWriter::writeNavigationLinks(const QString &previousText, const QString &nextText)
+{
+    m_writer.writeStartElement(QStringLiteral("a"));
+    m_writer.writeAttribute(QStringLiteral("href"), QStringLiteral("Previous"));
+    m_writer.writeCharacters(previousText);
+    m_writer.writeEndElement();
+    m_writer.writeStartElement(QStringLiteral("a"));
+    m_writer.writeAttribute(QStringLiteral("href"), QStringLiteral("Next"));
+    m_writer.writeCharacters(nextText);
+    m_writer.writeEndElement();
+}
+
+void ReportHtmlWriter::startTable()
+{
+    m_writer.writeStartElement(QStringLiteral("table"));
+    m_writer.writeAttribute(QStringLiteral("width"), QStringLiteral("100%"));
+    m_writer.writeAttribute(QStringLiteral("align"), QStringLiteral("left"));
+    m_writer.writeAttribute(QStringLiteral("cellpadding"), QStringLiteral("3"));
+    m_writer.writeAttribute(QStringLiteral("cellspacing"), QStringLiteral("0"));
+}
+
+void ReportHtmlWriter::startTableHeader()
+{
+    m_writer.writeStartElement(QStringLiteral("thead"));
+}
+
+void ReportHtmlWriter::startRow(const QString &cssClass)
+{
+    m_writer.writeStartElement(QStringLiteral("tr"));
+    if (!cssClass.isEmpty())
+        m_writer.writeAttribute(QStringLiteral("class"), cssClass);
+}
+
+void ReportHtmlWriter::writeHeaderCell(const QString &text)
+{
+    m_writer.writeTextElement(QStringLiteral("th"), text);
+}
+
+void ReportHtmlWriter::writeCell(const QString &text, const QString &align)
+{
+    m_writer.writeStartElement(QStringLiteral("td"));
+    if (!align.isEmpty())
+        m_writer.writeAttribute(QStringLiteral("align"), align);
+    m_writer.writeCharacters(text);
+    m_writer.writeEndElement();
+}
@@ -0,0 +1,69 @@
+/*
+  ReportHtmlWriter.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPORTHTMLWRITER_H
+#define REPORTHTMLWRITER_H
+
+#include <QString>
+#include <QXmlStreamWriter>
+
+/** ReportHtmlWriter writes the HTML of the report previews into a string buffer as it goes,
+    without building a DOM tree first. Text and attribute values are escaped.
+    The elements and classes used are those the report style sheet knows about. */
+class ReportHtmlWriter
+{
+public:
+    /** @p expectedSize is the estimated length of the HTML, the buffer is allocated once. */
+    explicit ReportHtmlWriter(int expectedSize = 0);
+
+    /** Start the document and its body, with @p title as the headline. */
+    void startReport(const QString &title);
+    /** Close all open elements and return the HTML. */
+    QString endReport();
+
+    void startElement(const QString &name);
+    void writeAttribute(const QString &name, const QString &value);
+    void writeText(const QString &text);
+    void endElement();
+    /** Write an element that contains only @p text. */
+    void writeTextElement(const QString &name, const QString &text);
+    void writeEmptyElement(const QString &name);
+
+    /** Write the links to the previous and the next time span, that the preview windows
+        handle in ReportPreviewWindow::anchorClicked(). */
+    void writeNavigationLinks(const QString &previousText, const QString &nextText);
+    /** Start a table over the width of the page. */
+    void startTable();
+    /** Start the header of a table, which the preview repeats on every page, see ReportPages.
+        Closed with endElement() after its rows. */
+    void startTableHeader();
+    /** Start a table row, with the style sheet class @p cssClass if it is not empty. */
+    void startRow(const QString &cssClass = QString());
+    void writeHeaderCell(const QString &text);
+    /** Write a table cell, aligned as @p align if it is not empty. */
+    void writeCell(const QString &text, const QString &align = QString());
+
+private:
+    QString m_html;
+    QXmlStreamWriter m_writer;
+};
+
+#endif
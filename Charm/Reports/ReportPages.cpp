@@ -0,0 +1,93 @@
+/*
+  ReportPages.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportPages.h"
+
+#include <QTextDocument>
+#include <QTextFrame>
+#include <QTextTable>
+
+#include <algorithm>
+
+namespace {
+QTextTable *topLevelTable(QTextDocument *document, int index)
+{
+    const QList<QTextFrame *> frames = document->rootFrame()->childFrames();
+    return qobject_cast<QTextTable *>(frames.value(index));
+}
+}
+
+ReportPages::ReportPages(const QSharedPointer<QTextDocument> &document, int rowsPerPage)
+    : m_document(document)
+    , m_rowsPerPage(rowsPerPage)
+{
+    Q_ASSERT_X(rowsPerPage > 0, Q_FUNC_INFO, "pages need rows");
+    if (!m_document)
+        return;
+
+    const QList<QTextFrame *> frames = m_document->rootFrame()->childFrames();
+    for (int index = 0; index < frames.size(); ++index) {
+        auto table = qobject_cast<QTextTable *>(frames.at(index));
+        if (!table)
+            continue;
+        // rows of a <thead> are repeated on every page:
+        const int headerRows = std::min(table->format().headerRowCount(), table->rows());
+        const int bodyRows = table->rows() - headerRows;
+        if (bodyRows > m_bodyRows) {
+            m_tableIndex = index;
+            m_headerRows = headerRows;
+            m_bodyRows = bodyRows;
+        }
+    }
+    m_pages.resize(pageCount());
+}
+
+QSharedPointer<QTextDocument> ReportPages::document() const
+{
+    return m_document;
+}
+
+int ReportPages::pageCount() const
+{
+    return std::max(1, (m_bodyRows + m_rowsPerPage - 1) / m_rowsPerPage);
+}
+
+QSharedPointer<QTextDocument> ReportPages::page(int index) const
+{
+    Q_ASSERT_X(index >= 0 && index < pageCount(), Q_FUNC_INFO, "no such page");
+    if (pageCount() == 1)
+        return m_document;
+    if (m_pages.at(index))
+        return m_pages.at(index);
+
+    QSharedPointer<QTextDocument> document(m_document->clone());
+    QTextTable *table = topLevelTable(document.data(), m_tableIndex);
+    Q_ASSERT_X(table, Q_FUNC_INFO, "the copy has the same tables");
+    const int first = m_headerRows + index * m_rowsPerPage;
+    const int end = std::min(first + m_rowsPerPage, m_headerRows + m_bodyRows);
+    // remove the rows after the page first, the positions of those before stay the same:
+    if (end < table->rows())
+        table->removeRows(end, table->rows() - end);
+    if (first > m_headerRows)
+        table->removeRows(m_headerRows, first - m_headerRows);
+    m_pages[index] = document;
+    return document;
+}
@@ -0,0 +1,65 @@
+/*
+  ReportPages.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPORTPAGES_H
+#define REPORTPAGES_H
+
+#include <QSharedPointer>
+#include <QVector>
+
+class QTextDocument;
+
+/** ReportPages splits reports with long tables into pages for the preview, so that the browser
+    only lays out one page at a time instead of tens of thousands of table rows.
+    The body rows of the longest table are split. Everything else, like the headline, the
+    navigation links and the table header, is on every page. Printing and saving use the
+    complete document. */
+class ReportPages
+{
+public:
+    enum {
+        DefaultRowsPerPage = 500
+    };
+
+    explicit ReportPages(const QSharedPointer<QTextDocument> &document
+                             = QSharedPointer<QTextDocument>(),
+                         int rowsPerPage = DefaultRowsPerPage);
+
+    /** The complete document. */
+    QSharedPointer<QTextDocument> document() const;
+    /** One for documents without tables longer than a page. */
+    int pageCount() const;
+    /** The document of page @p index, the complete document if there is only one page.
+        Pages are copied from the complete document when they are first requested, and kept. */
+    QSharedPointer<QTextDocument> page(int index) const;
+
+private:
+    QSharedPointer<QTextDocument> m_document;
+    int m_rowsPerPage;
+    // the position of the split table among the frames of the document:
+    int m_tableIndex = -1;
+    int m_headerRows = 0;
+    int m_bodyRows = 0;
+    // the pages copied so far, null for the others:
+    mutable QVector<QSharedPointer<QTextDocument>> m_pages;
+};
+
+#endif
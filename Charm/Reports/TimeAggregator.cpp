@@ -0,0 +1,95 @@
+/*
+  TimeAggregator.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TimeAggregator.h"
+
+#include "Core/CharmDataModel.h"
+#include "Core/Dates.h"
+
+TimeAggregator::BucketFunction TimeAggregator::dayOfWeek()
+{
+    return [](const Event &event) {
+        return event.startDateTime().date().dayOfWeek() - 1;
+    };
+}
+
+TimeAggregator::BucketFunction TimeAggregator::weekOfMonth(const QDate &start)
+{
+    return [start](const Event &event) {
+        return Charm::weekDifference(start, event.startDateTime().date());
+    };
+}
+
+TimeAggregator::BucketFunction TimeAggregator::monthOfYear()
+{
+    return [](const Event &event) {
+        return event.startDateTime().date().month() - 1;
+    };
+}
+
+TimeAggregator::BucketFunction TimeAggregator::monthsSince(const QDate &start)
+{
+    return [start](const Event &event) {
+        const QDate date = event.startDateTime().date();
+        return (date.year() - start.year()) * 12 + date.month() - start.month();
+    };
+}
+
+TimeAggregator::TimeAggregator(int bucketCount, const BucketFunction &bucketOf)
+    : m_bucketCount(bucketCount)
+    , m_bucketOf(bucketOf)
+{
+    Q_ASSERT_X(m_bucketOf, Q_FUNC_INFO, "A bucket function is required");
+}
+
+int TimeAggregator::bucketCount() const
+{
+    return m_bucketCount;
+}
+
+void TimeAggregator::addEvent(const Event &event)
+{
+    const int bucket = m_bucketOf(event);
+    if (bucket < 0 || bucket >= m_bucketCount)
+        return;
+
+    auto it = m_secondsMap.find(event.taskId());
+    if (it == m_secondsMap.end())
+        it = m_secondsMap.insert(event.taskId(), QVector<int>(m_bucketCount, 0));
+    (*it)[bucket] += event.duration();
+}
+
+void TimeAggregator::addEvents(const CharmDataModel *model, const EventIdList &eventIds)
+{
+    Q_FOREACH (EventId id, eventIds)
+        addEvent(model->eventForId(id));
+}
+
+const SecondsMap &TimeAggregator::secondsMap() const
+{
+    return m_secondsMap;
+}
+
+TimeSheetInfoList TimeAggregator::taskWithSubTasks(const CharmDataModel *model,
+                                                   TaskId rootTask) const
+{
+    return TimeSheetInfo::taskWithSubTasks(model, m_bucketCount, rootTask, m_secondsMap);
+}
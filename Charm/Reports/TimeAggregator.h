@@ -0,0 +1,73 @@
+/*
+  TimeAggregator.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TIMEAGGREGATOR_H
+#define TIMEAGGREGATOR_H
+
+#include "TimesheetInfo.h"
+
+#include "Core/Event.h"
+
+#include <functional>
+
+class QDate;
+
+/** TimeAggregator sums up the durations of events per task, in buckets of time like the days
+    of a week. A bucket function maps each event to its bucket, so that the same aggregation
+    serves the weekly, monthly and yearly reports. The seconds are accumulated in place, and
+    rolled up into the task tree once all events are added, see taskWithSubTasks(). */
+class TimeAggregator
+{
+public:
+    /** Maps an event to the index of its bucket. Events mapped to an index outside of the
+        buckets are not counted. */
+    typedef std::function<int(const Event &)> BucketFunction;
+
+    /** The days of the week of the event start, Monday first. */
+    static BucketFunction dayOfWeek();
+    /** The weeks since the week of @p start, see Charm::weekDifference(). */
+    static BucketFunction weekOfMonth(const QDate &start);
+    /** The months of the year of the event start, January first. */
+    static BucketFunction monthOfYear();
+    /** The months since the month of @p start, for reports spanning several years. */
+    static BucketFunction monthsSince(const QDate &start);
+
+    TimeAggregator(int bucketCount, const BucketFunction &bucketOf);
+
+    int bucketCount() const;
+
+    void addEvent(const Event &event);
+    void addEvents(const CharmDataModel *model, const EventIdList &eventIds);
+
+    /** The seconds of every task that has events, not including those of its subtasks. */
+    const SecondsMap &secondsMap() const;
+
+    /** The task @p rootTask followed by its subtasks, with the seconds of each task including
+        those of its subtasks. */
+    TimeSheetInfoList taskWithSubTasks(const CharmDataModel *model, TaskId rootTask) const;
+
+private:
+    int m_bucketCount;
+    BucketFunction m_bucketOf;
+    SecondsMap m_secondsMap;
+};
+
+#endif
@@ -25,6 +25,8 @@
 
 #include "Core/CharmDataModel.h"
 
+#include <algorithm>
+
 TimeSheetInfo::TimeSheetInfo(int segments)
     : seconds(segments)
 {
@@ -52,50 +54,57 @@ QString TimeSheetInfo::formattedTaskIdAndName(int taskPaddingLength) const
     return QStringLiteral("%1: %2").arg(formattedId, taskName);
 }
 
-// make the list, aggregate the seconds in the subtask:
-TimeSheetInfoList TimeSheetInfo::taskWithSubTasks(const CharmDataModel *dataModel, int segments,
-                                                  TaskId id, const SecondsMap &secondsMap,
-                                                  TimeSheetInfo *addTo)
+namespace {
+// append the item for id and then its subtasks, and return its index; the seconds of the
+// subtasks are added to the item once they are complete, in post-order:
+int appendTaskWithSubTasks(TimeSheetInfoList &result, const CharmDataModel *dataModel,
+                           int segments, TaskId id, const SecondsMap &secondsMap,
+                           int indentation)
 {
-    TimeSheetInfoList result;
-    TimeSheetInfoList children;
-
-    TimeSheetInfo myInformation(segments);
     const TaskTreeItem &item = dataModel->taskTreeItem(id);
     // real task or virtual root item
     Q_ASSERT(item.task().isValid() || id == 0);
 
-    if (id != 0) {
-        // add totals for task itself:
-        if (secondsMap.contains(id))
-            myInformation.seconds = secondsMap.value(id);
-        // add name and id:
-        myInformation.taskId = item.task().id();
-        myInformation.taskName = item.task().name();
-
-        if (addTo != 0)
-            myInformation.indentation = addTo->indentation + 1;
-        myInformation.taskId = id;
-    } else {
-        myInformation.indentation = -1;
+    const int index = result.size();
+    {
+        TimeSheetInfo myInformation(segments);
+        myInformation.indentation = indentation;
+        if (id != 0) {
+            // add totals for task itself:
+            const auto it = secondsMap.constFind(id);
+            if (it != secondsMap.constEnd())
+                myInformation.seconds = it.value();
+            // add name and id:
+            myInformation.taskId = id;
+            myInformation.taskName = item.task().name();
+        }
+        result.append(myInformation);
     }
 
     TaskIdList childIds = item.childIds();
     // sort by task id
-    qSort(childIds);
-    // recursively add those to myself:
-    Q_FOREACH (const TaskId i, childIds)
-        children << taskWithSubTasks(dataModel, segments, i, secondsMap, &myInformation);
-
-    // add to parent:
-    if (addTo != 0) {
+    std::sort(childIds.begin(), childIds.end());
+    Q_FOREACH (const TaskId childId, childIds) {
+        const int child = appendTaskWithSubTasks(result, dataModel, segments, childId,
+                                                 secondsMap, indentation + 1);
+        // add to parent:
+        TimeSheetInfo &myInformation = result[index];
+        const QVector<int> &childSeconds = result.at(child).seconds;
         for (int i = 0; i < segments; ++i)
-            addTo->seconds[i] += myInformation.seconds[i];
-        addTo->aggregated = true;
+            myInformation.seconds[i] += childSeconds[i];
+        myInformation.aggregated = true;
     }
 
-    result << myInformation << children;
+    return index;
+}
+}
 
+// make the list, aggregate the seconds in the subtask:
+TimeSheetInfoList TimeSheetInfo::taskWithSubTasks(const CharmDataModel *dataModel, int segments,
+                                                  TaskId id, const SecondsMap &secondsMap)
+{
+    TimeSheetInfoList result;
+    appendTaskWithSubTasks(result, dataModel, segments, id, secondsMap, id == 0 ? -1 : 0);
     return result;
 }
 
@@ -44,9 +44,10 @@ public:
     void dump();
 
 public:
+    /** The task @p id followed by its subtasks, depth first and ordered by task id. The
+        seconds of each task from @p secondsMap include those of its subtasks. */
     static TimeSheetInfoList taskWithSubTasks(const CharmDataModel *dataModel, int segments,
-                                              TaskId id, const SecondsMap &secondsMap,
-                                              TimeSheetInfo *addTo = 0);
+                                              TaskId id, const SecondsMap &secondsMap);
     static TimeSheetInfoList filteredTaskWithSubTasks(TimeSheetInfoList timeSheetInfo,
                                                       bool activeTasksOnly);
 
@@ -30,6 +30,24 @@
 #include "Core/XmlSerialization.h"
 
 #include <QDomDocument>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+#include <algorithm>
+
+namespace {
+typedef QPair<TaskId, QDate> EffortKey;
+
+/** The effort for a task in one period, usually a day, summed up from its events. */
+struct DailyEffort {
+    EffortKey key;
+    /** The first event of the day, carries the properties of the aggregate. */
+    Event event;
+    int seconds = 0;
+    QString comment;
+};
+}
 
 TimesheetXmlWriter::TimesheetXmlWriter(const QString &templateName)
     : m_templateName(templateName)
@@ -80,6 +98,11 @@ void TimesheetXmlWriter::setIncludeTaskList(bool includeTaskList)
     m_includeTaskList = includeTaskList;
 }
 
+QDate TimesheetXmlWriter::effortPeriod(const QDate &day) const
+{
+    return day;
+}
+
 QByteArray TimesheetXmlWriter::saveToXml() const
 {
     // now create the report:
@@ -120,52 +143,59 @@ QByteArray TimesheetXmlWriter::saveToXml() const
         QDomElement effort = document.createElement(QStringLiteral("effort"));
         report.appendChild(effort);
 
-        // aggregate (group by task and day):
-        typedef QPair<TaskId, QDate> Key;
-        QMap< Key, Event> events;
+        // aggregate (group by task and period), in one pass over the events:
+        QSet<TaskId> reportedTasks;
+        reportedTasks.reserve(timeSheetInfo.size());
+        Q_FOREACH (const TimeSheetInfo &info, timeSheetInfo)
+            reportedTasks.insert(info.taskId);
+
+        QHash<EffortKey, int> effortIndex;
+        QVector<DailyEffort> efforts;
         Q_FOREACH (const Event &event, m_events) {
-            TimeSheetInfoList::iterator it;
-            for (it = timeSheetInfo.begin(); it != timeSheetInfo.end(); ++it)
-                if ((*it).taskId == event.taskId()) break;
-            if (it == timeSheetInfo.end())
+            if (!reportedTasks.contains(event.taskId()))
                 continue;
-            Key key(event.taskId(), event.startDateTime().date());
-            if (events.contains(key)) {
+            const EffortKey key(event.taskId(), effortPeriod(event.startDateTime().date()));
+            const auto it = effortIndex.constFind(key);
+            if (it != effortIndex.constEnd()) {
                 // add to previous events:
-                const Event &oldEvent = events[key];
-                const int seconds = oldEvent.duration() + event.duration();
-                const QDateTime start = oldEvent.startDateTime();
-                const QDateTime end(start.addSecs(seconds));
-                Q_ASSERT(start.secsTo(end) == seconds);
-                Event newEvent(oldEvent);
-                newEvent.setStartDateTime(start);
-                newEvent.setEndDateTime(end);
-                Q_ASSERT(newEvent.duration() == seconds);
-                QString comment = oldEvent.comment();
+                DailyEffort &daily = efforts[it.value()];
+                daily.seconds += event.duration();
                 if (!event.comment().isEmpty()) {
-                    if (!comment.isEmpty())     // make separator
-                        comment += QLatin1String(" / ");
-                    comment += event.comment();
-                    newEvent.setComment(comment);
+                    if (!daily.comment.isEmpty())     // make separator
+                        daily.comment += QLatin1String(" / ");
+                    daily.comment += event.comment();
                 }
-                events[key] = newEvent;
             } else {
                 // add this event:
-                events[key] = event;
-                events[key].setId(-events[key].id());   // "synthetic" :-)
-                // move to start at midnight in UTC (for privacy reasons)
-                // never, never, never use setTime() here, it breaks on DST changes! (twice a year)
-                QDateTime start(event.startDateTime().date(), QTime(0, 0, 0, 0), Qt::UTC);
-                QDateTime end(start.addSecs(event.duration()));
-                events[key].setStartDateTime(start);
-                events[key].setEndDateTime(end);
-                Q_ASSERT(events[key].duration() == event.duration());
-                Q_ASSERT(start.time() == QTime(0, 0, 0, 0));
+                effortIndex.insert(key, efforts.size());
+                DailyEffort daily;
+                daily.key = key;
+                daily.event = event;
+                daily.seconds = event.duration();
+                daily.comment = event.comment();
+                efforts.append(daily);
             }
         }
-        // create elements:
-        Q_FOREACH (const Event &event, events)
+
+        // create elements, ordered by task and period:
+        std::sort(efforts.begin(), efforts.end(),
+                  [](const DailyEffort &left, const DailyEffort &right) {
+            return left.key < right.key;
+        });
+        Q_FOREACH (const DailyEffort &daily, efforts) {
+            Event event(daily.event);
+            event.setId(-event.id());   // "synthetic" :-)
+            // move to start at midnight in UTC (for privacy reasons)
+            // never, never, never use setTime() here, it breaks on DST changes! (twice a year)
+            const QDateTime start(daily.key.second, QTime(0, 0, 0, 0), Qt::UTC);
+            const QDateTime end(start.addSecs(daily.seconds));
+            event.setStartDateTime(start);
+            event.setEndDateTime(end);
+            event.setComment(daily.comment);
+            Q_ASSERT(event.duration() == daily.seconds);
+            Q_ASSERT(start.time() == QTime(0, 0, 0, 0));
             effort.appendChild(event.toXml(document));
+        }
     }
 
     return document.toByteArray(4);
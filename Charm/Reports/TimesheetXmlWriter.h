@@ -30,6 +30,7 @@
 #include "Core/Task.h"
 
 class QByteArray;
+class QDate;
 class QDomDocument;
 class QDomElement;
 
@@ -61,6 +62,9 @@ public:
 protected:
     virtual void writeMetadata(QDomDocument &document, QDomElement &metadata) const = 0;
     virtual QList<TimeSheetInfo> createTimeSheetInfo() const = 0;
+    /** The first day of the period the effort of @p day is summed up in, the day itself by
+        default. */
+    virtual QDate effortPeriod(const QDate &day) const;
 
 private:
     const CharmDataModel *m_dataModel = nullptr;
@@ -0,0 +1,65 @@
+/*
+  YearlyTimesheetXmlWriter.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "YearlyTimesheetXmlWriter.h"
+
+#include "TimesheetInfo.h"
+#include <QDomDocument>
+
+YearlyTimesheetXmlWriter::YearlyTimesheetXmlWriter()
+    : TimesheetXmlWriter(QLatin1String("yearly-timesheet"))
+{
+}
+
+void YearlyTimesheetXmlWriter::setFirstYear(int firstYear)
+{
+    m_firstYear = firstYear;
+}
+
+void YearlyTimesheetXmlWriter::setNumberOfYears(int numberOfYears)
+{
+    m_numberOfYears = numberOfYears;
+}
+
+void YearlyTimesheetXmlWriter::writeMetadata(QDomDocument &document, QDomElement &metadata) const
+{
+    QDomElement yearElement = document.createElement(QStringLiteral("year"));
+    metadata.appendChild(yearElement);
+    QDomText text = document.createTextNode(QString::number(m_firstYear));
+    yearElement.appendChild(text);
+    QDomElement yearsElement = document.createElement(QStringLiteral("number-of-years"));
+    metadata.appendChild(yearsElement);
+    QDomText yearsText = document.createTextNode(QString::number(m_numberOfYears));
+    yearsElement.appendChild(yearsText);
+}
+
+QList<TimeSheetInfo> YearlyTimesheetXmlWriter::createTimeSheetInfo() const
+{
+    return TimeSheetInfo::filteredTaskWithSubTasks(
+        TimeSheetInfo::taskWithSubTasks(dataModel(), 12 * m_numberOfYears, rootTask(),
+                                        SecondsMap()),
+        false);  // here, we don't care about active or not, because we only report on the tasks
+}
+
+QDate YearlyTimesheetXmlWriter::effortPeriod(const QDate &day) const
+{
+    return QDate(day.year(), day.month(), 1);
+}
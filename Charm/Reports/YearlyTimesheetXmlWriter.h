@@ -0,0 +1,46 @@
+/*
+  YearlyTimesheetXmlWriter.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef YEARLYTIMESHEETXMLWRITER_H
+#define YEARLYTIMESHEETXMLWRITER_H
+
+#include "TimesheetXmlWriter.h"
+
+/** Writes the yearly summary, with the effort of every task summed up per month. */
+class YearlyTimesheetXmlWriter : public TimesheetXmlWriter
+{
+public:
+    YearlyTimesheetXmlWriter();
+
+    void setFirstYear(int firstYear);
+    void setNumberOfYears(int numberOfYears);
+
+protected:
+    void writeMetadata(QDomDocument &document, QDomElement &metadata) const override;
+    QList<TimeSheetInfo> createTimeSheetInfo() const override;
+    QDate effortPeriod(const QDate &day) const override;
+
+private:
+    int m_firstYear = 0;
+    int m_numberOfYears = 1;
+};
+
+#endif
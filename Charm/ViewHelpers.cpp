@@ -23,9 +23,15 @@
 
 #include "ViewHelpers.h"
 
-#include <QtAlgorithms>
+#include "Core/TaskFilter.h"
+
 #include <QFile>
 #include <QCollator>
+#include <QHash>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
 
 namespace {
 static QCollator collator()
@@ -50,11 +56,37 @@ void Charm::connectControllerAndView(Controller *controller, CharmWindow *view)
                      view, SLOT(commitCommand(CharmCommand*)));
 }
 
+namespace {
+/** The sort keys of an event, computed once before sorting. */
+struct EventSortKey {
+    EventId id;
+    qint64 startTime;
+    qint64 endTime;
+    TaskId taskId;
+    /** The index of the collator sort key of the comment, -1 if not sorted by comment. */
+    int comment;
+};
+
+qint64 sortTime(const QDateTime &dateTime)
+{
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : std::numeric_limits<qint64>::min();
+}
+
+const QCollator &threadCollator()
+{
+    // QCollator is not thread-safe, and reports are sorted in worker threads:
+    static thread_local const auto collator(::collator());
+    return collator;
+}
+}
+
 class EventSorter
 {
 public:
-    EventSorter(const Charm::SortOrderList &orders)
-        : m_orders(orders)
+    EventSorter(const std::vector<QCollatorSortKey> &commentKeys,
+                const Charm::SortOrderList &orders)
+        : m_commentKeys(commentKeys)
+        , m_orders(orders)
     {
         Q_ASSERT(!m_orders.contains(Charm::SortOrder::None));
         Q_ASSERT(!m_orders.isEmpty());
@@ -71,11 +103,10 @@ public:
         return 0;
     }
 
-    bool operator()(const EventId &leftId, const EventId &rightId) const
+    bool operator()(const EventSortKey &left, const EventSortKey &right) const
     {
-        const Event &left = DATAMODEL->eventForId(leftId);
-        const Event &right = DATAMODEL->eventForId(rightId);
-        int result = -1;
+        // equal in all orders is not less, which keeps the order strict weak:
+        int result = 0;
 
         foreach (const auto order, m_orders) {
             switch (order) {
@@ -83,65 +114,92 @@ public:
                 Q_UNREACHABLE();
 
             case Charm::SortOrder::StartTime:
-                result = compare(left.startDateTime(), right.startDateTime());
+                result = compare(left.startTime, right.startTime);
                 break;
 
             case Charm::SortOrder::EndTime:
-                result = compare(left.endDateTime(), right.endDateTime());
+                result = compare(left.endTime, right.endTime);
                 break;
 
             case Charm::SortOrder::TaskId:
-                result = compare(left.taskId(), right.taskId());
+                result = compare(left.taskId, right.taskId);
                 break;
 
             case Charm::SortOrder::Comment:
-                result = Charm::collatorCompare(left.comment(), right.comment());
+                // equal comments share their key:
+                result = left.comment == right.comment
+                         ? 0 : m_commentKeys[left.comment].compare(m_commentKeys[right.comment]);
                 break;
             }
 
             if (result != 0)
                 break;
-
-            result = -1;
         }
 
         return result < 0;
     }
 
 private:
+    const std::vector<QCollatorSortKey> &m_commentKeys;
     const Charm::SortOrderList &m_orders;
 };
 
 int Charm::collatorCompare(const QString &left, const QString &right)
 {
-    static const auto collator(::collator());
-    return collator.compare(left, right);
+    return threadCollator().compare(left, right);
 }
 
-EventIdList Charm::eventIdsSortedBy(EventIdList ids, const Charm::SortOrderList &orders)
+EventIdList Charm::eventIdsSortedBy(const CharmDataModel *model, EventIdList ids,
+                                   const Charm::SortOrderList &orders)
 {
-    if (!orders.isEmpty())
-        qStableSort(ids.begin(), ids.end(), EventSorter(orders));
+    if (orders.isEmpty())
+        return ids;
+
+    // look up every event once, instead of twice per comparison, and compute its keys;
+    // the collator keys are only computed once per distinct comment:
+    const bool byComment = orders.contains(Charm::SortOrder::Comment);
+    std::vector<EventSortKey> keys;
+    keys.reserve(ids.size());
+    std::vector<QCollatorSortKey> commentKeys;
+    QHash<QString, int> commentIndex;
+    Q_FOREACH (EventId id, ids) {
+        const Event &event = model->eventForId(id);
+        EventSortKey key;
+        key.id = id;
+        key.startTime = sortTime(event.startDateTime(Qt::UTC));
+        key.endTime = sortTime(event.endDateTime(Qt::UTC));
+        key.taskId = event.taskId();
+        key.comment = -1;
+        if (byComment) {
+            auto it = commentIndex.constFind(event.comment());
+            if (it == commentIndex.constEnd()) {
+                it = commentIndex.insert(event.comment(), int(commentKeys.size()));
+                commentKeys.push_back(threadCollator().sortKey(event.comment()));
+            }
+            key.comment = it.value();
+        }
+        keys.push_back(key);
+    }
 
+    std::stable_sort(keys.begin(), keys.end(), EventSorter(commentKeys, orders));
+    for (int i = 0; i < ids.size(); ++i)
+        ids[i] = keys[i].id;
     return ids;
 }
 
-EventIdList Charm::eventIdsSortedBy(EventIdList ids, SortOrder order)
+EventIdList Charm::eventIdsSortedBy(const CharmDataModel *model, EventIdList ids,
+                                   SortOrder order)
 {
-    return eventIdsSortedBy(ids, SortOrderList(1) << order);
+    return eventIdsSortedBy(model, ids, SortOrderList() << order);
 }
 
-EventIdList Charm::filteredBySubtree(EventIdList ids, TaskId parent, bool exclude)
+EventIdList Charm::filteredBySubtree(const CharmDataModel *model, EventIdList ids,
+                                     TaskId parent, bool exclude)
 {
-    EventIdList result;
-    bool isParent = false;
-    Q_FOREACH (EventId id, ids) {
-        const Event &event = DATAMODEL->eventForId(id);
-        isParent = (parent == event.taskId() || DATAMODEL->isParentOf(parent, event.taskId()));
-        if (isParent != exclude)
-            result << id;
-    }
-    return result;
+    const QSet<TaskId> roots = QSet<TaskId>() << parent;
+    const TaskFilter filter = exclude ? TaskFilter(model, QSet<TaskId>(), roots)
+                                      : TaskFilter(model, roots);
+    return filter.filtered(model, ids);
 }
 
 QString Charm::elidedTaskName(const QString &text, const QFont &font, int width)
@@ -48,11 +48,16 @@ typedef QVarLengthArray<SortOrder, 5> SortOrderList;
 
 void connectControllerAndView(Controller *, CharmWindow *);
 int collatorCompare(const QString &left, const QString &right);
-EventIdList eventIdsSortedBy(EventIdList, const SortOrderList &orders);
-EventIdList eventIdsSortedBy(EventIdList, SortOrder order);
+/** The event and task lookups of the following functions use @p model, which does not need to
+ * be the global data model. They can be used in worker threads with a snapshot of the model. */
+EventIdList eventIdsSortedBy(const CharmDataModel *model, EventIdList,
+                             const SortOrderList &orders);
+EventIdList eventIdsSortedBy(const CharmDataModel *model, EventIdList, SortOrder order);
 /** Return those ids in the input list that elements of the subtree
- * under the parent task, which includes the parent task. */
-EventIdList filteredBySubtree(EventIdList, TaskId parent, bool exclude = false);
+ * under the parent task, which includes the parent task.
+ * To filter by several subtrees, use one TaskFilter instead. */
+EventIdList filteredBySubtree(const CharmDataModel *model, EventIdList, TaskId parent,
+                              bool exclude = false);
 QString elidedTaskName(const QString &text, const QFont &font, int width);
 QString reportStylesheet(const QPalette &palette);
 }
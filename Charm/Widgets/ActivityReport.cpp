@@ -27,20 +27,98 @@
 #include "Data.h"
 #include "SelectTaskDialog.h"
 
+#include "Reports/ReportHtmlWriter.h"
+
 #include "Core/Configuration.h"
+#include "Core/CsvWriter.h"
 #include "Core/Dates.h"
+#include "Core/TaskFilter.h"
 
 #include <QCalendarWidget>
-#include <QDomDocument>
-#include <QDomElement>
 #include <QFile>
 #include <QPushButton>
+#include <QStringList>
 #include <QTimer>
 #include <QtAlgorithms>
 #include <QUrl>
 
+#include <algorithm>
+
 #include "ui_ActivityReportConfigurationDialog.h"
 
+namespace {
+/** The properties of the report @p offset time spans away. */
+ActivityReportConfigurationDialog::Properties shiftedProperties(
+    ActivityReportConfigurationDialog::Properties properties, int offset)
+{
+    switch (properties.timeSpanSelection.timeSpanType) {
+    case Day:
+        properties.start = properties.start.addDays(1 * offset);
+        properties.end = properties.end.addDays(1 * offset);
+        break;
+    case Week:
+        properties.start = properties.start.addDays(7 * offset);
+        properties.end = properties.end.addDays(7 * offset);
+        break;
+    case Month:
+        properties.start = properties.start.addMonths(1 * offset);
+        properties.end = properties.end.addMonths(1 * offset);
+        break;
+    case Year:
+        properties.start = properties.start.addYears(1 * offset);
+        properties.end = properties.end.addYears(1 * offset);
+        break;
+    case Range:
+    {
+        const int spanRange = properties.start.daysTo(properties.end);
+        properties.start = properties.start.addDays(spanRange * offset);
+        properties.end = properties.end.addDays(spanRange * offset);
+        break;
+    }
+    default:
+        Q_ASSERT(false);   // should not happen
+    }
+    return properties;
+}
+
+QString taskIdsKey(const QSet<TaskId> &taskIds)
+{
+    QList<TaskId> sorted = taskIds.toList();
+    std::sort(sorted.begin(), sorted.end());
+    QStringList ids;
+    Q_FOREACH (TaskId id, sorted)
+        ids << QString::number(id);
+    return ids.join(QLatin1Char(','));
+}
+
+/** The events of the report, in the order they are listed in. */
+EventIdList reportedEvents(const CharmDataModel *model,
+                           const ActivityReportConfigurationDialog::Properties &properties)
+{
+    // the included and the unproductive excluded subtrees are checked in one pass:
+    const TaskFilter filter(model, properties.rootTasks, properties.rootExcludeTasks);
+    EventIdList matchingEvents = filter.filtered(
+        model, model->eventsThatStartInTimeFrame(properties.start, properties.end));
+
+    if (properties.groupByTaskId) {
+        matchingEvents = Charm::eventIdsSortedBy(model, matchingEvents,
+                                                 Charm::SortOrderList() << Charm::SortOrder::TaskId
+                                                                        << Charm::SortOrder::StartTime);
+    } else if (properties.groupByTaskIdAndComments) {
+        matchingEvents = Charm::eventIdsSortedBy(model, matchingEvents,
+                                                 Charm::SortOrderList() << Charm::SortOrder::TaskId
+                                                                        << Charm::SortOrder::Comment
+                                                                        << Charm::SortOrder::StartTime);
+    } else {
+        matchingEvents = Charm::eventIdsSortedBy(model, matchingEvents,
+                                                 Charm::SortOrderList()
+                                                 << Charm::SortOrder::StartTime);
+    }
+
+    return matchingEvents;
+}
+}
+
 ActivityReportConfigurationDialog::ActivityReportConfigurationDialog(QWidget *parent)
     : ReportConfigurationDialog(parent)
     , m_ui(new Ui::ActivityReportConfigurationDialog)
@@ -250,52 +328,87 @@ void ActivityReport::setReportProperties(
     const ActivityReportConfigurationDialog::Properties &properties)
 {
     m_properties = properties;
-    slotUpdate();
+    generateReport();
 }
 
-void ActivityReport::slotUpdate()
+QString ActivityReport::suggestedFileName() const
 {
-    // retrieve matching events:
-    EventIdList matchingEvents = DATAMODEL->eventsThatStartInTimeFrame(m_properties.start,
-                                                                       m_properties.end);
-
-    if (!m_properties.rootTasks.isEmpty()) {
-        QSet<EventId> filteredEvents;
-        Q_FOREACH (TaskId include, m_properties.rootTasks)
-            filteredEvents |= Charm::filteredBySubtree(matchingEvents, include).toSet();
-        matchingEvents = filteredEvents.toList();
-    }
+    return tr("ActivityReport-%1-%2").arg(m_properties.start.toString(Qt::ISODate),
+                                          m_properties.end.addDays(-1).toString(Qt::ISODate));
+}
 
-    if (m_properties.groupByTaskId) {
-        matchingEvents = Charm::eventIdsSortedBy(matchingEvents,
-                                                 Charm::SortOrderList() << Charm::SortOrder::TaskId
-                                                                        << Charm::SortOrder::StartTime);
-    } else if (m_properties.groupByTaskIdAndComments) {
-        matchingEvents = Charm::eventIdsSortedBy(matchingEvents,
-                                                 Charm::SortOrderList() << Charm::SortOrder::TaskId
-                                                                        << Charm::SortOrder::Comment
-                                                                        << Charm::SortOrder::StartTime);
-    } else {
-        matchingEvents = Charm::eventIdsSortedBy(matchingEvents,
-                                                 Charm::SortOrderList()
-                                                 << Charm::SortOrder::StartTime);
+void ActivityReport::saveToCsv(CsvWriter &writer)
+{
+    // the events are written one by one, straight from the model, or from a copy of it if
+    // archived events are reported:
+    const CharmDataModel *model = DATAMODEL;
+    QScopedPointer<CharmDataModel> withArchivedEvents;
+    const auto readArchivedEvents = ApplicationCore::instance().archivedEventsReader(
+        QDateTime(m_properties.start), QDateTime(m_properties.end));
+    const EventList archived = readArchivedEvents ? readArchivedEvents() : EventList();
+    if (!archived.isEmpty()) {
+        withArchivedEvents.reset(model->clone());
+        Q_FOREACH (const Event &event, archived) {
+            if (!withArchivedEvents->eventExists(event.id()))
+                withArchivedEvents->addEvent(event);
+        }
+        model = withArchivedEvents.data();
     }
+    writer.writeRow(CsvWriter::eventColumns());
+    Q_FOREACH (EventId id, reportedEvents(model, m_properties)) {
+        const Event &event = model->eventForId(id);
+        writer.writeEvent(event, model->fullTaskName(model->getTask(event.taskId())));
+    }
+}
+
+ReportPreviewWindow::Report ActivityReport::report(int offset)
+{
+    // the report is built in a worker thread, from copies of the settings it uses:
+    const ActivityReportConfigurationDialog::Properties properties
+        = shiftedProperties(m_properties, offset);
+    const QString userName = CONFIGURATION.user.name();
+    const int taskPaddingLength = CONFIGURATION.taskPaddingLength;
+
+    Report report;
+    report.key = QStringLiteral("activity/%1/%2/%3/%4/%5/%6%7%8/%9/")
+                 .arg(properties.start.toString(Qt::ISODate),
+                      properties.end.toString(Qt::ISODate),
+                      QString::number(properties.timeSpanSelection.timeSpanType),
+                      taskIdsKey(properties.rootTasks),
+                      taskIdsKey(properties.rootExcludeTasks),
+                      QString::number(properties.showFullDescription),
+                      QString::number(properties.groupByTaskId),
+                      QString::number(properties.groupByTaskIdAndComments),
+                      QString::number(taskPaddingLength))
+                 + userName;
+    report.start = QDateTime(properties.start);
+    report.end = QDateTime(properties.end);
+    report.build = [properties, userName, taskPaddingLength](
+        const ReportGenerator::Request &request) {
+        return reportHtml(request, properties, userName, taskPaddingLength);
+    };
+    return report;
+}
 
-    // filter unproductive events:
-    Q_FOREACH (TaskId exclude, m_properties.rootExcludeTasks)
-        matchingEvents = Charm::filteredBySubtree(matchingEvents, exclude, true);
+QString ActivityReport::reportHtml(const ReportGenerator::Request &request,
+                                   const ActivityReportConfigurationDialog::Properties &properties,
+                                   const QString &userName, int taskPaddingLength)
+{
+    const CharmDataModel *model = request.model();
+    // retrieve matching events:
+    const EventIdList matchingEvents = reportedEvents(model, properties);
 
     // calculate total:
     int totalSeconds = 0;
     Q_FOREACH (EventId id, matchingEvents) {
-        const Event &event = DATAMODEL->eventForId(id);
+        const Event &event = model->eventForId(id);
         Q_ASSERT(event.isValid());
         totalSeconds += event.duration();
     }
 
     // which TimeSpan type
     QString timeSpanTypeName;
-    switch (m_properties.timeSpanSelection.timeSpanType) {
+    switch (properties.timeSpanSelection.timeSpanType) {
     case Day:
         timeSpanTypeName = tr("Day");
         break;
@@ -315,107 +428,66 @@ void ActivityReport::slotUpdate()
         Q_ASSERT(false);   // should not happen
     }
 
-    auto report = new QTextDocument(this);
-    QDomDocument doc = createReportTemplate();
-    QDomElement root = doc.documentElement();
-    QDomElement body = root.firstChildElement(QStringLiteral("body"));
+    if (request.isCanceled())
+        return QString();
 
+    // about three lines of text per row:
+    ReportHtmlWriter html(2048 + 400 * matchingEvents.size());
     // create the caption:
+    html.startReport(tr("Activity Report"));
     {
-        QDomElement headline = doc.createElement(QStringLiteral("h1"));
-        QDomText text = doc.createTextNode(tr("Activity Report"));
-        headline.appendChild(text);
-        body.appendChild(headline);
-    }
-    {
-        QDomElement headline = doc.createElement(QStringLiteral("h3"));
         QString content = tr("Report for %1, from %2 to %3")
-                          .arg(CONFIGURATION.user.name(),
-                               m_properties.start.toString(Qt::TextDate),
-                               m_properties.end.toString(Qt::TextDate));
-        QDomText text = doc.createTextNode(content);
-        headline.appendChild(text);
-        body.appendChild(headline);
-        QDomElement previousLink = doc.createElement(QStringLiteral("a"));
-        previousLink.setAttribute(QStringLiteral("href"), QStringLiteral("Previous"));
-        QDomText previousLinkText = doc.createTextNode(tr("<Previous %1>").arg(timeSpanTypeName));
-        previousLink.appendChild(previousLinkText);
-        body.appendChild(previousLink);
-        QDomElement nextLink = doc.createElement(QStringLiteral("a"));
-        nextLink.setAttribute(QStringLiteral("href"), QStringLiteral("Next"));
-        QDomText nextLinkText = doc.createTextNode(tr("<Next %1>").arg(timeSpanTypeName));
-        nextLink.appendChild(nextLinkText);
-        body.appendChild(nextLink);
-        {
-            QDomElement paragraph = doc.createElement(QStringLiteral("h4"));
-            QString totalsText = tr("Total: %1").arg(hoursAndMinutes(totalSeconds));
-            QDomText totalsElement = doc.createTextNode(totalsText);
-            paragraph.appendChild(totalsElement);
-            body.appendChild(paragraph);
-        }
-        if (!m_properties.rootTasks.isEmpty()) {
-            QDomElement paragraph = doc.createElement(QStringLiteral("p"));
+                          .arg(userName,
+                               properties.start.toString(Qt::TextDate),
+                               properties.end.toString(Qt::TextDate));
+        html.writeTextElement(QStringLiteral("h3"), content);
+        html.writeNavigationLinks(tr("<Previous %1>").arg(timeSpanTypeName),
+                                  tr("<Next %1>").arg(timeSpanTypeName));
+        QString totalsText = tr("Total: %1").arg(hoursAndMinutes(totalSeconds));
+        html.writeTextElement(QStringLiteral("h4"), totalsText);
+        if (!properties.rootTasks.isEmpty()) {
             QString rootTaskText = tr("Activity under tasks:");
 
-            Q_FOREACH (TaskId taskId, m_properties.rootTasks) {
-                const Task &task = DATAMODEL->getTask(taskId);
-                rootTaskText.append(QStringLiteral(" ( %1 ),").arg(DATAMODEL->fullTaskName(task)));
+            Q_FOREACH (TaskId taskId, properties.rootTasks) {
+                const Task &task = model->getTask(taskId);
+                rootTaskText.append(QStringLiteral(" ( %1 ),").arg(model->fullTaskName(task)));
             }
             rootTaskText = rootTaskText.mid(0, rootTaskText.length() - 1);
-            QDomText rootText = doc.createTextNode(rootTaskText);
-            paragraph.appendChild(rootText);
-            body.appendChild(paragraph);
+            html.writeTextElement(QStringLiteral("p"), rootTaskText);
         }
 
-        QDomElement paragraph = doc.createElement(QStringLiteral("br"));
-        body.appendChild(paragraph);
+        html.writeEmptyElement(QStringLiteral("br"));
     }
     {
-        const QString Headlines[] = {
-            tr("Date and Time, Task, Description")
-        };
-        const int NumberOfColumns = sizeof Headlines / sizeof Headlines[0];
-
         // now for a table
-        QDomElement table = doc.createElement(QStringLiteral("table"));
-        table.setAttribute(QStringLiteral("width"), QStringLiteral("100%"));
-        table.setAttribute(QStringLiteral("align"), QStringLiteral("left"));
-        table.setAttribute(QStringLiteral("cellpadding"), QStringLiteral("3"));
-        table.setAttribute(QStringLiteral("cellspacing"), QStringLiteral("0"));
-        body.appendChild(table);
+        html.startTable();
         // table header
-        QDomElement tableHead = doc.createElement(QStringLiteral("thead"));
-        table.appendChild(tableHead);
-        QDomElement headerRow = doc.createElement(QStringLiteral("tr"));
-        headerRow.setAttribute(QStringLiteral("class"), QStringLiteral("header_row"));
-        tableHead.appendChild(headerRow);
-        // column headers
-        for (int i = 0; i < NumberOfColumns; ++i) {
-            QDomElement header = doc.createElement(QStringLiteral("th"));
-            QDomText text = doc.createTextNode(Headlines[i]);
-            header.appendChild(text);
-            headerRow.appendChild(header);
-        }
-        QDomElement tableBody = doc.createElement(QStringLiteral("tbody"));
-        table.appendChild(tableBody);
+        html.startTableHeader();
+        html.startRow(QStringLiteral("header_row"));
+        html.writeHeaderCell(tr("Date and Time, Task, Description"));
+        html.endElement();
+        html.endElement();
+        html.startElement(QStringLiteral("tbody"));
         // rows
-        const bool groupTasks = m_properties.groupByTaskId || m_properties.groupByTaskIdAndComments;
+        const bool groupTasks = properties.groupByTaskId || properties.groupByTaskIdAndComments;
         int groupTotalSeconds = 0;
         for (auto it = matchingEvents.constBegin(), end = matchingEvents.constEnd(); it != end;
              ++it) {
+            if (request.isCanceled())
+                return QString();
             const EventId id(*it);
-            const Event &event = DATAMODEL->eventForId(id);
+            const Event &event = model->eventForId(id);
             Q_ASSERT(event.isValid());
             bool nextMatch = false;
 
             if (groupTasks) {
                 const auto next(it + 1);
                 const EventId nextId(next != end ? *next : 0);
-                const Event &nextEvent(DATAMODEL->eventForId(nextId));
+                const Event &nextEvent(model->eventForId(nextId));
 
                 nextMatch = event.taskId() == nextEvent.taskId();
 
-                if (nextMatch && m_properties.groupByTaskIdAndComments)
+                if (nextMatch && properties.groupByTaskIdAndComments)
                     nextMatch = Charm::collatorCompare(event.comment(), nextEvent.comment()) == 0;
 
                 groupTotalSeconds += event.duration();
@@ -424,60 +496,48 @@ void ActivityReport::slotUpdate()
                     continue;
             }
 
-            const TaskTreeItem &item = DATAMODEL->taskTreeItem(event.taskId());
+            const TaskTreeItem &item = model->taskTreeItem(event.taskId());
             const Task &task = item.task();
             Q_ASSERT(task.isValid());
 
             const auto paddedId = QStringLiteral("%1").arg(QString::number(
                                                                task.id()).trimmed(),
-                                                           Configuration::instance().taskPaddingLength,
+                                                           taskPaddingLength,
                                                            QLatin1Char('0'));
 
-            QStringList row1Texts;
+            QString attributesText;
 
             if (groupTasks) {
-                row1Texts = QStringList {
-                    tr("%1 -- [%2] %3")
+                attributesText = tr("%1 -- [%2] %3")
                     .arg(hoursAndMinutes(groupTotalSeconds),
                          paddedId,
-                         m_properties.showFullDescription ? DATAMODEL->fullTaskName(
-                             task) : task.name().trimmed())
-                };
+                         properties.showFullDescription ? model->fullTaskName(
+                             task) : task.name().trimmed());
             } else {
-                row1Texts = QStringList {
-                    tr("%1 %2-%3 (%4) -- [%5] %6")
+                attributesText = tr("%1 %2-%3 (%4) -- [%5] %6")
                     .arg(event.startDateTime().date().toString(Qt::SystemLocaleShortDate).trimmed(),
                          event.startDateTime().time().toString(Qt::SystemLocaleShortDate).trimmed(),
                          event.endDateTime().time().toString(Qt::SystemLocaleShortDate).trimmed(),
                          hoursAndMinutes(event.duration()),
                          paddedId,
-                         m_properties.showFullDescription ? DATAMODEL->fullTaskName(
-                             task) : task.name().trimmed())
-                };
+                         properties.showFullDescription ? model->fullTaskName(
+                             task) : task.name().trimmed());
             }
 
-            QDomElement row1 = doc.createElement(QStringLiteral("tr"));
-            row1.setAttribute(QStringLiteral("class"), QStringLiteral("event_attributes_row"));
-            QDomElement row2 = doc.createElement(QStringLiteral("tr"));
-            for (int index = 0; index < NumberOfColumns; ++index) {
-                QDomElement cell = doc.createElement(QStringLiteral("td"));
-                cell.setAttribute(QStringLiteral("class"), QStringLiteral("event_attributes"));
-                QDomText text = doc.createTextNode(row1Texts[index]);
-                cell.appendChild(text);
-                row1.appendChild(cell);
-            }
-            QDomElement cell2 = doc.createElement(QStringLiteral("td"));
-            cell2.setAttribute(QStringLiteral("class"), QStringLiteral("event_description"));
-            cell2.setAttribute(QStringLiteral("align"), QStringLiteral("left"));
-            QDomElement preElement = doc.createElement(QStringLiteral("pre"));
-            QDomText preText = doc.createTextNode(
-                m_properties.groupByTaskId ? QString() : event.comment());
-            preElement.appendChild(preText);
-            cell2.appendChild(preElement);
-            row2.appendChild(cell2);
-
-            tableBody.appendChild(row1);
-            tableBody.appendChild(row2);
+            html.startRow(QStringLiteral("event_attributes_row"));
+            html.startElement(QStringLiteral("td"));
+            html.writeAttribute(QStringLiteral("class"), QStringLiteral("event_attributes"));
+            html.writeText(attributesText);
+            html.endElement();
+            html.endElement();
+            html.startRow();
+            html.startElement(QStringLiteral("td"));
+            html.writeAttribute(QStringLiteral("class"), QStringLiteral("event_description"));
+            html.writeAttribute(QStringLiteral("align"), QStringLiteral("left"));
+            html.writeTextElement(QStringLiteral("pre"),
+                                  properties.groupByTaskId ? QString() : event.comment());
+            html.endElement();
+            html.endElement();
 
             if (groupTasks) {
                 if (!nextMatch)
@@ -486,43 +546,11 @@ void ActivityReport::slotUpdate()
         }
     }
 
-    // NOTE: seems like the style sheet has to be set before the html
-    // code is pushed into the QTextDocument
-    report->setDefaultStyleSheet(Charm::reportStylesheet(palette()));
-
-    report->setHtml(doc.toString());
-    setDocument(report);
+    return html.endReport();
 }
 
 void ActivityReport::slotLinkClicked(const QUrl &which)
 {
     const int direction = which.toString() == QLatin1String("Previous") ? -1 : 1;
-    switch (m_properties.timeSpanSelection.timeSpanType) {
-    case Day:
-        m_properties.start = m_properties.start.addDays(1 * direction);
-        m_properties.end = m_properties.end.addDays(1 * direction);
-        break;
-    case Week:
-        m_properties.start = m_properties.start.addDays(7 * direction);
-        m_properties.end = m_properties.end.addDays(7 * direction);
-        break;
-    case Month:
-        m_properties.start = m_properties.start.addMonths(1 * direction);
-        m_properties.end = m_properties.end.addMonths(1 * direction);
-        break;
-    case Year:
-        m_properties.start = m_properties.start.addYears(1 * direction);
-        m_properties.end = m_properties.end.addYears(1 * direction);
-        break;
-    case Range:
-    {
-        const int spanRange = m_properties.start.daysTo(m_properties.end);
-        m_properties.start = m_properties.start.addDays(spanRange * direction);
-        m_properties.end = m_properties.end.addDays(spanRange * direction);
-        break;
-    }
-    default:
-        Q_ASSERT(false);   // should not happen
-    }
-    setReportProperties(m_properties);
+    setReportProperties(shiftedProperties(m_properties, direction));
 }
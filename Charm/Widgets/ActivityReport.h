@@ -100,7 +100,12 @@ private Q_SLOTS:
     void slotLinkClicked(const QUrl &which);
 
 private:
-    void slotUpdate() override;
+    QString suggestedFileName() const override;
+    void saveToCsv(CsvWriter &writer) override;
+    Report report(int offset) override;
+    static QString reportHtml(const ReportGenerator::Request &request,
+                              const ActivityReportConfigurationDialog::Properties &properties,
+                              const QString &userName, int taskPaddingLength);
 
 private:
     ActivityReportConfigurationDialog::Properties m_properties;
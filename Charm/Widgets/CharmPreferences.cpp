@@ -100,6 +100,7 @@ CharmPreferences::CharmPreferences(const Configuration &config, QWidget *parent_
     }
 
     m_ui.sbNumberOfTaskSelectorEntries->setValue(config.numberOfTaskSelectorEntries);
+    m_ui.sbArchiveEventsAfterMonths->setValue(config.archiveEventsAfterMonths);
 
     // resize( minimumSize() );
 }
@@ -133,6 +134,11 @@ int CharmPreferences::numberOfTaskSelectorEntries() const
     return m_ui.sbNumberOfTaskSelectorEntries->value();
 }
 
+int CharmPreferences::archiveEventsAfterMonths() const
+{
+    return m_ui.sbArchiveEventsAfterMonths->value();
+}
+
 Configuration::DurationFormat CharmPreferences::durationFormat() const
 {
     switch (m_ui.cbDurationFormat->currentIndex()) {
@@ -43,6 +43,7 @@ public:
     bool requestEventComment() const;
     bool enableCommandInterface() const;
     int numberOfTaskSelectorEntries() const;
+    int archiveEventsAfterMonths() const;
 
     Qt::ToolButtonStyle toolButtonStyle() const;
 
@@ -214,6 +214,9 @@ void EventView::timeSpansChanged()
 void EventView::commitCommand(CharmCommand *command)
 {
     command->finalize();
+    // commands on the undo stack are owned by it:
+    if (m_unstagedCommands.remove(command))
+        command->deleteLater();
 }
 
 void EventView::slotCurrentItemChanged(const QModelIndex &start, const QModelIndex &)
@@ -560,7 +563,8 @@ void EventView::slotEventChangesCompleted(const Event &event)
 {
     // make event editor finished, bypass the undo stack to set its contents
     // undo will just target CommandMakeEvent instead
+    // the command is executed asynchronously, it is deleted once it has been committed:
     auto command = new CommandModifyEvent(event, event, this);
+    m_unstagedCommands.insert(command);
     emitCommand(command);
-    delete command;
 }
@@ -28,6 +28,7 @@
 #include <QAction>
 #include <QUndoStack>
 #include <QDialog>
+#include <QSet>
 
 #include "Core/UIStateInterface.h"
 #include "Core/Event.h"
@@ -116,6 +117,8 @@ private:
     QComboBox *m_comboBox;
     QLabel *m_labelTotal;
     QListView *m_listView;
+    // commands sent without the undo stack, until they have been committed:
+    QSet<CharmCommand *> m_unstagedCommands;
 };
 
 #endif
@@ -23,6 +23,8 @@
 
 #include "MonthlyTimesheet.h"
 #include "Reports/MonthlyTimesheetXmlWriter.h"
+#include "Reports/ReportHtmlWriter.h"
+#include "Reports/TimeAggregator.h"
 
 #include <QFile>
 #include <QMessageBox>
@@ -136,174 +138,145 @@ QByteArray MonthlyTimeSheetReport::saveToXml(SaveToXmlMode mode)
     return QByteArray();
 }
 
-static QDomElement addTblHdr(QDomElement &toRow, const QString &text)
+int MonthlyTimeSheetReport::segmentCount() const
 {
-    QDomElement header = toRow.ownerDocument().createElement(QStringLiteral("th"));
-    QDomText textNode = toRow.ownerDocument().createTextNode(text);
-    header.appendChild(textNode);
-    toRow.appendChild(header);
-    return header;
+    return m_numberOfWeeks;
 }
 
-static QDomElement addTblCell(QDomElement &toRow, const QString &text)
+QString MonthlyTimeSheetReport::segmentName(int segment) const
 {
-    QDomElement cell = toRow.ownerDocument().createElement(QStringLiteral("td"));
-    cell.setAttribute(QStringLiteral("align"), QStringLiteral("center"));
-    QDomText textNode = toRow.ownerDocument().createTextNode(text);
-    cell.appendChild(textNode);
-    toRow.appendChild(cell);
-    return cell;
+    return tr("Week %1").arg(startDate().addDays(segment * 7).weekNumber(), 2, 10,
+                             QLatin1Char('0'));
 }
 
-void MonthlyTimeSheetReport::update()
+ReportPreviewWindow::Report MonthlyTimeSheetReport::report(int offset)
 {
-    // this creates the time sheet
+    // this creates the time sheet, in a worker thread:
+    Properties properties = this->properties();
+    properties.start = properties.start.addMonths(offset);
+    properties.end = properties.end.addMonths(offset);
+    const int monthNumber = properties.start.month();
+    const int numberOfWeeks = Charm::weekDifference(properties.start,
+                                                    properties.end.addDays(-1)) + 1;
+    const float dailyHours = m_dailyhours;
+    const QSharedPointer<SecondsMap> secondsMap(new SecondsMap);
+
+    Report report;
+    report.key = QStringLiteral("monthly/%1/").arg(dailyHours) + cacheKey(properties);
+    report.start = QDateTime(properties.start);
+    report.end = QDateTime(properties.end);
+    report.build = [=](const ReportGenerator::Request &request) {
+        return reportHtml(request, properties, monthNumber, numberOfWeeks, dailyHours,
+                          secondsMap.data());
+    };
+    report.finished = [this, secondsMap]() {
+        m_secondsMap = *secondsMap;
+        uploadButton()->setVisible(false);
+        uploadButton()->setEnabled(false);
+    };
+    return report;
+}
+
+QString MonthlyTimeSheetReport::reportHtml(const ReportGenerator::Request &request,
+                                           const Properties &properties, int monthNumber,
+                                           int numberOfWeeks, float dailyHours,
+                                           SecondsMap *secondsMap)
+{
+    const CharmDataModel *model = request.model();
     // retrieve matching events:
     const EventIdList matchingEvents
-        = DATAMODEL->eventsThatStartInTimeFrame(startDate(), endDate());
-
-    m_secondsMap.clear();
-
-    // for every task, make a vector that includes a number of seconds
-    // for every week of a month ( int seconds[m_numberOfWeeks]), and store those in
-    // a map by their task id
-    Q_FOREACH (EventId id, matchingEvents) {
-        const Event &event = DATAMODEL->eventForId(id);
-        QVector<int> seconds(m_numberOfWeeks);
-        if (m_secondsMap.contains(event.taskId()))
-            seconds = m_secondsMap.value(event.taskId());
-        // what week of the month is the event (normalized to vector indexes):
-        const int weekOfMonth = Charm::weekDifference(startDate(), event.startDateTime().date());
-        seconds[weekOfMonth] += event.duration();
-        // store in minute map:
-        m_secondsMap[event.taskId()] = seconds;
-    }
+        = model->eventsThatStartInTimeFrame(properties.start, properties.end);
+
+    // for every task, sum up the seconds for every week of the month:
+    TimeAggregator aggregator(numberOfWeeks, TimeAggregator::weekOfMonth(properties.start));
+    aggregator.addEvents(model, matchingEvents);
+    *secondsMap = aggregator.secondsMap();
+    if (request.isCanceled())
+        return QString();
+    // retrieve the information for the report:
+    TimeSheetInfoList timeSheetInfo = TimeSheetInfo::filteredTaskWithSubTasks(
+        aggregator.taskWithSubTasks(model, properties.rootTask), properties.activeTasksOnly);
+
     // now the reporting:
+    ReportHtmlWriter html(2048 + (400 + 100 * numberOfWeeks) * timeSheetInfo.size());
     // headline first:
-    QTextDocument report;
-    QDomDocument doc = createReportTemplate();
-    QDomElement root = doc.documentElement();
-    QDomElement body = root.firstChildElement(QStringLiteral("body"));
-
-//     QTextCursor cursor( m_report );
-    // create the caption:
-    {
-        QDomElement headline = doc.createElement(QStringLiteral("h1"));
-        QDomText text = doc.createTextNode(tr("Monthly Time Sheet"));
-        headline.appendChild(text);
-        body.appendChild(headline);
-    }
+    html.startReport(tr("Monthly Time Sheet"));
     {
-        QDomElement headline = doc.createElement(QStringLiteral("h3"));
         QString content = tr("Report for %1, %2 %3 (%4 to %5)")
-                          .arg(CONFIGURATION.user.name(),
-                               QDate::longMonthName(m_monthNumber),
-                               QString::number(startDate().year()),
-                               startDate().toString(Qt::TextDate),
-                               endDate().addDays(-1).toString(Qt::TextDate));
-        QDomText text = doc.createTextNode(content);
-        headline.appendChild(text);
-        body.appendChild(headline);
-        QDomElement previousLink = doc.createElement(QStringLiteral("a"));
-        previousLink.setAttribute(QStringLiteral("href"), QStringLiteral("Previous"));
-        QDomText previousLinkText = doc.createTextNode(tr("<Previous Month>"));
-        previousLink.appendChild(previousLinkText);
-        body.appendChild(previousLink);
-        QDomElement nextLink = doc.createElement(QStringLiteral("a"));
-        nextLink.setAttribute(QStringLiteral("href"), QStringLiteral("Next"));
-        QDomText nextLinkText = doc.createTextNode(tr("<Next Month>"));
-        nextLink.appendChild(nextLinkText);
-        body.appendChild(nextLink);
-        QDomElement paragraph = doc.createElement(QStringLiteral("br"));
-        body.appendChild(paragraph);
+                          .arg(properties.userName,
+                               QDate::longMonthName(monthNumber),
+                               QString::number(properties.start.year()),
+                               properties.start.toString(Qt::TextDate),
+                               properties.end.addDays(-1).toString(Qt::TextDate));
+        html.writeTextElement(QStringLiteral("h3"), content);
+        html.writeNavigationLinks(tr("<Previous Month>"), tr("<Next Month>"));
+        html.writeEmptyElement(QStringLiteral("br"));
     }
     {
         // now for a table
-        // retrieve the information for the report:
-        // TimeSheetInfoList timeSheetInfo = taskWithSubTasks( m_rootTask, m_secondsMap );
-        TimeSheetInfoList timeSheetInfo = TimeSheetInfo::filteredTaskWithSubTasks(
-            TimeSheetInfo::taskWithSubTasks(DATAMODEL, m_numberOfWeeks, rootTask(), secondsMap()),
-            activeTasksOnly());
-
-        QDomElement table = doc.createElement(QStringLiteral("table"));
-        table.setAttribute(QStringLiteral("width"), QStringLiteral("100%"));
-        table.setAttribute(QStringLiteral("align"), QStringLiteral("left"));
-        table.setAttribute(QStringLiteral("cellpadding"), QStringLiteral("3"));
-        table.setAttribute(QStringLiteral("cellspacing"), QStringLiteral("0"));
-        body.appendChild(table);
-
-        TimeSheetInfo totalsLine(m_numberOfWeeks);
+        html.startTable();
+
+        TimeSheetInfo totalsLine(numberOfWeeks);
         if (!timeSheetInfo.isEmpty()) {
             totalsLine = timeSheetInfo.first();
-            if (rootTask() == 0)
+            if (properties.rootTask == 0)
                 timeSheetInfo.removeAt(0);   // there is always one, because there is always the root item
         }
 
         {   //Header Row
-            QDomElement headerRow = doc.createElement(QStringLiteral("tr"));
-            headerRow.setAttribute(QStringLiteral("class"), QStringLiteral("header_row"));
-            table.appendChild(headerRow);
-            addTblHdr(headerRow, tr("Task"));
-            for (int i = 0; i < m_numberOfWeeks; ++i)
-                addTblHdr(headerRow, tr("Week"));
-            addTblHdr(headerRow, tr("Total"));
-            addTblHdr(headerRow, tr("Days"));
+            html.startTableHeader();
+            html.startRow(QStringLiteral("header_row"));
+            html.writeHeaderCell(tr("Task"));
+            for (int i = 0; i < numberOfWeeks; ++i)
+                html.writeHeaderCell(tr("Week"));
+            html.writeHeaderCell(tr("Total"));
+            html.writeHeaderCell(tr("Days"));
+            html.endElement();
         }
 
         {   //Header day row
-            QDomElement headerDayRow = doc.createElement(QStringLiteral("tr"));
-            headerDayRow.setAttribute(QStringLiteral("class"), QStringLiteral("header_row"));
-            table.appendChild(headerDayRow);
-            addTblHdr(headerDayRow, QString());
-            for (int i = 0; i < m_numberOfWeeks; ++i) {
-                QString label = tr("%1").arg(startDate().addDays(
+            html.startRow(QStringLiteral("header_row"));
+            html.writeHeaderCell(QString());
+            for (int i = 0; i < numberOfWeeks; ++i) {
+                QString label = tr("%1").arg(properties.start.addDays(
                                                  i * 7).weekNumber(), 2, 10, QLatin1Char('0'));
-                addTblHdr(headerDayRow, label);
+                html.writeHeaderCell(label);
             }
-            addTblHdr(headerDayRow, QString());
-            addTblHdr(headerDayRow, QString::number(m_dailyhours) + tr(" hours"));
+            html.writeHeaderCell(QString());
+            html.writeHeaderCell(QString::number(dailyHours) + tr(" hours"));
+            html.endElement();
+            html.endElement();
         }
 
+        const QString center = QStringLiteral("center");
         for (int i = 0; i < timeSheetInfo.size(); ++i) {
-            QDomElement row = doc.createElement(QStringLiteral("tr"));
-            if (i % 2)
-                row.setAttribute(QStringLiteral("class"), QStringLiteral("alternate_row"));
-            table.appendChild(row);
-
-            QDomElement taskCell
-                = addTblCell(row,
-                             timeSheetInfo[i].formattedTaskIdAndName(
-                                 CONFIGURATION.taskPaddingLength));
-            taskCell.setAttribute(QStringLiteral("align"), QStringLiteral("left"));
-            taskCell.setAttribute(QStringLiteral("style"), QStringLiteral("text-indent: %1px;")
-                                  .arg(9 * timeSheetInfo[i].indentation));
-            for (int week = 0; week < m_numberOfWeeks; ++week)
-                addTblCell(row, hoursAndMinutes(timeSheetInfo[i].seconds[week]));
-            addTblCell(row, hoursAndMinutes(timeSheetInfo[i].total()));
-            addTblCell(row, QString::number(timeSheetInfo[i].total() / SecondsInDay, 'f', 1));
+            html.startRow(i % 2 ? QStringLiteral("alternate_row") : QString());
+
+            html.startElement(QStringLiteral("td"));
+            html.writeAttribute(QStringLiteral("align"), QStringLiteral("left"));
+            html.writeAttribute(QStringLiteral("style"), QStringLiteral("text-indent: %1px;")
+                                .arg(9 * timeSheetInfo[i].indentation));
+            html.writeText(timeSheetInfo[i].formattedTaskIdAndName(properties.taskPaddingLength));
+            html.endElement();
+            for (int week = 0; week < numberOfWeeks; ++week)
+                html.writeCell(hoursAndMinutes(timeSheetInfo[i].seconds[week]), center);
+            html.writeCell(hoursAndMinutes(timeSheetInfo[i].total()), center);
+            html.writeCell(QString::number(timeSheetInfo[i].total() / SecondsInDay, 'f', 1), center);
+            html.endElement();
         }
 
         {   // Totals row
-            QDomElement totals = doc.createElement(QStringLiteral("tr"));
-            totals.setAttribute(QStringLiteral("class"), QStringLiteral("header_row"));
-            table.appendChild(totals);
-
-            addTblHdr(totals, tr("Total:"));
-            for (int i = 0; i < m_numberOfWeeks; ++i)
-                addTblHdr(totals, hoursAndMinutes(totalsLine.seconds[i]));
-            addTblHdr(totals, hoursAndMinutes(totalsLine.total()));
-            addTblHdr(totals, QString::number(totalsLine.total() / SecondsInDay, 'f', 1));
+            html.startRow(QStringLiteral("header_row"));
+            html.writeHeaderCell(tr("Total:"));
+            for (int i = 0; i < numberOfWeeks; ++i)
+                html.writeHeaderCell(hoursAndMinutes(totalsLine.seconds[i]));
+            html.writeHeaderCell(hoursAndMinutes(totalsLine.total()));
+            html.writeHeaderCell(QString::number(totalsLine.total() / SecondsInDay, 'f', 1));
+            html.endElement();
         }
     }
 
-    // NOTE: seems like the style sheet has to be set before the html
-    // code is pushed into the QTextDocument
-    report.setDefaultStyleSheet(Charm::reportStylesheet(palette()));
-
-    report.setHtml(doc.toString());
-    setDocument(&report);
-    uploadButton()->setVisible(false);
-    uploadButton()->setEnabled(false);
+    return html.endReport();
 }
 
 void MonthlyTimeSheetReport::slotLinkClicked(const QUrl &which)
@@ -46,9 +46,14 @@ private Q_SLOTS:
 
 private:
     QString suggestedFileName() const override;
-    void update() override;
+    Report report(int offset) override;
+    static QString reportHtml(const ReportGenerator::Request &request,
+                              const Properties &properties, int monthNumber, int numberOfWeeks,
+                              float dailyHours, SecondsMap *secondsMap);
     QByteArray saveToText() override;
     QByteArray saveToXml(SaveToXmlMode mode) override;
+    int segmentCount() const override;
+    QString segmentName(int segment) const override;
 
 private:
     // properties of the report:
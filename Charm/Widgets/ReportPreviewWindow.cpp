@@ -22,8 +22,20 @@
 */
 
 #include "ReportPreviewWindow.h"
+#include "ApplicationCore.h"
 #include "ViewHelpers.h"
 
+#include "Core/Configuration.h"
+#include "Core/CsvWriter.h"
+
+#include <QDir>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QSaveFile>
+#include <QSettings>
+
+#include <algorithm>
+
 #ifndef QT_NO_PRINTER
 #include <QPrinter>
 #include <QPrintDialog>
@@ -45,19 +57,30 @@ ReportPreviewWindow::ReportPreviewWindow(QWidget *parent)
             this, &ReportPreviewWindow::slotSaveToXml);
     connect(m_ui->pushButtonSaveTotals, &QPushButton::clicked,
             this, &ReportPreviewWindow::slotSaveToText);
+    connect(m_ui->pushButtonSaveCsv, &QPushButton::clicked,
+            this, &ReportPreviewWindow::slotSaveToCsv);
     connect(m_ui->textBrowser, &QTextBrowser::anchorClicked,
             this, &ReportPreviewWindow::anchorClicked);
+    connect(m_ui->pushButtonPreviousPage, &QPushButton::clicked,
+            this, &ReportPreviewWindow::slotPreviousPage);
+    connect(m_ui->pushButtonNextPage, &QPushButton::clicked,
+            this, &ReportPreviewWindow::slotNextPage);
+    m_ui->widgetPages->hide();
 #ifndef QT_NO_PRINTER
     connect(m_ui->pushButtonPrint, &QPushButton::clicked,
             this, &ReportPreviewWindow::slotPrint);
 #else
     m_ui->pushButtonPrint->setEnabled(false);
 #endif
+    // there is nothing to print or save before the first report is shown:
+    setDocumentActionsEnabled(false);
+
+    m_placeholder.setHtml(QStringLiteral("<h3>%1</h3>").arg(tr("Generating the report...")));
 
     m_updateTimer.setInterval(60 * 1000);
     m_updateTimer.start();
     connect(&m_updateTimer, &QTimer::timeout,
-            this, &ReportPreviewWindow::slotUpdate);
+            this, &ReportPreviewWindow::slotPeriodicUpdate);
 
     resize(850, 600);
 }
@@ -70,33 +93,162 @@ void ReportPreviewWindow::setDocument(const QTextDocument *document)
 {
     if (document != nullptr) {
         // we keep a copy, to be able to show different versions of the same document
-        QScopedPointer<QTextDocument> docClone(document->clone());
-        m_document.swap(docClone);
-        m_ui->textBrowser->setDocument(m_document.data());
+        showPages(QSharedPointer<QTextDocument>(document->clone()), 0);
     } else {
         m_ui->textBrowser->setDocument(nullptr);
+        m_ui->widgetPages->hide();
+        m_pages = ReportPages();
+        m_pageDocument.reset();
         m_document.reset();
+        setDocumentActionsEnabled(false);
     }
 }
 
-QDomDocument ReportPreviewWindow::createReportTemplate() const
+ReportPreviewWindow::Report ReportPreviewWindow::report(int offset)
 {
-    // create XHTML v1.0 structure:
-    QDomDocument doc(QStringLiteral("html"));
-    // FIXME this is only a rudimentary subset of a valid xhtml 1 document
+    Q_UNUSED(offset);
+    return Report();
+}
 
-    // html element
-    QDomElement html = doc.createElement(QStringLiteral("html"));
-    html.setAttribute(QStringLiteral("xmlns"), QStringLiteral("http://www.w3.org/1999/xhtml"));
-    doc.appendChild(html);
+void ReportPreviewWindow::generateReport()
+{
+    // cached reports are only valid for the settings they were laid out with:
+    const QString styleSheet = Charm::reportStylesheet(palette());
+    const QString settings = styleSheet + QString::number(CONFIGURATION.durationFormat);
+    if (settings != m_cacheSettings) {
+        m_cache.clear();
+        m_cacheSettings = settings;
+        m_styleSheet = styleSheet;
+    }
 
-    // head and body, children of html
-    QDomElement head = doc.createElement(QStringLiteral("head"));
-    html.appendChild(head);
-    QDomElement body = doc.createElement(QStringLiteral("body"));
-    html.appendChild(body);
+    const Report report = this->report(0);
+    const quint64 revision = DATAMODEL->revision(report.start, report.end);
+    m_currentKey = report.key;
+    m_prefetchQueue.clear();
+
+    const ReportCache::Entry cached = report.key.isEmpty() ? ReportCache::Entry()
+                                      : m_cache.find(report.key, revision);
+    if (cached.document) {
+        m_generator.cancel();
+        showDocument(cached);
+        prefetchAdjacentReports();
+        return;
+    }
 
-    return doc;
+    if (m_showPlaceholder || !m_document) {
+        m_ui->textBrowser->setDocument(&m_placeholder);
+        m_ui->widgetPages->hide();
+        setDocumentActionsEnabled(false);
+    }
+
+    if (m_prefetcher.isRunning() && !report.key.isEmpty() && m_prefetchKey == report.key
+        && m_prefetchRevision == revision) {
+        // the report is being prefetched already, it is shown when it is ready:
+        m_generator.cancel();
+        return;
+    }
+
+    m_prefetcher.cancel();
+    m_prefetchKey.clear();
+    m_generator.start(DATAMODEL, m_styleSheet, report.build,
+                      [this, report, revision](QTextDocument *document) {
+        reportBuilt(report, revision, document);
+    }, archivedEventsReader(report));
+}
+
+void ReportPreviewWindow::showDocument(const ReportCache::Entry &entry)
+{
+    // updates of the report that is shown stay on the same page:
+    const bool sameReport = !m_currentKey.isEmpty() && m_currentKey == m_shownKey;
+    m_shownKey = m_currentKey;
+    showPages(entry.document, sameReport ? m_page : 0);
+    if (entry.finished)
+        entry.finished();
+}
+
+void ReportPreviewWindow::showPages(const QSharedPointer<QTextDocument> &document, int page)
+{
+    m_pages = ReportPages(document);
+    showPage(std::min(page, m_pages.pageCount() - 1));
+    // the browser lets go of the previous document before it may be deleted:
+    m_document = document;
+    setDocumentActionsEnabled(true);
+}
+
+void ReportPreviewWindow::setDocumentActionsEnabled(bool enabled)
+{
+    // the save functions of the reports use the data of the document that is shown:
+    m_ui->pushButtonSave->setEnabled(enabled);
+    m_ui->pushButtonSaveTotals->setEnabled(enabled);
+    m_ui->pushButtonSaveCsv->setEnabled(enabled);
+#ifndef QT_NO_PRINTER
+    m_ui->pushButtonPrint->setEnabled(enabled);
+#endif
+}
+
+void ReportPreviewWindow::showPage(int page)
+{
+    // only the page is laid out by the browser, printing uses the complete document:
+    m_page = page;
+    const QSharedPointer<QTextDocument> document = m_pages.page(page);
+    m_ui->textBrowser->setDocument(document.data());
+    m_pageDocument = document;
+
+    const int pageCount = m_pages.pageCount();
+    m_ui->widgetPages->setVisible(pageCount > 1);
+    m_ui->labelPage->setText(tr("Page %1 of %2").arg(page + 1).arg(pageCount));
+    m_ui->pushButtonPreviousPage->setEnabled(page > 0);
+    m_ui->pushButtonNextPage->setEnabled(page + 1 < pageCount);
+}
+
+void ReportPreviewWindow::reportBuilt(const Report &report, quint64 revision,
+                                      QTextDocument *document)
+{
+    const ReportCache::Entry entry { QSharedPointer<QTextDocument>(document), report.finished };
+    if (!report.key.isEmpty())
+        m_cache.insert(report.key, revision, entry);
+
+    if (report.key == m_currentKey) {
+        showDocument(entry);
+        prefetchAdjacentReports();
+    } else {
+        prefetchNextReport();
+    }
+}
+
+ReportGenerator::EventSource ReportPreviewWindow::archivedEventsReader(const Report &report)
+{
+    if (!report.start.isValid() || !ApplicationCore::hasInstance())
+        return ReportGenerator::EventSource();
+    return ApplicationCore::instance().archivedEventsReader(report.start, report.end);
+}
+
+void ReportPreviewWindow::prefetchAdjacentReports()
+{
+    m_prefetchQueue.clear();
+    if (m_currentKey.isEmpty())
+        return;
+    m_prefetchQueue << report(-1) << report(1);
+    if (!m_prefetcher.isRunning())
+        prefetchNextReport();
+}
+
+void ReportPreviewWindow::prefetchNextReport()
+{
+    while (!m_prefetchQueue.isEmpty()) {
+        const Report report = m_prefetchQueue.takeFirst();
+        const quint64 revision = DATAMODEL->revision(report.start, report.end);
+        if (report.key.isEmpty() || m_cache.contains(report.key, revision))
+            continue;
+        m_prefetchKey = report.key;
+        m_prefetchRevision = revision;
+        m_prefetcher.start(DATAMODEL, m_styleSheet, report.build,
+                           [this, report, revision](QTextDocument *document) {
+            m_prefetchKey.clear();
+            reportBuilt(report, revision, document);
+        }, archivedEventsReader(report));
+        return;
+    }
 }
 
 QPushButton *ReportPreviewWindow::saveToXmlButton() const
@@ -109,11 +261,47 @@ QPushButton *ReportPreviewWindow::saveToTextButton() const
     return m_ui->pushButtonSaveTotals;
 }
 
+QPushButton *ReportPreviewWindow::saveToCsvButton() const
+{
+    return m_ui->pushButtonSaveCsv;
+}
+
 QPushButton *ReportPreviewWindow::uploadButton() const
 {
     return m_ui->pushButtonUpload;
 }
 
+QString ReportPreviewWindow::suggestedFileName() const
+{
+    return QString();
+}
+
+QString ReportPreviewWindow::getFileName(const QString &filter)
+{
+    QSettings settings;
+    QString path;
+    if (settings.contains(MetaKey_ReportsRecentSavePath)) {
+        path = settings.value(MetaKey_ReportsRecentSavePath).toString();
+        QDir dir(path);
+        if (!dir.exists()) path = QString();
+    }
+    // suggest file name:
+    path += QDir::separator() + suggestedFileName();
+    // ask:
+    QString filename = QFileDialog::getSaveFileName(this, tr("Enter File Name"), path, filter);
+    if (filename.isEmpty())
+        return QString();
+    QFileInfo fileinfo(filename);
+    path = fileinfo.absolutePath();
+    if (!path.isEmpty())
+        settings.setValue(MetaKey_ReportsRecentSavePath, path);
+    return filename;
+}
+
+void ReportPreviewWindow::saveToCsv(CsvWriter &)
+{
+}
+
 void ReportPreviewWindow::slotSaveToXml()
 {
 }
@@ -122,9 +310,39 @@ void ReportPreviewWindow::slotSaveToText()
 {
 }
 
+void ReportPreviewWindow::slotSaveToCsv()
+{
+    // first, ask for a file name:
+    QString filename = getFileName(tr("Comma separated values (*.csv);;"
+                                      "Tab separated values (*.tsv)"));
+    if (filename.isEmpty())
+        return;
+
+    QFileInfo fileinfo(filename);
+    if (fileinfo.suffix().isEmpty())
+        filename += QLatin1String(".csv");
+
+    // the rows are written into the file as they are generated:
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+        QMessageBox::critical(this, tr("Error saving report"),
+                              tr("Cannot write to selected location:\n%1")
+                              .arg(file.errorString()));
+        return;
+    }
+    CsvWriter writer(&file, CsvWriter::formatForFileName(filename));
+    saveToCsv(writer);
+    if (!writer.flush() || !file.commit())
+        QMessageBox::critical(this, tr("Error saving report"),
+                              tr("Cannot write to selected location:\n%1")
+                              .arg(file.errorString()));
+}
+
 void ReportPreviewWindow::slotPrint()
 {
 #ifndef QT_NO_PRINTER
+    if (!m_document)
+        return;
     QPrinter printer;
     QPrintDialog dialog(&printer, this);
 
@@ -136,6 +354,26 @@ void ReportPreviewWindow::slotPrint()
 
 void ReportPreviewWindow::slotUpdate()
 {
+    generateReport();
+}
+
+void ReportPreviewWindow::slotPeriodicUpdate()
+{
+    m_showPlaceholder = false;
+    slotUpdate();
+    m_showPlaceholder = true;
+}
+
+void ReportPreviewWindow::slotPreviousPage()
+{
+    if (m_page > 0)
+        showPage(m_page - 1);
+}
+
+void ReportPreviewWindow::slotNextPage()
+{
+    if (m_page + 1 < m_pages.pageCount())
+        showPage(m_page + 1);
 }
 
 void ReportPreviewWindow::slotClose()
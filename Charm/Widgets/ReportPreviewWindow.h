@@ -24,16 +24,23 @@
 #ifndef REPORTPREVIEWWINDOW_H
 #define REPORTPREVIEWWINDOW_H
 
+#include <QDateTime>
 #include <QDialog>
-#include <QDomDocument>
+#include <QList>
 #include <QScopedPointer>
+#include <QSharedPointer>
 #include <QTextDocument>
 #include <QTimer>
 
+#include "Reports/ReportCache.h"
+#include "Reports/ReportGenerator.h"
+#include "Reports/ReportPages.h"
+
 namespace Ui {
 class ReportPreviewWindow;
 }
 
+class CsvWriter;
 class QPushButton;
 
 class ReportPreviewWindow : public QDialog
@@ -48,10 +55,41 @@ Q_SIGNALS:
     void anchorClicked(const QUrl &which);
 
 protected:
+    /** A report, as built by a ReportGenerator. */
+    struct Report {
+        /** Identifies the report type, time range and filters, see ReportCache. */
+        QString key;
+        /** The time range of the report. Archived events in it are added to the data the
+            report is built from, see ApplicationCore::archivedEventsReader(). Cached reports stay
+            valid while the events in the range do not change, see CharmDataModel::revision(). */
+        QDateTime start;
+        QDateTime end;
+        ReportGenerator::Builder build;
+        /** Called whenever the document of the report is shown. */
+        std::function<void()> finished;
+    };
+
     void setDocument(const QTextDocument *document);
-    QDomDocument createReportTemplate() const;
+    /** The report @p offset periods away from the current one, for example -1 for the
+     *  previous week of a weekly timesheet. Reports without a key are not cached. */
+    virtual Report report(int offset);
+    /** Show the current report, from the cache if it was built from the current data before.
+     *  Otherwise the report is built in a worker thread, see ReportGenerator, and a placeholder
+     *  is shown until the document is ready, except for the periodic updates, which keep
+     *  showing the current document. Afterwards the adjacent reports are built in the
+     *  background, so that the Previous and Next links show them immediately.
+     *  Reports with long tables are previewed page by page, see ReportPages. */
+    void generateReport();
+    /** The name suggested when saving the report, without a suffix. */
+    virtual QString suggestedFileName() const;
+    /** Ask for the name of the file to save the report in, see suggestedFileName(). */
+    QString getFileName(const QString &filter);
+    /** Write the report as a table of comma or tab separated values, row by row. The
+     *  default writes nothing. */
+    virtual void saveToCsv(CsvWriter &writer);
     QPushButton *saveToXmlButton() const;
     QPushButton *saveToTextButton() const;
+    QPushButton *saveToCsvButton() const;
     QPushButton *uploadButton() const;
 
     QTimer m_updateTimer;
@@ -59,13 +97,42 @@ protected:
 private Q_SLOTS:
     virtual void slotSaveToXml();
     virtual void slotSaveToText();
+    void slotSaveToCsv();
     virtual void slotPrint();
     virtual void slotUpdate();
     virtual void slotClose();
+    void slotPeriodicUpdate();
+    void slotPreviousPage();
+    void slotNextPage();
 
 private:
+    void showDocument(const ReportCache::Entry &entry);
+    void showPages(const QSharedPointer<QTextDocument> &document, int page);
+    void showPage(int page);
+    /** Enable printing and saving, which need the document and data of a finished report. */
+    void setDocumentActionsEnabled(bool enabled);
+    void reportBuilt(const Report &report, quint64 revision, QTextDocument *document);
+    static ReportGenerator::EventSource archivedEventsReader(const Report &report);
+    void prefetchAdjacentReports();
+    void prefetchNextReport();
+
     QScopedPointer<Ui::ReportPreviewWindow> m_ui;
-    QScopedPointer<QTextDocument> m_document;
+    QSharedPointer<QTextDocument> m_document;
+    ReportPages m_pages;
+    QSharedPointer<QTextDocument> m_pageDocument;
+    int m_page = 0;
+    QString m_shownKey;
+    QTextDocument m_placeholder;
+    ReportCache m_cache;
+    QString m_cacheSettings;
+    QString m_styleSheet;
+    QString m_currentKey;
+    QList<Report> m_prefetchQueue;
+    QString m_prefetchKey;
+    quint64 m_prefetchRevision = 0;
+    ReportGenerator m_generator;
+    ReportGenerator m_prefetcher;
+    bool m_showPlaceholder = true;
 };
 
 #endif
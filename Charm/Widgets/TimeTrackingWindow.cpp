@@ -36,17 +36,22 @@
 #include "MessageBox.h"
 #include "MonthlyTimesheet.h"
 #include "MonthlyTimesheetConfigurationDialog.h"
+#include "YearlyTimesheetConfigurationDialog.h"
 #include "TemporaryValue.h"
 #include "TimeTrackingView.h"
 #include "ViewHelpers.h"
 #include "WeeklyTimesheet.h"
 
+#include "Commands/CommandExportToBinary.h"
 #include "Commands/CommandExportToXml.h"
+#include "Commands/CommandImportFromBinary.h"
 #include "Commands/CommandImportFromXml.h"
 #include "Commands/CommandMakeEvent.h"
 #include "Commands/CommandModifyEvent.h"
 #include "Commands/CommandSetAllTasks.h"
 
+#include "Core/Controller.h"
+#include "Core/GzipDevice.h"
 #include "Core/TaskListMerger.h"
 #include "Core/TimeSpans.h"
 #include "Core/XmlSerialization.h"
@@ -64,12 +69,14 @@
 
 #include <QBuffer>
 #include <QDir>
+#include <QFile>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMenuBar>
 #include <QMessageBox>
+#include <QProgressDialog>
 #include <QSettings>
 #include <QToolBar>
 #include <QUrlQuery>
@@ -77,6 +84,26 @@
 
 #include <algorithm>
 
+namespace {
+const QString BinaryExportSuffix(QStringLiteral("charmbinaryexport"));
+
+// shows the progress of an import command until it has been finalized
+template<typename ImportCommand>
+void showImportProgress(ImportCommand *command, const QString &fileName, QWidget *parent)
+{
+    auto dialog = new QProgressDialog(QObject::tr("Importing %1...").arg(fileName), QString(), 0,
+                                      100, parent);
+    dialog->setWindowTitle(QObject::tr("Importing"));
+    dialog->setMinimumDuration(500);
+    QObject::connect(command, &ImportCommand::progress, dialog, [dialog](qint64 bytesRead,
+                                                                       qint64 bytesTotal) {
+        if (bytesTotal > 0)
+            dialog->setValue(static_cast<int>(bytesRead * 100 / bytesTotal));
+    });
+    QObject::connect(command, &ImportCommand::finished, dialog, &QObject::deleteLater);
+}
+}
+
 TimeTrackingWindow::TimeTrackingWindow(QWidget *parent)
     : CharmWindow(tr("Time Tracker"), parent)
     , m_summaryWidget(new TimeTrackingView(this))
@@ -311,6 +338,7 @@ void TimeTrackingWindow::slotEditPreferences(bool)
         CONFIGURATION.requestEventComment = dialog.requestEventComment();
         CONFIGURATION.enableCommandInterface = dialog.enableCommandInterface();
         CONFIGURATION.numberOfTaskSelectorEntries = dialog.numberOfTaskSelectorEntries();
+        CONFIGURATION.archiveEventsAfterMonths = dialog.archiveEventsAfterMonths();
         emit saveConfiguration();
     }
 }
@@ -375,6 +403,16 @@ void TimeTrackingWindow::slotMonthlyTimesheetReport()
     m_monthlyTimesheetDialog->open();
 }
 
+void TimeTrackingWindow::slotYearlyTimesheetReport()
+{
+    delete m_yearlyTimesheetDialog;
+    m_yearlyTimesheetDialog = new YearlyTimesheetConfigurationDialog(this);
+    m_yearlyTimesheetDialog->setAttribute(Qt::WA_DeleteOnClose);
+    connect(m_yearlyTimesheetDialog, &YearlyTimesheetConfigurationDialog::finished,
+            this, &TimeTrackingWindow::slotYearlyTimesheetPreview);
+    m_yearlyTimesheetDialog->open();
+}
+
 void TimeTrackingWindow::slotWeeklyTimesheetPreview(int result)
 {
     showPreview(m_weeklyTimesheetDialog, result);
@@ -387,6 +425,12 @@ void TimeTrackingWindow::slotMonthlyTimesheetPreview(int result)
     m_monthlyTimesheetDialog = nullptr;
 }
 
+void TimeTrackingWindow::slotYearlyTimesheetPreview(int result)
+{
+    showPreview(m_yearlyTimesheetDialog, result);
+    m_yearlyTimesheetDialog = nullptr;
+}
+
 void TimeTrackingWindow::slotActivityReportPreview(int result)
 {
     showPreview(m_activityReportDialog, result);
@@ -411,7 +455,19 @@ void TimeTrackingWindow::slotExportToXml()
         if (!dir.exists()) path = QString();
     }
 
-    QString filename = QFileDialog::getSaveFileName(this, tr("Enter File Name"), path);
+    const QString xmlFilter = tr("Charm database export (*.charmdatabaseexport)");
+    const QString compressedXmlFilter = tr(
+        "Compressed Charm database export (*.charmdatabaseexport.gz)");
+    const QString binaryFilter = tr("Charm binary database export (*.%1)").arg(BinaryExportSuffix);
+    QStringList filters;
+    filters << xmlFilter;
+    if (GzipDevice::isCompressionSupported())
+        filters << compressedXmlFilter;
+    filters << binaryFilter;
+    QString selectedFilter = xmlFilter;
+    QString filename = QFileDialog::getSaveFileName(this, tr("Enter File Name"), path,
+                                                    filters.join(QStringLiteral(";;")),
+                                                    &selectedFilter);
     if (filename.isEmpty()) return;
 
     QFileInfo fileinfo(filename);
@@ -420,12 +476,23 @@ void TimeTrackingWindow::slotExportToXml()
     if (!path.isEmpty())
         settings.setValue(MetaKey_ExportToXmlRecentSavePath, path);
 
-    if (fileinfo.suffix().isEmpty())
-        filename += QLatin1String(".charmdatabaseexport");
+    const bool binary = fileinfo.suffix().isEmpty() ? selectedFilter == binaryFilter
+                        : fileinfo.suffix() == BinaryExportSuffix;
+    if (fileinfo.suffix().isEmpty()) {
+        filename += QLatin1Char('.')
+                    + (binary ? BinaryExportSuffix : QStringLiteral("charmdatabaseexport"));
+        // the XML export is compressed if the file name ends in .gz:
+        if (selectedFilter == compressedXmlFilter)
+            filename += QLatin1String(".gz");
+    }
 
-    // get a XML export:
-    CommandExportToXml *command = new CommandExportToXml(filename, this);
-    sendCommand(command);
+    if (binary) {
+        sendCommand(new CommandExportToBinary(filename, this));
+    } else {
+        // get a XML export:
+        CommandExportToXml *command = new CommandExportToXml(filename, this);
+        sendCommand(command);
+    }
 }
 
 void TimeTrackingWindow::slotImportFromXml()
@@ -452,9 +519,25 @@ void TimeTrackingWindow::slotImportFromXml()
                             tr("Cancel")) != QMessageBox::Yes)
         return;
 
+    // binary exports are recognized by their content, whatever the file is called,
+    // compressed exports are decompressed by the import commands:
+    QFile file(filename);
+    GzipDevice device(&file);
+    const bool binary = file.open(QIODevice::ReadOnly) && device.open(QIODevice::ReadOnly)
+                        && Controller::isBinaryDatabaseExport(&device);
+    device.close();
+    file.close();
+
     // ask the controller to import the file:
-    CommandImportFromXml *cmd = new CommandImportFromXml(filename, this);
-    sendCommand(cmd);
+    if (binary) {
+        auto cmd = new CommandImportFromBinary(filename, this);
+        showImportProgress(cmd, fileinfo.fileName(), this);
+        sendCommand(cmd);
+    } else {
+        CommandImportFromXml *cmd = new CommandImportFromXml(filename, this);
+        showImportProgress(cmd, fileinfo.fileName(), this);
+        sendCommand(cmd);
+    }
 }
 
 void TimeTrackingWindow::slotSyncTasks(VerboseMode mode)
@@ -522,7 +605,7 @@ void TimeTrackingWindow::slotImportTasks()
                                                               "Please Select File"),
                                                           QLatin1String(""),
                                                           tr(
-                                                              "Task definitions (*.xml);;All Files (*)"));
+                                                              "Task definitions (*.xml *.xml.gz);;All Files (*)"));
     if (filename.isNull())
         return;
     importTasksFromDeviceOrFile(0, filename);
@@ -535,7 +618,7 @@ void TimeTrackingWindow::slotExportTasks()
                                                               "Please select export filename"),
                                                           QLatin1String(""),
                                                           tr(
-                                                              "Task definitions (*.xml);;All Files (*)"));
+                                                              "Task definitions (*.xml);;Compressed task definitions (*.xml.gz);;All Files (*)"));
     if (filename.isNull()) return;
 
     try {
@@ -740,17 +823,18 @@ void TimeTrackingWindow::importTasksFromDeviceOrFile(QIODevice *device, const QS
             }
         } else {
             auto cmd = new CommandSetAllTasks(merger.mergedTaskList(), this);
+            // the command is executed in the storage thread, report the result once it is finalized:
+            connect(cmd, &CommandSetAllTasks::finished, this, [this, verbose](bool success) {
+                const QString detailsText = success ? tr("The task list has been updated.") : tr(
+                    "Setting the new tasks failed.");
+                const QString title = success ? tr("Tasks Import") : tr("Failure setting new tasks");
+                if (verbose) {
+                    QMessageBox::information(this, title, detailsText);
+                } else if (!success) {
+                    emit showNotification(title, detailsText);
+                }
+            });
             sendCommand(cmd);
-            // At this point the command was finalized and we have a result.
-            const bool success = cmd->finalize();
-            const QString detailsText = success ? tr("The task list has been updated.") : tr(
-                "Setting the new tasks failed.");
-            const QString title = success ? tr("Tasks Import") : tr("Failure setting new tasks");
-            if (verbose) {
-                QMessageBox::information(this, title, detailsText);
-            } else if (!success) {
-                emit showNotification(title, detailsText);
-            }
         }
 
         Lotsofcake::Configuration lotsofcakeConfig;
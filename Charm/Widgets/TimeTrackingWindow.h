@@ -42,6 +42,7 @@ class IdleDetector;
 class ReportConfigurationDialog;
 class WeeklyTimesheetConfigurationDialog;
 class MonthlyTimesheetConfigurationDialog;
+class YearlyTimesheetConfigurationDialog;
 class ActivityReportConfigurationDialog;
 
 class TimeTrackingWindow : public CharmWindow, public CharmDataModelAdapterInterface
@@ -87,6 +88,7 @@ public Q_SLOTS:
     void slotActivityReport();
     void slotWeeklyTimesheetReport();
     void slotMonthlyTimesheetReport();
+    void slotYearlyTimesheetReport();
     void slotExportToXml();
     void slotImportFromXml();
     void slotSyncTasks(VerboseMode mode = Verbose);
@@ -108,6 +110,7 @@ private Q_SLOTS:
     void slotSelectTasksToShow();
     void slotWeeklyTimesheetPreview(int result);
     void slotMonthlyTimesheetPreview(int result);
+    void slotYearlyTimesheetPreview(int result);
     void slotActivityReportPreview(int result);
     void slotCheckUploadedTimesheets();
     void slotBillGone(int result);
@@ -137,6 +140,7 @@ private:
 
     WeeklyTimesheetConfigurationDialog *m_weeklyTimesheetDialog = nullptr;
     MonthlyTimesheetConfigurationDialog *m_monthlyTimesheetDialog = nullptr;
+    YearlyTimesheetConfigurationDialog *m_yearlyTimesheetDialog = nullptr;
     ActivityReportConfigurationDialog *m_activityReportDialog = nullptr;
     TimeTrackingView *m_summaryWidget;
     QVector<WeeklySummary> m_summaries;
@@ -29,6 +29,9 @@
 
 #include "ViewHelpers.h"
 
+#include "Core/CsvWriter.h"
+#include "Core/GzipDevice.h"
+
 #include "CharmCMake.h"
 
 TimeSheetReport::TimeSheetReport(QWidget *parent)
@@ -47,18 +50,66 @@ void TimeSheetReport::setReportProperties(
     m_end = end;
     m_rootTask = rootTask;
     m_activeTasksOnly = activeTasksOnly;
-    update();
+    generateReport();
+}
+
+TimeSheetReport::Properties TimeSheetReport::properties() const
+{
+    Properties properties;
+    properties.start = m_start;
+    properties.end = m_end;
+    properties.rootTask = m_rootTask;
+    properties.activeTasksOnly = m_activeTasksOnly;
+    properties.userName = CONFIGURATION.user.name();
+    properties.taskPaddingLength = CONFIGURATION.taskPaddingLength;
+    return properties;
 }
 
-void TimeSheetReport::slotUpdate()
+QString TimeSheetReport::cacheKey(const Properties &properties)
 {
-    update();
+    return QStringLiteral("%1/%2/%3/%4/%5/").arg(properties.start.toString(Qt::ISODate),
+                                                 properties.end.toString(Qt::ISODate),
+                                                 QString::number(properties.rootTask),
+                                                 QString::number(properties.activeTasksOnly),
+                                                 QString::number(properties.taskPaddingLength))
+           + properties.userName;
+}
+
+void TimeSheetReport::saveToCsv(CsvWriter &writer)
+{
+    const int segments = segmentCount();
+    QStringList columns;
+    columns << QStringLiteral("Task Id") << QStringLiteral("Task") << QStringLiteral("Level");
+    for (int i = 0; i < segments; ++i)
+        columns << segmentName(i);
+    columns << QStringLiteral("Total");
+    writer.writeRow(columns);
+
+    // the rows of the parent tasks include their subtasks, the level tells them apart:
+    const TimeSheetInfoList timeSheetInfo = TimeSheetInfo::filteredTaskWithSubTasks(
+        TimeSheetInfo::taskWithSubTasks(DATAMODEL, segments, rootTask(), secondsMap()),
+        activeTasksOnly());
+    Q_FOREACH (const TimeSheetInfo &info, timeSheetInfo) {
+        QStringList row;
+        if (info.taskId == 0)   // the root item, when reporting on all tasks
+            row << QString() << QStringLiteral("Total") << QString();
+        else
+            row << QString::number(info.taskId) << info.taskName
+                << QString::number(info.indentation);
+        for (int i = 0; i < segments; ++i)
+            row << CsvWriter::hours(info.seconds.value(i));
+        row << CsvWriter::hours(info.total());
+        writer.writeRow(row);
+    }
 }
 
 void TimeSheetReport::slotSaveToXml()
 {
     // first, ask for a file name:
-    QString filename = getFileName(tr("Charm reports (*.charmreport)"));
+    QString filter = tr("Charm reports (*.charmreport)");
+    if (GzipDevice::isCompressionSupported())
+        filter += QLatin1String(";;") + tr("Compressed Charm reports (*.charmreport.gz)");
+    QString filename = getFileName(filter);
     if (filename.isEmpty())
         return;
 
@@ -70,13 +121,19 @@ void TimeSheetReport::slotSaveToXml()
     if (payload.isEmpty())
         return; // Error should have been already displayed by saveToXml()
 
+    // the report is compressed if the file name ends in .gz:
     QFile file(filename);
-    if (file.open(QIODevice::WriteOnly)) {
-        file.write(payload);
-    } else {
+    GzipDevice device(&file, GzipDevice::compressionForFileName(filename));
+    if (!file.open(QIODevice::WriteOnly) || !device.open(QIODevice::WriteOnly)) {
+        const QString error = file.isOpen() ? device.errorString() : file.errorString();
         QMessageBox::critical(this, tr("Error saving report"),
-                              tr("Cannot write to selected location:\n%1").arg(file.errorString()));
+                              tr("Cannot write to selected location:\n%1").arg(error));
+        return;
     }
+    if (device.write(payload) != payload.size() || !device.commit())
+        QMessageBox::critical(this, tr("Error saving report"),
+                              tr("Cannot write to selected location:\n%1").arg(
+                                  device.errorString()));
 }
 
 void TimeSheetReport::slotSaveToText()
@@ -96,25 +153,3 @@ void TimeSheetReport::slotSaveToText()
     file.write(saveToText());
     file.close();
 }
-
-QString TimeSheetReport::getFileName(const QString &filter)
-{
-    QSettings settings;
-    QString path;
-    if (settings.contains(MetaKey_ReportsRecentSavePath)) {
-        path = settings.value(MetaKey_ReportsRecentSavePath).toString();
-        QDir dir(path);
-        if (!dir.exists()) path = QString();
-    }
-    // suggest file name:
-    path += QDir::separator() + suggestedFileName();
-    // ask:
-    QString filename = QFileDialog::getSaveFileName(this, tr("Enter File Name"), path, filter);
-    if (filename.isEmpty())
-        return QString();
-    QFileInfo fileinfo(filename);
-    path = fileinfo.absolutePath();
-    if (!path.isEmpty())
-        settings.setValue(MetaKey_ReportsRecentSavePath, path);
-    return filename;
-}
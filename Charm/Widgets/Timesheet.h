@@ -41,15 +41,27 @@ public:
                                      bool activeTasksOnly);
 
 protected:
+    /** The properties of the report, copied for building it in a worker thread. */
+    struct Properties {
+        QDate start;
+        QDate end;
+        TaskId rootTask = {};
+        bool activeTasksOnly = false;
+        QString userName;
+        int taskPaddingLength = 0;
+    };
+
     enum SaveToXmlMode {
         IncludeTaskList,
         ExcludeTaskList
     };
 
-    virtual QString suggestedFileName() const = 0;
-    virtual void update() = 0;
     virtual QByteArray saveToText() = 0;
     virtual QByteArray saveToXml(SaveToXmlMode mode) = 0;
+    /** The number of columns of time in the report, like the days of a week. */
+    virtual int segmentCount() const = 0;
+    /** The title of column @p segment, as used in the table exports. */
+    virtual QString segmentName(int segment) const = 0;
 
 protected:
 
@@ -78,9 +90,11 @@ protected:
         return m_secondsMap;
     }
 
-    QString getFileName(const QString &filter);
+    Properties properties() const;
+    /** The part of the report cache key that identifies @p properties. */
+    static QString cacheKey(const Properties &properties);
 
-    void slotUpdate() override;
+    void saveToCsv(CsvWriter &writer) override;
     void slotSaveToText() override;
     void slotSaveToXml() override;
 
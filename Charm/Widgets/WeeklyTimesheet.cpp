@@ -22,12 +22,15 @@
 */
 
 #include "WeeklyTimesheet.h"
+#include "Reports/ReportHtmlWriter.h"
+#include "Reports/TimeAggregator.h"
 #include "Reports/WeeklyTimesheetXmlWriter.h"
 
 #include <QCalendarWidget>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QSettings>
+#include <QTextStream>
 #include <QUrl>
 
 #include <Core/Dates.h>
@@ -324,95 +327,73 @@ QString WeeklyTimeSheetReport::suggestedFileName() const
     return tr("WeeklyTimeSheet-%1-%2").arg(m_yearOfWeek).arg(m_weekNumber, 2, 10, QLatin1Char('0'));
 }
 
-void WeeklyTimeSheetReport::update()
-{   // this creates the time sheet
+ReportPreviewWindow::Report WeeklyTimeSheetReport::report(int offset)
+{   // this creates the time sheet, in a worker thread:
+    Properties properties = this->properties();
+    properties.start = properties.start.addDays(7 * offset);
+    properties.end = properties.end.addDays(7 * offset);
+    const int weekNumber = properties.start.weekNumber();
+    const QSharedPointer<SecondsMap> secondsMap(new SecondsMap);
+
+    Report report;
+    report.key = QStringLiteral("weekly/") + cacheKey(properties);
+    report.start = QDateTime(properties.start);
+    report.end = QDateTime(properties.end);
+    report.build = [properties, weekNumber, secondsMap](const ReportGenerator::Request &request) {
+        return reportHtml(request, properties, weekNumber, secondsMap.data());
+    };
+    report.finished = [this, secondsMap]() {
+        m_secondsMap = *secondsMap;
+        uploadButton()->setEnabled(true);
+    };
+    return report;
+}
+
+QString WeeklyTimeSheetReport::reportHtml(const ReportGenerator::Request &request,
+                                          const Properties &properties, int weekNumber,
+                                          SecondsMap *secondsMap)
+{
+    const CharmDataModel *model = request.model();
     // retrieve matching events:
     const EventIdList matchingEvents
-        = DATAMODEL->eventsThatStartInTimeFrame(startDate(), endDate());
-
-    m_secondsMap.clear();
-
-    // for every task, make a vector that includes a number of seconds
-    // for every day of the week ( int seconds[7]), and store those in
-    // a map by their task id
-    Q_FOREACH (EventId id, matchingEvents) {
-        const Event &event = DATAMODEL->eventForId(id);
-        QVector<int> seconds(DaysInWeek);
-        if (m_secondsMap.contains(event.taskId()))
-            seconds = m_secondsMap.value(event.taskId());
-        // what day in the week is the event (normalized to vector indexes):
-        int dayOfWeek = event.startDateTime().date().dayOfWeek() - 1;
-        Q_ASSERT(dayOfWeek >= 0 && dayOfWeek < DaysInWeek);
-        seconds[dayOfWeek] += event.duration();
-        // store in minute map:
-        m_secondsMap[event.taskId()] = seconds;
-    }
+        = model->eventsThatStartInTimeFrame(properties.start, properties.end);
+
+    // for every task, sum up the seconds for every day of the week:
+    TimeAggregator aggregator(DaysInWeek, TimeAggregator::dayOfWeek());
+    aggregator.addEvents(model, matchingEvents);
+    *secondsMap = aggregator.secondsMap();
+    if (request.isCanceled())
+        return QString();
     // now the reporting:
     // headline first:
-    QTextDocument report;
-    QDomDocument doc = createReportTemplate();
-    QDomElement root = doc.documentElement();
-    QDomElement body = root.firstChildElement(QStringLiteral("body"));
+    // retrieve the information for the report:
+    TimeSheetInfoList timeSheetInfo = TimeSheetInfo::filteredTaskWithSubTasks(
+        aggregator.taskWithSubTasks(model, properties.rootTask), properties.activeTasksOnly);
 
+    ReportHtmlWriter html(2048 + 800 * timeSheetInfo.size());
     // create the caption:
+    html.startReport(tr("Weekly Time Sheet"));
     {
-        QDomElement headline = doc.createElement(QStringLiteral("h1"));
-        QDomText text = doc.createTextNode(tr("Weekly Time Sheet"));
-        headline.appendChild(text);
-        body.appendChild(headline);
-    }
-    {
-        QDomElement headline = doc.createElement(QStringLiteral("h3"));
         QString content = tr("Report for %1, Week %2 (%3 to %4)")
-                          .arg(CONFIGURATION.user.name())
-                          .arg(m_weekNumber, 2, 10, QLatin1Char('0'))
-                          .arg(startDate().toString(Qt::TextDate))
-                          .arg(endDate().addDays(-1).toString(Qt::TextDate));
-        QDomText text = doc.createTextNode(content);
-        headline.appendChild(text);
-        body.appendChild(headline);
-        QDomElement previousLink = doc.createElement(QStringLiteral("a"));
-        previousLink.setAttribute(QStringLiteral("href"), QStringLiteral("Previous"));
-        QDomText previousLinkText = doc.createTextNode(tr("<Previous Week>"));
-        previousLink.appendChild(previousLinkText);
-        body.appendChild(previousLink);
-        QDomElement nextLink = doc.createElement(QStringLiteral("a"));
-        nextLink.setAttribute(QStringLiteral("href"), QStringLiteral("Next"));
-        QDomText nextLinkText = doc.createTextNode(tr("<Next Week>"));
-        nextLink.appendChild(nextLinkText);
-        body.appendChild(nextLink);
-        QDomElement paragraph = doc.createElement(QStringLiteral("br"));
-        body.appendChild(paragraph);
+                          .arg(properties.userName)
+                          .arg(weekNumber, 2, 10, QLatin1Char('0'))
+                          .arg(properties.start.toString(Qt::TextDate))
+                          .arg(properties.end.addDays(-1).toString(Qt::TextDate));
+        html.writeTextElement(QStringLiteral("h3"), content);
+        html.writeNavigationLinks(tr("<Previous Week>"), tr("<Next Week>"));
+        html.writeEmptyElement(QStringLiteral("br"));
     }
     {
         // now for a table
-        // retrieve the information for the report:
-        // TimeSheetInfoList timeSheetInfo = taskWithSubTasks( rootTask(), secondsMap() );
-        TimeSheetInfoList timeSheetInfo = TimeSheetInfo::filteredTaskWithSubTasks(
-            TimeSheetInfo::taskWithSubTasks(DATAMODEL, DaysInWeek, rootTask(), secondsMap()),
-            activeTasksOnly());
-
-        QDomElement table = doc.createElement(QStringLiteral("table"));
-        table.setAttribute(QStringLiteral("width"), QStringLiteral("100%"));
-        table.setAttribute(QStringLiteral("align"), QStringLiteral("left"));
-        table.setAttribute(QStringLiteral("cellpadding"), QStringLiteral("3"));
-        table.setAttribute(QStringLiteral("cellspacing"), QStringLiteral("0"));
-        body.appendChild(table);
+        html.startTable();
 
         TimeSheetInfo totalsLine(DaysInWeek);
         if (!timeSheetInfo.isEmpty()) {
             totalsLine = timeSheetInfo.first();
-            if (rootTask() == 0)
+            if (properties.rootTask == 0)
                 timeSheetInfo.removeAt(0);   // there is always one, because there is always the root item
         }
 
-        QDomElement headerRow = doc.createElement(QStringLiteral("tr"));
-        headerRow.setAttribute(QStringLiteral("class"), QStringLiteral("header_row"));
-        table.appendChild(headerRow);
-        QDomElement headerDayRow = doc.createElement(QStringLiteral("tr"));
-        headerDayRow.setAttribute(QStringLiteral("class"), QStringLiteral("header_row"));
-        table.appendChild(headerDayRow);
-
         const QString Headlines[NumberOfColumns] = {
             tr("Task"),
             QDate::shortDayName(1),
@@ -426,36 +407,33 @@ void WeeklyTimeSheetReport::update()
         };
         const QString DayHeadlines[NumberOfColumns] = {
             QString(),
-            tr("%1").arg(startDate().day(), 2, 10, QLatin1Char('0')),
-            tr("%1").arg(startDate().addDays(1).day(), 2, 10, QLatin1Char('0')),
-            tr("%1").arg(startDate().addDays(2).day(), 2, 10, QLatin1Char('0')),
-            tr("%1").arg(startDate().addDays(3).day(), 2, 10, QLatin1Char('0')),
-            tr("%1").arg(startDate().addDays(4).day(), 2, 10, QLatin1Char('0')),
-            tr("%1").arg(startDate().addDays(5).day(), 2, 10, QLatin1Char('0')),
-            tr("%1").arg(startDate().addDays(6).day(), 2, 10, QLatin1Char('0')),
+            tr("%1").arg(properties.start.day(), 2, 10, QLatin1Char('0')),
+            tr("%1").arg(properties.start.addDays(1).day(), 2, 10, QLatin1Char('0')),
+            tr("%1").arg(properties.start.addDays(2).day(), 2, 10, QLatin1Char('0')),
+            tr("%1").arg(properties.start.addDays(3).day(), 2, 10, QLatin1Char('0')),
+            tr("%1").arg(properties.start.addDays(4).day(), 2, 10, QLatin1Char('0')),
+            tr("%1").arg(properties.start.addDays(5).day(), 2, 10, QLatin1Char('0')),
+            tr("%1").arg(properties.start.addDays(6).day(), 2, 10, QLatin1Char('0')),
             QString()
         };
 
-        for (int i = 0; i < NumberOfColumns; ++i) {
-            QDomElement header = doc.createElement(QStringLiteral("th"));
-            QDomText text = doc.createTextNode(Headlines[i]);
-            header.appendChild(text);
-            headerRow.appendChild(header);
-            QDomElement dayHeader = doc.createElement(QStringLiteral("th"));
-            QDomText dayText = doc.createTextNode(DayHeadlines[i]);
-            dayHeader.appendChild(dayText);
-            headerDayRow.appendChild(dayHeader);
-        }
+        html.startTableHeader();
+        html.startRow(QStringLiteral("header_row"));
+        for (int i = 0; i < NumberOfColumns; ++i)
+            html.writeHeaderCell(Headlines[i]);
+        html.endElement();
+        html.startRow(QStringLiteral("header_row"));
+        for (int i = 0; i < NumberOfColumns; ++i)
+            html.writeHeaderCell(DayHeadlines[i]);
+        html.endElement();
+        html.endElement();
 
         for (int i = 0; i < timeSheetInfo.size(); ++i) {
-            QDomElement row = doc.createElement(QStringLiteral("tr"));
-            if (i % 2)
-                row.setAttribute(QStringLiteral("class"), QStringLiteral("alternate_row"));
-            table.appendChild(row);
+            html.startRow(i % 2 ? QStringLiteral("alternate_row") : QString());
 
             QString texts[NumberOfColumns];
             texts[Column_Task] = timeSheetInfo[i].formattedTaskIdAndName(
-                CONFIGURATION.taskPaddingLength);
+                properties.taskPaddingLength);
             texts[Column_Monday] = hoursAndMinutes(timeSheetInfo[i].seconds[0]);
             texts[Column_Tuesday] = hoursAndMinutes(timeSheetInfo[i].seconds[1]);
             texts[Column_Wednesday] = hoursAndMinutes(timeSheetInfo[i].seconds[2]);
@@ -465,22 +443,15 @@ void WeeklyTimeSheetReport::update()
             texts[Column_Sunday] = hoursAndMinutes(timeSheetInfo[i].seconds[6]);
             texts[Column_Total] = hoursAndMinutes(timeSheetInfo[i].total());
 
-            for (int column = 0; column < NumberOfColumns; ++column) {
-                QDomElement cell = doc.createElement(QStringLiteral("td"));
-                cell.setAttribute(QStringLiteral("align"),
-                                  column
-                                  == Column_Task ? QStringLiteral("left") : QStringLiteral("center"));
-
-                if (column == Column_Task) {
-                    QString style = QStringLiteral("text-indent: %1px;")
-                                    .arg(9 * timeSheetInfo[i].indentation);
-                    cell.setAttribute(QStringLiteral("style"), style);
-                }
-
-                QDomText text = doc.createTextNode(texts[column]);
-                cell.appendChild(text);
-                row.appendChild(cell);
-            }
+            html.startElement(QStringLiteral("td"));
+            html.writeAttribute(QStringLiteral("align"), QStringLiteral("left"));
+            html.writeAttribute(QStringLiteral("style"), QStringLiteral("text-indent: %1px;")
+                                .arg(9 * timeSheetInfo[i].indentation));
+            html.writeText(texts[Column_Task]);
+            html.endElement();
+            for (int column = Column_Task + 1; column < NumberOfColumns; ++column)
+                html.writeCell(texts[column], QStringLiteral("center"));
+            html.endElement();
         }
         // put the totals:
         QString TotalsTexts[NumberOfColumns] = {
@@ -494,24 +465,13 @@ void WeeklyTimeSheetReport::update()
             hoursAndMinutes(totalsLine.seconds[6]),
             hoursAndMinutes(totalsLine.total())
         };
-        QDomElement totals = doc.createElement(QStringLiteral("tr"));
-        totals.setAttribute(QStringLiteral("class"), QStringLiteral("header_row"));
-        table.appendChild(totals);
-        for (int i = 0; i < NumberOfColumns; ++i) {
-            QDomElement cell = doc.createElement(QStringLiteral("th"));
-            QDomText text = doc.createTextNode(TotalsTexts[i]);
-            cell.appendChild(text);
-            totals.appendChild(cell);
-        }
+        html.startRow(QStringLiteral("header_row"));
+        for (int i = 0; i < NumberOfColumns; ++i)
+            html.writeHeaderCell(TotalsTexts[i]);
+        html.endElement();
     }
 
-    // NOTE: seems like the style sheet has to be set before the html
-    // code is pushed into the QTextDocument
-    report.setDefaultStyleSheet(Charm::reportStylesheet(palette()));
-
-    report.setHtml(doc.toString());
-    setDocument(&report);
-    uploadButton()->setEnabled(true);
+    return html.endReport();
 }
 
 QByteArray WeeklyTimeSheetReport::saveToXml(SaveToXmlMode mode)
@@ -571,6 +531,16 @@ QByteArray WeeklyTimeSheetReport::saveToText()
     return output;
 }
 
+int WeeklyTimeSheetReport::segmentCount() const
+{
+    return DaysInWeek;
+}
+
+QString WeeklyTimeSheetReport::segmentName(int segment) const
+{
+    return startDate().addDays(segment).toString(Qt::ISODate);
+}
+
 void WeeklyTimeSheetReport::slotLinkClicked(const QUrl &which)
 {
     QDate start = which.toString()
@@ -90,9 +90,14 @@ private Q_SLOTS:
 
 private:
     QString suggestedFileName() const override;
-    void update() override;
+    Report report(int offset) override;
+    static QString reportHtml(const ReportGenerator::Request &request,
+                              const Properties &properties, int weekNumber,
+                              SecondsMap *secondsMap);
     QByteArray saveToXml(SaveToXmlMode mode) override;
     QByteArray saveToText() override;
+    int segmentCount() const override;
+    QString segmentName(int segment) const override;
 
 private:
     // properties of the report:
@@ -0,0 +1,315 @@
+/*
+  YearlyTimesheet.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "YearlyTimesheet.h"
+#include "Reports/ReportHtmlWriter.h"
+#include "Reports/YearlyTimesheetXmlWriter.h"
+
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTextStream>
+#include <QUrl>
+
+#include "ViewHelpers.h"
+
+#include "CharmCMake.h"
+
+namespace {
+const int MonthsInYear = 12;
+
+/** The seconds of @p info in the months of the @p year-th year of the report. */
+int yearTotal(const TimeSheetInfo &info, int year)
+{
+    int total = 0;
+    for (int month = 0; month < MonthsInYear; ++month)
+        total += info.seconds.value(year * MonthsInYear + month);
+    return total;
+}
+
+void writeTaskCell(ReportHtmlWriter &html, const TimeSheetInfo &info, int taskPaddingLength)
+{
+    html.startElement(QStringLiteral("td"));
+    html.writeAttribute(QStringLiteral("align"), QStringLiteral("left"));
+    html.writeAttribute(QStringLiteral("style"), QStringLiteral("text-indent: %1px;")
+                        .arg(9 * info.indentation));
+    html.writeText(info.formattedTaskIdAndName(taskPaddingLength));
+    html.endElement();
+}
+}
+
+YearlyTimeSheetReport::YearlyTimeSheetReport(QWidget *parent)
+    : TimeSheetReport(parent)
+{
+    connect(this, &YearlyTimeSheetReport::anchorClicked,
+            this, &YearlyTimeSheetReport::slotLinkClicked);
+}
+
+YearlyTimeSheetReport::~YearlyTimeSheetReport()
+{
+}
+
+void YearlyTimeSheetReport::setReportProperties(
+    const QDate &start, const QDate &end, TaskId rootTask, bool activeTasksOnly)
+{
+    Q_ASSERT_X(start.month() == 1 && start.day() == 1, Q_FUNC_INFO,
+               "The report starts at the beginning of a year");
+    m_firstYear = start.year();
+    m_numberOfYears = qMax(1, end.year() - start.year());
+    TimeSheetReport::setReportProperties(start, start.addYears(m_numberOfYears), rootTask,
+                                         activeTasksOnly);
+}
+
+QString YearlyTimeSheetReport::suggestedFileName() const
+{
+    if (m_numberOfYears == 1)
+        return tr("YearlyTimeSheet-%1").arg(m_firstYear);
+    return tr("YearlyTimeSheet-%1-%2").arg(m_firstYear).arg(m_firstYear + m_numberOfYears - 1);
+}
+
+QByteArray YearlyTimeSheetReport::saveToText()
+{
+    QByteArray output;
+    QTextStream stream(&output);
+    QString content = tr("Report for %1, %2 to %3")
+                      .arg(CONFIGURATION.user.name(),
+                           QString::number(m_firstYear),
+                           QString::number(m_firstYear + m_numberOfYears - 1));
+    stream << content << '\n';
+    stream << '\n';
+    TimeSheetInfoList timeSheetInfo = TimeSheetInfo::filteredTaskWithSubTasks(
+        TimeSheetInfo::taskWithSubTasks(DATAMODEL, MonthsInYear * m_numberOfYears, rootTask(),
+                                        secondsMap()),
+        activeTasksOnly());
+
+    TimeSheetInfo totalsLine(MonthsInYear * m_numberOfYears);
+    if (!timeSheetInfo.isEmpty()) {
+        totalsLine = timeSheetInfo.first();
+        if (rootTask() == 0)
+            timeSheetInfo.removeAt(0);   // there is always one, because there is always the root item
+    }
+
+    for (int i = 0; i < timeSheetInfo.size(); ++i) {
+        stream << timeSheetInfo[i].formattedTaskIdAndName(CONFIGURATION.taskPaddingLength);
+        for (int year = 0; year < m_numberOfYears; ++year)
+            stream << "\t" << hoursAndMinutes(yearTotal(timeSheetInfo[i], year));
+        if (m_numberOfYears > 1)
+            stream << "\t" << hoursAndMinutes(timeSheetInfo[i].total());
+        stream << '\n';
+    }
+    stream << '\n';
+    for (int year = 0; year < m_numberOfYears; ++year)
+        stream << "Year total " << m_firstYear + year << ": "
+               << hoursAndMinutes(yearTotal(totalsLine, year)) << '\n';
+    if (m_numberOfYears > 1)
+        stream << "Total: " << hoursAndMinutes(totalsLine.total()) << '\n';
+    stream.flush();
+
+    return output;
+}
+
+QByteArray YearlyTimeSheetReport::saveToXml(SaveToXmlMode mode)
+{
+    try {
+        YearlyTimesheetXmlWriter timesheet;
+        timesheet.setDataModel(DATAMODEL);
+        timesheet.setFirstYear(m_firstYear);
+        timesheet.setNumberOfYears(m_numberOfYears);
+        timesheet.setRootTask(rootTask());
+        timesheet.setIncludeTaskList(mode == IncludeTaskList);
+        const EventIdList matchingEventIds = DATAMODEL->eventsThatStartInTimeFrame(
+            startDate(), endDate());
+        EventList events;
+        events.reserve(matchingEventIds.size());
+        Q_FOREACH (const EventId &eventId, matchingEventIds)
+            events.append(DATAMODEL->eventForId(eventId));
+        timesheet.setEvents(events);
+        return timesheet.saveToXml();
+    } catch (const XmlSerializationException &e) {
+        QMessageBox::critical(this, tr("Error exporting the report"), e.what());
+    }
+
+    return QByteArray();
+}
+
+int YearlyTimeSheetReport::segmentCount() const
+{
+    return MonthsInYear * m_numberOfYears;
+}
+
+QString YearlyTimeSheetReport::segmentName(int segment) const
+{
+    return startDate().addMonths(segment).toString(QStringLiteral("yyyy-MM"));
+}
+
+ReportPreviewWindow::Report YearlyTimeSheetReport::report(int offset)
+{
+    // this creates the time sheet, in a worker thread:
+    Properties properties = this->properties();
+    properties.start = properties.start.addYears(offset);
+    properties.end = properties.end.addYears(offset);
+    const int numberOfYears = m_numberOfYears;
+    const QSharedPointer<SecondsMap> secondsMap(new SecondsMap);
+
+    Report report;
+    report.key = QStringLiteral("yearly/") + cacheKey(properties);
+    report.start = QDateTime(properties.start);
+    report.end = QDateTime(properties.end);
+    report.build = [=](const ReportGenerator::Request &request) {
+        return reportHtml(request, properties, numberOfYears, secondsMap.data());
+    };
+    report.finished = [this, secondsMap]() {
+        m_secondsMap = *secondsMap;
+        uploadButton()->setVisible(false);
+        uploadButton()->setEnabled(false);
+    };
+    return report;
+}
+
+QString YearlyTimeSheetReport::reportHtml(const ReportGenerator::Request &request,
+                                          const Properties &properties, int numberOfYears,
+                                          SecondsMap *secondsMap)
+{
+    const CharmDataModel *model = request.model();
+    // the model keeps the seconds of every task and month, so neither this nor the rest
+    // depends on the number of events, only on the number of tasks and months:
+    const int numberOfMonths = MonthsInYear * numberOfYears;
+    *secondsMap = model->monthlySeconds(properties.start, numberOfMonths);
+    if (request.isCanceled())
+        return QString();
+    // retrieve the information for the report, rolled up into the parent tasks:
+    TimeSheetInfoList timeSheetInfo = TimeSheetInfo::filteredTaskWithSubTasks(
+        TimeSheetInfo::taskWithSubTasks(model, numberOfMonths, properties.rootTask,
+                                        *secondsMap), properties.activeTasksOnly);
+
+    TimeSheetInfo totalsLine(numberOfMonths);
+    if (!timeSheetInfo.isEmpty()) {
+        totalsLine = timeSheetInfo.first();
+        if (properties.rootTask == 0)
+            timeSheetInfo.removeAt(0);   // there is always one, because there is always the root item
+    }
+
+    // now the reporting:
+    const int firstYear = properties.start.year();
+    const int lastYear = firstYear + numberOfYears - 1;
+    ReportHtmlWriter html(2048 + (400 + 100 * (MonthsInYear + 1)) * timeSheetInfo.size()
+                          * (numberOfYears + 1));
+    // headline first:
+    html.startReport(tr("Yearly Time Sheet"));
+    {
+        const QString years = numberOfYears == 1
+                              ? QString::number(firstYear)
+                              : tr("%1 to %2").arg(firstYear).arg(lastYear);
+        html.writeTextElement(QStringLiteral("h3"), tr("Report for %1, %2")
+                              .arg(properties.userName, years));
+        html.writeNavigationLinks(tr("<Previous Year>"), tr("<Next Year>"));
+        html.writeEmptyElement(QStringLiteral("br"));
+    }
+
+    const QString center = QStringLiteral("center");
+    // one table per year, with the months as columns:
+    for (int year = 0; year < numberOfYears; ++year) {
+        if (numberOfYears > 1)
+            html.writeTextElement(QStringLiteral("h4"), QString::number(firstYear + year));
+        html.startTable();
+
+        {   //Header Row
+            html.startTableHeader();
+            html.startRow(QStringLiteral("header_row"));
+            html.writeHeaderCell(tr("Task"));
+            for (int month = 1; month <= MonthsInYear; ++month)
+                html.writeHeaderCell(QDate::shortMonthName(month));
+            html.writeHeaderCell(tr("Total"));
+            html.endElement();
+            html.endElement();
+        }
+
+        int row = 0;
+        for (int i = 0; i < timeSheetInfo.size(); ++i) {
+            const int total = yearTotal(timeSheetInfo[i], year);
+            // tasks that are only active in the other years:
+            if (properties.activeTasksOnly && total == 0)
+                continue;
+            html.startRow(row++ % 2 ? QStringLiteral("alternate_row") : QString());
+            writeTaskCell(html, timeSheetInfo[i], properties.taskPaddingLength);
+            for (int month = 0; month < MonthsInYear; ++month)
+                html.writeCell(hoursAndMinutes(timeSheetInfo[i].seconds[year * MonthsInYear
+                                                                         + month]), center);
+            html.writeCell(hoursAndMinutes(total), center);
+            html.endElement();
+        }
+
+        {   // Totals row
+            html.startRow(QStringLiteral("header_row"));
+            html.writeHeaderCell(tr("Total:"));
+            for (int month = 0; month < MonthsInYear; ++month)
+                html.writeHeaderCell(hoursAndMinutes(totalsLine.seconds[year * MonthsInYear
+                                                                        + month]));
+            html.writeHeaderCell(hoursAndMinutes(yearTotal(totalsLine, year)));
+            html.endElement();
+        }
+        html.endElement();
+        html.writeEmptyElement(QStringLiteral("br"));
+    }
+
+    if (numberOfYears > 1) {
+        // and the summary of all years, with the years as columns:
+        html.writeTextElement(QStringLiteral("h4"), tr("%1 to %2").arg(firstYear).arg(lastYear));
+        html.startTable();
+
+        {   //Header Row
+            html.startTableHeader();
+            html.startRow(QStringLiteral("header_row"));
+            html.writeHeaderCell(tr("Task"));
+            for (int year = firstYear; year <= lastYear; ++year)
+                html.writeHeaderCell(QString::number(year));
+            html.writeHeaderCell(tr("Total"));
+            html.endElement();
+            html.endElement();
+        }
+
+        for (int i = 0; i < timeSheetInfo.size(); ++i) {
+            html.startRow(i % 2 ? QStringLiteral("alternate_row") : QString());
+            writeTaskCell(html, timeSheetInfo[i], properties.taskPaddingLength);
+            for (int year = 0; year < numberOfYears; ++year)
+                html.writeCell(hoursAndMinutes(yearTotal(timeSheetInfo[i], year)), center);
+            html.writeCell(hoursAndMinutes(timeSheetInfo[i].total()), center);
+            html.endElement();
+        }
+
+        {   // Totals row
+            html.startRow(QStringLiteral("header_row"));
+            html.writeHeaderCell(tr("Total:"));
+            for (int year = 0; year < numberOfYears; ++year)
+                html.writeHeaderCell(hoursAndMinutes(yearTotal(totalsLine, year)));
+            html.writeHeaderCell(hoursAndMinutes(totalsLine.total()));
+            html.endElement();
+        }
+    }
+
+    return html.endReport();
+}
+
+void YearlyTimeSheetReport::slotLinkClicked(const QUrl &which)
+{
+    const int years = which.toString() == QLatin1String("Previous") ? -1 : 1;
+    setReportProperties(startDate().addYears(years), endDate().addYears(years), rootTask(),
+                        activeTasksOnly());
+}
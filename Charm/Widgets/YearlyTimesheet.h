@@ -0,0 +1,67 @@
+/*
+  YearlyTimesheet.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef YEARLYTIMESHEET_H
+#define YEARLYTIMESHEET_H
+
+#include <Core/Task.h>
+
+#include "Timesheet.h"
+
+class QUrl;
+
+/** The summary of one or more years, with the time spent on every task per month. The
+    events are summed up per task and month once, the report then only depends on the number
+    of tasks and months. */
+class YearlyTimeSheetReport : public TimeSheetReport
+{
+    Q_OBJECT
+
+public:
+    explicit YearlyTimeSheetReport(QWidget *parent = nullptr);
+    ~YearlyTimeSheetReport() override;
+
+    /** @p start is the first day of the first year, @p end the first day after the last
+        year. */
+    void setReportProperties(const QDate &start, const QDate &end, TaskId rootTask,
+                             bool activeTasksOnly) override;
+
+private Q_SLOTS:
+    void slotLinkClicked(const QUrl &which);
+
+private:
+    QString suggestedFileName() const override;
+    Report report(int offset) override;
+    static QString reportHtml(const ReportGenerator::Request &request,
+                              const Properties &properties, int numberOfYears,
+                              SecondsMap *secondsMap);
+    QByteArray saveToText() override;
+    QByteArray saveToXml(SaveToXmlMode mode) override;
+    int segmentCount() const override;
+    QString segmentName(int segment) const override;
+
+private:
+    // properties of the report:
+    int m_firstYear = 0;
+    int m_numberOfYears = 1;
+};
+
+#endif
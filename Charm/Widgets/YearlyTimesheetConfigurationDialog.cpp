@@ -0,0 +1,141 @@
+/*
+  YearlyTimesheetConfigurationDialog.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "YearlyTimesheetConfigurationDialog.h"
+
+#include <QSettings>
+
+#include "SelectTaskDialog.h"
+#include "ViewHelpers.h"
+
+#include "CharmCMake.h"
+
+#include "YearlyTimesheet.h"
+
+#include "ui_YearlyTimesheetConfigurationDialog.h"
+
+YearlyTimesheetConfigurationDialog::YearlyTimesheetConfigurationDialog(QWidget *parent)
+    : ReportConfigurationDialog(parent)
+    , m_ui(new Ui::YearlyTimesheetConfigurationDialog)
+{
+    setWindowTitle(tr("Yearly Timesheet"));
+
+    m_ui->setupUi(this);
+    connect(m_ui->buttonBox, &QDialogButtonBox::accepted,
+            this, &YearlyTimesheetConfigurationDialog::accept);
+    connect(m_ui->buttonBox, &QDialogButtonBox::rejected,
+            this, &YearlyTimesheetConfigurationDialog::reject);
+
+    connect(m_ui->spinBoxFirstYear, SIGNAL(valueChanged(int)),
+            SLOT(slotFirstYearChanged(int)));
+    connect(m_ui->toolButtonSelectTask, &QToolButton::clicked,
+            this, &YearlyTimesheetConfigurationDialog::slotSelectTask);
+    connect(m_ui->checkBoxSubTasksOnly, &QCheckBox::toggled,
+            this, &YearlyTimesheetConfigurationDialog::slotCheckboxSubtasksOnlyChecked);
+    slotCheckboxSubtasksOnlyChecked(m_ui->checkBoxSubTasksOnly->isChecked());
+
+    // set current year:
+    m_ui->spinBoxFirstYear->setValue(QDate::currentDate().year());
+    m_ui->spinBoxLastYear->setValue(QDate::currentDate().year());
+
+    // load settings:
+    QSettings settings;
+    if (settings.contains(MetaKey_TimesheetActiveOnly)) {
+        m_ui->checkBoxActiveOnly->setChecked(settings.value(MetaKey_TimesheetActiveOnly).toBool());
+    } else {
+        m_ui->checkBoxActiveOnly->setChecked(true);
+    }
+}
+
+YearlyTimesheetConfigurationDialog::~YearlyTimesheetConfigurationDialog()
+{
+}
+
+void YearlyTimesheetConfigurationDialog::accept()
+{
+    // save settings:
+    QSettings settings;
+    settings.setValue(MetaKey_TimesheetActiveOnly,
+                      m_ui->checkBoxActiveOnly->isChecked());
+    settings.setValue(MetaKey_TimesheetRootTask,
+                      m_rootTask);
+
+    QDialog::accept();
+}
+
+void YearlyTimesheetConfigurationDialog::showReportPreviewDialog()
+{
+    const QDate start(m_ui->spinBoxFirstYear->value(), 1, 1);
+    const QDate end(m_ui->spinBoxLastYear->value() + 1, 1, 1);
+    bool activeOnly = m_ui->checkBoxActiveOnly->isChecked();
+    auto report = new YearlyTimeSheetReport();
+    report->setReportProperties(start, end, m_rootTask, activeOnly);
+    report->show();
+}
+
+void YearlyTimesheetConfigurationDialog::showEvent(QShowEvent *)
+{
+    QSettings settings;
+
+    // we only want to do this once a backend is loaded, and we ignore
+    // the saved root task if it does not exist anymore
+    if (settings.contains(MetaKey_TimesheetRootTask)) {
+        TaskId root = settings.value(MetaKey_TimesheetRootTask).toInt();
+        const TaskTreeItem &item = DATAMODEL->taskTreeItem(root);
+        if (item.isValid()) {
+            m_rootTask = root;
+            m_ui->labelTaskName->setText(DATAMODEL->fullTaskName(item.task()));
+            m_ui->checkBoxSubTasksOnly->setChecked(true);
+        }
+    }
+}
+
+void YearlyTimesheetConfigurationDialog::slotCheckboxSubtasksOnlyChecked(bool checked)
+{
+    if (checked && m_rootTask == 0)
+        slotSelectTask();
+
+    if (!checked) {
+        m_rootTask = 0;
+        m_ui->labelTaskName->setText(tr("(All Tasks)"));
+    }
+}
+
+void YearlyTimesheetConfigurationDialog::slotFirstYearChanged(int year)
+{
+    // the report covers at least the first year:
+    m_ui->spinBoxLastYear->setMinimum(year);
+}
+
+void YearlyTimesheetConfigurationDialog::slotSelectTask()
+{
+    SelectTaskDialog dialog(this);
+    dialog.setNonTrackableSelectable();
+    dialog.setNonValidSelectable();
+    if (dialog.exec()) {
+        m_rootTask = dialog.selectedTask();
+        const TaskTreeItem &item = DATAMODEL->taskTreeItem(m_rootTask);
+        m_ui->labelTaskName->setText(DATAMODEL->fullTaskName(item.task()));
+    } else {
+        if (m_rootTask == 0)
+            m_ui->checkBoxSubTasksOnly->setChecked(false);
+    }
+}
@@ -55,6 +55,16 @@ bool CharmCommand::rollback(Controller *)
     return false;
 }
 
+QString CharmCommand::failure() const
+{
+    return m_failure;
+}
+
+void CharmCommand::setFailure(const QString &failure)
+{
+    m_failure = failure;
+}
+
 CommandEmitterInterface *CharmCommand::owner() const
 {
     return m_owner;
@@ -72,6 +72,10 @@ public:
     virtual bool rollback(Controller *controller);
     virtual bool finalize() = 0;
 
+    /** The error that stopped the command in the controller, empty if it did not fail. */
+    QString failure() const;
+    void setFailure(const QString &failure);
+
     CommandEmitterInterface *owner() const;
 
     //used by UndoCharmCommandWrapper to forward signal firing
@@ -99,6 +103,7 @@ private:
 
     CommandEmitterInterface *m_owner = nullptr;
     const QString m_description;
+    QString m_failure;
 };
 
 #endif
@@ -52,6 +52,9 @@ const QString MetaKey_TimesheetSubscribedOnly = QStringLiteral("TimesheetSubscri
 const QString MetaKey_TimesheetActiveOnly = QStringLiteral("TimesheetActiveOnly");
 const QString MetaKey_TimesheetRootTask = QStringLiteral("TimesheetRootTask");
 const QString MetaKey_LastEventEditorDateTime = QStringLiteral("LastEventEditorDateTime");
+const QString MetaKey_EventArchiveCutoff = QStringLiteral("EventArchiveCutoff");
+const QString MetaKey_EventArchiveLastId = QStringLiteral("EventArchiveLastId");
+const QString MetaKey_DeltaExportWatermark = QStringLiteral("DeltaExportWatermark");
 const QString MetaKey_Key_InstallationId = QStringLiteral("InstallationId");
 const QString MetaKey_Key_UserName = QStringLiteral("UserName");
 const QString MetaKey_Key_UserId = QStringLiteral("UserId");
@@ -68,6 +71,7 @@ const QString MetaKey_Key_ToolButtonStyle = QStringLiteral("ToolButtonStyle");
 const QString MetaKey_Key_ShowStatusBar = QStringLiteral("ShowStatusBar");
 const QString MetaKey_Key_EnableCommandInterface = QStringLiteral("EnableCommandInterface");
 const QString MetaKey_Key_NumberOfTaskSelectorEntries = QStringLiteral("NumberOfTaskSelectorEntries");
+const QString MetaKey_Key_ArchiveEventsAfterMonths = QStringLiteral("ArchiveEventsAfterMonths");
 
 const QString TrueString(QStringLiteral("true"));
 const QString FalseString(QStringLiteral("false"));
@@ -36,11 +36,15 @@
 #define CHARM_DATABASE_VERSION_BEFORE_TASK_EXPIRY 2
 #define CHARM_DATABASE_VERSION_BEFORE_TRACKABLE 3
 #define CHARM_DATABASE_VERSION_BEFORE_COMMENT 4
-#define CHARM_DATABASE_VERSION 5
+#define CHARM_DATABASE_VERSION_BEFORE_CHANGES 5
+#define CHARM_DATABASE_VERSION_BEFORE_EVENT_ORIGINS 6
+#define CHARM_DATABASE_VERSION 7
 #define REQUIRED_CHARM_DATABASE_VERSION CHARM_DATABASE_VERSION
 // FIXME this may have to go into some plugin configuration later:
 // FIXME also, we may need some verbose descriptors for configuration
 #define CHARM_SQLITE_BACKEND_DESCRIPTOR QStringLiteral("sqlite")
+// an SQLite database in memory, which is lost on disconnect (for tests and tools):
+#define CHARM_SQLITE_MEMORY_BACKEND_DESCRIPTOR QStringLiteral("sqlite-memory")
 #define CHARM_MYSQL_BACKEND_DESCRIPTOR QStringLiteral("mysql")
 
 // Metadata and QSettings Keys:
@@ -60,6 +64,9 @@ extern const QString MetaKey_TimesheetActiveOnly;
 extern const QString MetaKey_TimesheetSubscribedOnly;
 extern const QString MetaKey_TimesheetRootTask;
 extern const QString MetaKey_LastEventEditorDateTime;
+extern const QString MetaKey_EventArchiveCutoff;
+extern const QString MetaKey_EventArchiveLastId;
+extern const QString MetaKey_DeltaExportWatermark;
 extern const QString MetaKey_Key_InstallationId;
 extern const QString MetaKey_Key_UserName;
 extern const QString MetaKey_Key_UserId;
@@ -75,6 +82,7 @@ extern const QString MetaKey_Key_ToolButtonStyle;
 extern const QString MetaKey_Key_ShowStatusBar;
 extern const QString MetaKey_Key_EnableCommandInterface;
 extern const QString MetaKey_Key_NumberOfTaskSelectorEntries;
+extern const QString MetaKey_Key_ArchiveEventsAfterMonths;
 
 extern const QString TrueString;
 extern const QString FalseString;
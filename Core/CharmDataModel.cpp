@@ -44,6 +44,7 @@
 
 CharmDataModel::CharmDataModel()
     : QObject()
+    , m_events(new EventData)
 {
     connect(&m_timer, SIGNAL(timeout()), SLOT(eventUpdateTimerEvent()));
 }
@@ -81,6 +82,7 @@ void CharmDataModel::unregisterAdapter(CharmDataModelAdapterInterface *adapter)
 
 void CharmDataModel::setAllTasks(const TaskList &tasks)
 {
+    m_revision = ++m_lastRevision;
     clearTasks();
 
     Q_ASSERT(Task::checkForTreeness(tasks));
@@ -114,6 +116,7 @@ void CharmDataModel::setAllTasks(const TaskList &tasks)
 
 void CharmDataModel::addTask(const Task &task)
 {
+    m_revision = ++m_lastRevision;
     Q_ASSERT_X(!taskExists(task.id()), Q_FUNC_INFO,
                "New tasks need to have a unique task id");
 
@@ -146,6 +149,7 @@ void CharmDataModel::addTask(const Task &task)
 
 void CharmDataModel::modifyTask(const Task &task)
 {
+    m_revision = ++m_lastRevision;
     const auto it = m_tasks.find(task.id());
     Q_ASSERT_X(it != m_tasks.end(), Q_FUNC_INFO,
                "Task to modify has to exist");
@@ -175,6 +179,7 @@ void CharmDataModel::modifyTask(const Task &task)
 
 void CharmDataModel::deleteTask(const Task &task)
 {
+    m_revision = ++m_lastRevision;
     Q_ASSERT_X(taskExists(task.id()), Q_FUNC_INFO,
                "Task to delete has to exist");
     Q_ASSERT_X(taskTreeItem(task.id()).childCount() == 0,
@@ -199,6 +204,7 @@ void CharmDataModel::deleteTask(const Task &task)
 
 void CharmDataModel::clearTasks()
 {
+    m_revision = ++m_lastRevision;
     // to clear the task list, all tasks have first to be changed to be children of the root item:
     for (TaskTreeItem::Map::iterator it = m_tasks.begin(); it != m_tasks.end(); ++it)
         it->second.makeChildOf(m_rootItem);
@@ -213,11 +219,14 @@ void CharmDataModel::clearTasks()
 
 void CharmDataModel::setAllEvents(const EventList &events)
 {
-    m_events.clear();
+    m_revision = ++m_lastRevision;
+    // a new map, clones keep the old one:
+    m_events = new EventData;
 
     for (int i = 0; i < events.size(); ++i) {
         if (!eventExists(events[i].id())) {
-            m_events[ events[i].id() ] = events[i];
+            m_events->events[ events[i].id() ] = events[i];
+            m_events->count(events[i], 1);
         } else {
             qCritical() << "CharmDataModel::addTask: duplicate task id"
                         << m_tasks[i].task().id() << "ignored. THIS IS A BUG";
@@ -230,13 +239,15 @@ void CharmDataModel::setAllEvents(const EventList &events)
 
 void CharmDataModel::addEvent(const Event &event)
 {
+    m_revision = ++m_lastRevision;
     Q_ASSERT_X(!eventExists(event.id()), Q_FUNC_INFO,
                "New event must have a unique id");
 
     Q_FOREACH (auto adapter, m_adapters)
         adapter->eventAboutToBeAdded(event.id());
 
-    m_events[ event.id() ] = event;
+    m_events->events[ event.id() ] = event;
+    m_events->count(event, 1);
 
     Q_FOREACH (auto adapter, m_adapters)
         adapter->eventAdded(event.id());
@@ -248,8 +259,17 @@ void CharmDataModel::modifyEvent(const Event &newEvent)
                "Event to modify has to exist");
 
     const Event oldEvent = eventForId(newEvent.id());
-
-    m_events[ newEvent.id() ] = newEvent;
+    // the periodic updates of the end time of active events only change the revision of
+    // time ranges that include the active events, see revision(start, end):
+    Event endUpdated = oldEvent;
+    endUpdated.setEndDateTime(newEvent.endDateTime());
+    ++m_lastRevision;
+    if (!m_activeEventIds.contains(newEvent.id()) || endUpdated != newEvent)
+        m_revision = m_lastRevision;
+
+    m_events->count(oldEvent, -1);
+    m_events->events[ newEvent.id() ] = newEvent;
+    m_events->count(newEvent, 1);
 
     Q_FOREACH (auto adapter, m_adapters)
         adapter->eventModified(newEvent.id(), oldEvent);
@@ -257,6 +277,7 @@ void CharmDataModel::modifyEvent(const Event &newEvent)
 
 void CharmDataModel::deleteEvent(const Event &event)
 {
+    m_revision = ++m_lastRevision;
     Q_ASSERT_X(eventExists(event.id()), Q_FUNC_INFO,
                "Event to delete has to exist");
     Q_ASSERT_X(!m_activeEventIds.contains(event.id()), Q_FUNC_INFO,
@@ -265,9 +286,12 @@ void CharmDataModel::deleteEvent(const Event &event)
     Q_FOREACH (auto adapter, m_adapters)
         adapter->eventAboutToBeDeleted(event.id());
 
-    const auto it = m_events.find(event.id());
-    if (it != m_events.end())
-        m_events.erase(it);
+    EventMap &events = m_events->events;
+    const auto it = events.find(event.id());
+    if (it != events.end()) {
+        m_events->count(it->second, -1);
+        events.erase(it);
+    }
 
     Q_FOREACH (auto adapter, m_adapters)
         adapter->eventDeleted(event.id());
@@ -275,7 +299,8 @@ void CharmDataModel::deleteEvent(const Event &event)
 
 void CharmDataModel::clearEvents()
 {
-    m_events.clear();
+    m_revision = ++m_lastRevision;
+    m_events = new EventData;
 
     Q_FOREACH (auto adapter, m_adapters)
         adapter->resetEvents();
@@ -314,8 +339,8 @@ Task &CharmDataModel::findTask(TaskId id)
 const Event &CharmDataModel::eventForId(EventId id) const
 {
     static const Event InvalidEvent;
-    EventMap::const_iterator it = m_events.find(id);
-    if (it != m_events.end()) {
+    EventMap::const_iterator it = m_events->events.find(id);
+    if (it != m_events->events.end()) {
         return it->second;
     } else {
         return InvalidEvent;
@@ -325,8 +350,9 @@ const Event &CharmDataModel::eventForId(EventId id) const
 Event &CharmDataModel::findEvent(int id)
 {
     // in this method, the event has to exist
-    const auto it = m_events.find(id);
-    Q_ASSERT(it != m_events.end());
+    EventMap &events = m_events->events;
+    const auto it = events.find(id);
+    Q_ASSERT(it != events.end());
     return it->second;
 }
 
@@ -351,6 +377,7 @@ bool CharmDataModel::activateEvent(const Event &activeEvent)
         }
     }
 
+    m_revision = ++m_lastRevision;
     m_activeEventIds << activeEvent.id();
     Q_FOREACH (auto adapter, m_adapters)
         adapter->eventActivated(activeEvent.id());
@@ -380,14 +407,32 @@ TaskTreeItem &CharmDataModel::parentItem(const Task &task)
     }
 }
 
+quint64 CharmDataModel::revision() const
+{
+    return m_lastRevision;
+}
+
+quint64 CharmDataModel::revision(const QDateTime &start, const QDateTime &end) const
+{
+    Q_FOREACH (EventId id, m_activeEventIds) {
+        const Event &event = eventForId(id);
+        const QDateTime eventEnd = event.endDateTime().isValid() ? event.endDateTime()
+                                   : event.startDateTime();
+        if ((!end.isValid() || event.startDateTime() < end)
+            && (!start.isValid() || eventEnd >= start))
+            return m_lastRevision;
+    }
+    return m_revision;
+}
+
 bool CharmDataModel::taskExists(TaskId id)
 {
     return m_tasks.find(id) != m_tasks.end();
 }
 
-bool CharmDataModel::eventExists(EventId id)
+bool CharmDataModel::eventExists(EventId id) const
 {
-    return m_events.find(id) != m_events.end();
+    return m_events->events.find(id) != m_events->events.end();
 }
 
 bool CharmDataModel::isTaskActive(TaskId id) const
@@ -439,6 +484,7 @@ void CharmDataModel::endEventRequested(const Task &task)
         if (eventForId(m_activeEventIds[i]).taskId() == task.id()) {
             eventId = m_activeEventIds[i];
             m_activeEventIds.removeAt(i);
+            m_revision = ++m_lastRevision;
             Q_FOREACH (auto adapter, m_adapters)
                 adapter->eventDeactivated(eventId);
             break;
@@ -449,6 +495,8 @@ void CharmDataModel::endEventRequested(const Task &task)
     Event &event = findEvent(eventId);
     Event old = event;
     event.setEndDateTime(QDateTime::currentDateTime());
+    m_events->count(old, -1);
+    m_events->count(event, 1);
 
     emit requestEventModification(event, old);
 
@@ -462,6 +510,7 @@ void CharmDataModel::endAllEventsRequested()
     while (!m_activeEventIds.isEmpty()) {
         EventId eventId = m_activeEventIds.first();
         m_activeEventIds.pop_front();
+        m_revision = ++m_lastRevision;
         Q_FOREACH (auto adapter, m_adapters)
             adapter->eventDeactivated(eventId);
 
@@ -469,6 +518,8 @@ void CharmDataModel::endAllEventsRequested()
         Event &event = findEvent(eventId);
         Event old = event;
         event.setEndDateTime(currentDateTime);
+        m_events->count(old, -1);
+        m_events->count(event, 1);
 
         emit requestEventModification(event, old);
     }
@@ -591,7 +642,7 @@ void CharmDataModel::updateToolTip()
 
 const EventMap &CharmDataModel::eventMap() const
 {
-    return m_events;
+    return m_events->events;
 }
 
 bool CharmDataModel::isEventActive(EventId id) const
@@ -612,8 +663,8 @@ EventIdList CharmDataModel::eventsThatStartInTimeFrame(const QDate &start, const
     const QDateTime endUTC = QDateTime(end, QTime(0, 0, 0)).toUTC();
     EventIdList events;
     EventMap::const_iterator it;
-    for (it = m_events.begin();
-         it != m_events.end(); ++it) {
+    for (it = m_events->events.begin();
+         it != m_events->events.end(); ++it) {
         const Event &event(it->second);
         if (event.startDateTime(Qt::UTC) >= startUTC && event.startDateTime(Qt::UTC) < endUTC)
             events << event.id();
@@ -627,6 +678,39 @@ EventIdList CharmDataModel::eventsThatStartInTimeFrame(const TimeSpan &timeSpan)
     return eventsThatStartInTimeFrame(timeSpan.first, timeSpan.second);
 }
 
+namespace {
+int monthIndex(const QDate &date)
+{
+    return date.year() * 12 + date.month() - 1;
+}
+}
+
+void CharmDataModel::EventData::count(const Event &event, int sign)
+{
+    const QDate date = event.startDateTime().date();
+    if (!date.isValid())
+        return;
+    QHash<TaskId, int> &seconds = monthlySeconds[monthIndex(date)];
+    seconds[event.taskId()] += sign * event.duration();
+}
+
+QMap<TaskId, QVector<int> > CharmDataModel::monthlySeconds(const QDate &start, int months) const
+{
+    QMap<TaskId, QVector<int> > result;
+    const int first = monthIndex(start);
+    const auto &monthly = m_events->monthlySeconds;
+    for (auto it = monthly.lower_bound(first); it != monthly.end() && it->first < first + months;
+         ++it) {
+        for (auto task = it->second.constBegin(); task != it->second.constEnd(); ++task) {
+            auto row = result.find(task.key());
+            if (row == result.end())
+                row = result.insert(task.key(), QVector<int>(months, 0));
+            (*row)[it->first - first] += task.value();
+        }
+    }
+    return result;
+}
+
 bool CharmDataModel::isParentOf(TaskId parent, TaskId id) const
 {
     Q_ASSERT_X(parent != 0, Q_FUNC_INFO, "parent is invalid (0)");
@@ -714,14 +798,20 @@ bool CharmDataModel::operator==(const CharmDataModel &other) const
     if (&other == this)
         return true;
     return getAllTasks() == other.getAllTasks()
-           && m_events == other.m_events
+           && m_events->events == other.m_events->events
            && m_activeEventIds == other.m_activeEventIds;
 }
 
 CharmDataModel *CharmDataModel::clone() const
 {
-    auto c = new CharmDataModel();
+    CharmDataModel *c = cloneEvents();
     c->setAllTasks(getAllTasks());
+    return c;
+}
+
+CharmDataModel *CharmDataModel::cloneEvents() const
+{
+    auto c = new CharmDataModel();
     c->m_events = m_events;
     c->m_activeEventIds = m_activeEventIds;
     return c;
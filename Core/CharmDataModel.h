@@ -27,8 +27,12 @@
 #ifndef CHARMDATAMODEL_H
 #define CHARMDATAMODEL_H
 
+#include <QHash>
+#include <QMap>
 #include <QObject>
+#include <QSharedData>
 #include <QTimer>
+#include <QVector>
 
 #include "Task.h"
 #include "State.h"
@@ -75,6 +79,7 @@ public:
     TaskList getAllTasks() const;
     /** Retrieve an event for the given event id. */
     const Event &eventForId(EventId id) const;
+    bool eventExists(EventId id) const;
     /** Constant access to the map of events. */
     const EventMap &eventMap() const;
     /**
@@ -84,6 +89,10 @@ public:
     EventIdList eventsThatStartInTimeFrame(const QDate &start, const QDate &end) const;
     // convenience overload
     EventIdList eventsThatStartInTimeFrame(const TimeSpan &timeSpan) const;
+    /** The seconds of the events of every task in the @p months months from the month of
+     *  @p start, by the month the events start in. The totals are kept up to date with the
+     *  events, the cost depends on the number of tasks and months, not on the events. */
+    QMap<TaskId, QVector<int> > monthlySeconds(const QDate &start, int months) const;
     const Event &activeEventFor(TaskId id) const;
     EventIdList activeEvents() const;
     int activeEventCount() const;
@@ -131,6 +140,22 @@ public:
 
     bool operator==(const CharmDataModel &other) const;
 
+    /** Copy the tasks and events into a new model, for example as a snapshot that is read
+        in another thread. The events are not copied, the models share them until one of
+        them modifies its events, which then makes a copy of its own. */
+    CharmDataModel *clone() const;
+    /** Like clone(), without the tasks. Building the task tree of a snapshot can be left
+        to the thread that reads it, by passing getAllTasks() to setAllTasks() there. */
+    CharmDataModel *cloneEvents() const;
+
+    /** A counter that changes whenever tasks, events or the set of active events change.
+        Results computed from the model can be reused as long as the revision is the same. */
+    quint64 revision() const;
+    /** The revision of the events between @p start and @p end, an invalid bound is open.
+        The periodic updates of the end time of active events only change it if the range
+        includes an active event, so that results for other ranges stay valid. */
+    quint64 revision(const QDateTime &start, const QDateTime &end) const;
+
 Q_SIGNALS:
     // these need to be implemented in the respective application to
     // be able to track time:
@@ -154,7 +179,6 @@ public Q_SLOTS:
 
 private:
     void determineTaskPaddingLength();
-    bool eventExists(EventId id);
 
     Task &findTask(TaskId id);
     Event &findEvent(EventId id);
@@ -167,7 +191,15 @@ private:
     TaskTreeItem::Map m_tasks;
     TaskTreeItem m_rootItem;
 
-    EventMap m_events;
+    struct EventData : public QSharedData {
+        EventMap events;
+        // the seconds per month of the event start, and task, see monthlySeconds():
+        std::map<int, QHash<TaskId, int> > monthlySeconds;
+        /** Add the duration of @p event to its month, or subtract it if @p sign is -1. */
+        void count(const Event &event, int sign);
+    };
+    // implicitly shared with the clones of the model, every write to the events detaches:
+    QSharedDataPointer<EventData> m_events;
     EventIdList m_activeEventIds;
     // adapters are notified when the model changes
     CharmDataModelAdapterList m_adapters;
@@ -175,12 +207,13 @@ private:
     // event update timer:
     QTimer m_timer;
     SmartNameCache m_nameCache;
+    // every change gets the next revision, m_revision is the latest one that was not
+    // an update of the end time of an active event:
+    quint64 m_lastRevision = 0;
+    quint64 m_revision = 0;
 
 private Q_SLOTS:
     void eventUpdateTimerEvent();
 
-private:
-    // functions only used for testing:
-    CharmDataModel *clone() const;
 };
 #endif
@@ -51,7 +51,8 @@ Configuration::Configuration(TaskPrefilteringMode _taskPrefilteringMode,
                              DurationFormat _durationFormat, bool _detectIdling,
                              Qt::ToolButtonStyle _buttonstyle, bool _showStatusBar,
                              bool _warnUnuploadedTimesheets, bool _requestEventComment,
-                             bool _enableCommandInterface, int _numberOfTaskSelectorEntries)
+                             bool _enableCommandInterface, int _numberOfTaskSelectorEntries,
+                             int _archiveEventsAfterMonths)
     : taskPrefilteringMode(_taskPrefilteringMode)
     , timeTrackerFontSize(_timeTrackerFontSize)
     , durationFormat(_durationFormat)
@@ -62,6 +63,7 @@ Configuration::Configuration(TaskPrefilteringMode _taskPrefilteringMode,
     , requestEventComment(_requestEventComment)
     , enableCommandInterface(_enableCommandInterface)
     , numberOfTaskSelectorEntries(_numberOfTaskSelectorEntries)
+    , archiveEventsAfterMonths(_archiveEventsAfterMonths)
     , configurationName(DEFAULT_CONFIG_GROUP)
 {
 }
@@ -81,7 +83,8 @@ bool Configuration::operator==(const Configuration &other) const
            && installationId == other.installationId
            && localStorageType == other.localStorageType
            && localStorageDatabase == other.localStorageDatabase
-           && numberOfTaskSelectorEntries == other.numberOfTaskSelectorEntries;
+           && numberOfTaskSelectorEntries == other.numberOfTaskSelectorEntries
+           && archiveEventsAfterMonths == other.archiveEventsAfterMonths;
 }
 
 void Configuration::writeTo(QSettings &settings)
@@ -151,7 +154,8 @@ void Configuration::dump(const QString &why)
              << "--> warnUnuploadedTimesheets: " << warnUnuploadedTimesheets << endl
              << "--> requestEventComment:      " << requestEventComment << endl
              << "--> enableCommandInterface:   " << enableCommandInterface
-             << "--> numberOfTaskSelectorEntries: " << numberOfTaskSelectorEntries;
+             << "--> numberOfTaskSelectorEntries: " << numberOfTaskSelectorEntries
+             << "--> archiveEventsAfterMonths: " << archiveEventsAfterMonths;
 }
 
 quint32 Configuration::createInstallationId() const
@@ -81,6 +81,8 @@ public:
     bool requestEventComment = false;
     bool enableCommandInterface = false;
     int numberOfTaskSelectorEntries = 5;
+    // events that ended this many months ago are archived, 0 keeps all events:
+    int archiveEventsAfterMonths = 0;
 
     // these are stored in QSettings, since we need this information to locate and open the database:
     QString configurationName;
@@ -103,7 +105,8 @@ private:
     Configuration(TaskPrefilteringMode taskPrefilteringMode, TimeTrackerFontSize,
                   DurationFormat durationFormat, bool detectIdling, Qt::ToolButtonStyle buttonstyle,
                   bool showStatusBar, bool warnUnuploadedTimesheets, bool _requestEventComment,
-                  bool enableCommandInterface, int _numberOfTaskSelectorEntries);
+                  bool enableCommandInterface, int _numberOfTaskSelectorEntries,
+                  int _archiveEventsAfterMonths);
     Configuration();
 };
 
@@ -35,6 +35,16 @@
 #include "SqlStorage.h"
 #include "Task.h"
 
+#include <QIODevice>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+#include <QCborMap>
+#include <QCborStreamReader>
+#include <QCborStreamWriter>
+#include <QCborValue>
+#endif
+#include <QSet>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 #include <QtDebug>
 
 Controller::Controller(QObject *parent_)
@@ -96,6 +106,14 @@ bool Controller::deleteEvent(const Event &e)
     }
 }
 
+bool Controller::archiveEvents(const QDateTime &cutoff)
+{
+    if (cutoff > QDateTime::currentDateTime() || !m_storage->archiveEvents(cutoff))
+        return false;
+    emit allEvents(m_storage->getAllEvents());
+    return true;
+}
+
 bool Controller::addTask(const Task &task)
 {
     if (m_storage->addTask(task)) {
@@ -139,10 +157,16 @@ bool Controller::deleteTask(const Task &task)
 
 bool Controller::setAllTasks(const TaskList &tasks)
 {
-    if (m_storage->setAllTasks(CONFIGURATION.user, tasks)) {
-        const TaskList newTasks = m_storage->getAllTasks();
-        // tell the view about the existing tasks;
-        emit definedTasks(newTasks);
+    SqlStorage::TaskListChanges changes;
+    if (m_storage->setAllTasks(CONFIGURATION.user, tasks, &changes)) {
+        // tell the view about the changes only: added tasks come parents first, and
+        // tasks are moved away before their old parents are removed
+        Q_FOREACH (const Task &task, changes.added)
+            emit taskAdded(task);
+        Q_FOREACH (const Task &task, changes.modified)
+            emit taskUpdated(task);
+        Q_FOREACH (const Task &task, changes.removed)
+            emit taskDeleted(task);
         return true;
     } else {
         return false;
@@ -237,43 +261,57 @@ void Controller::persistMetaData(Configuration &configuration)
         { MetaKey_Key_EnableCommandInterface,
           stringForBool(configuration.enableCommandInterface) },
         { MetaKey_Key_NumberOfTaskSelectorEntries,
-          QString::number(configuration.numberOfTaskSelectorEntries) }
+          QString::number(configuration.numberOfTaskSelectorEntries) },
+        { MetaKey_Key_ArchiveEventsAfterMonths,
+          QString::number(configuration.archiveEventsAfterMonths) }
     };
     int NumberOfSettings = sizeof settings / sizeof settings[0];
 
-    bool good = true;
+    // store all settings in one transaction:
+    QHash<QString, QString> metaData;
     for (int i = 0; i < NumberOfSettings; ++i)
-        good = good && m_storage->setMetaData(settings[i].key, settings[i].value);
+        metaData.insert(settings[i].key, settings[i].value);
+    const bool good = m_storage->setAllMetaData(metaData);
+    Q_UNUSED(good);
     Q_ASSERT_X(good, Q_FUNC_INFO, "Controller assumes write "
                                   "permissions in meta data table if persistMetaData is called");
     CONFIGURATION.dump();
 }
 
 template<class T>
-void Controller::loadConfigValue(const QString &key, T &configValue) const
+void Controller::loadConfigValue(const QHash<QString, QString> &metaData, const QString &key,
+                                 T &configValue) const
 {
-    const QString storedValue = m_storage->getMetaData(key);
-    if (storedValue.isNull())
+    const auto it = metaData.constFind(key);
+    if (it == metaData.constEnd())
         return;
-    configValue = strToT<T>(storedValue);
+    configValue = strToT<T>(*it);
 }
 
 void Controller::provideMetaData(Configuration &configuration)
 {
     Q_ASSERT_X(m_storage != nullptr, Q_FUNC_INFO, "No storage interface available");
-    configuration.user.setName(m_storage->getMetaData(MetaKey_Key_UserName));
-
-    loadConfigValue(MetaKey_Key_TimeTrackerFontSize, configuration.timeTrackerFontSize);
-    loadConfigValue(MetaKey_Key_DurationFormat, configuration.durationFormat);
-    loadConfigValue(MetaKey_Key_SubscribedTasksOnly, configuration.taskPrefilteringMode);
-    loadConfigValue(MetaKey_Key_IdleDetection, configuration.detectIdling);
-    loadConfigValue(MetaKey_Key_WarnUnuploadedTimesheets, configuration.warnUnuploadedTimesheets);
-    loadConfigValue(MetaKey_Key_RequestEventComment, configuration.requestEventComment);
-    loadConfigValue(MetaKey_Key_ToolButtonStyle, configuration.toolButtonStyle);
-    loadConfigValue(MetaKey_Key_ShowStatusBar, configuration.showStatusBar);
-    loadConfigValue(MetaKey_Key_EnableCommandInterface, configuration.enableCommandInterface);
-    loadConfigValue(MetaKey_Key_NumberOfTaskSelectorEntries, configuration.numberOfTaskSelectorEntries);
+    // load all settings with one query:
+    const QHash<QString, QString> metaData = m_storage->getAllMetaData();
+    configuration.user.setName(metaData.value(MetaKey_Key_UserName));
+
+    loadConfigValue(metaData, MetaKey_Key_TimeTrackerFontSize, configuration.timeTrackerFontSize);
+    loadConfigValue(metaData, MetaKey_Key_DurationFormat, configuration.durationFormat);
+    loadConfigValue(metaData, MetaKey_Key_SubscribedTasksOnly, configuration.taskPrefilteringMode);
+    loadConfigValue(metaData, MetaKey_Key_IdleDetection, configuration.detectIdling);
+    loadConfigValue(metaData, MetaKey_Key_WarnUnuploadedTimesheets,
+                    configuration.warnUnuploadedTimesheets);
+    loadConfigValue(metaData, MetaKey_Key_RequestEventComment, configuration.requestEventComment);
+    loadConfigValue(metaData, MetaKey_Key_ToolButtonStyle, configuration.toolButtonStyle);
+    loadConfigValue(metaData, MetaKey_Key_ShowStatusBar, configuration.showStatusBar);
+    loadConfigValue(metaData, MetaKey_Key_EnableCommandInterface,
+                    configuration.enableCommandInterface);
+    loadConfigValue(metaData, MetaKey_Key_NumberOfTaskSelectorEntries,
+                    configuration.numberOfTaskSelectorEntries);
     configuration.numberOfTaskSelectorEntries = qMax(0, configuration.numberOfTaskSelectorEntries);
+    loadConfigValue(metaData, MetaKey_Key_ArchiveEventsAfterMonths,
+                    configuration.archiveEventsAfterMonths);
+    configuration.archiveEventsAfterMonths = qMax(0, configuration.archiveEventsAfterMonths);
 
     CONFIGURATION.dump();
 }
@@ -287,6 +325,9 @@ bool Controller::initializeBackEnd(const QString &name)
     if (name == CHARM_SQLITE_BACKEND_DESCRIPTOR) {
         m_storage = new SqLiteStorage;
         return true;
+    } else if (name == CHARM_SQLITE_MEMORY_BACKEND_DESCRIPTOR) {
+        m_storage = new SqLiteStorage(SqLiteStorage::InMemory);
+        return true;
     } else {
         Q_ASSERT_X(false, Q_FUNC_INFO, "Unknown local storage backend type");
         return false;
@@ -312,14 +353,24 @@ bool Controller::disconnectFromBackend()
 
 void Controller::executeCommand(CharmCommand *command)
 {
-    command->execute(this);
+    // commands arrive through the event loop of the storage thread, which cannot propagate
+    // exceptions. Failures are sent back to the view with the command instead:
+    try {
+        command->execute(this);
+    } catch (const CharmException &e) {
+        command->setFailure(e.what());
+    }
     // send it back to the view:
     emit commandCompleted(command);
 }
 
 void Controller::rollbackCommand(CharmCommand *command)
 {
-    command->rollback(this);
+    try {
+        command->rollback(this);
+    } catch (const CharmException &e) {
+        command->setFailure(e.what());
+    }
     // send it back to the view:
     emit commandCompleted(command);
 }
@@ -334,6 +385,8 @@ const QString ExportRootElement(QStringLiteral("charmdatabase"));
 const QString VersionElement(QStringLiteral("version"));
 const QString TasksElement(QStringLiteral("tasks"));
 const QString EventsElement(QStringLiteral("events"));
+// the number of events read from a streamed import before they are written to the database:
+const int ImportEventChunkSize(1000);
 
 QDomDocument Controller::exportDatabasetoXml() const
 {
@@ -357,7 +410,7 @@ QDomDocument Controller::exportDatabasetoXml() const
     root.appendChild(tasksElement);
     // events element:
     QDomElement eventsElement = document.createElement(EventsElement);
-    EventList events = m_storage->getAllEvents();
+    EventList events = m_storage->getAllEvents(SqlStorage::AllEvents);
     Q_FOREACH (const Event &event, events) {
         QDomElement element = event.toXml(document);
         eventsElement.appendChild(element);
@@ -366,6 +419,42 @@ QDomDocument Controller::exportDatabasetoXml() const
     return document;
 }
 
+QString Controller::exportDatabaseToXml(QIODevice *device) const
+{
+    Q_ASSERT_X(device && device->isWritable(), Q_FUNC_INFO, "device must be open for writing");
+
+    QXmlStreamWriter writer(device);
+    writer.setAutoFormatting(true);
+    writer.setAutoFormattingIndent(4);
+    writer.writeStartDocument();
+    writer.writeDTD(QStringLiteral("<!DOCTYPE charmdatabase>"));
+    writer.writeStartElement(ExportRootElement);
+    writer.writeAttribute(VersionElement, QString::number(CHARM_DATABASE_VERSION));
+    writer.writeEmptyElement(MetaDataElement);
+
+    writer.writeStartElement(TasksElement);
+    const bool tasksRead = m_storage->visitAllTasks([&writer](const Task &task) {
+        task.writeXml(writer);
+    });
+    writer.writeEndElement();
+    if (!tasksRead)
+        return tr("The tasks could not be read from the database.");
+
+    writer.writeStartElement(EventsElement);
+    const bool eventsRead = m_storage->visitAllEvents([&writer](const Event &event) {
+        event.writeXml(writer);
+    }, SqlStorage::AllEvents);
+    writer.writeEndElement();
+    if (!eventsRead)
+        return tr("The events could not be read from the database.");
+
+    writer.writeEndElement();
+    writer.writeEndDocument();
+    if (writer.hasError())
+        return tr("Error writing the export: %1").arg(device->errorString());
+    return QString();
+}
+
 class MakeSureTheModelIsUpdated
 {
 public:
@@ -448,6 +537,562 @@ QString Controller::importDatabaseFromXml(const QDomDocument &document)
     return QString();
 }
 
+namespace {
+// Stores the tasks and events of a streamed import within one transaction, the events in chunks.
+// All changes are rolled back if the import is destroyed before it has been committed.
+class StreamingImport
+{
+public:
+    StreamingImport(SqlStorage *storage, QIODevice *device,
+                    const Controller::ImportProgress &progress)
+        : m_storage(storage)
+        , m_transactor(storage->database())
+        , m_device(device)
+        , m_progress(progress)
+        , m_bytesTotal(device->isSequential() ? 0 : device->size())
+    {
+        m_events.reserve(ImportEventChunkSize);
+    }
+
+    QString errorString() const
+    {
+        return m_errorString;
+    }
+
+    bool deleteExistingData()
+    {
+        // exports include the archived events, the archive is not used anymore:
+        if (m_storage->deleteAllEvents(m_transactor) && m_storage->deleteAllTasks(m_transactor)
+            && m_storage->discardArchive(m_transactor))
+            return true;
+        m_errorString = QObject::tr("Error deleting the existing tasks and events.");
+        return false;
+    }
+
+    bool addTask(const Task &task)
+    {
+        if (!task.isValid()) {
+            qDebug() << "The following task is invalid and will not be added:";
+            task.dump();
+            return true;
+        }
+        if (!m_storage->addImportedTask(CONFIGURATION.user, task, m_transactor)) {
+            m_errorString = QObject::tr("Cannot add imported tasks.");
+            return false;
+        }
+        m_taskIds.insert(task.id());
+        return true;
+    }
+
+    bool addEvent(const Event &event)
+    {
+        if (!event.isValid()) {
+            qDebug() << "The following event is invalid and will not be added:";
+            event.dump();
+            return true;
+        }
+        // events of unknown tasks are a semantical error:
+        if (!m_taskIds.contains(event.taskId()))
+            return true;
+        m_events.append(event);
+        return m_events.size() < ImportEventChunkSize || flushEvents();
+    }
+
+    bool commit()
+    {
+        if (!flushEvents())
+            return false;
+        if (!m_transactor.commit()) {
+            m_errorString = QObject::tr("The import could not be committed to the database.");
+            return false;
+        }
+        if (m_progress)
+            m_progress(qMax(m_device->pos(), m_bytesTotal), m_bytesTotal);
+        return true;
+    }
+
+    void reportProgress()
+    {
+        if (m_progress)
+            m_progress(m_device->pos(), m_bytesTotal);
+    }
+
+private:
+    bool flushEvents()
+    {
+        if (!m_storage->addEvents(m_events, m_transactor)) {
+            m_errorString = QObject::tr("Error adding imported event.");
+            return false;
+        }
+        m_events.clear();
+        reportProgress();
+        return true;
+    }
+
+    SqlStorage *m_storage;
+    SqlRaiiTransactor m_transactor;
+    QIODevice *m_device;
+    const Controller::ImportProgress &m_progress;
+    const qint64 m_bytesTotal;
+    QSet<TaskId> m_taskIds;
+    EventList m_events;
+    QString m_errorString;
+};
+}
+
+QString Controller::importDatabaseFromXml(QIODevice *device, const ImportProgress &progress)
+{
+    Q_ASSERT_X(device && device->isReadable(), Q_FUNC_INFO, "device must be open for reading");
+    MakeSureTheModelIsUpdated m(this);
+
+    QXmlStreamReader reader(device);
+    StreamingImport importer(m_storage, device, progress);
+    try {
+        if (!reader.readNextStartElement() || reader.name() != ExportRootElement)
+            throw XmlSerializationException(QObject::tr("This is not a Charm database export."));
+        bool ok;
+        const int databaseSchemaVersion = reader.attributes().value(VersionElement).toInt(&ok);
+        if (!ok) throw XmlSerializationException(QObject::tr(
+                                                     "Syntax error, no version attribute found."));
+
+        if (!importer.deleteExistingData())
+            return tr("Error importing tasks and events from the file:<br />%1")
+                   .arg(importer.errorString());
+
+        while (reader.readNextStartElement()) {
+            if (reader.name() == TasksElement) {
+                while (reader.readNextStartElement()) {
+                    if (reader.name() != Task::tagName()) {
+                        reader.skipCurrentElement();
+                        continue;
+                    }
+                    if (!importer.addTask(Task::fromXml(reader, databaseSchemaVersion)))
+                        return tr("Error importing tasks and events from the file:<br />%1")
+                               .arg(importer.errorString());
+                }
+                importer.reportProgress();
+            } else if (reader.name() == EventsElement) {
+                while (reader.readNextStartElement()) {
+                    if (reader.name() != Event::tagName()) {
+                        reader.skipCurrentElement();
+                        continue;
+                    }
+                    if (!importer.addEvent(Event::fromXml(reader, databaseSchemaVersion)))
+                        return tr("Error importing tasks and events from the file:<br />%1")
+                               .arg(importer.errorString());
+                }
+            } else {
+                reader.skipCurrentElement();
+            }
+        }
+        if (reader.hasError())
+            throw XmlSerializationException(tr("[%1:%2] %3").arg(QString::number(reader.lineNumber()),
+                                                                 QString::number(reader.columnNumber()),
+                                                                 reader.errorString()));
+    } catch (const XmlSerializationException &e) {
+        qDebug() << "Controller::importDatabaseFromXml: invalid export file:" << e.what();
+        return tr("The export file is invalid: %1").arg(e.what());
+    }
+
+    if (!importer.commit())
+        return tr("Error importing tasks and events from the file:<br />%1")
+               .arg(importer.errorString());
+
+    // tell the model that the tasks and events have vanished:
+    emit allEvents(EventList());
+    emit definedTasks(TaskList());
+
+    return QString();
+}
+
+const QString DeltaRootElement(QStringLiteral("charmdatabasedelta"));
+const QString DeltaSinceAttribute(QStringLiteral("since"));
+const QString DeltaUntilAttribute(QStringLiteral("until"));
+const QString DeltaInstallationAttribute(QStringLiteral("installation"));
+const QString DeletionsElement(QStringLiteral("deletions"));
+const QString DeletedIdAttribute(QStringLiteral("id"));
+
+QString Controller::exportDeltaToXml(QIODevice *device, qint64 since, qint64 *lastChange) const
+{
+    Q_ASSERT_X(device && device->isWritable(), Q_FUNC_INFO, "device must be open for writing");
+
+    SqlStorage::ChangeSet changes;
+    if (!m_storage->getChangesSince(since, &changes))
+        return tr("The changes could not be read from the database.");
+
+    // same structure as the database export, with a different root element, so that a delta
+    // is never mistaken for a complete export:
+    QXmlStreamWriter writer(device);
+    writer.setAutoFormatting(true);
+    writer.setAutoFormattingIndent(4);
+    writer.writeStartDocument();
+    writer.writeDTD(QStringLiteral("<!DOCTYPE charmdatabasedelta>"));
+    writer.writeStartElement(DeltaRootElement);
+    writer.writeAttribute(VersionElement, QString::number(CHARM_DATABASE_VERSION));
+    writer.writeAttribute(DeltaSinceAttribute, QString::number(since));
+    writer.writeAttribute(DeltaUntilAttribute, QString::number(changes.lastChange));
+    writer.writeEmptyElement(MetaDataElement);
+
+    writer.writeStartElement(TasksElement);
+    Q_FOREACH (const Task &task, changes.tasks)
+        task.writeXml(writer);
+    writer.writeEndElement();
+
+    // the event ids are the ids in the installation that created the events, one element
+    // per installation:
+    QList<quint32> installations;
+    Q_FOREACH (quint32 installation, changes.eventInstallations) {
+        if (!installations.contains(installation))
+            installations.append(installation);
+    }
+    Q_FOREACH (quint32 installation, installations) {
+        writer.writeStartElement(EventsElement);
+        writer.writeAttribute(DeltaInstallationAttribute, QString::number(installation));
+        for (int i = 0; i < changes.events.size(); ++i) {
+            if (changes.eventInstallations.at(i) == installation)
+                changes.events.at(i).writeXml(writer);
+        }
+        writer.writeEndElement();
+    }
+
+    writer.writeStartElement(DeletionsElement);
+    Q_FOREACH (TaskId id, changes.deletedTasks) {
+        writer.writeEmptyElement(Task::tagName());
+        writer.writeAttribute(DeletedIdAttribute, QString::number(id));
+    }
+    for (int i = 0; i < changes.deletedEvents.size(); ++i) {
+        writer.writeEmptyElement(Event::tagName());
+        writer.writeAttribute(DeletedIdAttribute, QString::number(changes.deletedEvents.at(i)));
+        writer.writeAttribute(DeltaInstallationAttribute,
+                              QString::number(changes.deletedEventInstallations.at(i)));
+    }
+    writer.writeEndElement();
+
+    writer.writeEndElement();
+    writer.writeEndDocument();
+    if (writer.hasError())
+        return tr("Error writing the export: %1").arg(device->errorString());
+    if (lastChange)
+        *lastChange = changes.lastChange;
+    return QString();
+}
+
+QString Controller::importDeltaFromXml(QIODevice *device)
+{
+    Q_ASSERT_X(device && device->isReadable(), Q_FUNC_INFO, "device must be open for reading");
+
+    // deltas are small, they are read completely before the database is modified:
+    SqlStorage::ChangeSet changes;
+    QXmlStreamReader reader(device);
+    try {
+        if (!reader.readNextStartElement() || reader.name() != DeltaRootElement)
+            throw XmlSerializationException(QObject::tr("This is not a Charm database delta export."));
+        bool ok;
+        const int databaseSchemaVersion = reader.attributes().value(VersionElement).toInt(&ok);
+        if (!ok) throw XmlSerializationException(QObject::tr(
+                                                     "Syntax error, no version attribute found."));
+        // event ids are only unique within the installation that created the event, events
+        // without one are matched by their ids:
+        const auto installationOf = [](const QXmlStreamReader &reader) {
+            bool ok;
+            const quint32 installation
+                = reader.attributes().value(DeltaInstallationAttribute).toUInt(&ok);
+            return ok ? installation : SqlStorage::UnknownInstallationId;
+        };
+
+        while (reader.readNextStartElement()) {
+            if (reader.name() == TasksElement) {
+                while (reader.readNextStartElement()) {
+                    if (reader.name() != Task::tagName()) {
+                        reader.skipCurrentElement();
+                        continue;
+                    }
+                    const Task task = Task::fromXml(reader, databaseSchemaVersion);
+                    if (task.isValid())
+                        changes.tasks.append(task);
+                }
+            } else if (reader.name() == EventsElement) {
+                const quint32 installation = installationOf(reader);
+                while (reader.readNextStartElement()) {
+                    if (reader.name() != Event::tagName()) {
+                        reader.skipCurrentElement();
+                        continue;
+                    }
+                    const Event event = Event::fromXml(reader, databaseSchemaVersion);
+                    if (event.isValid()) {
+                        changes.events.append(event);
+                        changes.eventInstallations.append(installation);
+                    }
+                }
+            } else if (reader.name() == DeletionsElement) {
+                while (reader.readNextStartElement()) {
+                    const int id = reader.attributes().value(DeletedIdAttribute).toInt(&ok);
+                    if (!ok)
+                        throw XmlSerializationException(QObject::tr(
+                                                            "Syntax error, deletion without an id."));
+                    if (reader.name() == Task::tagName())
+                        changes.deletedTasks.append(id);
+                    else if (reader.name() == Event::tagName()) {
+                        changes.deletedEvents.append(id);
+                        changes.deletedEventInstallations.append(installationOf(reader));
+                    }
+                    reader.skipCurrentElement();
+                }
+            } else {
+                reader.skipCurrentElement();
+            }
+        }
+        if (reader.hasError())
+            throw XmlSerializationException(tr("[%1:%2] %3").arg(QString::number(reader.lineNumber()),
+                                                                 QString::number(reader.columnNumber()),
+                                                                 reader.errorString()));
+    } catch (const XmlSerializationException &e) {
+        qDebug() << "Controller::importDeltaFromXml: invalid delta file:" << e.what();
+        return tr("The delta export is invalid: %1").arg(e.what());
+    }
+
+    MakeSureTheModelIsUpdated m(this);
+    SqlRaiiTransactor transactor(m_storage->database());
+    if (!m_storage->applyChanges(CONFIGURATION.user, changes, transactor) || !transactor.commit())
+        return tr("Error applying the changes to the database.");
+    return QString();
+}
+
+qint64 Controller::deltaWatermark() const
+{
+    return m_storage->getMetaData(MetaKey_DeltaExportWatermark).toLongLong();
+}
+
+bool Controller::setDeltaWatermark(qint64 change)
+{
+    return m_storage->setMetaData(MetaKey_DeltaExportWatermark, QString::number(change));
+}
+
+namespace {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+// the binary export is a CBOR map, with the XML element and attribute names as keys:
+const QString BinaryFormatKey(QStringLiteral("format"));
+const QString BinaryFormatVersionKey(QStringLiteral("formatversion"));
+const int BinaryFormatVersion(1);
+const QString TaskIdKey(QStringLiteral("taskid"));
+const QString TaskParentIdKey(QStringLiteral("parentid"));
+const QString TaskSubscribedKey(QStringLiteral("subscribed"));
+const QString TaskTrackableKey(QStringLiteral("trackable"));
+const QString TaskValidFromKey(QStringLiteral("validfrom"));
+const QString TaskValidUntilKey(QStringLiteral("validuntil"));
+const QString TaskNameKey(QStringLiteral("name"));
+const QString EventIdKey(QStringLiteral("eventid"));
+const QString EventTaskIdKey(QStringLiteral("taskid"));
+const QString EventUserIdKey(QStringLiteral("userid"));
+const QString EventReportIdKey(QStringLiteral("reportid"));
+const QString EventStartKey(QStringLiteral("start"));
+const QString EventEndKey(QStringLiteral("end"));
+const QString EventCommentKey(QStringLiteral("comment"));
+
+// time stamps are stored as seconds since the epoch
+QCborMap taskToBinary(const Task &task)
+{
+    QCborMap map;
+    map.insert(TaskIdKey, task.id());
+    map.insert(TaskParentIdKey, task.parent());
+    map.insert(TaskSubscribedKey, task.subscribed());
+    map.insert(TaskTrackableKey, task.trackable());
+    if (task.validFrom().isValid())
+        map.insert(TaskValidFromKey, task.validFrom().toSecsSinceEpoch());
+    if (task.validUntil().isValid())
+        map.insert(TaskValidUntilKey, task.validUntil().toSecsSinceEpoch());
+    if (!task.name().isEmpty())
+        map.insert(TaskNameKey, task.name());
+    return map;
+}
+
+Task taskFromBinary(const QCborMap &map)
+{
+    if (!map.value(TaskIdKey).isInteger() || !map.value(TaskParentIdKey).isInteger())
+        throw ParseError(QObject::tr("Task without a valid task or parent id"));
+    Task task;
+    task.setId(map.value(TaskIdKey).toInteger());
+    task.setParent(map.value(TaskParentIdKey).toInteger());
+    task.setSubscribed(map.value(TaskSubscribedKey).toBool());
+    task.setTrackable(map.value(TaskTrackableKey).toBool(true));
+    if (map.contains(TaskValidFromKey))
+        task.setValidFrom(QDateTime::fromSecsSinceEpoch(map.value(TaskValidFromKey).toInteger()));
+    if (map.contains(TaskValidUntilKey))
+        task.setValidUntil(QDateTime::fromSecsSinceEpoch(map.value(TaskValidUntilKey).toInteger()));
+    task.setName(map.value(TaskNameKey).toString());
+    return task;
+}
+
+QCborMap eventToBinary(const Event &event)
+{
+    QCborMap map;
+    map.insert(EventIdKey, event.id());
+    map.insert(EventTaskIdKey, event.taskId());
+    map.insert(EventUserIdKey, event.userId());
+    map.insert(EventReportIdKey, event.reportId());
+    if (event.startDateTime().isValid())
+        map.insert(EventStartKey, event.startDateTime().toSecsSinceEpoch());
+    if (event.endDateTime().isValid())
+        map.insert(EventEndKey, event.endDateTime().toSecsSinceEpoch());
+    if (!event.comment().isEmpty())
+        map.insert(EventCommentKey, event.comment());
+    return map;
+}
+
+Event eventFromBinary(const QCborMap &map)
+{
+    if (!map.value(EventIdKey).isInteger() || !map.value(EventTaskIdKey).isInteger())
+        throw ParseError(QObject::tr("Event without a valid event or task id"));
+    Event event;
+    event.setId(map.value(EventIdKey).toInteger());
+    event.setTaskId(map.value(EventTaskIdKey).toInteger());
+    event.setUserId(map.value(EventUserIdKey).toInteger());
+    event.setReportId(map.value(EventReportIdKey).toInteger());
+    if (map.contains(EventStartKey))
+        event.setStartDateTime(QDateTime::fromSecsSinceEpoch(map.value(EventStartKey).toInteger()));
+    if (map.contains(EventEndKey))
+        event.setEndDateTime(QDateTime::fromSecsSinceEpoch(map.value(EventEndKey).toInteger()));
+    event.setComment(map.value(EventCommentKey).toString());
+    return event;
+}
+#endif
+}
+
+QString Controller::exportDatabaseToBinary(QIODevice *device) const
+{
+    Q_ASSERT_X(device && device->isWritable(), Q_FUNC_INFO, "device must be open for writing");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    QCborStreamWriter writer(device);
+    writer.append(QCborKnownTags::Signature);
+    writer.startMap(6);
+    writer.append(BinaryFormatKey);
+    writer.append(ExportRootElement);
+    writer.append(BinaryFormatVersionKey);
+    writer.append(qint64(BinaryFormatVersion));
+    writer.append(VersionElement);
+    writer.append(qint64(CHARM_DATABASE_VERSION));
+    writer.append(MetaDataElement);
+    writer.startMap(0);
+    writer.endMap();
+
+    // the task and event arrays are written without knowing their size in advance:
+    writer.append(TasksElement);
+    writer.startArray();
+    const bool tasksRead = m_storage->visitAllTasks([&writer](const Task &task) {
+        QCborValue(taskToBinary(task)).toCbor(writer);
+    });
+    writer.endArray();
+    if (!tasksRead)
+        return tr("The tasks could not be read from the database.");
+
+    writer.append(EventsElement);
+    writer.startArray();
+    const bool eventsRead = m_storage->visitAllEvents([&writer](const Event &event) {
+        QCborValue(eventToBinary(event)).toCbor(writer);
+    }, SqlStorage::AllEvents);
+    writer.endArray();
+    if (!eventsRead)
+        return tr("The events could not be read from the database.");
+
+    writer.endMap();
+    return QString();
+#else
+    Q_UNUSED(device);
+    return tr("The binary export format requires Qt 5.12 or later.");
+#endif
+}
+
+QString Controller::importDatabaseFromBinary(QIODevice *device, const ImportProgress &progress)
+{
+    Q_ASSERT_X(device && device->isReadable(), Q_FUNC_INFO, "device must be open for reading");
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    MakeSureTheModelIsUpdated m(this);
+
+    QCborStreamReader reader(device);
+    StreamingImport importer(m_storage, device, progress);
+    const QString notAnExport = QObject::tr("This is not a Charm database export.");
+    try {
+        if (reader.isTag() && reader.toTag() == QCborTag(QCborKnownTags::Signature))
+            reader.next();
+        if (!reader.isMap() || !reader.enterContainer())
+            throw ParseError(notAnExport);
+
+        bool headerRead = false;
+        bool existingDataDeleted = false;
+        while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+            const QString key = QCborValue::fromCbor(reader).toString();
+            if (key == BinaryFormatKey) {
+                if (QCborValue::fromCbor(reader).toString() != ExportRootElement)
+                    throw ParseError(notAnExport);
+            } else if (key == BinaryFormatVersionKey) {
+                const qint64 formatVersion = QCborValue::fromCbor(reader).toInteger();
+                if (formatVersion < 1 || formatVersion > BinaryFormatVersion)
+                    throw ParseError(QObject::tr("Unsupported binary export version %1.")
+                                     .arg(formatVersion));
+                headerRead = true;
+            } else if (key == TasksElement || key == EventsElement) {
+                // the database is only changed once the file is known to be an export:
+                if (!headerRead)
+                    throw ParseError(notAnExport);
+                if (!existingDataDeleted) {
+                    if (!importer.deleteExistingData())
+                        return tr("Error importing tasks and events from the file:<br />%1")
+                               .arg(importer.errorString());
+                    existingDataDeleted = true;
+                }
+                if (!reader.isArray() || !reader.enterContainer())
+                    throw ParseError(QObject::tr("Syntax error in the %1 array.").arg(key));
+                while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+                    const QCborMap map = QCborValue::fromCbor(reader).toMap();
+                    if (reader.lastError() != QCborError::NoError)
+                        break;
+                    const bool added = key == TasksElement ? importer.addTask(taskFromBinary(map))
+                                       : importer.addEvent(eventFromBinary(map));
+                    if (!added)
+                        return tr("Error importing tasks and events from the file:<br />%1")
+                               .arg(importer.errorString());
+                }
+                if (reader.lastError() == QCborError::NoError)
+                    reader.leaveContainer();
+                importer.reportProgress();
+            } else {
+                // skip unknown entries, like the metadata:
+                QCborValue::fromCbor(reader);
+            }
+        }
+        if (reader.lastError() == QCborError::NoError)
+            reader.leaveContainer();
+        if (reader.lastError() != QCborError::NoError)
+            throw ParseError(reader.lastError().toString());
+        if (!headerRead)
+            throw ParseError(notAnExport);
+    } catch (const ParseError &e) {
+        qDebug() << "Controller::importDatabaseFromBinary: invalid export file:" << e.what();
+        return tr("The export file is invalid: %1").arg(e.what());
+    }
+
+    if (!importer.commit())
+        return tr("Error importing tasks and events from the file:<br />%1")
+               .arg(importer.errorString());
+
+    // tell the model that the tasks and events have vanished:
+    emit allEvents(EventList());
+    emit definedTasks(TaskList());
+
+    return QString();
+#else
+    Q_UNUSED(device);
+    Q_UNUSED(progress);
+    return tr("The binary export format requires Qt 5.12 or later.");
+#endif
+}
+
+bool Controller::isBinaryDatabaseExport(QIODevice *device)
+{
+    // the self-described CBOR tag the binary export starts with:
+    return device->peek(3) == QByteArray::fromHex("d9d9f7");
+}
+
 void Controller::updateModelEventsAndTasks()
 {
     TaskList tasks = m_storage->getAllTasks();
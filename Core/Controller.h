@@ -26,14 +26,18 @@
 #ifndef CONTROLLER_H
 #define CONTROLLER_H
 
+#include <QHash>
 #include <QObject>
 
+#include <functional>
+
 #include "Event.h"
 #include "Task.h"
 #include "State.h"
 
 class CharmCommand;
 class Configuration;
+class QIODevice;
 class SqlStorage;
 
 class Controller : public QObject
@@ -81,6 +85,11 @@ public:
     /** Delete an event. */
     bool deleteEvent(const Event &);
 
+    /** Move the events that ended before @p cutoff into the archive database.
+        The cutoff must not be in the future, to keep running events in place.
+        The view receives the remaining events. */
+    bool archiveEvents(const QDateTime &cutoff);
+
     /** Add a task, and send the result to the view as a signal. */
     bool addTask(const Task &parent);
 
@@ -96,12 +105,65 @@ public:
     /** Export the database contents into a XML document. */
     QDomDocument exportDatabasetoXml() const;
 
+    /** Export the database contents as XML directly to @p device, reading the rows one by one.
+     *  The output can be imported with importDatabaseFromXml().
+     *  @return An empty string on no error, an human-readable error message otherwise.
+     */
+    QString exportDatabaseToXml(QIODevice *device) const;
+
     /** Import the content of the Xml document into the currently open database.
      *  This will modify the database.
      *  @return An empty string on no error, an human-readable error message otherwise.
      */
     QString importDatabaseFromXml(const QDomDocument &);
 
+    /** Called with the number of bytes read so far and the size of the import file, or 0 if unknown. */
+    typedef std::function<void(qint64 bytesRead, qint64 bytesTotal)> ImportProgress;
+
+    /** Import a database export from @p device, without loading the whole file into memory.
+     *  Events are validated and stored in chunks, all within one transaction, so the database
+     *  is unchanged if the file turns out to be invalid. @p progress is called after every chunk.
+     *  The tasks element has to precede the events element, as in all Charm exports.
+     *  @return An empty string on no error, an human-readable error message otherwise.
+     */
+    QString importDatabaseFromXml(QIODevice *device, const ImportProgress &progress = ImportProgress());
+
+    /** Export the tasks and events that were added, modified or deleted after change @p since
+     *  as XML to @p device. Deleted tasks and events are listed by their ids.
+     *  @p lastChange receives the latest change in the export, which is the watermark for the
+     *  next delta export. See SqlStorage::lastChange().
+     *  @return An empty string on no error, an human-readable error message otherwise.
+     */
+    QString exportDeltaToXml(QIODevice *device, qint64 since, qint64 *lastChange = nullptr) const;
+
+    /** Apply a delta export from @p device in one transaction. Tasks are added or replaced
+     *  keeping their ids, so deltas apply to a copy of the database they were exported from,
+     *  or to a database that received the same earlier deltas. Events are identified by the
+     *  installation that created them, see SqlStorage::applyChanges().
+     *  @return An empty string on no error, an human-readable error message otherwise.
+     */
+    QString importDeltaFromXml(QIODevice *device);
+
+    /** The change the next delta export starts after, as stored in the database metadata. */
+    qint64 deltaWatermark() const;
+
+    /** Store @p change as the delta watermark, after a delta export up to it has been saved. */
+    bool setDeltaWatermark(qint64 change);
+
+    /** Export the database contents in the binary (CBOR) export format to @p device, reading
+     *  the rows one by one. It carries the same data as the XML export.
+     *  The binary format requires Qt 5.12, an error is returned with older versions.
+     *  @return An empty string on no error, an human-readable error message otherwise.
+     */
+    QString exportDatabaseToBinary(QIODevice *device) const;
+
+    /** Import a binary database export from @p device, like importDatabaseFromXml(). */
+    QString importDatabaseFromBinary(QIODevice *device,
+                                     const ImportProgress &progress = ImportProgress());
+
+    /** Returns true if the data available on @p device starts with a binary database export. */
+    static bool isBinaryDatabaseExport(QIODevice *device);
+
     void updateModelEventsAndTasks();
 
 public Q_SLOTS:
@@ -152,7 +214,8 @@ Q_SIGNALS:
 private:
     void updateSubscriptionForTask(const Task &);
 
-    template<class T> void loadConfigValue(const QString &key, T &configValue) const;
+    template<class T> void loadConfigValue(const QHash<QString, QString> &metaData,
+                                           const QString &key, T &configValue) const;
     SqlStorage *m_storage = nullptr;
 };
 
@@ -0,0 +1,156 @@
+/*
+  CsvWriter.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CsvWriter.h"
+#include "Event.h"
+
+#include <QFileInfo>
+#include <QIODevice>
+
+namespace {
+const int BufferSize = 64 * 1024;
+
+QString dateTimeField(const QDateTime &dateTime)
+{
+    // the format spreadsheets recognize, in local time:
+    return dateTime.toLocalTime().toString(QStringLiteral("yyyy-MM-dd HH:mm:ss"));
+}
+
+bool startsLikeFormula(const QString &field)
+{
+    if (field.isEmpty())
+        return false;
+    const QChar first = field.at(0);
+    if (first != QLatin1Char('=') && first != QLatin1Char('+') && first != QLatin1Char('-')
+        && first != QLatin1Char('@'))
+        return false;
+    // signed numbers are no formulas:
+    bool isNumber = false;
+    field.toDouble(&isNumber);
+    return !isNumber;
+}
+}
+
+CsvWriter::CsvWriter(QIODevice *device, Format format)
+    : m_device(device)
+    , m_format(format)
+    , m_separator(format == TabSeparated ? '\t' : ',')
+{
+    Q_ASSERT_X(m_device && m_device->isWritable(), Q_FUNC_INFO,
+               "The device needs to be opened for writing");
+    // reserved, so that the buffer is reused after every flush:
+    m_buffer.reserve(BufferSize + 4096);
+}
+
+CsvWriter::~CsvWriter()
+{
+    flush();
+}
+
+CsvWriter::Format CsvWriter::format() const
+{
+    return m_format;
+}
+
+void CsvWriter::writeRow(const QStringList &fields)
+{
+    for (int i = 0; i < fields.size(); ++i) {
+        if (i > 0)
+            m_buffer += m_separator;
+        appendField(fields.at(i));
+    }
+    m_buffer += "\r\n";
+    if (m_buffer.size() >= BufferSize)
+        flush();
+}
+
+QStringList CsvWriter::eventColumns()
+{
+    return QStringList() << QStringLiteral("Event Id")
+                         << QStringLiteral("Task Id")
+                         << QStringLiteral("Task")
+                         << QStringLiteral("Start")
+                         << QStringLiteral("End")
+                         << QStringLiteral("Seconds")
+                         << QStringLiteral("Hours")
+                         << QStringLiteral("Comment");
+}
+
+void CsvWriter::writeEvent(const Event &event, const QString &taskName)
+{
+    const int seconds = event.duration();
+    writeRow(QStringList() << QString::number(event.id())
+                           << QString::number(event.taskId())
+                           << taskName
+                           << dateTimeField(event.startDateTime())
+                           << dateTimeField(event.endDateTime())
+                           << QString::number(seconds)
+                           << hours(seconds)
+                           << event.comment());
+}
+
+bool CsvWriter::flush()
+{
+    if (!m_failed && !m_buffer.isEmpty())
+        m_failed = m_device->write(m_buffer) != m_buffer.size();
+    m_buffer.resize(0);
+    return !m_failed;
+}
+
+QString CsvWriter::errorString() const
+{
+    return m_device->errorString();
+}
+
+QString CsvWriter::hours(int seconds)
+{
+    return QString::number(seconds / 3600.0, 'f', 2);
+}
+
+CsvWriter::Format CsvWriter::formatForFileName(const QString &fileName)
+{
+    QString name = fileName;
+    if (name.endsWith(QLatin1String(".gz"), Qt::CaseInsensitive))
+        name.chop(3);
+    return QFileInfo(name).suffix().compare(QLatin1String("tsv"), Qt::CaseInsensitive) == 0
+           ? TabSeparated : CommaSeparated;
+}
+
+void CsvWriter::appendField(const QString &field)
+{
+    // spreadsheets evaluate fields that start like a formula, for example a comment "=1+2",
+    // the quote makes them text:
+    const QByteArray text = startsLikeFormula(field) ? QByteArray("'") + field.toUtf8()
+                            : field.toUtf8();
+    const bool quoted = text.contains(m_separator) || text.contains('"')
+                        || text.contains('\n') || text.contains('\r');
+    if (!quoted) {
+        m_buffer += text;
+        return;
+    }
+    m_buffer += '"';
+    for (char c : text) {
+        if (c == '"')
+            m_buffer += '"';
+        m_buffer += c;
+    }
+    m_buffer += '"';
+}
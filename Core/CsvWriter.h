@@ -0,0 +1,79 @@
+/*
+  CsvWriter.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CSVWRITER_H
+#define CSVWRITER_H
+
+#include <QByteArray>
+#include <QStringList>
+
+class QIODevice;
+class Event;
+
+/** CsvWriter writes tables as comma or tab separated values into an already opened device,
+    row by row, for spreadsheets. Only a small buffer is kept, so that exports of long time
+    ranges are streamed instead of being built in memory first.
+    Fields that contain the separator, quotes or line breaks are quoted as in RFC 4180, in
+    both formats. Fields that start with =, +, - or @ and are not numbers are prefixed with
+    a single quote, so that spreadsheets do not evaluate them as formulas. The text is UTF-8
+    encoded and rows end in CRLF. */
+class CsvWriter
+{
+public:
+    enum Format {
+        CommaSeparated,
+        TabSeparated
+    };
+
+    explicit CsvWriter(QIODevice *device, Format format = CommaSeparated);
+    /** Flushes the remaining rows. */
+    ~CsvWriter();
+
+    Format format() const;
+
+    void writeRow(const QStringList &fields);
+    /** The column names of the rows written by writeEvent(). */
+    static QStringList eventColumns();
+    /** Write @p event as a row, in the task @p taskName. */
+    void writeEvent(const Event &event, const QString &taskName);
+
+    /** Write the buffered rows into the device. Returns false if this or an earlier write
+        failed, see errorString(). */
+    bool flush();
+    QString errorString() const;
+
+    /** A time span of @p seconds, as a decimal number of hours. */
+    static QString hours(int seconds);
+    /** The format implied by the suffix of @p fileName (".tsv" for tab separated values),
+        ignoring a trailing ".gz". */
+    static Format formatForFileName(const QString &fileName);
+
+private:
+    void appendField(const QString &field);
+
+    QIODevice *m_device;
+    Format m_format;
+    char m_separator;
+    QByteArray m_buffer;
+    bool m_failed = false;
+};
+
+#endif
@@ -26,6 +26,33 @@
 
 #include <QDate>
 
+namespace {
+// reads the @p length decimal digits at @p data, returns false if one is not a digit
+bool readDigits(const QChar *data, int length, int *value)
+{
+    int result = 0;
+    for (int i = 0; i < length; ++i) {
+        const ushort digit = ushort(data[i].unicode() - '0');
+        if (digit > 9)
+            return false;
+        result = result * 10 + digit;
+    }
+    *value = result;
+    return true;
+}
+
+// writes @p value as @p length decimal digits with leading zeros to @p data
+void writeDigits(QChar *data, int length, int value)
+{
+    for (int i = length - 1; i >= 0; --i) {
+        data[i] = QLatin1Char('0' + value % 10);
+        value /= 10;
+    }
+}
+
+const int IsoDateTimeLength = 19; // yyyy-MM-ddTHH:mm:ss
+}
+
 //find date for a certain weekday in week no/year
 QDate Charm::dateByWeekNumberAndWeekDay(int year, int week, int day)
 {
@@ -70,3 +97,60 @@ int Charm::weekDifference(const QDate &from, const QDate &to)
 
     return toWeekNumber + weeksForInterveningYears - fromWeekNumber;
 }
+
+QDateTime Charm::dateTimeFromIsoString(const QString &string)
+{
+    const bool utc = string.size() == IsoDateTimeLength + 1
+                     && string.at(IsoDateTimeLength) == QLatin1Char('Z');
+    if (string.size() != IsoDateTimeLength && !utc)
+        return QDateTime::fromString(string, Qt::ISODate);
+
+    const QChar *data = string.constData();
+    int year, month, day, hour, minute, second;
+    if (data[4] != QLatin1Char('-') || data[7] != QLatin1Char('-')
+        || data[10] != QLatin1Char('T') || data[13] != QLatin1Char(':')
+        || data[16] != QLatin1Char(':')
+        || !readDigits(data, 4, &year) || !readDigits(data + 5, 2, &month)
+        || !readDigits(data + 8, 2, &day) || !readDigits(data + 11, 2, &hour)
+        || !readDigits(data + 14, 2, &minute) || !readDigits(data + 17, 2, &second))
+        return QDateTime::fromString(string, Qt::ISODate);
+
+    const QDate date(year, month, day);
+    const QTime time(hour, minute, second);
+    // leave the special cases (like 24:00:00) and the error handling to Qt:
+    if (!date.isValid() || !time.isValid())
+        return QDateTime::fromString(string, Qt::ISODate);
+    return QDateTime(date, time, utc ? Qt::UTC : Qt::LocalTime);
+}
+
+QString Charm::dateTimeToIsoString(const QDateTime &dateTime)
+{
+    if (!dateTime.isValid())
+        return QString();
+    const Qt::TimeSpec spec = dateTime.timeSpec();
+    const QDate date = dateTime.date();
+    if ((spec != Qt::LocalTime && spec != Qt::UTC) || date.year() < 0 || date.year() > 9999)
+        return dateTime.toString(Qt::ISODate);
+
+    int year, month, day;
+    date.getDate(&year, &month, &day);
+    const QTime time = dateTime.time();
+    const bool utc = spec == Qt::UTC;
+
+    QString result(IsoDateTimeLength + (utc ? 1 : 0), Qt::Uninitialized);
+    QChar *data = result.data();
+    writeDigits(data, 4, year);
+    data[4] = QLatin1Char('-');
+    writeDigits(data + 5, 2, month);
+    data[7] = QLatin1Char('-');
+    writeDigits(data + 8, 2, day);
+    data[10] = QLatin1Char('T');
+    writeDigits(data + 11, 2, time.hour());
+    data[13] = QLatin1Char(':');
+    writeDigits(data + 14, 2, time.minute());
+    data[16] = QLatin1Char(':');
+    writeDigits(data + 17, 2, time.second());
+    if (utc)
+        data[IsoDateTimeLength] = QLatin1Char('Z');
+    return result;
+}
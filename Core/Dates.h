@@ -26,6 +26,8 @@
 #define CHARM_DATES_H
 
 #include <QDate>
+#include <QDateTime>
+#include <QString>
 
 namespace Charm {
 QDate dateByWeekNumberAndWeekDay(int year, int week, int weekday);
@@ -37,6 +39,19 @@ QDate weekDayInWeekOf(Qt::DayOfWeek dayOfWeek, const QDate &date);
 int numberOfWeeksInYear(int year);
 
 int weekDifference(const QDate &from, const QDate &to);
+
+/**
+ * Parses @p string like QDateTime::fromString(string, Qt::ISODate).
+ * The yyyy-MM-ddTHH:mm:ss[Z] format written by dateTimeToIsoString() is parsed without the
+ * overhead of the generic Qt parser, all other input is handed to Qt.
+ */
+QDateTime dateTimeFromIsoString(const QString &string);
+
+/**
+ * Formats @p dateTime like QDateTime::toString(Qt::ISODate).
+ * Local and UTC times of the years 0 to 9999 are formatted directly, all others by Qt.
+ */
+QString dateTimeToIsoString(const QDateTime &dateTime);
 }
 
 #endif // CHARM_DATES_H
@@ -23,9 +23,13 @@
 
 #include "Event.h"
 #include "CharmExceptions.h"
+#include "Dates.h"
+#include "XmlSerialization.h"
 
 #include <QDomElement>
 #include <QDomText>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 Event::Event()
 {
@@ -166,9 +170,9 @@ QDomElement Event::toXml(QDomDocument document) const
     element.setAttribute(EventUserIdAttribute, QString().setNum(userId()));
     element.setAttribute(EventReportIdAttribute, QString().setNum(reportId()));
     if (m_start.isValid())
-        element.setAttribute(EventStartAttribute, m_start.toString(Qt::ISODate));
+        element.setAttribute(EventStartAttribute, Charm::dateTimeToIsoString(m_start));
     if (m_end.isValid())
-        element.setAttribute(EventEndAttribute, m_end.toString(Qt::ISODate));
+        element.setAttribute(EventEndAttribute, Charm::dateTimeToIsoString(m_end));
     if (!comment().isEmpty()) {
         QDomText commentText = document.createTextNode(comment());
         element.appendChild(commentText);
@@ -176,19 +180,36 @@ QDomElement Event::toXml(QDomDocument document) const
     return element;
 }
 
+void Event::writeXml(QXmlStreamWriter &writer) const
+{
+    writer.writeStartElement(EventElement);
+    writer.writeAttribute(EventIdAttribute, QString::number(id()));
+    writer.writeAttribute(EventTaskIdAttribute, QString::number(taskId()));
+    writer.writeAttribute(EventUserIdAttribute, QString::number(userId()));
+    writer.writeAttribute(EventReportIdAttribute, QString::number(reportId()));
+    if (m_start.isValid())
+        writer.writeAttribute(EventStartAttribute, Charm::dateTimeToIsoString(m_start));
+    if (m_end.isValid())
+        writer.writeAttribute(EventEndAttribute, Charm::dateTimeToIsoString(m_end));
+    if (!comment().isEmpty())
+        writer.writeCharacters(comment());
+    writer.writeEndElement();
+}
+
 QString Event::tagName()
 {
     static const QString tag(QStringLiteral("event"));
     return tag;
 }
 
-Event Event::fromXml(const QDomElement &element, int databaseSchemaVersion)
-{   // in case any event object creates trouble with
-    // serialization/deserialization, add an object of it to
-    // void XmlSerializationTests::testEventSerialization()
+namespace {
+// shared by the DOM and the stream parser, Element is a QDomElement or XmlSerialization::StreamAttributes
+template<typename Element>
+Event eventFromAttributes(const Element &element, const QString &text, int databaseSchemaVersion)
+{
     Event event;
     bool ok;
-    event.setComment(element.text());
+    event.setComment(text);
     event.setId(element.attribute(EventIdAttribute).toInt(&ok));
     if (!ok) throw XmlSerializationException(QObject::tr("Event::fromXml: invalid event id"));
 
@@ -206,7 +227,7 @@ Event Event::fromXml(const QDomElement &element, int databaseSchemaVersion)
     }
     if (element.hasAttribute(EventStartAttribute)) {
         QDateTime start
-            = QDateTime::fromString(element.attribute(EventStartAttribute), Qt::ISODate);
+            = Charm::dateTimeFromIsoString(element.attribute(EventStartAttribute));
         if (!start.isValid()) throw XmlSerializationException(QObject::tr(
                                                                   "Event::fromXml: invalid start date"));
 
@@ -214,13 +235,29 @@ Event Event::fromXml(const QDomElement &element, int databaseSchemaVersion)
         event.setStartDateTime(start);
     }
     if (element.hasAttribute(EventEndAttribute)) {
-        QDateTime end = QDateTime::fromString(element.attribute(EventEndAttribute), Qt::ISODate);
+        QDateTime end = Charm::dateTimeFromIsoString(element.attribute(EventEndAttribute));
         if (!end.isValid()) throw XmlSerializationException(QObject::tr(
                                                                 "Event::fromXml: invalid end date"));
 
         end.setTimeSpec(Qt::UTC);
         event.setEndDateTime(end.toLocalTime());
     }
-    event.setComment(element.text());
     return event;
 }
+}
+
+Event Event::fromXml(const QDomElement &element, int databaseSchemaVersion)
+{   // in case any event object creates trouble with
+    // serialization/deserialization, add an object of it to
+    // void XmlSerializationTests::testEventSerialization()
+    return eventFromAttributes(element, element.text(), databaseSchemaVersion);
+}
+
+Event Event::fromXml(QXmlStreamReader &reader, int databaseSchemaVersion)
+{
+    const XmlSerialization::StreamAttributes attributes(reader.attributes());
+    const QString text = reader.readElementText();
+    if (reader.hasError())
+        throw XmlSerializationException(QObject::tr("Event::fromXml: %1").arg(reader.errorString()));
+    return eventFromAttributes(attributes, text, databaseSchemaVersion);
+}
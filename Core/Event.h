@@ -34,6 +34,9 @@
 
 #include "Task.h"
 
+class QXmlStreamReader;
+class QXmlStreamWriter;
+
 typedef int EventId;
 
 /** An event is a recorded time for a task.
@@ -87,8 +90,12 @@ public:
     void dump() const;
 
     QDomElement toXml(QDomDocument) const;
+    /** Write the same element as toXml() to @p writer. */
+    void writeXml(QXmlStreamWriter &writer) const;
 
     static Event fromXml(const QDomElement &, int databaseSchemaVersion = 1);
+    /** Read the event element @p reader is positioned at, leaving it at the end of the element. */
+    static Event fromXml(QXmlStreamReader &reader, int databaseSchemaVersion = 1);
     static QString tagName();
 
 private:
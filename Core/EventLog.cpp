@@ -0,0 +1,366 @@
+/*
+  EventLog.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EventLog.h"
+
+#include <QDataStream>
+#include <QSaveFile>
+#include <QtDebug>
+#include <QtEndian>
+
+#include <limits>
+
+namespace {
+enum RecordType : quint8 {
+    PutRecord = 1,
+    DeleteRecord = 2,
+    ClearRecord = 3
+};
+
+const quint32 Magic = 0x4348454c; // "CHEL"
+const quint32 FormatVersion = 1;
+const int HeaderSize = 8; // magic and format version
+const int RecordHeaderSize = 6; // payload size (32 bit) and checksum (16 bit)
+const int MinimumObsoleteRecordsForCompaction = 1000;
+const qint64 InvalidTime = std::numeric_limits<qint64>::min();
+
+QByteArray fileHeader()
+{
+    QByteArray header(HeaderSize, Qt::Uninitialized);
+    qToBigEndian<quint32>(Magic, reinterpret_cast<uchar *>(header.data()));
+    qToBigEndian<quint32>(FormatVersion, reinterpret_cast<uchar *>(header.data()) + 4);
+    return header;
+}
+
+QByteArray frame(const QByteArray &payload)
+{
+    QByteArray record(RecordHeaderSize, Qt::Uninitialized);
+    uchar *header = reinterpret_cast<uchar *>(record.data());
+    qToBigEndian<quint32>(payload.size(), header);
+    qToBigEndian<quint16>(qChecksum(payload.constData(), payload.size()), header + 4);
+    return record + payload;
+}
+
+qint64 toMSecs(const QDateTime &time)
+{
+    return time.isValid() ? time.toMSecsSinceEpoch() : InvalidTime;
+}
+
+QByteArray putPayload(const Event &event)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << quint8(PutRecord) << qint32(event.id()) << qint32(event.userId())
+           << qint32(event.reportId()) << qint32(event.taskId()) << event.comment()
+           << toMSecs(event.startDateTime(Qt::UTC)) << toMSecs(event.endDateTime(Qt::UTC));
+    return payload;
+}
+
+QByteArray deletePayload(EventId id)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << quint8(DeleteRecord) << qint32(id);
+    return payload;
+}
+
+QByteArray clearPayload()
+{
+    return QByteArray(1, char(ClearRecord));
+}
+}
+
+EventLog::EventLog(const QString &fileName)
+    : m_fileName(fileName)
+{
+}
+
+EventLog::~EventLog()
+{
+    close();
+}
+
+bool EventLog::open()
+{
+    close();
+    m_file.setFileName(m_fileName);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        m_errorString = QObject::tr("Cannot open the event log %1: %2").arg(m_fileName,
+                                                                           m_file.errorString());
+        return false;
+    }
+
+    if (m_file.size() == 0) {
+        if (m_file.write(fileHeader()) != HeaderSize || !m_file.flush()) {
+            m_errorString = m_file.errorString();
+            m_file.close();
+            return false;
+        }
+    } else if (!load()) {
+        m_file.close();
+        return false;
+    }
+    m_file.seek(m_file.size());
+    return true;
+}
+
+void EventLog::close()
+{
+    m_file.close();
+    m_events.clear();
+    m_nextId = 1;
+    m_records = 0;
+}
+
+bool EventLog::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+QString EventLog::errorString() const
+{
+    return m_errorString;
+}
+
+bool EventLog::load()
+{
+    const qint64 size = m_file.size();
+    // replay the records directly from the mapped file, read it only if mapping fails:
+    QByteArray buffer;
+    const char *data = reinterpret_cast<const char *>(m_file.map(0, size));
+    if (!data) {
+        buffer = m_file.readAll();
+        data = buffer.constData();
+    }
+
+    if (size < HeaderSize
+        || qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(data)) != Magic
+        || qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(data) + 4) != FormatVersion) {
+        m_errorString = QObject::tr("%1 is not a Charm event log.").arg(m_fileName);
+        if (buffer.isNull())
+            m_file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+        return false;
+    }
+
+    qint64 offset = HeaderSize;
+    while (offset + RecordHeaderSize <= size) {
+        const uchar *header = reinterpret_cast<const uchar *>(data + offset);
+        const qint64 payloadSize = qFromBigEndian<quint32>(header);
+        const quint16 checksum = qFromBigEndian<quint16>(header + 4);
+        const char *payload = data + offset + RecordHeaderSize;
+        if (offset + RecordHeaderSize + payloadSize > size
+            || qChecksum(payload, payloadSize) != checksum
+            || !applyRecord(payload, payloadSize))
+            break;
+        offset += RecordHeaderSize + payloadSize;
+        ++m_records;
+    }
+
+    if (buffer.isNull())
+        m_file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+
+    if (offset < size) {
+        // the last write has been interrupted, drop the incomplete record:
+        qWarning() << "EventLog::load: discarding" << size - offset
+                   << "bytes of incomplete records at the end of" << m_fileName;
+        if (!m_file.resize(offset)) {
+            m_errorString = m_file.errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EventLog::applyRecord(const char *payload, int size)
+{
+    QDataStream stream(QByteArray::fromRawData(payload, size));
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint8 type = 0;
+    stream >> type;
+    switch (type) {
+    case PutRecord: {
+        qint32 id, userId, reportId, taskId;
+        QString comment;
+        qint64 start, end;
+        stream >> id >> userId >> reportId >> taskId >> comment >> start >> end;
+        if (stream.status() != QDataStream::Ok)
+            return false;
+        Event event;
+        event.setId(id);
+        event.setUserId(userId);
+        event.setReportId(reportId);
+        event.setTaskId(taskId);
+        event.setComment(comment);
+        if (start != InvalidTime)
+            event.setStartDateTime(QDateTime::fromMSecsSinceEpoch(start, Qt::UTC));
+        if (end != InvalidTime)
+            event.setEndDateTime(QDateTime::fromMSecsSinceEpoch(end, Qt::UTC));
+        m_events.insert(id, event);
+        m_nextId = qMax(m_nextId, id + 1);
+        return true;
+    }
+    case DeleteRecord: {
+        qint32 id;
+        stream >> id;
+        if (stream.status() != QDataStream::Ok)
+            return false;
+        m_events.remove(id);
+        m_nextId = qMax(m_nextId, id + 1);
+        return true;
+    }
+    case ClearRecord:
+        if (stream.status() != QDataStream::Ok)
+            return false;
+        m_events.clear();
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool EventLog::appendRecord(const QByteArray &payload)
+{
+    Q_ASSERT_X(isOpen(), Q_FUNC_INFO, "The event log has to be opened first");
+    const QByteArray record = frame(payload);
+    if (m_file.write(record) != record.size() || !m_file.flush()) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    ++m_records;
+    return true;
+}
+
+EventList EventLog::getAllEvents() const
+{
+    return m_events.values();
+}
+
+Event EventLog::getEvent(EventId id) const
+{
+    return m_events.value(id);
+}
+
+Event EventLog::makeEvent()
+{
+    Event event;
+    event.setId(m_nextId);
+    if (!appendRecord(putPayload(event)))
+        return Event();
+    ++m_nextId;
+    m_events.insert(event.id(), event);
+    return event;
+}
+
+bool EventLog::modifyEvent(const Event &event)
+{
+    if (!m_events.contains(event.id()))
+        return false;
+    if (!appendRecord(putPayload(event)))
+        return false;
+    m_events.insert(event.id(), event);
+    return compactIfNeeded();
+}
+
+bool EventLog::deleteEvent(const Event &event)
+{
+    if (!m_events.contains(event.id()))
+        return true;
+    if (!appendRecord(deletePayload(event.id())))
+        return false;
+    m_events.remove(event.id());
+    return compactIfNeeded();
+}
+
+bool EventLog::deleteAllEvents()
+{
+    if (!appendRecord(clearPayload()))
+        return false;
+    m_events.clear();
+    return compactIfNeeded();
+}
+
+bool EventLog::setAllEvents(const EventList &events)
+{
+    if (!writeCompacted(events))
+        return false;
+    m_events.clear();
+    Q_FOREACH (const Event &event, events) {
+        m_events.insert(event.id(), event);
+        m_nextId = qMax(m_nextId, event.id() + 1);
+    }
+    return true;
+}
+
+bool EventLog::compact()
+{
+    return writeCompacted(m_events.values());
+}
+
+int EventLog::obsoleteRecords() const
+{
+    return m_records - m_events.size();
+}
+
+bool EventLog::compactIfNeeded()
+{
+    if (obsoleteRecords() > qMax(MinimumObsoleteRecordsForCompaction, m_events.size()))
+        return compact();
+    return true;
+}
+
+bool EventLog::writeCompacted(const EventList &events)
+{
+    Q_ASSERT_X(isOpen(), Q_FUNC_INFO, "The event log has to be opened first");
+    // the new log replaces the old one only once it has been written completely:
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        m_errorString = file.errorString();
+        return false;
+    }
+    bool success = file.write(fileHeader()) == HeaderSize;
+    Q_FOREACH (const Event &event, events) {
+        if (!success)
+            break;
+        const QByteArray record = frame(putPayload(event));
+        success = file.write(record) == record.size();
+    }
+    if (!success) {
+        m_errorString = file.errorString();
+        file.cancelWriting();
+        return false;
+    }
+
+    // the old file has to be closed before it can be replaced on all platforms:
+    m_file.close();
+    success = file.commit();
+    if (!success)
+        m_errorString = file.errorString();
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        m_errorString = m_file.errorString();
+        return false;
+    }
+    m_file.seek(m_file.size());
+    if (success)
+        m_records = events.size();
+    return success;
+}
@@ -0,0 +1,82 @@
+/*
+  EventLog.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <QFile>
+#include <QMap>
+#include <QString>
+
+#include "Event.h"
+
+/** EventLog stores events in an append-only binary file.
+    Every change to an event appends a checksummed record; creating an event and
+    updating its end time while it is running therefore cost one small write each.
+    When opened, the file is memory-mapped and replayed. A torn record at the end of
+    the file (from an interrupted write) is detected by its checksum and cut off.
+    Once the log holds more superseded records than live events, it is compacted
+    into a new file that contains every live event once.
+    The event operations mirror the ones of SqlStorage, but the log is not a backend of the
+    Controller: tasks, users, metadata and change tracking stay in the SQL database. The
+    EventLogConverter tool moves the events between the two. */
+class EventLog
+{
+public:
+    explicit EventLog(const QString &fileName);
+    ~EventLog();
+
+    /** Open the log, creating it if it does not exist, and load all events. */
+    bool open();
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+
+    EventList getAllEvents() const;
+    Event getEvent(EventId id) const;
+    Event makeEvent();
+    bool modifyEvent(const Event &event);
+    bool deleteEvent(const Event &event);
+    bool deleteAllEvents();
+    /** Replace the contents of the log with @p events, keeping their ids. */
+    bool setAllEvents(const EventList &events);
+
+    /** Rewrite the log so that it contains every live event exactly once. */
+    bool compact();
+    /** The number of records that have been superseded by later records. */
+    int obsoleteRecords() const;
+
+private:
+    bool load();
+    bool applyRecord(const char *payload, int size);
+    bool appendRecord(const QByteArray &payload);
+    bool writeCompacted(const EventList &events);
+    bool compactIfNeeded();
+
+    QString m_fileName;
+    QFile m_file;
+    QMap<EventId, Event> m_events;
+    EventId m_nextId = 1;
+    int m_records = 0;
+    QString m_errorString;
+};
+
+#endif
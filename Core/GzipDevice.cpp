@@ -0,0 +1,286 @@
+/*
+  GzipDevice.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "GzipDevice.h"
+
+#include <QByteArray>
+
+#ifdef CHARM_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+const int BufferSize = 64 * 1024;
+}
+
+class GzipDevice::Private
+{
+public:
+    QIODevice *device = nullptr;
+    Compression compression = NoCompression;
+    QByteArray buffer;
+    bool streamEnd = false;
+#ifdef CHARM_ZLIB
+    z_stream stream;
+    bool streamInitialized = false;
+
+    bool fillInput()
+    {
+        const qint64 read = device->read(buffer.data(), buffer.size());
+        if (read <= 0)
+            return false;
+        stream.next_in = reinterpret_cast<Bytef *>(buffer.data());
+        stream.avail_in = static_cast<uInt>(read);
+        return true;
+    }
+
+    bool writeOutput()
+    {
+        const qint64 size = buffer.size() - stream.avail_out;
+        return size == 0 || device->write(buffer.constData(), size) == size;
+    }
+
+    QString zlibError(const char *fallback) const
+    {
+        return QString::fromLatin1(stream.msg ? stream.msg : fallback);
+    }
+#endif
+};
+
+GzipDevice::GzipDevice(QIODevice *device, Compression compression, QObject *parent)
+    : QIODevice(parent)
+    , d(new Private)
+{
+    Q_ASSERT_X(device, Q_FUNC_INFO, "GzipDevice requires an underlying device");
+    d->device = device;
+    d->compression = compression;
+}
+
+GzipDevice::~GzipDevice()
+{
+    if (isOpen())
+        close();
+}
+
+GzipDevice::Compression GzipDevice::compression() const
+{
+    return d->compression;
+}
+
+bool GzipDevice::open(OpenMode mode)
+{
+    Q_ASSERT_X(!isOpen(), Q_FUNC_INFO, "device is already open");
+    const OpenMode access = mode & ReadWrite;
+    if (access != ReadOnly && access != WriteOnly) {
+        setErrorString(tr("Compressed devices can only be opened for either reading or writing"));
+        return false;
+    }
+    if (!(d->device->openMode() & access)) {
+        setErrorString(tr("The underlying device is not open for %1").arg(
+                           access == ReadOnly ? tr("reading") : tr("writing")));
+        return false;
+    }
+
+    d->streamEnd = false;
+    if (access == ReadOnly)
+        d->compression = isCompressed(d->device) ? GzipCompression : NoCompression;
+    if (d->compression == GzipCompression) {
+#ifdef CHARM_ZLIB
+        d->buffer.resize(BufferSize);
+        d->stream = z_stream();
+        // 16 added to the window bits selects the gzip header and trailer:
+        const int result = access == ReadOnly
+                           ? inflateInit2(&d->stream, 16 + MAX_WBITS)
+                           : deflateInit2(&d->stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                          16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        if (result != Z_OK) {
+            setErrorString(d->zlibError("Cannot initialize compression"));
+            return false;
+        }
+        d->streamInitialized = true;
+#else
+        setErrorString(tr("Compressed files are not supported by this build"));
+        return false;
+#endif
+    }
+    return QIODevice::open(mode);
+}
+
+void GzipDevice::close()
+{
+    commit();
+}
+
+bool GzipDevice::commit()
+{
+    if (!isOpen())
+        return false;
+    const bool finished = !(openMode() & WriteOnly) || finish();
+    const QString error = errorString();
+#ifdef CHARM_ZLIB
+    if (d->streamInitialized) {
+        if (openMode() & WriteOnly)
+            deflateEnd(&d->stream);
+        else
+            inflateEnd(&d->stream);
+        d->streamInitialized = false;
+    }
+#endif
+    d->buffer.clear();
+    QIODevice::close();
+    // the error of the last write is kept after closing:
+    if (!finished)
+        setErrorString(error);
+    return finished;
+}
+
+bool GzipDevice::isSequential() const
+{
+    return true;
+}
+
+bool GzipDevice::atEnd() const
+{
+    if (!isOpen())
+        return true;
+    if (bytesAvailable() > 0)
+        return false;
+    if (d->compression == NoCompression)
+        return d->device->atEnd();
+    // a truncated stream is not at its end, reading it reports the error:
+    return d->streamEnd;
+}
+
+bool GzipDevice::isCompressionSupported()
+{
+#ifdef CHARM_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool GzipDevice::isCompressed(QIODevice *device)
+{
+    return device->peek(2) == QByteArray::fromRawData("\x1f\x8b", 2);
+}
+
+GzipDevice::Compression GzipDevice::compressionForFileName(const QString &fileName)
+{
+    return fileName.endsWith(QLatin1String(".gz"), Qt::CaseInsensitive)
+           ? GzipCompression : NoCompression;
+}
+
+qint64 GzipDevice::readData(char *data, qint64 maxSize)
+{
+    if (d->compression == NoCompression) {
+        const qint64 read = d->device->read(data, maxSize);
+        // a sequential device signals the end of the data with -1:
+        return read == 0 && d->device->atEnd() ? -1 : read;
+    }
+#ifdef CHARM_ZLIB
+    if (d->streamEnd)
+        return -1;
+    d->stream.next_out = reinterpret_cast<Bytef *>(data);
+    d->stream.avail_out = static_cast<uInt>(qMin<qint64>(maxSize, BufferSize));
+    const uInt requested = d->stream.avail_out;
+    while (d->stream.avail_out > 0 && !d->streamEnd) {
+        if (d->stream.avail_in == 0 && !d->fillInput()) {
+            // the input ended before the end of the compressed stream:
+            if (d->stream.avail_out < requested)
+                break; // deliver what has been decompressed, fail on the next call
+            setErrorString(tr("Unexpected end of compressed data"));
+            return -1;
+        }
+        const int result = inflate(&d->stream, Z_NO_FLUSH);
+        if (result == Z_STREAM_END) {
+            d->streamEnd = true;
+        } else if (result != Z_OK) {
+            setErrorString(d->zlibError("Corrupt compressed data"));
+            return -1;
+        }
+    }
+    const qint64 produced = requested - d->stream.avail_out;
+    return produced == 0 && d->streamEnd ? -1 : produced;
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+#endif
+}
+
+qint64 GzipDevice::writeData(const char *data, qint64 size)
+{
+    if (d->compression == NoCompression) {
+        const qint64 written = d->device->write(data, size);
+        if (written < 0)
+            setErrorString(d->device->errorString());
+        return written;
+    }
+#ifdef CHARM_ZLIB
+    qint64 remaining = size;
+    while (remaining > 0) {
+        const uInt chunk = static_cast<uInt>(qMin<qint64>(remaining, BufferSize));
+        d->stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data + size - remaining));
+        d->stream.avail_in = chunk;
+        do {
+            d->stream.next_out = reinterpret_cast<Bytef *>(d->buffer.data());
+            d->stream.avail_out = static_cast<uInt>(d->buffer.size());
+            deflate(&d->stream, Z_NO_FLUSH);
+            if (!d->writeOutput()) {
+                setErrorString(d->device->errorString());
+                return -1;
+            }
+        } while (d->stream.avail_out == 0);
+        remaining -= chunk;
+    }
+    return size;
+#else
+    Q_UNUSED(data);
+    return -1;
+#endif
+}
+
+bool GzipDevice::finish()
+{
+#ifdef CHARM_ZLIB
+    if (!d->streamInitialized)
+        return true;
+    d->stream.next_in = nullptr;
+    d->stream.avail_in = 0;
+    int result = Z_OK;
+    do {
+        d->stream.next_out = reinterpret_cast<Bytef *>(d->buffer.data());
+        d->stream.avail_out = static_cast<uInt>(d->buffer.size());
+        result = deflate(&d->stream, Z_FINISH);
+        if (!d->writeOutput()) {
+            setErrorString(d->device->errorString());
+            return false;
+        }
+    } while (result == Z_OK);
+    if (result != Z_STREAM_END) {
+        setErrorString(d->zlibError("Cannot finish compressed data"));
+        return false;
+    }
+#endif
+    return true;
+}
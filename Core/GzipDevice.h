@@ -0,0 +1,82 @@
+/*
+  GzipDevice.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef GZIPDEVICE_H
+#define GZIPDEVICE_H
+
+#include <QIODevice>
+#include <QScopedPointer>
+
+/** GzipDevice compresses and decompresses data on the fly while it is streamed
+    through another, already opened device.
+    When writing, the data is gzip compressed if compression() is GzipCompression,
+    and passed through unchanged otherwise.
+    When reading, gzip compressed data is detected by its magic bytes and decompressed
+    transparently, everything else is passed through. Readers therefore accept both
+    compressed and plain files.
+    Closing the device finishes the compressed stream, but does not close the
+    underlying device. Writers use commit() to learn whether that succeeded. */
+class GzipDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    enum Compression {
+        NoCompression,
+        GzipCompression
+    };
+
+    explicit GzipDevice(QIODevice *device, Compression compression = NoCompression,
+                        QObject *parent = nullptr);
+    ~GzipDevice() override;
+
+    /** When reading, the compression detected in open(). */
+    Compression compression() const;
+
+    /** Open the device either ReadOnly or WriteOnly. */
+    bool open(OpenMode mode) override;
+    void close() override;
+    /** Close the device like close(). Returns false if the end of the compressed stream could
+        not be written, errorString() then describes the error. */
+    bool commit();
+    bool isSequential() const override;
+    bool atEnd() const override;
+
+    /** Whether this build can compress and decompress data. */
+    static bool isCompressionSupported();
+    /** Whether the data in @p device starts with the gzip magic bytes. */
+    static bool isCompressed(QIODevice *device);
+    /** The compression implied by the suffix of @p fileName (".gz"). */
+    static Compression compressionForFileName(const QString &fileName);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+
+private:
+    bool finish();
+
+    class Private;
+    QScopedPointer<Private> d;
+};
+
+#endif
@@ -32,7 +32,8 @@
 // DATABASE STRUCTURE DEFINITION FOR MYSQL
 static const QString Tables[] = {
     QStringLiteral("MetaData"), QStringLiteral("Installations"), QStringLiteral("Tasks"),
-    QStringLiteral("Events"), QStringLiteral("Subscriptions"), QStringLiteral("Users")
+    QStringLiteral("Events"), QStringLiteral("Subscriptions"), QStringLiteral("Users"),
+    QStringLiteral("Changes"), QStringLiteral("EventOrigins")
 };
 
 static const int NumberOfTables = sizeof Tables / sizeof Tables[0];
@@ -95,9 +96,47 @@ static const Fields Users_Fields[] = {
     { QStringLiteral("name"), QStringLiteral("varchar(256)") }, LastField
 };
 
+// one row per task or event, see the indexes below:
+static const Fields Changes_Fields[] = {
+    { QStringLiteral("id"), QStringLiteral("INTEGER AUTO_INCREMENT PRIMARY KEY") },
+    { QStringLiteral("kind"), QStringLiteral("INTEGER") },
+    { QStringLiteral("object_id"), QStringLiteral("INTEGER") },
+    { QStringLiteral("change_id"), QStringLiteral("INTEGER") },
+    { QStringLiteral("deleted"), QStringLiteral("INTEGER") }, LastField
+};
+
+// the installation that created an event, and the id it has there:
+static const Fields EventOrigins_Fields[] = {
+    { QStringLiteral("id"), QStringLiteral("INTEGER AUTO_INCREMENT PRIMARY KEY") },
+    { QStringLiteral("event_id"), QStringLiteral("INTEGER") },
+    { QStringLiteral("installation_id"), QStringLiteral("INTEGER") },
+    { QStringLiteral("origin_id"), QStringLiteral("INTEGER") }, LastField
+};
+
 static const Fields *Database_Fields[NumberOfTables] = {
     MetaData_Fields, Installations_Fields, Tasks_Fields, Event_Fields,
-    Subscriptions_Fields, Users_Fields
+    Subscriptions_Fields, Users_Fields, Changes_Fields, EventOrigins_Fields
+};
+
+// the indexes of the tables, terminated by an empty statement:
+static const QString NoIndexes[] = { QString() };
+
+static const QString Changes_Indexes[] = {
+    QStringLiteral("CREATE UNIQUE INDEX Changes_object ON Changes ( kind, object_id );"),
+    QStringLiteral("CREATE INDEX Changes_change ON Changes ( change_id );"),
+    QString()
+};
+
+static const QString EventOrigins_Indexes[] = {
+    QStringLiteral("CREATE UNIQUE INDEX EventOrigins_event ON EventOrigins ( event_id );"),
+    QStringLiteral("CREATE UNIQUE INDEX EventOrigins_origin "
+                   "ON EventOrigins ( installation_id, origin_id );"),
+    QString()
+};
+
+static const QString *Database_Indexes[NumberOfTables] = {
+    NoIndexes, NoIndexes, NoIndexes, NoIndexes, NoIndexes, NoIndexes,
+    Changes_Indexes, EventOrigins_Indexes
 };
 
 const QString DatabaseName = QStringLiteral("mysql.charm.kdab.com");
@@ -140,6 +179,13 @@ bool MySqlStorage::createDatabaseTables()
             query.prepare(statement);
             if (!runQuery(query))
                 error = true;
+            // MySQL has no CREATE INDEX IF NOT EXISTS, the indexes are created with the table:
+            for (const QString *index = Database_Indexes[i]; !index->isEmpty(); ++index) {
+                QSqlQuery indexQuery(database());
+                indexQuery.prepare(*index);
+                if (!runQuery(indexQuery))
+                    error = true;
+            }
         }
     }
 
@@ -218,6 +264,8 @@ void MySqlStorage::configure(const Parameters &parameters)
     database().setDatabaseName(parameters.database);
     database().setUserName(parameters.name);
     database().setPassword(parameters.password);
+    // report matched instead of changed rows, SqlStorage::setMetaData() relies on that:
+    database().setConnectOptions(QStringLiteral("CLIENT_FOUND_ROWS"));
     if (parameters.port != 0)
         database().setPort(parameters.port);
 }
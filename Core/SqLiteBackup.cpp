@@ -0,0 +1,292 @@
+/*
+  SqLiteBackup.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SqLiteBackup.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include <QVersionNumber>
+
+#ifdef CHARM_SQLITE_BACKUP
+#include <sqlite3.h>
+#endif
+
+namespace {
+const QString DriverName = QStringLiteral("QSQLITE");
+const QString SnapshotInfix = QStringLiteral("-snapshot-");
+const QString TemporarySuffix = QStringLiteral(".part");
+
+QString connectionName(const SqLiteBackup *backup, const QString &role)
+{
+    return QStringLiteral("charm.backup.%1.%2").arg(quintptr(backup), 0, 16).arg(role);
+}
+
+QString driverSourceId(const QSqlDatabase &database)
+{
+    QSqlQuery query(database);
+    if (query.exec(QStringLiteral("SELECT sqlite_source_id();")) && query.next())
+        return query.value(0).toString();
+    return QString();
+}
+
+#ifdef CHARM_SQLITE_BACKUP
+/** The handle of the connection, if the Qt driver uses the SQLite library Charm is linked
+    against. Drivers that bundle their own copy of SQLite (the default on Windows and macOS)
+    have handles that must not be passed to another library. Builds of different source
+    code are told apart by the source id, identical builds are interchangeable. */
+sqlite3 *sqliteHandle(const QSqlDatabase &database)
+{
+    if (driverSourceId(database) != QString::fromLatin1(sqlite3_sourceid()))
+        return nullptr;
+    const QVariant handle = database.driver()->handle();
+    if (handle.isValid() && qstrcmp(handle.typeName(), "sqlite3*") == 0)
+        return *static_cast<sqlite3 *const *>(handle.constData());
+    return nullptr;
+}
+#endif
+
+QDateTime snapshotTime(const QString &snapshotFile)
+{
+    return QDateTime::fromString(snapshotFile.section(SnapshotInfix, -1),
+                                 QStringLiteral("yyyyMMdd-HHmmss"));
+}
+}
+
+SqLiteBackup::SqLiteBackup(const QString &sourceFile, const QString &targetFile,
+                           QObject *parent)
+    : QThread(parent)
+    , m_sourceFile(sourceFile)
+    , m_targetFile(targetFile)
+{
+}
+
+SqLiteBackup::~SqLiteBackup()
+{
+    cancel();
+    wait();
+}
+
+QString SqLiteBackup::sourceFile() const
+{
+    return m_sourceFile;
+}
+
+QString SqLiteBackup::targetFile() const
+{
+    return m_targetFile;
+}
+
+void SqLiteBackup::setPagesPerStep(int pages)
+{
+    Q_ASSERT_X(pages != 0, Q_FUNC_INFO, "A backup step has to copy at least one page");
+    m_pagesPerStep = pages;
+}
+
+void SqLiteBackup::setStepInterval(int msecs)
+{
+    m_stepInterval = msecs;
+}
+
+void SqLiteBackup::cancel()
+{
+    m_canceled.store(1);
+}
+
+QString SqLiteBackup::errorString() const
+{
+    return m_errorString;
+}
+
+bool SqLiteBackup::copy()
+{
+    m_canceled.store(0);
+    m_errorString.clear();
+    if (!QFileInfo::exists(m_sourceFile)) {
+        m_errorString = tr("The database file %1 does not exist.").arg(m_sourceFile);
+        return false;
+    }
+
+    const QString temporaryFile = m_targetFile + TemporarySuffix;
+    QFile::remove(temporaryFile);
+    const bool success = copyPages(temporaryFile);
+    // the connections used by copyPages() are out of scope now:
+    QSqlDatabase::removeDatabase(connectionName(this, QStringLiteral("source")));
+    QSqlDatabase::removeDatabase(connectionName(this, QStringLiteral("target")));
+
+    if (success) {
+        if (QFile::exists(m_targetFile) && !QFile::remove(m_targetFile)) {
+            m_errorString = tr("Could not replace the existing backup %1.").arg(m_targetFile);
+        } else if (!QFile::rename(temporaryFile, m_targetFile)) {
+            m_errorString = tr("Could not rename the backup to %1.").arg(m_targetFile);
+        } else {
+            return true;
+        }
+    }
+    QFile::remove(temporaryFile);
+    return false;
+}
+
+bool SqLiteBackup::copyPages(const QString &temporaryFile)
+{
+    QSqlDatabase source = QSqlDatabase::addDatabase(DriverName,
+                                                    connectionName(this, QStringLiteral("source")));
+    source.setConnectOptions(QStringLiteral("QSQLITE_OPEN_READONLY"));
+    source.setDatabaseName(m_sourceFile);
+    if (!source.open()) {
+        m_errorString = tr("Could not open the database %1: %2").arg(m_sourceFile,
+                                                                    source.lastError().text());
+        return false;
+    }
+
+#ifdef CHARM_SQLITE_BACKUP
+    if (sqliteHandle(source))
+        return backupPages(source, temporaryFile);
+#endif
+    return vacuumInto(source, temporaryFile);
+}
+
+bool SqLiteBackup::backupPages(const QSqlDatabase &source, const QString &temporaryFile)
+{
+#ifdef CHARM_SQLITE_BACKUP
+    QSqlDatabase target = QSqlDatabase::addDatabase(DriverName,
+                                                    connectionName(this, QStringLiteral("target")));
+    target.setDatabaseName(temporaryFile);
+    if (!target.open()) {
+        m_errorString = tr("Could not create the backup %1: %2").arg(temporaryFile,
+                                                                    target.lastError().text());
+        return false;
+    }
+
+    sqlite3 *sourceHandle = sqliteHandle(source);
+    sqlite3 *targetHandle = sqliteHandle(target);
+    if (!sourceHandle || !targetHandle) {
+        m_errorString = tr("The SQLite driver does not provide access to the database handle.");
+        return false;
+    }
+
+    sqlite3_backup *backup = sqlite3_backup_init(targetHandle, "main", sourceHandle, "main");
+    if (!backup) {
+        m_errorString = QString::fromUtf8(sqlite3_errmsg(targetHandle));
+        return false;
+    }
+
+    int result = SQLITE_OK;
+    for (;;) {
+        result = sqlite3_backup_step(backup, m_pagesPerStep);
+        emit progress(sqlite3_backup_remaining(backup), sqlite3_backup_pagecount(backup));
+        if (result != SQLITE_OK && result != SQLITE_BUSY && result != SQLITE_LOCKED)
+            break;
+        if (m_canceled.load())
+            break;
+        // give the connections writing to the database a chance to get their locks:
+        if (m_stepInterval > 0)
+            QThread::msleep(m_stepInterval);
+    }
+    sqlite3_backup_finish(backup);
+
+    if (result != SQLITE_DONE) {
+        m_errorString = m_canceled.load() ? tr("The backup has been canceled.")
+                        : QString::fromUtf8(sqlite3_errstr(result));
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(source);
+    Q_UNUSED(temporaryFile);
+    m_errorString = tr("Charm has been built without the SQLite backup API.");
+    return false;
+#endif
+}
+
+bool SqLiteBackup::vacuumInto(const QSqlDatabase &source, const QString &temporaryFile)
+{
+    // without access to the SQLite API, VACUUM INTO creates a consistent copy in one step.
+    // It has been added in SQLite 3.27:
+    QSqlQuery version(source);
+    if (version.exec(QStringLiteral("SELECT sqlite_version();")) && version.next()) {
+        const QString driverVersion = version.value(0).toString();
+        const QVersionNumber sqliteVersion = QVersionNumber::fromString(driverVersion);
+        if (sqliteVersion < QVersionNumber(3, 27)) {
+            m_errorString = tr("Backups need SQLite 3.27 or later, the database driver uses %1.")
+                            .arg(sqliteVersion.toString());
+            return false;
+        }
+    }
+
+    QSqlQuery query(source);
+    query.prepare(QStringLiteral("VACUUM INTO :file;"));
+    query.bindValue(QStringLiteral(":file"), temporaryFile);
+    if (!query.exec()) {
+        m_errorString = tr("Could not create the backup %1: %2").arg(temporaryFile,
+                                                                    query.lastError().text());
+        return false;
+    }
+    emit progress(0, 0);
+    return true;
+}
+
+void SqLiteBackup::run()
+{
+    emit completed(copy());
+}
+
+QString SqLiteBackup::snapshotFileName(const QString &databaseFile, const QDateTime &time)
+{
+    return databaseFile + SnapshotInfix + time.toString(QStringLiteral("yyyyMMdd-HHmmss"));
+}
+
+QStringList SqLiteBackup::snapshots(const QString &databaseFile)
+{
+    const QFileInfo info(databaseFile);
+    const QDir directory = info.dir();
+    const QStringList filter(info.fileName() + SnapshotInfix + QLatin1Char('*'));
+    QStringList files;
+    // the time stamps in the names make the alphabetical order the chronological order:
+    Q_FOREACH (const QString &entry, directory.entryList(filter, QDir::Files, QDir::Name)) {
+        if (!entry.endsWith(TemporarySuffix))
+            files.append(directory.filePath(entry));
+    }
+    return files;
+}
+
+QDateTime SqLiteBackup::lastSnapshotTime(const QString &databaseFile)
+{
+    const QStringList files = snapshots(databaseFile);
+    return files.isEmpty() ? QDateTime() : snapshotTime(files.last());
+}
+
+int SqLiteBackup::removeOldSnapshots(const QString &databaseFile, int keep)
+{
+    const QStringList files = snapshots(databaseFile);
+    int removed = 0;
+    for (int i = 0; i < files.size() - keep; ++i) {
+        if (QFile::remove(files[i]))
+            ++removed;
+    }
+    return removed;
+}
@@ -0,0 +1,99 @@
+/*
+  SqLiteBackup.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SQLITEBACKUP_H
+#define SQLITEBACKUP_H
+
+#include <QAtomicInt>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+class QDateTime;
+class QSqlDatabase;
+
+/** SqLiteBackup copies a SQLite database file while it is in use, using the SQLite
+    online backup API. The copy is made in small steps, so that connections writing to
+    the database are only locked out for the duration of one step. If the source
+    database is modified in between, the backup restarts, so the result is always a
+    consistent snapshot.
+    The backup API is only used if the Qt SQLite driver uses the SQLite library Charm is
+    linked against. Otherwise, or without the library, the copy is made in one step with
+    VACUUM INTO, which needs SQLite 3.27 or later.
+    copy() performs the backup in the calling thread, start() in a background thread.
+    The backup is written to a temporary file first, an existing target file is only
+    replaced once the backup has completed. */
+class SqLiteBackup : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit SqLiteBackup(const QString &sourceFile, const QString &targetFile,
+                          QObject *parent = nullptr);
+    ~SqLiteBackup() override;
+
+    QString sourceFile() const;
+    QString targetFile() const;
+
+    /** The number of database pages copied in one step, -1 copies all pages at once. */
+    void setPagesPerStep(int pages);
+    /** The time in milliseconds the backup sleeps between steps. */
+    void setStepInterval(int msecs);
+
+    /** Perform the backup in the calling thread. Returns true on success. */
+    bool copy();
+    /** Abort a running backup at the next step. */
+    void cancel();
+
+    QString errorString() const;
+
+    /** The file name of a rolling snapshot of @p databaseFile taken at @p time. */
+    static QString snapshotFileName(const QString &databaseFile, const QDateTime &time);
+    /** The paths of the snapshots of @p databaseFile, the oldest first. */
+    static QStringList snapshots(const QString &databaseFile);
+    /** The time the most recent snapshot of @p databaseFile was taken at, invalid if there
+        is none. */
+    static QDateTime lastSnapshotTime(const QString &databaseFile);
+    /** Delete all but the @p keep most recent snapshots of @p databaseFile.
+        Returns the number of deleted snapshots. */
+    static int removeOldSnapshots(const QString &databaseFile, int keep);
+
+Q_SIGNALS:
+    void progress(int remainingPages, int totalPages);
+    void completed(bool success);
+
+protected:
+    void run() override;
+
+private:
+    bool copyPages(const QString &temporaryFile);
+    bool backupPages(const QSqlDatabase &source, const QString &temporaryFile);
+    bool vacuumInto(const QSqlDatabase &source, const QString &temporaryFile);
+
+    const QString m_sourceFile;
+    const QString m_targetFile;
+    int m_pagesPerStep = 64;
+    int m_stepInterval = 10;
+    QAtomicInt m_canceled;
+    QString m_errorString;
+};
+
+#endif
@@ -34,13 +34,15 @@
 #include <QFileInfo>
 #include <QSqlDatabase>
 #include <QSqlQuery>
+#include <QUrl>
 
 #include <cerrno>
 
 // DATABASE STRUCTURE DEFINITION
 static const QString Tables[] = {
     QStringLiteral("MetaData"), QStringLiteral("Installations"), QStringLiteral("Tasks"),
-    QStringLiteral("Events"), QStringLiteral("Subscriptions"), QStringLiteral("Users")
+    QStringLiteral("Events"), QStringLiteral("Subscriptions"), QStringLiteral("Users"),
+    QStringLiteral("Changes"), QStringLiteral("EventOrigins")
 };
 
 static const int NumberOfTables = sizeof Tables / sizeof Tables[0];
@@ -103,16 +105,55 @@ static const Fields Users_Fields[] = {
     { QStringLiteral("name"), QStringLiteral("varchar(256)") }, LastField
 };
 
+// one row per task or event, see the indexes below:
+static const Fields Changes_Fields[] = {
+    { QStringLiteral("id"), QStringLiteral("INTEGER PRIMARY KEY") },
+    { QStringLiteral("kind"), QStringLiteral("INTEGER") },
+    { QStringLiteral("object_id"), QStringLiteral("INTEGER") },
+    { QStringLiteral("change_id"), QStringLiteral("INTEGER") },
+    { QStringLiteral("deleted"), QStringLiteral("INTEGER") }, LastField
+};
+
+// the installation that created an event, and the id it has there:
+static const Fields EventOrigins_Fields[] = {
+    { QStringLiteral("id"), QStringLiteral("INTEGER PRIMARY KEY") },
+    { QStringLiteral("event_id"), QStringLiteral("INTEGER") },
+    { QStringLiteral("installation_id"), QStringLiteral("INTEGER") },
+    { QStringLiteral("origin_id"), QStringLiteral("INTEGER") }, LastField
+};
+
 static const Fields *Database_Fields[NumberOfTables] = {
     MetaData_Fields, Installations_Fields, Tasks_Fields, Event_Fields,
-    Subscriptions_Fields, Users_Fields
+    Subscriptions_Fields, Users_Fields, Changes_Fields, EventOrigins_Fields
+};
+
+// the indexes of the tables, terminated by an empty statement:
+static const QString NoIndexes[] = { QString() };
+
+static const QString Changes_Indexes[] = {
+    QStringLiteral("CREATE UNIQUE INDEX IF NOT EXISTS Changes_object ON Changes ( kind, object_id );"),
+    QStringLiteral("CREATE INDEX IF NOT EXISTS Changes_change ON Changes ( change_id );"),
+    QString()
+};
+
+static const QString EventOrigins_Indexes[] = {
+    QStringLiteral("CREATE UNIQUE INDEX IF NOT EXISTS EventOrigins_event ON EventOrigins ( event_id );"),
+    QStringLiteral("CREATE UNIQUE INDEX IF NOT EXISTS EventOrigins_origin "
+                   "ON EventOrigins ( installation_id, origin_id );"),
+    QString()
+};
+
+static const QString *Database_Indexes[NumberOfTables] = {
+    NoIndexes, NoIndexes, NoIndexes, NoIndexes, NoIndexes, NoIndexes,
+    Changes_Indexes, EventOrigins_Indexes
 };
 
 const QString DatabaseName = QStringLiteral("charm.kdab.com");
 const QString DriverName = QStringLiteral("QSQLITE");
 
-SqLiteStorage::SqLiteStorage()
+SqLiteStorage::SqLiteStorage(Location location)
     : SqlStorage()
+    , m_location(location)
     , m_database(QSqlDatabase::addDatabase(DriverName, DatabaseName))
 {
     if (!QSqlDatabase::isDriverAvailable(DriverName))
@@ -130,6 +171,8 @@ QString SqLiteStorage::lastInsertRowFunction() const
 
 QString SqLiteStorage::description() const
 {
+    if (m_location == InMemory)
+        return QObject::tr("in-memory database");
     return QObject::tr("local database");
 }
 
@@ -161,6 +204,13 @@ bool SqLiteStorage::createDatabaseTables()
             if (!runQuery(query))
                 error = true;
         }
+        // the indexes are created if they are missing, also in tables of older versions:
+        for (const QString *index = Database_Indexes[i]; !index->isEmpty(); ++index) {
+            QSqlQuery query(database());
+            query.prepare(*index);
+            if (!runQuery(query))
+                error = true;
+        }
     }
 
     error = error
@@ -170,7 +220,11 @@ bool SqLiteStorage::createDatabaseTables()
 }
 
 bool SqLiteStorage::connect(Configuration &configuration)
-{   // make sure the database folder exits:
+{
+    if (m_location == InMemory)
+        return connectInMemory(configuration);
+
+    // make sure the database folder exits:
     configuration.failure = true;
 
     const QFileInfo fileInfo(configuration.localStorageDatabase);   // this is the full path
@@ -196,6 +250,7 @@ bool SqLiteStorage::connect(Configuration &configuration)
     m_database.setHostName(QStringLiteral("localhost"));
     const QString databaseName = fileInfo.absoluteFilePath();
     m_database.setDatabaseName(databaseName);
+    m_database.setConnectOptions(QStringLiteral("QSQLITE_OPEN_URI"));
 
     bool error = false;
 
@@ -242,6 +297,26 @@ bool SqLiteStorage::connect(Configuration &configuration)
     return true;
 }
 
+bool SqLiteStorage::connectInMemory(Configuration &configuration)
+{
+    configuration.failure = true;
+    m_database.setDatabaseName(QStringLiteral(":memory:"));
+    if (!m_database.open()) {
+        configuration.failureMessage = QObject::tr("Could not open an in-memory SQLite database");
+        return false;
+    }
+
+    // the database is always new, creating it also creates the user:
+    if (!verifyDatabase() && !createDatabase(configuration)) {
+        configuration.failureMessage = QObject::tr(
+            "SqLiteStorage::connect: error creating default database contents");
+        return false;
+    }
+
+    configuration.failure = false;
+    return true;
+}
+
 bool SqLiteStorage::migrateDatabaseDirectory(QDir oldDirectory, const QDir &newDirectory) const
 {
     if (oldDirectory == newDirectory)
@@ -270,6 +345,40 @@ QSqlDatabase &SqLiteStorage::database()
     return m_database;
 }
 
+QString SqLiteStorage::archiveFileName(const QString &databaseFile)
+{
+    return databaseFile + QStringLiteral("-archive");
+}
+
+QString SqLiteStorage::archiveFileName() const
+{
+    return archiveFileName(m_database.databaseName());
+}
+
+bool SqLiteStorage::attachArchive(bool writable)
+{
+    // an archive of an in-memory database would not survive the next detach:
+    if (m_location == InMemory)
+        return false;
+    const QString fileName = archiveFileName();
+    if (!writable && !QFileInfo::exists(fileName))
+        return false;
+    QSqlQuery query(m_database);
+    query.prepare(QStringLiteral("ATTACH DATABASE :file AS archive;"));
+    // read-only access needs a URI, the connection is opened with QSQLITE_OPEN_URI for that:
+    query.bindValue(QStringLiteral(":file"), writable ? fileName
+                    : QUrl::fromLocalFile(fileName).toString() + QStringLiteral("?mode=ro"));
+    return runQuery(query);
+}
+
+void SqLiteStorage::detachArchive()
+{
+    QSqlQuery query(m_database);
+    query.prepare(QStringLiteral("DETACH DATABASE archive;"));
+    if (!runQuery(query))
+        qWarning() << "SqLiteStorage::detachArchive: cannot detach the archive database";
+}
+
 bool SqLiteStorage::createDatabase(Configuration &configuration)
 {
     bool success = createDatabaseTables();
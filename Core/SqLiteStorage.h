@@ -35,7 +35,12 @@ class Configuration;
 class SqLiteStorage : public SqlStorage
 {
 public:
-    SqLiteStorage();
+    enum Location {
+        OnDisk,
+        InMemory // the database is created on connect, and lost on disconnect
+    };
+
+    explicit SqLiteStorage(Location location = OnDisk);
     ~SqLiteStorage();
 
     QString description() const override;
@@ -44,13 +49,22 @@ public:
 
     QSqlDatabase &database() override;
 
+    /** The database the events of @p databaseFile are archived in, see archiveEvents(). */
+    static QString archiveFileName(const QString &databaseFile);
+
 protected:
     bool createDatabase(Configuration &) override;
     bool createDatabaseTables() override;
     bool migrateDatabaseDirectory(QDir, const QDir &) const;
     QString lastInsertRowFunction() const override;
+    bool attachArchive(bool writable) override;
+    void detachArchive() override;
 
 private:
+    QString archiveFileName() const;
+    bool connectInMemory(Configuration &);
+
+    Location m_location;
     QSqlDatabase m_database;
 };
 
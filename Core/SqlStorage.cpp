@@ -26,6 +26,7 @@
 #include "CharmConstants.h"
 #include "CharmExceptions.h"
 #include "Event.h"
+#include "SqLiteBackup.h"
 #include "SqlRaiiTransactor.h"
 #include "State.h"
 #include "Task.h"
@@ -33,6 +34,8 @@
 #include <QDateTime>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QSet>
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlField>
@@ -42,8 +45,12 @@
 #include <QTextStream>
 #include <QtDebug>
 
+#include <algorithm>
+
 // SqlStorage class
 
+const quint32 SqlStorage::UnknownInstallationId;
+
 SqlStorage::SqlStorage()
 {
 }
@@ -82,6 +89,30 @@ bool SqlStorage::verifyDatabase()
         return migrateDB(QStringLiteral(
                              "ALTER TABLE Tasks ADD comment varchar(256)"),
                          CHARM_DATABASE_VERSION_BEFORE_COMMENT);
+    } else if (version == CHARM_DATABASE_VERSION_BEFORE_CHANGES) {
+        // the Changes table is created with the other missing tables, and the existing tasks
+        // and events count as changed, so that a delta since change 0 contains everything:
+        backupBeforeMigration(version);
+        const QString error = QObject::tr("Could not upgrade database from version %1 to version %2.")
+                              .arg(QString::number(version), QString::number(version + 1));
+        if (!createDatabaseTables())
+            throw UnsupportedDatabaseVersionException(error);
+        SqlRaiiTransactor transactor(database());
+        if (!recordChanges(TaskChange, QStringLiteral("task_id FROM Tasks"), false)
+            || !recordChanges(EventChange, QStringLiteral("event_id FROM Events"), false))
+            throw UnsupportedDatabaseVersionException(error);
+        transactor.commit();
+        return verifyDatabase();
+    } else if (version == CHARM_DATABASE_VERSION_BEFORE_EVENT_ORIGINS) {
+        // creates the EventOrigins table and the missing indexes of the Changes table, the
+        // existing events have no origin and are matched by their ids, see applyChanges():
+        backupBeforeMigration(version);
+        if (!createDatabaseTables()) {
+            throw UnsupportedDatabaseVersionException(
+                QObject::tr("Could not upgrade database from version %1 to version %2.")
+                .arg(QString::number(version), QString::number(version + 1)));
+        }
+        return verifyDatabase();
     }
 
     throw UnsupportedDatabaseVersionException(QObject::tr("Database version is not supported."));
@@ -91,42 +122,117 @@ bool SqlStorage::verifyDatabase()
 TaskList SqlStorage::getAllTasks()
 {
     TaskList tasks;
+    visitAllTasks([&tasks](const Task &task) {
+        tasks.append(task);
+    });
+    return tasks;
+}
+
+bool SqlStorage::visitAllTasks(const std::function<void(const Task &)> &visitor)
+{
     QSqlQuery query(database());
+    query.setForwardOnly(true);
     query.prepare(QStringLiteral(
                       "select * from Tasks left join Subscriptions on Tasks.task_id = Subscriptions.task;"));
 
     // FIXME merge record retrieval with getTask:
-    if (runQuery(query)) {
-        while (query.next())
-        {
-            Task task = makeTaskFromRecord(query.record());
-            tasks.append(task);
+    if (!runQuery(query))
+        return false;
+    while (query.next())
+        visitor(makeTaskFromRecord(query.record()));
+    return true;
+}
+
+namespace {
+// subscriptions are handled separately, and Task::operator== does not compare comments:
+bool taskDataDiffers(const Task &left, const Task &right)
+{
+    return left.name() != right.name()
+           || left.parent() != right.parent()
+           || left.validFrom() != right.validFrom()
+           || left.validUntil() != right.validUntil()
+           || left.trackable() != right.trackable()
+           || left.comment() != right.comment();
+}
+
+// orders the tasks so that every task comes after its parent, if the parent is in the list:
+TaskList parentsFirst(const TaskList &tasks)
+{
+    QHash<TaskId, int> positions;
+    for (int i = 0; i < tasks.size(); ++i)
+        positions.insert(tasks[i].id(), i);
+
+    TaskList sorted;
+    sorted.reserve(tasks.size());
+    QSet<TaskId> done;
+    QVector<int> path;
+    for (int i = 0; i < tasks.size(); ++i) {
+        // collect the chain of not yet sorted ancestors within the list, then append it top-down:
+        int position = i;
+        while (position != -1 && !done.contains(tasks[position].id())) {
+            done.insert(tasks[position].id());
+            path.append(position);
+            position = positions.value(tasks[position].parent(), -1);
         }
+        while (!path.isEmpty())
+            sorted.append(tasks[path.takeLast()]);
     }
+    return sorted;
+}
 
-    return tasks;
+// the subscription is part of the task, but removing the subscription of a deleted task
+// must not record the task as changed again:
+QString existingTaskSelection(const Task &task)
+{
+    return QStringLiteral("task_id FROM Tasks WHERE task_id = %1").arg(task.id());
+}
 }
 
-bool SqlStorage::setAllTasks(const User &user, const TaskList &tasks)
+bool SqlStorage::setAllTasks(const User &user, const TaskList &tasks, TaskListChanges *changes)
 {
     SqlRaiiTransactor transactor(database());
-    const TaskList oldTasks = getAllTasks();
-    // clear tasks
-    deleteAllTasks(transactor);
-    // add tasks
+    QHash<TaskId, Task> oldTasks;
+    Q_FOREACH (const Task &task, getAllTasks())
+        oldTasks.insert(task.id(), task);
+
+    TaskList added;
+    TaskList modified;
     Q_FOREACH (Task task, tasks) {
-        task.setSubscribed(false);
-        addTask(task, transactor);
-    }
-    // try to restore subscriptions where possible
-    Q_FOREACH (const Task &oldTask, oldTasks) {
-        const Task task = getTask(oldTask.id());
-        if (task.isValid()) {
-            if (oldTask.subscribed())
-                addSubscription(user, task);
+        const auto it = oldTasks.constFind(task.id());
+        if (it == oldTasks.constEnd()) {
+            task.setSubscribed(false);
+            if (!addTask(task, transactor) || !deleteSubscription(user, task))
+                return false;
+            added << task;
+        } else {
+            task.setSubscribed(it->subscribed());
+            if (taskDataDiffers(*it, task)) {
+                if (!modifyTask(task, transactor))
+                    return false;
+                modified << task;
+            }
+            oldTasks.erase(it);
         }
     }
-    transactor.commit();
+    // the remaining old tasks are not part of the new task list:
+    const TaskList removed = oldTasks.values();
+    Q_FOREACH (const Task &task, removed) {
+        QSqlQuery query(database());
+        query.prepare(QStringLiteral("DELETE from Tasks where task_id = :task_id;"));
+        query.bindValue(QStringLiteral(":task_id"), task.id());
+        if (!runQuery(query) || !deleteSubscription(user, task)
+            || !recordChange(TaskChange, task.id(), true))
+            return false;
+    }
+
+    if (!transactor.commit())
+        return false;
+    if (changes) {
+        changes->added = parentsFirst(added);
+        changes->modified = modified;
+        changes->removed = parentsFirst(removed);
+        std::reverse(changes->removed.begin(), changes->removed.end());
+    }
     return true;
 }
 
@@ -154,7 +260,7 @@ bool SqlStorage::addTask(const Task &task, const SqlRaiiTransactor &)
     query.bindValue(QStringLiteral(":validuntil"), task.validUntil());
     query.bindValue(QStringLiteral(":trackable"), task.trackable() ? 1 : 0);
     query.bindValue(QStringLiteral(":comment"), task.comment());
-    return runQuery(query);
+    return runQuery(query) && recordChange(TaskChange, task.id(), false);
 }
 
 Task SqlStorage::getTask(int taskid)
@@ -173,18 +279,30 @@ Task SqlStorage::getTask(int taskid)
 }
 
 bool SqlStorage::modifyTask(const Task &task)
+{
+    SqlRaiiTransactor transactor(database());
+    if (modifyTask(task, transactor)) {
+        transactor.commit();
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool SqlStorage::modifyTask(const Task &task, const SqlRaiiTransactor &)
 {
     QSqlQuery query(database());
     query.prepare(QLatin1String("UPDATE Tasks set name = :name, parent = :parent, "
-                                "validfrom = :validfrom, validuntil = :validuntil, trackable = :trackable "
-                                "where task_id = :task_id;"));
+                                "validfrom = :validfrom, validuntil = :validuntil, trackable = :trackable, "
+                                "comment = :comment where task_id = :task_id;"));
     query.bindValue(QStringLiteral(":task_id"), task.id());
     query.bindValue(QStringLiteral(":name"), task.name());
     query.bindValue(QStringLiteral(":parent"), task.parent());
     query.bindValue(QStringLiteral(":validfrom"), task.validFrom());
     query.bindValue(QStringLiteral(":validuntil"), task.validUntil());
     query.bindValue(QStringLiteral(":trackable"), task.trackable() ? 1 : 0);
-    return runQuery(query);
+    query.bindValue(QStringLiteral(":comment"), task.comment());
+    return runQuery(query) && recordChange(TaskChange, task.id(), false);
 }
 
 bool SqlStorage::deleteTask(const Task &task)
@@ -193,11 +311,14 @@ bool SqlStorage::deleteTask(const Task &task)
     QSqlQuery query(database());
     query.prepare(QStringLiteral("DELETE from Tasks where task_id = :task_id;"));
     query.bindValue(QStringLiteral(":task_id"), task.id());
-    bool rc = runQuery(query);
+    bool rc = runQuery(query) && recordChange(TaskChange, task.id(), true);
+    // the events of the task are deleted with it:
+    bool rc2 = recordChanges(EventChange, QStringLiteral("event_id FROM Events WHERE task = %1")
+                             .arg(task.id()), true);
     QSqlQuery query2(database());
     query2.prepare(QStringLiteral("DELETE from Events where task = :task_id;"));
     query2.bindValue(QStringLiteral(":task_id"), task.id());
-    bool rc2 = runQuery(query2);
+    rc2 = rc2 && runQuery(query2);
     if (rc && rc2) {
         transactor.commit();
         return true;
@@ -221,7 +342,7 @@ bool SqlStorage::deleteAllTasks(const SqlRaiiTransactor &)
 {
     QSqlQuery query(database());
     query.prepare(QStringLiteral("DELETE from Tasks;"));
-    return runQuery(query);
+    return recordChanges(TaskChange, QStringLiteral("task_id FROM Tasks"), true) && runQuery(query);
 }
 
 Event SqlStorage::makeEventFromRecord(const QSqlRecord &record)
@@ -253,18 +374,107 @@ Event SqlStorage::makeEventFromRecord(const QSqlRecord &record)
     return event;
 }
 
-EventList SqlStorage::getAllEvents()
+EventList SqlStorage::getAllEvents(EventSelection selection)
 {
     EventList events;
-    QSqlQuery query(database());
-    query.prepare(QStringLiteral("SELECT * from Events;"));
-    if (runQuery(query)) {
-        while (query.next())
-            events.append(makeEventFromRecord(query.record()));
-    }
+    visitAllEvents([&events](const Event &event) {
+        events.append(event);
+    }, selection);
     return events;
 }
 
+bool SqlStorage::visitAllEvents(const std::function<void(const Event &)> &visitor,
+                                EventSelection selection)
+{
+    // the archive is only attached if something has been archived:
+    const bool withArchive = selection != CurrentEvents && archiveCutoff().isValid()
+                             && attachArchive(false);
+    QStringList selects;
+    if (selection != ArchivedEvents)
+        selects << QStringLiteral("SELECT * from Events");
+    if (withArchive)
+        selects << QStringLiteral("SELECT * from archive.Events");
+    return visitEvents(selects, QString(), QVariantMap(), withArchive, visitor);
+}
+
+EventList SqlStorage::getEventsInRange(const QDateTime &start, const QDateTime &end,
+                                       EventSelection selection)
+{
+    EventList events;
+    visitEventsInRange(start, end, [&events](const Event &event) {
+        events.append(event);
+    }, selection);
+    return events;
+}
+
+bool SqlStorage::visitEventsInRange(const QDateTime &start, const QDateTime &end,
+                                    const std::function<void(const Event &)> &visitor,
+                                    EventSelection selection)
+{
+    const QDateTime cutoff = selection != CurrentEvents ? archiveCutoff() : QDateTime();
+    // the archive is only attached if the range reaches into it:
+    const bool withArchive = cutoff.isValid() && start < cutoff && attachArchive(false);
+    QStringList selects;
+    if (selection != ArchivedEvents) {
+        selects << QStringLiteral("SELECT * from Events "
+                                  "WHERE start >= :start AND start < :end");
+    }
+    if (withArchive) {
+        selects << QStringLiteral("SELECT * from archive.Events "
+                                  "WHERE start >= :archive_start AND start < :archive_end");
+    }
+    QVariantMap values;
+    values.insert(QStringLiteral(":start"), start.toUTC());
+    values.insert(QStringLiteral(":end"), end.toUTC());
+    values.insert(QStringLiteral(":archive_start"), start.toUTC());
+    values.insert(QStringLiteral(":archive_end"), end.toUTC());
+    return visitEvents(selects, QStringLiteral(" ORDER BY start"), values, withArchive, visitor);
+}
+
+bool SqlStorage::visitEvents(const QStringList &selects, const QString &order,
+                             const QVariantMap &values, bool withArchive,
+                             const std::function<void(const Event &)> &visitor)
+{
+    if (selects.isEmpty())
+        return true;
+
+    bool result = false;
+    {
+        const QString statement = selects.join(QStringLiteral(" UNION ALL ")) + order
+                                  + QLatin1Char(';');
+        QSqlQuery query(database());
+        query.setForwardOnly(true);
+        query.prepare(statement);
+        for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+            if (statement.contains(it.key()))
+                query.bindValue(it.key(), it.value());
+        }
+        result = runQuery(query);
+        if (result) {
+            while (query.next())
+                visitor(makeEventFromRecord(query.record()));
+        }
+    }
+    // the query has to be finished before the archive can be detached:
+    if (withArchive)
+        detachArchive();
+    return result;
+}
+
+int SqlStorage::nextEventId()
+{
+    // without AUTOINCREMENT, the database continues after the highest id in the table, which
+    // may be lower than the id of an archived event:
+    const int lastArchivedId = getMetaData(MetaKey_EventArchiveLastId).toInt();
+    if (lastArchivedId <= 0)
+        return 0;
+    QSqlQuery query(database());
+    query.prepare(QStringLiteral("SELECT MAX(id) FROM Events;"));
+    if (!runQuery(query) || !query.next())
+        return 0;
+    return query.value(0).toInt() < lastArchivedId ? lastArchivedId + 1 : 0;
+}
+
 Event SqlStorage::makeEvent()
 {
     SqlRaiiTransactor transactor(database());
@@ -280,9 +490,15 @@ Event SqlStorage::makeEvent(const SqlRaiiTransactor &)
     Event event;
 
     { // insert a new record in the database
+        const int id = nextEventId();
         QSqlQuery query(database());
-        query.prepare(QLatin1String("INSERT into Events values "
-                                    "( NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL );"));
+        if (id > 0) {
+            query.prepare(QStringLiteral("INSERT into Events (id) values (:id);"));
+            query.bindValue(QStringLiteral(":id"), id);
+        } else {
+            query.prepare(QLatin1String("INSERT into Events values "
+                                        "( NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL );"));
+        }
         result = runQuery(query);
         Q_ASSERT(result); // this has to suceed
     }
@@ -304,15 +520,16 @@ Event SqlStorage::makeEvent(const SqlRaiiTransactor &)
     }
     if (result) {
         // modify the created record to make sure event_id is unique
-        // within the installation:
+        // within the database, the origin identifies it in other ones:
         QSqlQuery query(database());
         query.prepare(QLatin1String("UPDATE Events SET event_id = :event_id, "
-                                    "installation_id = :installation_id, report_id = :report_id WHERE id = :id;"));
+                                    "report_id = :report_id WHERE id = :id;"));
         query.bindValue(QStringLiteral(":event_id"), event.id());
-        query.bindValue(QStringLiteral(":installation_id"), 1);
         query.bindValue(QStringLiteral(":report_id"), event.reportId());
         query.bindValue(QStringLiteral(":id"), event.id());
-        result = runQuery(query);
+        result = runQuery(query) && recordChange(EventChange, event.id(), false)
+                 && setEventOrigin(event.id(), Configuration::instance().installationId,
+                                   event.id());
         Q_ASSERT_X(result, Q_FUNC_INFO,
                    "database implementation error (UPDATE)");
     }
@@ -367,16 +584,27 @@ bool SqlStorage::modifyEvent(const Event &event, const SqlRaiiTransactor &)
     query.bindValue(QStringLiteral(":start"), event.startDateTime());
     query.bindValue(QStringLiteral(":end"), event.endDateTime());
 
-    return runQuery(query);
+    return runQuery(query) && recordChange(EventChange, event.id(), false);
 }
 
 bool SqlStorage::deleteEvent(const Event &event)
+{
+    SqlRaiiTransactor transactor(database());
+    if (deleteEvent(event, transactor)) {
+        transactor.commit();
+        return true;
+    } else {
+        return false;
+    }
+}
+
+bool SqlStorage::deleteEvent(const Event &event, const SqlRaiiTransactor &)
 {
     QSqlQuery query(database());
     query.prepare(QStringLiteral("DELETE from Events where event_id = :id;"));
     query.bindValue(QStringLiteral(":id"), event.id());
 
-    return runQuery(query);
+    return runQuery(query) && recordChange(EventChange, event.id(), true);
 }
 
 bool SqlStorage::deleteAllEvents()
@@ -392,9 +620,13 @@ bool SqlStorage::deleteAllEvents()
 
 bool SqlStorage::deleteAllEvents(const SqlRaiiTransactor &)
 {
+    // the origins go with the events, events added later start a new history:
     QSqlQuery query(database());
     query.prepare(QStringLiteral("DELETE from Events;"));
-    return runQuery(query);
+    QSqlQuery origins(database());
+    origins.prepare(QStringLiteral("DELETE from EventOrigins;"));
+    return recordChanges(EventChange, QStringLiteral("event_id FROM Events"), true)
+           && runQuery(query) && runQuery(origins);
 }
 
 bool SqlStorage::runQuery(QSqlQuery &query)
@@ -418,13 +650,21 @@ bool SqlStorage::runQuery(QSqlQuery &query)
 #endif
 }
 
-bool SqlStorage::migrateDB(const QString &queryString, int oldVersion)
+void SqlStorage::backupBeforeMigration(int oldVersion)
 {
     const QFileInfo info(Configuration::instance().localStorageDatabase);
     if (info.exists()) {
-        QFile::copy(info.fileName(), info.fileName().append(QStringLiteral("-backup-version-%1")
-                                                            .arg(oldVersion)));
+        const QString databaseFile = info.absoluteFilePath();
+        SqLiteBackup backup(databaseFile, databaseFile + QStringLiteral("-backup-version-%1")
+                            .arg(oldVersion));
+        if (!backup.copy())
+            qWarning() << "SqlStorage::migrateDB: backup failed:" << backup.errorString();
     }
+}
+
+bool SqlStorage::migrateDB(const QString &queryString, int oldVersion)
+{
+    backupBeforeMigration(oldVersion);
     SqlRaiiTransactor transactor(database());
     QSqlQuery query(database());
     query.prepare(queryString);
@@ -557,7 +797,7 @@ bool SqlStorage::addSubscription(User user, Task task)
         query.prepare(QStringLiteral("INSERT into Subscriptions VALUES (NULL, :user_id, :task);"));
         query.bindValue(QStringLiteral(":user_id"), user.id());
         query.bindValue(QStringLiteral(":task"), task.id());
-        return runQuery(query);
+        return runQuery(query) && recordChanges(TaskChange, existingTaskSelection(task), false);
     } else {
         return true;
     }
@@ -570,7 +810,7 @@ bool SqlStorage::deleteSubscription(User user, Task task)
                       "DELETE from Subscriptions WHERE user_id = :user_id AND task = :task;"));
     query.bindValue(QStringLiteral(":user_id"), user.id());
     query.bindValue(QStringLiteral(":task"), task.id());
-    return runQuery(query);
+    return runQuery(query) && recordChanges(TaskChange, existingTaskSelection(task), false);
 }
 
 bool SqlStorage::setMetaData(const QString &key, const QString &value)
@@ -585,37 +825,36 @@ bool SqlStorage::setMetaData(const QString &key, const QString &value)
 
 bool SqlStorage::setMetaData(const QString &key, const QString &value, const SqlRaiiTransactor &)
 {
-    // find out if the key is in the database:
-    bool result;
+    // update the key if it is in the database:
     {
-        QSqlQuery query(database());
-        query.prepare(QStringLiteral("SELECT * FROM MetaData WHERE MetaData.key = :key;"));
-        query.bindValue(QStringLiteral(":key"), key);
-        if (runQuery(query) && query.next()) {
-            result = true;
-        } else {
-            result = false;
-        }
-    }
-
-    if (result) { // key exists, let's update:
         QSqlQuery query(database());
         query.prepare(QStringLiteral("UPDATE MetaData SET value = :value WHERE key = :key;"));
         query.bindValue(QStringLiteral(":value"), value);
         query.bindValue(QStringLiteral(":key"), key);
+        if (!runQuery(query))
+            return false;
+        // the backends count matched rows, not only the rows whose value has changed:
+        if (query.numRowsAffected() > 0)
+            return true;
+    }
 
-        return runQuery(query);
-    } else {
-        // key does not exist, let's insert:
-        QSqlQuery query(database());
-        query.prepare(QStringLiteral("INSERT INTO MetaData VALUES ( NULL, :key, :value );"));
-        query.bindValue(QStringLiteral(":key"), key);
-        query.bindValue(QStringLiteral(":value"), value);
+    // key does not exist, let's insert:
+    QSqlQuery query(database());
+    query.prepare(QStringLiteral("INSERT INTO MetaData VALUES ( NULL, :key, :value );"));
+    query.bindValue(QStringLiteral(":key"), key);
+    query.bindValue(QStringLiteral(":value"), value);
 
-        return runQuery(query);
-    }
+    return runQuery(query);
+}
 
-    return false; // never reached
+bool SqlStorage::setAllMetaData(const QHash<QString, QString> &metaData)
+{
+    SqlRaiiTransactor transactor(database());
+    for (auto it = metaData.constBegin(); it != metaData.constEnd(); ++it) {
+        if (!setMetaData(it.key(), it.value(), transactor))
+            return false;
+    }
+    return transactor.commit();
 }
 
 QString SqlStorage::getMetaData(const QString &key)
@@ -632,6 +871,82 @@ QString SqlStorage::getMetaData(const QString &key)
     }
 }
 
+QHash<QString, QString> SqlStorage::getAllMetaData()
+{
+    QHash<QString, QString> metaData;
+    QSqlQuery query(database());
+    query.prepare(QStringLiteral("SELECT key, value FROM MetaData;"));
+    if (runQuery(query)) {
+        while (query.next()) {
+            // like getMetaData(), use the first value if a key is stored more than once:
+            const QString key = query.value(0).toString();
+            if (!metaData.contains(key))
+                metaData.insert(key, query.value(1).toString());
+        }
+    }
+    return metaData;
+}
+
+bool SqlStorage::archiveEvents(const QDateTime &cutoff)
+{
+    // attaching a database is not possible within a transaction:
+    if (!attachArchive(true))
+        return false;
+
+    bool success = false;
+    try {
+        SqlRaiiTransactor transactor(database());
+        const QDateTime previousCutoff = archiveCutoff();
+        const QDateTime newCutoff = previousCutoff.isValid() ? qMax(previousCutoff, cutoff) : cutoff;
+        QSqlQuery create(database());
+        create.prepare(QStringLiteral(
+                           "CREATE TABLE IF NOT EXISTS archive.Events AS SELECT * FROM main.Events WHERE 0;"));
+        // without a cutoff, the archive is left over from before the events were imported:
+        QSqlQuery clear(database());
+        clear.prepare(QStringLiteral("DELETE FROM archive.Events;"));
+        QSqlQuery copy(database());
+        copy.prepare(QStringLiteral(
+                         "INSERT INTO archive.Events SELECT * FROM main.Events WHERE end < :cutoff;"));
+        copy.bindValue(QStringLiteral(":cutoff"), cutoff.toUTC());
+        QSqlQuery remove(database());
+        remove.prepare(QStringLiteral("DELETE FROM main.Events WHERE end < :cutoff;"));
+        remove.bindValue(QStringLiteral(":cutoff"), cutoff.toUTC());
+        QSqlQuery lastId(database());
+        lastId.prepare(QStringLiteral("SELECT MAX(id) FROM archive.Events;"));
+        if (runQuery(create) && (previousCutoff.isValid() || runQuery(clear))
+            && runQuery(copy) && runQuery(remove) && runQuery(lastId) && lastId.next()) {
+            // new events continue after the archived ones, see nextEventId():
+            const QString lastArchivedId = lastId.value(0).toString();
+            lastId.finish();
+            if (setMetaData(MetaKey_EventArchiveCutoff, newCutoff.toUTC().toString(Qt::ISODate),
+                            transactor)
+                && setMetaData(MetaKey_EventArchiveLastId, lastArchivedId, transactor)) {
+                success = transactor.commit();
+            }
+        }
+    } catch (...) {
+        detachArchive();
+        throw;
+    }
+    detachArchive();
+    return success;
+}
+
+QDateTime SqlStorage::archiveCutoff()
+{
+    return QDateTime::fromString(getMetaData(MetaKey_EventArchiveCutoff), Qt::ISODate);
+}
+
+bool SqlStorage::attachArchive(bool writable)
+{
+    Q_UNUSED(writable);
+    return false;
+}
+
+void SqlStorage::detachArchive()
+{
+}
+
 Task SqlStorage::makeTaskFromRecord(const QSqlRecord &record)
 {
     Task task;
@@ -672,8 +987,9 @@ QString SqlStorage::setAllTasksAndEvents(const User &user, const TaskList &tasks
 {
     SqlRaiiTransactor transactor(database());
 
-    // clear subscriptions, tasks and events:
-    if (!deleteAllEvents(transactor))
+    // clear subscriptions, tasks and events. Exports include the archived events, the
+    // archive is not used anymore:
+    if (!deleteAllEvents(transactor) || !discardArchive(transactor))
         return QObject::tr("Error deleting the existing events.");
     Q_ASSERT(getAllEvents().isEmpty());
     if (!deleteAllTasks(transactor))
@@ -681,38 +997,334 @@ QString SqlStorage::setAllTasksAndEvents(const User &user, const TaskList &tasks
     Q_ASSERT(getAllTasks().isEmpty());
 
     // now import Events and Tasks from the XML document:
+    QSet<TaskId> taskIds;
     Q_FOREACH (const Task &task, tasks) {
-        // don't use our own addTask method, it emits signals and that
-        // confuses the model, because the task tree is not inserted depth-first:
-        if (addTask(task, transactor)) {
-            if (task.subscribed()) {
-                bool result = addSubscription(user, task);
-                Q_ASSERT(result);
-                Q_UNUSED(result);
+        if (!addImportedTask(user, task, transactor))
+            return QObject::tr("Cannot add imported tasks.");
+        taskIds.insert(task.id());
+    }
+    EventList validEvents;
+    Q_FOREACH (const Event &event, events) {
+        // events of unknown tasks are a semantical error:
+        if (event.isValid() && taskIds.contains(event.taskId()))
+            validEvents.append(event);
+    }
+    if (!addEvents(validEvents, transactor))
+        return QObject::tr("Error adding imported event.");
+
+    transactor.commit();
+    return QString();
+}
+
+bool SqlStorage::addImportedTask(const User &user, const Task &task,
+                                 const SqlRaiiTransactor &transactor)
+{
+    // don't use our own addTask method, it emits signals and that
+    // confuses the model, because the task tree is not inserted depth-first:
+    if (!addTask(task, transactor))
+        return false;
+    bool result;
+    if (task.subscribed())
+        result = addSubscription(user, task);
+    else
+        result = deleteSubscription(user, task);
+    Q_ASSERT(result);
+    Q_UNUSED(result);
+    return true;
+}
+
+bool SqlStorage::addEvents(const EventList &events, const SqlRaiiTransactor &)
+{
+    if (events.isEmpty())
+        return true;
+
+    // one prepared statement for all events, the event ids are assigned from the row ids below.
+    // Only the first row may need an explicit id, the others follow it:
+    int id = nextEventId();
+    QSqlQuery query(database());
+    query.prepare(QLatin1String("INSERT into Events (id, user_id, installation_id, report_id, "
+                                "task, comment, start, end) VALUES (:id, :user, :installation_id, "
+                                ":report, :task, :comment, :start, :end);"));
+    Q_FOREACH (const Event &event, events) {
+        query.bindValue(QStringLiteral(":id"), id > 0 ? QVariant(id) : QVariant(QVariant::Int));
+        id = 0;
+        query.bindValue(QStringLiteral(":user"), event.userId());
+        query.bindValue(QStringLiteral(":installation_id"), 1);
+        query.bindValue(QStringLiteral(":report"), event.reportId());
+        query.bindValue(QStringLiteral(":task"), event.taskId());
+        query.bindValue(QStringLiteral(":comment"), event.comment());
+        query.bindValue(QStringLiteral(":start"), event.startDateTime());
+        query.bindValue(QStringLiteral(":end"), event.endDateTime());
+        if (!runQuery(query))
+            return false;
+    }
+
+    // same as makeEvent(): the event id is unique within the database. The imported events
+    // have no origin, an origin left from a deleted event with the same id does not apply:
+    if (!recordChanges(EventChange, QStringLiteral("id FROM Events WHERE event_id IS NULL"), false))
+        return false;
+    QSqlQuery origins(database());
+    origins.prepare(QLatin1String("DELETE FROM EventOrigins WHERE event_id IN "
+                                  "(SELECT id FROM Events WHERE event_id IS NULL);"));
+    if (!runQuery(origins))
+        return false;
+    QSqlQuery update(database());
+    update.prepare(QStringLiteral("UPDATE Events SET event_id = id WHERE event_id IS NULL;"));
+    return runQuery(update);
+}
+
+bool SqlStorage::setAllEvents(const EventList &events)
+{
+    SqlRaiiTransactor transactor(database());
+    if (!deleteAllEvents(transactor) || !discardArchive(transactor))
+        return false;
+
+    // the row id has to match the event id for makeEvent() to continue after them:
+    QSqlQuery query(database());
+    query.prepare(QLatin1String("INSERT INTO Events (id, event_id, installation_id, user_id, "
+                                "report_id, task, comment, start, end) VALUES (:id, :event_id, "
+                                ":installation_id, :user_id, :report_id, :task, :comment, "
+                                ":start, :end);"));
+    Q_FOREACH (const Event &event, events) {
+        query.bindValue(QStringLiteral(":id"), event.id());
+        query.bindValue(QStringLiteral(":event_id"), event.id());
+        query.bindValue(QStringLiteral(":installation_id"), 1);
+        query.bindValue(QStringLiteral(":user_id"), event.userId());
+        query.bindValue(QStringLiteral(":report_id"), event.reportId());
+        query.bindValue(QStringLiteral(":task"), event.taskId());
+        query.bindValue(QStringLiteral(":comment"), event.comment());
+        query.bindValue(QStringLiteral(":start"), event.startDateTime());
+        query.bindValue(QStringLiteral(":end"), event.endDateTime());
+        if (!runQuery(query))
+            return false;
+    }
+
+    // all events share one change, so that delta exports pick them up:
+    return recordChanges(EventChange, QStringLiteral("event_id FROM Events"), false)
+           && transactor.commit();
+}
+
+bool SqlStorage::discardArchive(const SqlRaiiTransactor &transactor)
+{
+    // without a cutoff, the archive is not read anymore, and cleared when events are archived:
+    return setMetaData(MetaKey_EventArchiveCutoff, QString(), transactor)
+           && setMetaData(MetaKey_EventArchiveLastId, QString(), transactor);
+}
+
+qint64 SqlStorage::lastChange()
+{
+    // not cached, a cached number would be wrong after a transaction is rolled back. The
+    // index on change_id lets the database read the maximum without scanning the table:
+    QSqlQuery query(database());
+    query.prepare(QStringLiteral("SELECT MAX(change_id) FROM Changes;"));
+    if (!runQuery(query) || !query.next())
+        return 0;
+    // the maximum of an empty table is NULL, which converts to 0:
+    return query.value(0).toLongLong();
+}
+
+bool SqlStorage::getChangesSince(qint64 since, ChangeSet *changes)
+{
+    Q_ASSERT(changes);
+    *changes = ChangeSet();
+    changes->lastChange = since;
+
+    // every changed task and event has one row with its latest change:
+    {
+        QSqlQuery query(database());
+        query.setForwardOnly(true);
+        query.prepare(QLatin1String("SELECT kind, object_id, change_id, deleted, "
+                                    "EventOrigins.installation_id, EventOrigins.origin_id "
+                                    "FROM Changes LEFT JOIN EventOrigins ON kind = :event_kind "
+                                    "AND object_id = EventOrigins.event_id "
+                                    "WHERE change_id > :since;"));
+        query.bindValue(QStringLiteral(":event_kind"), EventChange);
+        query.bindValue(QStringLiteral(":since"), since);
+        if (!runQuery(query))
+            return false;
+        while (query.next()) {
+            changes->lastChange = qMax(changes->lastChange, query.value(2).toLongLong());
+            if (query.value(3).toInt() == 0)
+                continue;
+            if (query.value(0).toInt() == TaskChange) {
+                changes->deletedTasks.append(query.value(1).toInt());
+            } else if (query.isNull(4)) {
+                changes->deletedEvents.append(query.value(1).toInt());
+                changes->deletedEventInstallations.append(UnknownInstallationId);
             } else {
-                bool result = deleteSubscription(user, task);
-                Q_ASSERT(result);
-                Q_UNUSED(result);
+                changes->deletedEvents.append(query.value(5).toInt());
+                changes->deletedEventInstallations.append(query.value(4).toUInt());
             }
+        }
+    }
+
+    // the current state of the tasks and events that still exist:
+    const QString changed = QStringLiteral(
+        "IN (SELECT object_id FROM Changes WHERE kind = :kind AND deleted = 0 "
+        "AND change_id > :since AND change_id <= :until);");
+    QSqlQuery tasks(database());
+    tasks.setForwardOnly(true);
+    tasks.prepare(QStringLiteral("SELECT * FROM Tasks LEFT JOIN Subscriptions "
+                                 "ON Tasks.task_id = Subscriptions.task WHERE task_id ") + changed);
+    tasks.bindValue(QStringLiteral(":kind"), TaskChange);
+    tasks.bindValue(QStringLiteral(":since"), since);
+    tasks.bindValue(QStringLiteral(":until"), changes->lastChange);
+    if (!runQuery(tasks))
+        return false;
+    while (tasks.next())
+        changes->tasks.append(makeTaskFromRecord(tasks.record()));
+
+    QSqlQuery events(database());
+    events.setForwardOnly(true);
+    events.prepare(QLatin1String("SELECT Events.*, EventOrigins.installation_id AS origin_installation, "
+                                 "EventOrigins.origin_id FROM Events LEFT JOIN EventOrigins "
+                                 "ON Events.event_id = EventOrigins.event_id "
+                                 "WHERE Events.event_id ") + changed);
+    events.bindValue(QStringLiteral(":kind"), EventChange);
+    events.bindValue(QStringLiteral(":since"), since);
+    events.bindValue(QStringLiteral(":until"), changes->lastChange);
+    if (!runQuery(events))
+        return false;
+    while (events.next()) {
+        const QSqlRecord record = events.record();
+        Event event = makeEventFromRecord(record);
+        const QVariant installation = record.value(QStringLiteral("origin_installation"));
+        if (installation.isNull()) {
+            changes->eventInstallations.append(UnknownInstallationId);
         } else {
-            return QObject::tr("Cannot add imported tasks.");
+            event.setId(record.value(QStringLiteral("origin_id")).toInt());
+            changes->eventInstallations.append(installation.toUInt());
         }
+        changes->events.append(event);
     }
-    Q_FOREACH (const Event &event, events) {
-        if (!event.isValid()) continue;
-        Task task = getTask(event.taskId());
-        if (!task.isValid()) {
-            // semantical error
-            continue;
+    return true;
+}
+
+bool SqlStorage::applyChanges(const User &user, const ChangeSet &changes,
+                              const SqlRaiiTransactor &transactor)
+{
+    Q_FOREACH (const Task &task, changes.tasks) {
+        const bool exists = getTask(task.id()).isValid();
+        if (!(exists ? modifyTask(task, transactor) : addTask(task, transactor)))
+            return false;
+        if (!(task.subscribed() ? addSubscription(user, task) : deleteSubscription(user, task)))
+            return false;
+    }
+
+    // the events are matched by their origin, new ones get an id of this database like
+    // events created here. Copies of a database assign the same ids to different events:
+    for (int i = 0; i < changes.events.size(); ++i) {
+        Event event = changes.events.at(i);
+        const quint32 installation = changes.eventInstallations.value(i, UnknownInstallationId);
+        int id;
+        if (!findEvent(installation, event.id(), &id))
+            return false;
+        if (id == 0) {
+            id = makeEvent(transactor).id();
+            if (id == 0 || !setEventOrigin(id, installation, event.id()))
+                return false;
+        } else if (!getEvent(id).isValid()) {
+            continue; // deleted or archived here
         }
-        Event newEvent = makeEvent(transactor);
-        int id = newEvent.id();
-        newEvent = event;
-        newEvent.setId(id);
-        if (!modifyEvent(newEvent, transactor))
-            return QObject::tr("Error adding imported event.");
+        event.setId(id);
+        if (!modifyEvent(event, transactor))
+            return false;
     }
 
-    transactor.commit();
-    return QString();
+    for (int i = 0; i < changes.deletedEvents.size(); ++i) {
+        const quint32 installation = changes.deletedEventInstallations.value(i, UnknownInstallationId);
+        int id;
+        if (!findEvent(installation, changes.deletedEvents.at(i), &id))
+            return false;
+        if (id == 0)
+            continue;
+        Event event;
+        event.setId(id);
+        if (!deleteEvent(event, transactor))
+            return false;
+    }
+    QSqlQuery deleteTask(database());
+    deleteTask.prepare(QStringLiteral("DELETE from Tasks where task_id = :task_id;"));
+    Q_FOREACH (TaskId id, changes.deletedTasks) {
+        deleteTask.bindValue(QStringLiteral(":task_id"), id);
+        if (!runQuery(deleteTask) || !recordChange(TaskChange, id, true)
+            || !deleteSubscription(user, Task(id, QString())))
+            return false;
+    }
+    return true;
+}
+
+bool SqlStorage::setEventOrigin(int eventId, quint32 installation, int originId)
+{
+    QSqlQuery query(database());
+    query.prepare(QLatin1String("REPLACE into EventOrigins (event_id, installation_id, origin_id) "
+                                "VALUES (:event_id, :installation_id, :origin_id);"));
+    query.bindValue(QStringLiteral(":event_id"), eventId);
+    query.bindValue(QStringLiteral(":installation_id"), installation);
+    query.bindValue(QStringLiteral(":origin_id"), originId);
+    QSqlQuery update(database());
+    update.prepare(QStringLiteral("UPDATE Events SET installation_id = :installation_id "
+                                  "WHERE event_id = :event_id;"));
+    update.bindValue(QStringLiteral(":installation_id"), installation);
+    update.bindValue(QStringLiteral(":event_id"), eventId);
+    return runQuery(query) && runQuery(update);
+}
+
+bool SqlStorage::findEvent(quint32 installation, int originId, int *eventId)
+{
+    Q_ASSERT(eventId);
+    *eventId = 0;
+    QSqlQuery query(database());
+    query.setForwardOnly(true);
+    query.prepare(QLatin1String("SELECT event_id FROM EventOrigins "
+                                "WHERE installation_id = :installation_id AND origin_id = :origin_id;"));
+    query.bindValue(QStringLiteral(":installation_id"), installation);
+    query.bindValue(QStringLiteral(":origin_id"), originId);
+    if (!runQuery(query))
+        return false;
+    if (query.next()) {
+        *eventId = query.value(0).toInt();
+        return true;
+    }
+    if (installation != UnknownInstallationId)
+        return true;
+
+    // events without an origin have the same id in all copies of the database:
+    QSqlQuery unknown(database());
+    unknown.setForwardOnly(true);
+    unknown.prepare(QLatin1String("SELECT event_id FROM Events WHERE event_id = :origin_id "
+                                  "AND NOT EXISTS (SELECT 1 FROM EventOrigins "
+                                  "WHERE EventOrigins.event_id = Events.event_id);"));
+    unknown.bindValue(QStringLiteral(":origin_id"), originId);
+    if (!runQuery(unknown))
+        return false;
+    if (unknown.next())
+        *eventId = unknown.value(0).toInt();
+    return true;
+}
+
+bool SqlStorage::recordChange(ChangeKind kind, int id, bool deleted)
+{
+    const qint64 change = lastChange() + 1;
+    QSqlQuery query(database());
+    query.prepare(QStringLiteral("REPLACE into Changes (kind, object_id, change_id, deleted) "
+                                 "VALUES (:kind, :object_id, :change_id, :deleted);"));
+    query.bindValue(QStringLiteral(":kind"), kind);
+    query.bindValue(QStringLiteral(":object_id"), id);
+    query.bindValue(QStringLiteral(":change_id"), change);
+    query.bindValue(QStringLiteral(":deleted"), deleted ? 1 : 0);
+    return runQuery(query);
+}
+
+bool SqlStorage::recordChanges(ChangeKind kind, const QString &selection, bool deleted)
+{
+    // all tasks or events selected by "<id column> FROM <table> [WHERE ...]" share one change:
+    const qint64 change = lastChange() + 1;
+    QSqlQuery query(database());
+    query.prepare(QStringLiteral("REPLACE into Changes (kind, change_id, deleted, object_id) "
+                                 "SELECT :kind, :change_id, :deleted, %1;").arg(selection));
+    query.bindValue(QStringLiteral(":kind"), kind);
+    query.bindValue(QStringLiteral(":change_id"), change);
+    query.bindValue(QStringLiteral(":deleted"), deleted ? 1 : 0);
+    return runQuery(query);
 }
@@ -24,7 +24,12 @@
 #ifndef SQLSTORAGE_H
 #define SQLSTORAGE_H
 
+#include <QHash>
 #include <QString>
+#include <QStringList>
+#include <QVariant>
+
+#include <functional>
 
 #include "Task.h"
 #include "User.h"
@@ -41,6 +46,36 @@ class SqlRaiiTransactor;
 class SqlStorage
 {
 public:
+    /** The changes setAllTasks() applied to the stored task list.
+        Added tasks are ordered parents first, removed tasks children first,
+        so that they can be applied to a task tree one by one. */
+    struct TaskListChanges {
+        TaskList added;
+        TaskList modified;
+        TaskList removed;
+    };
+
+    /** The installation of events without a recorded origin, which were created before
+        origins were recorded, or imported from a complete export. */
+    static const quint32 UnknownInstallationId = 1;
+
+    /** The tasks and events changed after a given change, see getChangesSince().
+        Tasks and events that have been deleted are only listed by their ids. Copies of a
+        database assign the same ids to different new events, so events are identified by
+        the installation that created them, and the id they have there. */
+    struct ChangeSet {
+        TaskList tasks;
+        /** The events, with the ids they have in the installation that created them. */
+        EventList events;
+        /** The installation that created each of the events. */
+        QList<quint32> eventInstallations;
+        TaskIdList deletedTasks;
+        EventIdList deletedEvents;
+        QList<quint32> deletedEventInstallations;
+        /** The latest change contained in the set. */
+        qint64 lastChange = 0;
+    };
+
     SqlStorage();
     virtual ~SqlStorage();
 
@@ -64,17 +99,45 @@ public:
 
     // task database functions:
     TaskList getAllTasks();
-    bool setAllTasks(const User &user, const TaskList &tasks);
+    /** Call @p visitor for every stored task, in the order returned by the database,
+        without building a list. Returns false if the query failed. */
+    bool visitAllTasks(const std::function<void(const Task &)> &visitor);
+    /** Replace the stored tasks with @p tasks, in a single transaction.
+        Only added, modified and removed tasks are written. Subscriptions of tasks that
+        remain are kept, added tasks are not subscribed.
+        If @p changes is given, it receives the applied changes. */
+    bool setAllTasks(const User &user, const TaskList &tasks, TaskListChanges *changes = nullptr);
     bool addTask(const Task &task);
     bool addTask(const Task &task, const SqlRaiiTransactor &);
     Task getTask(int taskid);
     bool modifyTask(const Task &task);
+    bool modifyTask(const Task &task, const SqlRaiiTransactor &);
     bool deleteTask(const Task &task);
     bool deleteAllTasks();
     bool deleteAllTasks(const SqlRaiiTransactor &);
 
     // event database functions:
-    EventList getAllEvents();
+    /** The events that are read, see archiveEvents(). */
+    enum EventSelection {
+        CurrentEvents, ///< the events that have not been archived
+        ArchivedEvents, ///< only the archived events
+        AllEvents ///< the current and the archived events
+    };
+    /** The data model is loaded with the current events, exports use all of them. */
+    EventList getAllEvents(EventSelection selection = CurrentEvents);
+    /** Call @p visitor for every stored event, without building a list.
+        Returns false if the query failed. */
+    bool visitAllEvents(const std::function<void(const Event &)> &visitor,
+                        EventSelection selection = CurrentEvents);
+    /** All events that start in [@p start, @p end), ordered by their start time.
+        If the range begins before the archive cutoff, archived events are included. */
+    EventList getEventsInRange(const QDateTime &start, const QDateTime &end,
+                               EventSelection selection = AllEvents);
+    /** Call @p visitor for every event returned by getEventsInRange(), without building a
+        list. Returns false if the query failed. */
+    bool visitEventsInRange(const QDateTime &start, const QDateTime &end,
+                            const std::function<void(const Event &)> &visitor,
+                            EventSelection selection = AllEvents);
 
     // all events are created by the storage interface
     Event makeEvent();
@@ -83,6 +146,7 @@ public:
     bool modifyEvent(const Event &event);
     bool modifyEvent(const Event &event, const SqlRaiiTransactor &);
     bool deleteEvent(const Event &event);
+    bool deleteEvent(const Event &event, const SqlRaiiTransactor &);
     bool deleteAllEvents();
     bool deleteAllEvents(const SqlRaiiTransactor &);
 
@@ -95,15 +159,50 @@ public:
     // implement metadata management functions:
     bool setMetaData(const QString &, const QString &);
     bool setMetaData(const QString &, const QString &, const SqlRaiiTransactor &);
+    /** Store all entries of @p metaData in a single transaction. */
+    bool setAllMetaData(const QHash<QString, QString> &metaData);
 
     // database metadata management functions
     QString getMetaData(const QString &);
+    /** All metadata entries, loaded with a single query. */
+    QHash<QString, QString> getAllMetaData();
+
+    // event archive functions:
+    /** Move all events that ended before @p cutoff into the archive database.
+        The events are no longer returned by getAllEvents(), unless all events are selected.
+        Their ids are not reused for new events. */
+    bool archiveEvents(const QDateTime &cutoff);
+    /** Events that ended before the cutoff have been archived, invalid if nothing has been archived. */
+    QDateTime archiveCutoff();
+    /** Forget the archived events, when all events are replaced by ones that include them. */
+    bool discardArchive(const SqlRaiiTransactor &);
+
+    // change tracking functions:
+    /** The number of the latest change. Every write to tasks, events and subscriptions
+        is numbered, and every task and event remembers the number of its latest change. */
+    qint64 lastChange();
+    /** Collect the tasks and events that were added, modified or deleted after change @p since. */
+    bool getChangesSince(qint64 since, ChangeSet *changes);
+    /** Apply @p changes read from another database: add or replace the tasks, keeping their
+        ids, and delete the deleted ones. Events are matched by their origin, new ones get
+        an id of this database. Events deleted or archived here are not added again.
+        Subscriptions are set for @p user according to Task::subscribed(). */
+    bool applyChanges(const User &user, const ChangeSet &changes, const SqlRaiiTransactor &);
 
     /*! @brief update all tasks and events in a single-transaction during imports
       @return an empty String on success, an error message otherwise
       */
     QString setAllTasksAndEvents(const User &, const TaskList &, const EventList &);
 
+    /** Add a task read from an export, and set the subscription of @p user to it
+        according to Task::subscribed(). Used by the imports. */
+    bool addImportedTask(const User &user, const Task &task, const SqlRaiiTransactor &);
+    /** Add @p events as new events with newly assigned ids. The task ids are not checked. */
+    bool addEvents(const EventList &events, const SqlRaiiTransactor &);
+    /** Replace all events with @p events, keeping their ids, for example to restore them from
+        an EventLog. They are recorded as changed, like events added by the user. */
+    bool setAllEvents(const EventList &events);
+
     /**
      * @throws UnsupportedDatabaseVersionException
      */
@@ -130,9 +229,36 @@ protected:
      */
     virtual QString lastInsertRowFunction() const = 0;
 
+    /** Attach the archive database with the schema name "archive", read-only unless
+        @p writable is true. Returns false if the backend does not support archives, or if
+        a read-only archive does not exist. */
+    virtual bool attachArchive(bool writable);
+    virtual void detachArchive();
+
 private:
+    enum ChangeKind {
+        TaskChange = 0,
+        EventChange = 1
+    };
+
+    void backupBeforeMigration(int oldVersion);
     bool migrateDB(const QString &queryString, int oldVersion);
+    bool recordChange(ChangeKind kind, int id, bool deleted);
+    bool recordChanges(ChangeKind kind, const QString &selection, bool deleted);
     Event makeEventFromRecord(const QSqlRecord &);
+    /** Read the events of the union of @p selects, and detach the archive afterwards if
+        @p withArchive is true. */
+    bool visitEvents(const QStringList &selects, const QString &order,
+                     const QVariantMap &values, bool withArchive,
+                     const std::function<void(const Event &)> &visitor);
+    /** The id of the next new event, if the database would reuse the id of an archived event,
+        otherwise 0, and the database assigns it. */
+    int nextEventId();
+    /** Record that the event @p eventId was created by @p installation with the id @p originId. */
+    bool setEventOrigin(int eventId, quint32 installation, int originId);
+    /** Set @p eventId to the id of the event created by @p installation with the id
+        @p originId, or to 0 if it is not known here. */
+    bool findEvent(quint32 installation, int originId, int *eventId);
     Task makeTaskFromRecord(const QSqlRecord &);
 };
 
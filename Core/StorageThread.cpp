@@ -0,0 +1,133 @@
+/*
+  StorageThread.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StorageThread.h"
+
+#include <QCoreApplication>
+#include <QEvent>
+#include <QSemaphore>
+
+#include <exception>
+
+namespace {
+class FunctionEvent : public QEvent
+{
+public:
+    FunctionEvent(const std::function<void()> &function, std::exception_ptr *error,
+                  QSemaphore *done)
+        : QEvent(eventType())
+        , m_function(function)
+        , m_error(error)
+        , m_done(done)
+    {
+    }
+
+    static QEvent::Type eventType()
+    {
+        static const int type = QEvent::registerEventType();
+        return static_cast<QEvent::Type>(type);
+    }
+
+    void run()
+    {
+        try {
+            m_function();
+        } catch (...) {
+            *m_error = std::current_exception();
+        }
+        m_done->release();
+    }
+
+private:
+    std::function<void()> m_function;
+    std::exception_ptr *m_error;
+    QSemaphore *m_done;
+};
+}
+
+class StorageThread::Executor : public QObject
+{
+public:
+    bool event(QEvent *event) override
+    {
+        if (event->type() == FunctionEvent::eventType()) {
+            static_cast<FunctionEvent *>(event)->run();
+            return true;
+        }
+        return QObject::event(event);
+    }
+};
+
+StorageThread::StorageThread(QObject *parent)
+    : QThread(parent)
+    , m_executor(new Executor)
+{
+    setObjectName(QStringLiteral("StorageThread"));
+    m_executor->moveToThread(this);
+}
+
+StorageThread::~StorageThread()
+{
+    shutdown();
+    delete m_executor;
+}
+
+void StorageThread::adopt(QObject *object)
+{
+    Q_ASSERT_X(m_adopted == nullptr, Q_FUNC_INFO, "StorageThread can only adopt one object");
+    m_adopted = object;
+    object->moveToThread(this);
+}
+
+void StorageThread::runBlocking(const std::function<void()> &function)
+{
+    if (QThread::currentThread() == this) {
+        function();
+        return;
+    }
+    Q_ASSERT_X(isRunning(), Q_FUNC_INFO, "The storage thread has to be started first");
+
+    QSemaphore done;
+    std::exception_ptr error;
+    // posted events are delivered in order, so this waits for all previously queued commands:
+    QCoreApplication::postEvent(m_executor, new FunctionEvent(function, &error, &done));
+    done.acquire();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void StorageThread::shutdown()
+{
+    if (!isRunning())
+        return;
+    Q_ASSERT_X(QThread::currentThread() != this, Q_FUNC_INFO,
+               "The storage thread cannot shut itself down");
+
+    QThread *caller = QThread::currentThread();
+    runBlocking([this, caller]() {
+        if (m_adopted)
+            m_adopted->moveToThread(caller);
+        m_executor->moveToThread(caller);
+    });
+    m_adopted = nullptr;
+    quit();
+    wait();
+}
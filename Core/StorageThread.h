@@ -0,0 +1,64 @@
+/*
+  StorageThread.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STORAGETHREAD_H
+#define STORAGETHREAD_H
+
+#include <QThread>
+
+#include <functional>
+
+/** StorageThread is the worker thread the Controller and its storage backend live in.
+    Once the Controller has been adopted, commands sent by the view and the signals
+    emitted back to the model travel through queued connections. The event queue of
+    the thread is the command queue: commands are executed strictly in the order they
+    have been sent, which keeps undo and redo sequences consistent. Exceptions cannot
+    travel through the event loop, the Controller sends failures back with the command.
+    Operations that need an immediate answer (connecting to the backend, persisting
+    the configuration) are executed with runBlocking(), after all commands queued
+    before them have completed. */
+class StorageThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit StorageThread(QObject *parent = nullptr);
+    ~StorageThread() override;
+
+    /** Move @p object into the storage thread.
+        Has to be called from the thread the object currently lives in. */
+    void adopt(QObject *object);
+
+    /** Queue @p function behind all pending commands and wait until it has been executed.
+        Exceptions thrown by @p function are re-thrown in the calling thread. */
+    void runBlocking(const std::function<void()> &function);
+
+    /** Complete all pending commands, return the adopted object to the calling thread,
+        and stop the thread. */
+    void shutdown();
+
+private:
+    class Executor;
+    Executor *m_executor;
+    QObject *m_adopted = nullptr;
+};
+
+#endif
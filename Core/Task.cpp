@@ -26,8 +26,12 @@
 #include "Task.h"
 #include "CharmConstants.h"
 #include "CharmExceptions.h"
+#include "Dates.h"
+#include "XmlSerialization.h"
 
 #include <QtDebug>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
 
 #include <set>
 #include <algorithm>
@@ -191,23 +195,36 @@ QDomElement Task::toXml(QDomDocument document) const
         element.appendChild(taskName);
     }
     if (validFrom().isValid())
-        element.setAttribute(TaskValidFrom, validFrom().toString(Qt::ISODate));
+        element.setAttribute(TaskValidFrom, Charm::dateTimeToIsoString(validFrom()));
     if (validUntil().isValid())
-        element.setAttribute(TaskValidUntil, validUntil().toString(Qt::ISODate));
+        element.setAttribute(TaskValidUntil, Charm::dateTimeToIsoString(validUntil()));
     return element;
 }
 
-Task Task::fromXml(const QDomElement &element, int databaseSchemaVersion)
-{   // in case any task object creates trouble with
-    // serialization/deserialization, add an object of it to
-    // void XmlSerializationTests::testTaskSerialization()
-    if (element.tagName() != tagName())
-        throw XmlSerializationException(QObject::tr(
-                                            "Task::fromXml: judging from the tag name, this is not a task tag"));
+void Task::writeXml(QXmlStreamWriter &writer) const
+{
+    writer.writeStartElement(tagName());
+    writer.writeAttribute(TaskIdElement, QString::number(id()));
+    writer.writeAttribute(TaskParentId, QString::number(parent()));
+    writer.writeAttribute(TaskSubscribed, QString::number(subscribed() ? 1 : 0));
+    writer.writeAttribute(TaskTrackable, QString::number(trackable() ? 1 : 0));
+    if (validFrom().isValid())
+        writer.writeAttribute(TaskValidFrom, Charm::dateTimeToIsoString(validFrom()));
+    if (validUntil().isValid())
+        writer.writeAttribute(TaskValidUntil, Charm::dateTimeToIsoString(validUntil()));
+    if (!name().isEmpty())
+        writer.writeCharacters(name());
+    writer.writeEndElement();
+}
 
+namespace {
+// shared by the DOM and the stream parser, Element is a QDomElement or XmlSerialization::StreamAttributes
+template<typename Element>
+Task taskFromAttributes(const Element &element, const QString &text, int databaseSchemaVersion)
+{
     Task task;
     bool ok;
-    task.setName(element.text());
+    task.setName(text);
     task.setId(element.attribute(TaskIdElement).toInt(&ok));
     if (!ok)
         throw XmlSerializationException(QObject::tr("Task::fromXml: invalid task id"));
@@ -220,14 +237,14 @@ Task Task::fromXml(const QDomElement &element, int databaseSchemaVersion)
 
     if (databaseSchemaVersion > CHARM_DATABASE_VERSION_BEFORE_TASK_EXPIRY) {
         if (element.hasAttribute(TaskValidFrom)) {
-            QDateTime start = QDateTime::fromString(element.attribute(TaskValidFrom), Qt::ISODate);
+            QDateTime start = Charm::dateTimeFromIsoString(element.attribute(TaskValidFrom));
             if (!start.isValid()) throw XmlSerializationException(QObject::tr(
                                                                       "Task::fromXml: invalid valid-from date"));
 
             task.setValidFrom(start);
         }
         if (element.hasAttribute(TaskValidUntil)) {
-            QDateTime end = QDateTime::fromString(element.attribute(TaskValidUntil), Qt::ISODate);
+            QDateTime end = Charm::dateTimeFromIsoString(element.attribute(TaskValidUntil));
             if (!end.isValid()) throw XmlSerializationException(QObject::tr(
                                                                     "Task::fromXml: invalid valid-until date"));
 
@@ -244,6 +261,31 @@ Task Task::fromXml(const QDomElement &element, int databaseSchemaVersion)
         task.setComment(element.attribute(TaskComment));
     return task;
 }
+}
+
+Task Task::fromXml(const QDomElement &element, int databaseSchemaVersion)
+{   // in case any task object creates trouble with
+    // serialization/deserialization, add an object of it to
+    // void XmlSerializationTests::testTaskSerialization()
+    if (element.tagName() != tagName())
+        throw XmlSerializationException(QObject::tr(
+                                            "Task::fromXml: judging from the tag name, this is not a task tag"));
+
+    return taskFromAttributes(element, element.text(), databaseSchemaVersion);
+}
+
+Task Task::fromXml(QXmlStreamReader &reader, int databaseSchemaVersion)
+{
+    if (reader.name() != tagName())
+        throw XmlSerializationException(QObject::tr(
+                                            "Task::fromXml: judging from the tag name, this is not a task tag"));
+
+    const XmlSerialization::StreamAttributes attributes(reader.attributes());
+    const QString text = reader.readElementText();
+    if (reader.hasError())
+        throw XmlSerializationException(QObject::tr("Task::fromXml: %1").arg(reader.errorString()));
+    return taskFromAttributes(attributes, text, databaseSchemaVersion);
+}
 
 TaskList Task::readTasksElement(const QDomElement &element, int databaseSchemaVersion)
 {
@@ -34,6 +34,9 @@
 #include <QDomDocument>
 #include <QDateTime>
 
+class QXmlStreamReader;
+class QXmlStreamWriter;
+
 typedef int TaskId;
 Q_DECLARE_METATYPE(TaskId)
 
@@ -98,8 +101,12 @@ public:
     static QString taskListTagName();
 
     QDomElement toXml(QDomDocument) const;
+    /** Write the same element as toXml() to @p writer. */
+    void writeXml(QXmlStreamWriter &writer) const;
 
     static Task fromXml(const QDomElement &, int databaseSchemaVersion = 1);
+    /** Read the task element @p reader is positioned at, leaving it at the end of the element. */
+    static Task fromXml(QXmlStreamReader &reader, int databaseSchemaVersion = 1);
 
     static TaskList readTasksElement(const QDomElement &, int databaseSchemaVersion = 1);
 
@@ -0,0 +1,83 @@
+/*
+  TaskFilter.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TaskFilter.h"
+#include "CharmDataModel.h"
+
+#include <algorithm>
+
+TaskFilter::TaskFilter()
+{
+}
+
+TaskFilter::TaskFilter(const CharmDataModel *model, const QSet<TaskId> &includedRoots,
+                       const QSet<TaskId> &excludedRoots)
+    : m_marksAccepted(!includedRoots.isEmpty())
+{
+    if (includedRoots.isEmpty() && excludedRoots.isEmpty())
+        return;
+
+    TaskIdList marked;
+    const TaskTreeItem &root = model->taskTreeItem(0);
+    for (int row = 0; row < root.childCount(); ++row)
+        compile(root.child(row), includedRoots, excludedRoots, includedRoots.isEmpty(), false,
+                marked);
+
+    TaskId maximum = -1;
+    Q_FOREACH (TaskId id, marked)
+        maximum = std::max(maximum, id);
+    m_marked.resize(maximum + 1);
+    Q_FOREACH (TaskId id, marked)
+        m_marked.setBit(id);
+}
+
+void TaskFilter::compile(const TaskTreeItem &item, const QSet<TaskId> &includedRoots,
+                         const QSet<TaskId> &excludedRoots, bool included, bool excluded,
+                         TaskIdList &marked) const
+{
+    const TaskId id = item.task().id();
+    included = included || includedRoots.contains(id);
+    excluded = excluded || excludedRoots.contains(id);
+    if ((included && !excluded) == m_marksAccepted)
+        marked << id;
+    for (int row = 0; row < item.childCount(); ++row)
+        compile(item.child(row), includedRoots, excludedRoots, included, excluded, marked);
+}
+
+bool TaskFilter::accepts(TaskId id) const
+{
+    const bool isMarked = id >= 0 && id < m_marked.size() && m_marked.testBit(id);
+    return isMarked == m_marksAccepted;
+}
+
+EventIdList TaskFilter::filtered(const CharmDataModel *model, const EventIdList &ids) const
+{
+    if (!m_marksAccepted && m_marked.isEmpty())
+        return ids;
+
+    EventIdList result;
+    result.reserve(ids.size());
+    Q_FOREACH (EventId id, ids) {
+        if (accepts(model->eventForId(id).taskId()))
+            result << id;
+    }
+    return result;
+}
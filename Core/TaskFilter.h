@@ -0,0 +1,63 @@
+/*
+  TaskFilter.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TASKFILTER_H
+#define TASKFILTER_H
+
+#include <QBitArray>
+#include <QSet>
+
+#include "Event.h"
+#include "Task.h"
+
+class CharmDataModel;
+class TaskTreeItem;
+
+/** TaskFilter selects the tasks in the subtrees of a set of included root tasks, except those
+    in the subtrees of a set of excluded root tasks. Without included roots, all tasks are
+    included. The filter is compiled once from the task tree of the model into a bitmap indexed
+    by task id, so that every event is then checked in constant time, in a single pass.
+    The filter is a snapshot, it has to be compiled again when the tasks change. */
+class TaskFilter
+{
+public:
+    /** A filter that accepts all tasks. */
+    TaskFilter();
+    TaskFilter(const CharmDataModel *model, const QSet<TaskId> &includedRoots,
+               const QSet<TaskId> &excludedRoots = QSet<TaskId>());
+
+    bool accepts(TaskId id) const;
+    /** Return those of @p ids whose tasks are accepted, in the same order. */
+    EventIdList filtered(const CharmDataModel *model, const EventIdList &ids) const;
+
+private:
+    void compile(const TaskTreeItem &item, const QSet<TaskId> &includedRoots,
+                 const QSet<TaskId> &excludedRoots, bool included, bool excluded,
+                 TaskIdList &marked) const;
+
+    /* Without included roots, the bitmap marks the rejected tasks, otherwise the accepted ones.
+       Either way tasks that are not in the tree are unmarked, and accepted only if there are
+       no included roots, as they cannot be in an included subtree. */
+    QBitArray m_marked;
+    bool m_marksAccepted = false;
+};
+
+#endif
@@ -26,6 +26,7 @@
 #include "CharmConstants.h"
 #include "CharmExceptions.h"
 #include "Configuration.h"
+#include "GzipDevice.h"
 
 #include <QDateTime>
 #include <QFile>
@@ -131,15 +132,25 @@ void TaskExport::writeTo(const QString &filename, const TaskList &tasks)
         report.appendChild(tasksElement);
     }
 
-    // all done, write to file:
+    // all done, write to file, compressed if the file name asks for it:
     QFile file(filename);
-    if (file.open(QIODevice::WriteOnly)) {
-        QTextStream stream(&file);
-        document.save(stream, 4);
-    } else {
+    if (!file.open(QIODevice::WriteOnly))
         throw XmlSerializationException(QObject::tr("Cannot write to file: %1").arg(
                                             file.errorString()));
+    GzipDevice device(&file, GzipDevice::compressionForFileName(filename));
+    if (!device.open(QIODevice::WriteOnly))
+        throw XmlSerializationException(QObject::tr("Cannot write to file: %1").arg(
+                                            device.errorString()));
+    {
+        QTextStream stream(&device);
+        document.save(stream, 4);
     }
+    if (!device.commit())
+        throw XmlSerializationException(QObject::tr("Cannot write to file: %1").arg(
+                                            device.errorString()));
+    if (file.error() != QFile::NoError)
+        throw XmlSerializationException(QObject::tr("Cannot write to file: %1").arg(
+                                            file.errorString()));
 }
 
 void TaskExport::readFrom(const QString &filename)
@@ -158,11 +169,16 @@ void TaskExport::readFrom(const QString &filename)
 
 void TaskExport::readFrom(QIODevice *device)
 {
+    // compressed task definitions are detected and decompressed on the fly:
+    GzipDevice input(device);
+    if (!input.open(QIODevice::ReadOnly))
+        throw XmlSerializationException(QObject::tr("Cannot open file for reading: %1").arg(
+                                            input.errorString()));
     QDomDocument document;
     QString errorMessage;
     int errorLine = 0;
     int errorColumn = 0;
-    if (!document.setContent(device, &errorMessage, &errorLine, &errorColumn)) {
+    if (!document.setContent(&input, &errorMessage, &errorLine, &errorColumn)) {
         throw XmlSerializationException(QObject::tr("Invalid XML: [%1:%2] %3").arg(QString::number(
                                                                                        errorLine),
                                                                                    QString::number(
@@ -28,6 +28,7 @@
 #include <QDomDocument>
 #include <QHash>
 #include <QString>
+#include <QXmlStreamAttributes>
 
 #include "Task.h"
 
@@ -40,6 +41,30 @@ QDomElement metadataElement(const QDomDocument &doc);
 
 QDateTime creationTime(const QDomElement &metaDataElement);
 QString userName(const QDomElement &metaDataElement);
+
+/** Offers the attribute lookup of QDomElement for the attributes of a QXmlStreamReader
+    element, so that the same code can parse elements from both. */
+class StreamAttributes
+{
+public:
+    explicit StreamAttributes(const QXmlStreamAttributes &attributes)
+        : m_attributes(attributes)
+    {
+    }
+
+    bool hasAttribute(const QString &name) const
+    {
+        return m_attributes.hasAttribute(name);
+    }
+
+    QString attribute(const QString &name, const QString &defaultValue = QString()) const
+    {
+        return hasAttribute(name) ? m_attributes.value(name).toString() : defaultValue;
+    }
+
+private:
+    QXmlStreamAttributes m_attributes;
+};
 }
 
 class TaskExport
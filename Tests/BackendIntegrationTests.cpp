@@ -35,6 +35,8 @@
 #include <QtDebug>
 #include <QtTest/QtTest>
 
+#include <algorithm>
+
 BackendIntegrationTests::BackendIntegrationTests()
     : TestApplication(QStringLiteral("./BackendIntegrationTestDatabase.db"))
 {
@@ -112,6 +114,53 @@ void BackendIntegrationTests::biggerCreateModifyDeleteTaskTest()
     QVERIFY(model()->taskTreeItem(0).childCount() == 0);
 }
 
+void BackendIntegrationTests::setAllTasksTest()
+{
+    // make sure everything is cleaned up:
+    QVERIFY(controller()->storage()->getAllTasks().isEmpty());
+    QVERIFY(model()->taskTreeItem(0).childCount() == 0);
+
+    // set the tasks with the children listed before their parents:
+    TaskList currentTasks = referenceTasks();
+    std::reverse(currentTasks.begin(), currentTasks.end());
+    QVERIFY(controller()->setAllTasks(currentTasks));
+    QVERIFY(contentsEqual(controller()->storage()->getAllTasks(), currentTasks));
+    QVERIFY(contentsEqual(model()->getAllTasks(), currentTasks));
+
+    // subscribe to one of the tasks:
+    Task task1_1 = controller()->storage()->getTask(1001);
+    task1_1.setSubscribed(true);
+    QVERIFY(controller()->modifyTask(task1_1));
+
+    // rename a task, move a task out of a removed subtree, and add new tasks:
+    TaskList newTasks;
+    Q_FOREACH (Task task, referenceTasks()) {
+        if (task.id() == 1001) {
+            task.setSubscribed(true);
+        } else if (task.id() == 1002) {
+            task.setName(QStringLiteral("Task 1-2, modified"));
+        } else if (task.id() == 2210) {
+            task.setParent(1000);
+        } else if (task.id() == 2200 || task.id() == 2220) {
+            continue;
+        }
+        newTasks << task;
+    }
+    newTasks << Task(3100, QStringLiteral("Task 3-1"), 3000)
+             << Task(3000, QStringLiteral("Task 3"));
+    QVERIFY(controller()->setAllTasks(newTasks));
+    QVERIFY(contentsEqual(controller()->storage()->getAllTasks(), newTasks));
+    QVERIFY(contentsEqual(model()->getAllTasks(), newTasks));
+    QVERIFY(controller()->storage()->getTask(1001).subscribed());
+    QVERIFY(model()->taskTreeItem(1000).childCount() == 4);
+    QVERIFY(model()->taskTreeItem(2000).childCount() == 1);
+
+    // remove all of them:
+    QVERIFY(controller()->setAllTasks(TaskList()));
+    QVERIFY(controller()->storage()->getAllTasks().isEmpty());
+    QVERIFY(model()->taskTreeItem(0).childCount() == 0);
+}
+
 void BackendIntegrationTests::cleanupTestCase()
 {
     destroy();
@@ -43,6 +43,8 @@ private Q_SLOTS:
 
     void biggerCreateModifyDeleteTaskTest();
 
+    void setAllTasksTest();
+
     void cleanupTestCase();
 
 private:
@@ -24,6 +24,7 @@
 
 #include "CharmDataModelTests.h"
 
+#include "Core/Event.h"
 #include "Core/Task.h"
 #include "Core/TaskTreeItem.h"
 #include "Core/CharmDataModel.h"
@@ -175,6 +176,125 @@ void CharmDataModelTests::modifyTaskTest()
     QVERIFY(model.taskTreeItem(0).childCount() == 0);
 }
 
+void CharmDataModelTests::revisionTest()
+{
+    CharmDataModel model;
+    quint64 revision = model.revision();
+
+    Task task(1000, QStringLiteral("Task 1"));
+    model.addTask(task);
+    QVERIFY(model.revision() != revision);
+    revision = model.revision();
+
+    Event event;
+    event.setId(1);
+    event.setTaskId(task.id());
+    model.addEvent(event);
+    QVERIFY(model.revision() != revision);
+    revision = model.revision();
+
+    // reading does not change the revision:
+    QCOMPARE(model.eventForId(event.id()).taskId(), task.id());
+    QCOMPARE(model.revision(), revision);
+
+    event.setComment(QStringLiteral("modified"));
+    model.modifyEvent(event);
+    QVERIFY(model.revision() != revision);
+    revision = model.revision();
+
+    model.deleteEvent(event);
+    QVERIFY(model.revision() != revision);
+
+    // updating the end of an active event only changes the revision of ranges that include it:
+    const QDateTime start(QDate(2019, 5, 6), QTime(9, 0));
+    const QDateTime lastWeek = start.addDays(-7);
+    Event active;
+    active.setId(2);
+    active.setTaskId(task.id());
+    active.setStartDateTime(start);
+    active.setEndDateTime(start);
+    model.addEvent(active);
+    QVERIFY(model.activateEvent(active));
+    revision = model.revision();
+    const quint64 lastWeekRevision = model.revision(lastWeek, lastWeek.addDays(7));
+    const quint64 thisWeekRevision = model.revision(start, start.addDays(7));
+    active.setEndDateTime(start.addSecs(10));
+    model.modifyEvent(active);
+    QVERIFY(model.revision() != revision);
+    QCOMPARE(model.revision(lastWeek, lastWeek.addDays(7)), lastWeekRevision);
+    QVERIFY(model.revision(start, start.addDays(7)) != thisWeekRevision);
+
+    // other modifications of the active event change the revision of all ranges:
+    active.setComment(QStringLiteral("modified"));
+    model.modifyEvent(active);
+    QVERIFY(model.revision(lastWeek, lastWeek.addDays(7)) != lastWeekRevision);
+}
+
+void CharmDataModelTests::cloneTest()
+{
+    CharmDataModel model;
+    model.setAllTasks(m_referenceModel->getAllTasks());
+    Event event;
+    event.setId(1);
+    event.setTaskId(1001);
+    model.addEvent(event);
+
+    // the clone reads the events of the model, until one of them modifies them:
+    QScopedPointer<CharmDataModel> clone(model.clone());
+    QVERIFY(*clone == model);
+    QCOMPARE(&clone->eventMap(), &model.eventMap());
+    event.setComment(QStringLiteral("modified"));
+    model.modifyEvent(event);
+    QVERIFY(&clone->eventMap() != &model.eventMap());
+    QVERIFY(clone->eventForId(event.id()).comment().isEmpty());
+    QCOMPARE(model.eventForId(event.id()).comment(), event.comment());
+
+    // a clone without the tasks gets them later:
+    QScopedPointer<CharmDataModel> events(model.cloneEvents());
+    QCOMPARE(events->eventMap().size(), model.eventMap().size());
+    QVERIFY(events->getAllTasks().isEmpty());
+    events->setAllTasks(model.getAllTasks());
+    QVERIFY(*events == model);
+}
+
+void CharmDataModelTests::monthlySecondsTest()
+{
+    const auto makeEvent = [](EventId id, TaskId task, const QDateTime &start, int seconds) {
+        Event event;
+        event.setId(id);
+        event.setTaskId(task);
+        event.setStartDateTime(start);
+        event.setEndDateTime(start.addSecs(seconds));
+        return event;
+    };
+    const QDate start(2020, 1, 1);
+    CharmDataModel model;
+    model.addEvent(makeEvent(1, 1001, QDateTime(QDate(2020, 1, 15), QTime(10, 0)), 3600));
+    model.addEvent(makeEvent(2, 1001, QDateTime(QDate(2020, 2, 3), QTime(10, 0)), 1800));
+    model.addEvent(makeEvent(3, 1002, QDateTime(QDate(2020, 1, 31), QTime(23, 0)), 7200));
+    // before the first month, not counted:
+    model.addEvent(makeEvent(4, 1002, QDateTime(QDate(2019, 12, 31), QTime(12, 0)), 600));
+
+    QMap<TaskId, QVector<int> > expected;
+    expected[1001] = QVector<int>(12, 0);
+    expected[1001][0] = 3600;
+    expected[1001][1] = 1800;
+    expected[1002] = QVector<int>(12, 0);
+    expected[1002][0] = 7200;
+    QCOMPARE(model.monthlySeconds(start, 12), expected);
+
+    // the totals follow the events, the clone keeps the ones it was made with:
+    QScopedPointer<CharmDataModel> clone(model.cloneEvents());
+    model.modifyEvent(makeEvent(2, 1001, QDateTime(QDate(2020, 3, 3), QTime(10, 0)), 900));
+    model.deleteEvent(model.eventForId(3));
+    QCOMPARE(clone->monthlySeconds(start, 12), expected);
+    expected[1001][1] = 0;
+    expected[1001][2] = 900;
+    expected[1002][0] = 0;
+    QCOMPARE(model.monthlySeconds(start, 12), expected);
+    QCOMPARE(model.monthlySeconds(QDate(2019, 12, 1), 1).value(1002), QVector<int>(1, 600));
+}
+
 void CharmDataModelTests::cleanupTestCase()
 {
     m_referenceModel->clearTasks();
@@ -40,6 +40,9 @@ private Q_SLOTS:
     void createAndDestroyTest();
     void addAndRemoveTasksTest();
     void modifyTaskTest();
+    void revisionTest();
+    void cloneTest();
+    void monthlySecondsTest();
     void cleanupTestCase();
 
 private:
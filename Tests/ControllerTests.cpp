@@ -27,7 +27,10 @@
 #include "ControllerTests.h"
 
 #include "Core/SqlStorage.h"
+#include "Core/CharmCommand.h"
 #include "Core/CharmConstants.h"
+#include "Core/CharmExceptions.h"
+#include "Core/CommandEmitterInterface.h"
 #include "Core/Controller.h"
 
 #include <QDir>
@@ -35,6 +38,40 @@
 #include <QtDebug>
 #include <QtTest/QtTest>
 
+namespace {
+class CommandEmitter : public QObject, public CommandEmitterInterface
+{
+public:
+    void commitCommand(CharmCommand *) override
+    {
+    }
+};
+
+class FailingCommand : public CharmCommand
+{
+public:
+    explicit FailingCommand(QObject *parent)
+        : CharmCommand(QStringLiteral("Fail"), parent)
+    {
+    }
+
+    bool prepare() override
+    {
+        return true;
+    }
+
+    bool execute(Controller *) override
+    {
+        throw TransactionException(QStringLiteral("storage failure"));
+    }
+
+    bool finalize() override
+    {
+        return failure().isEmpty();
+    }
+};
+}
+
 ControllerTests::ControllerTests()
     : QObject()
     , m_configuration(Configuration::instance())
@@ -81,15 +118,15 @@ void ControllerTests:: persistProvideMetaDataTest()
     Configuration configs[] = {
         Configuration(Configuration::TaskPrefilter_ShowAll, Configuration::TimeTrackerFont_Small,
                       Configuration::Minutes, true, Qt::ToolButtonIconOnly, true, true, true,
-                      false, 5),
+                      false, 5, 0),
         Configuration(Configuration::TaskPrefilter_CurrentOnly,
                       Configuration::TimeTrackerFont_Regular,
                       Configuration::Minutes, false, Qt::ToolButtonTextOnly, false, false, false,
-                      false, 5),
+                      false, 5, 12),
         Configuration(Configuration::TaskPrefilter_SubscribedAndCurrentOnly,
                       Configuration::TimeTrackerFont_Large,
                       Configuration::Minutes, true, Qt::ToolButtonTextBesideIcon, true, true, true,
-                      false, 5),
+                      false, 5, 36),
     };
     const int NumberOfConfigurations = sizeof configs / sizeof configs[0];
 
@@ -265,6 +302,18 @@ void ControllerTests::toAndFromXmlTest()
     QDomDocument document2 = m_controller->exportDatabasetoXml();
 }
 
+void ControllerTests::failedCommandIsCompletedTest()
+{
+    // the view is told about failed commands, to finalize them:
+    CommandEmitter emitter;
+    FailingCommand command(&emitter);
+    QSignalSpy completed(m_controller, &Controller::commandCompleted);
+    m_controller->executeCommand(&command);
+    QCOMPARE(completed.count(), 1);
+    QCOMPARE(command.failure(), QStringLiteral("storage failure"));
+    QVERIFY(!command.finalize());
+}
+
 void ControllerTests::disconnectFromBackendTest()
 {
     QVERIFY(m_controller->disconnectFromBackend());
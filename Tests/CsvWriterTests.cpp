@@ -0,0 +1,157 @@
+/*
+  CsvWriterTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CsvWriterTests.h"
+
+#include "Core/CsvWriter.h"
+#include "Core/Event.h"
+
+#include <QBuffer>
+#include <QtTest/QtTest>
+
+namespace {
+QByteArray writeRows(const QList<QStringList> &rows, CsvWriter::Format format)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    {
+        CsvWriter writer(&buffer, format);
+        Q_FOREACH (const QStringList &row, rows)
+            writer.writeRow(row);
+    }
+    return buffer.data();
+}
+}
+
+void CsvWriterTests::quotingTest_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<QStringList>("fields");
+    QTest::addColumn<QByteArray>("expected");
+
+    const int csv = CsvWriter::CommaSeparated;
+    const int tsv = CsvWriter::TabSeparated;
+    QTest::newRow("plain") << csv << (QStringList() << QStringLiteral("a") << QStringLiteral("b c"))
+                           << QByteArray("a,b c\r\n");
+    QTest::newRow("empty") << csv << (QStringList() << QString() << QString())
+                           << QByteArray(",\r\n");
+    QTest::newRow("separator") << csv << (QStringList() << QStringLiteral("a,b"))
+                               << QByteArray("\"a,b\"\r\n");
+    QTest::newRow("quotes") << csv << (QStringList() << QStringLiteral("say \"hi\""))
+                            << QByteArray("\"say \"\"hi\"\"\"\r\n");
+    QTest::newRow("line break") << csv << (QStringList() << QStringLiteral("a\nb"))
+                                << QByteArray("\"a\nb\"\r\n");
+    QTest::newRow("tab separated") << tsv << (QStringList() << QStringLiteral("a,b")
+                                                            << QStringLiteral("c\td"))
+                                   << QByteArray("a,b\t\"c\td\"\r\n");
+    QTest::newRow("utf-8") << csv << (QStringList() << QString::fromUtf8("Klarälvdalens"))
+                           << QByteArray("Klar\xc3\xa4lvdalens\r\n");
+}
+
+void CsvWriterTests::quotingTest()
+{
+    QFETCH(int, format);
+    QFETCH(QStringList, fields);
+    QFETCH(QByteArray, expected);
+
+    QCOMPARE(writeRows(QList<QStringList>() << fields, CsvWriter::Format(format)), expected);
+}
+
+void CsvWriterTests::formulaTest_data()
+{
+    QTest::addColumn<QString>("field");
+    QTest::addColumn<QByteArray>("expected");
+
+    QTest::newRow("formula") << QStringLiteral("=1+2") << QByteArray("'=1+2\r\n");
+    QTest::newRow("plus") << QStringLiteral("+cmd") << QByteArray("'+cmd\r\n");
+    QTest::newRow("minus") << QStringLiteral("-2+3") << QByteArray("'-2+3\r\n");
+    QTest::newRow("at") << QStringLiteral("@SUM(A1:A2)") << QByteArray("'@SUM(A1:A2)\r\n");
+    QTest::newRow("quoted formula") << QStringLiteral("=HYPERLINK(\"x\",\"y\")")
+                                    << QByteArray("\"'=HYPERLINK(\"\"x\"\",\"\"y\"\")\"\r\n");
+    QTest::newRow("negative number") << QStringLiteral("-1.50") << QByteArray("-1.50\r\n");
+    QTest::newRow("formula inside") << QStringLiteral("a=b") << QByteArray("a=b\r\n");
+}
+
+void CsvWriterTests::formulaTest()
+{
+    QFETCH(QString, field);
+    QFETCH(QByteArray, expected);
+
+    QCOMPARE(writeRows(QList<QStringList>() << (QStringList() << field),
+                       CsvWriter::CommaSeparated), expected);
+}
+
+void CsvWriterTests::eventRowTest()
+{
+    Event event;
+    event.setId(42);
+    event.setTaskId(7);
+    event.setStartDateTime(QDateTime(QDate(2019, 3, 4), QTime(9, 0)));
+    event.setEndDateTime(QDateTime(QDate(2019, 3, 4), QTime(10, 30)));
+    event.setComment(QStringLiteral("Review, part 1"));
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    CsvWriter writer(&buffer);
+    writer.writeRow(CsvWriter::eventColumns());
+    writer.writeEvent(event, QStringLiteral("Charm"));
+    QVERIFY(writer.flush());
+
+    const QList<QByteArray> lines = buffer.data().split('\n');
+    QCOMPARE(lines.size(), 3);
+    QCOMPARE(lines.at(0), QByteArray("Event Id,Task Id,Task,Start,End,Seconds,Hours,Comment\r"));
+    QCOMPARE(lines.at(1), QByteArray("42,7,Charm,2019-03-04 09:00:00,2019-03-04 10:30:00,"
+                                     "5400,1.50,\"Review, part 1\"\r"));
+    QVERIFY(lines.at(2).isEmpty());
+}
+
+void CsvWriterTests::streamingTest()
+{
+    // the rows reach the device before the writer is done:
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    CsvWriter writer(&buffer);
+    const QStringList row = QStringList() << QStringLiteral("Task")
+                                          << QString(100, QLatin1Char('x'));
+    int rows = 0;
+    while (buffer.size() == 0 && rows < 10000) {
+        writer.writeRow(row);
+        ++rows;
+    }
+    QVERIFY(buffer.size() > 0);
+    QVERIFY(rows < 10000);
+    QVERIFY(writer.flush());
+    QCOMPARE(buffer.size(), qint64(rows * (row.join(QLatin1Char(',')).size() + 2)));
+}
+
+void CsvWriterTests::formatForFileNameTest()
+{
+    QCOMPARE(CsvWriter::formatForFileName(QStringLiteral("events.csv")),
+             CsvWriter::CommaSeparated);
+    QCOMPARE(CsvWriter::formatForFileName(QStringLiteral("events.tsv")),
+             CsvWriter::TabSeparated);
+    QCOMPARE(CsvWriter::formatForFileName(QStringLiteral("events.TSV.gz")),
+             CsvWriter::TabSeparated);
+    QCOMPARE(CsvWriter::formatForFileName(QStringLiteral("events")),
+             CsvWriter::CommaSeparated);
+}
+
+QTEST_MAIN(CsvWriterTests)
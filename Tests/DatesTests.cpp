@@ -108,4 +108,149 @@ void DatesTests::testWeekDifference()
     QCOMPARE(Charm::weekDifference(from, to), weekDiff);
 }
 
+void DatesTests::testIsoDateTimeRoundTrip_data()
+{
+    QTest::addColumn<int>("timeSpec");
+    QTest::newRow("local time") << static_cast<int>(Qt::LocalTime);
+    QTest::newRow("UTC") << static_cast<int>(Qt::UTC);
+}
+
+void DatesTests::testIsoDateTimeRoundTrip()
+{
+    QFETCH(int, timeSpec);
+    const Qt::TimeSpec spec = static_cast<Qt::TimeSpec>(timeSpec);
+
+    // every day of two centuries, with a different time of the day each:
+    const QDate first(1900, 1, 1);
+    const QDate last(2100, 12, 31);
+    int counter = 0;
+    for (QDate date = first; date <= last; date = date.addDays(1), ++counter) {
+        const QTime time(counter % 24, (counter * 7) % 60, (counter * 13) % 60);
+        const QDateTime dateTime(date, time, spec);
+        // local times skipped by daylight saving time changes do not exist:
+        if (!dateTime.isValid())
+            continue;
+        const QString string = Charm::dateTimeToIsoString(dateTime);
+        QCOMPARE(string, dateTime.toString(Qt::ISODate));
+        const QDateTime parsed = Charm::dateTimeFromIsoString(string);
+        QCOMPARE(parsed, QDateTime::fromString(string, Qt::ISODate));
+        QCOMPARE(parsed.timeSpec(), spec);
+        QCOMPARE(parsed, dateTime);
+    }
+    // and every second of one day:
+    for (QTime time(0, 0, 0); ; time = time.addSecs(1)) {
+        const QDateTime dateTime(QDate(2019, 7, 31), time, spec);
+        const QString string = Charm::dateTimeToIsoString(dateTime);
+        QCOMPARE(string, dateTime.toString(Qt::ISODate));
+        QCOMPARE(Charm::dateTimeFromIsoString(string), dateTime);
+        if (time == QTime(23, 59, 59))
+            break;
+    }
+}
+
+void DatesTests::testIsoDateTimeParsing_data()
+{
+    QTest::addColumn<QString>("string");
+    QTest::newRow("local time") << QStringLiteral("2019-03-01T10:20:30");
+    QTest::newRow("UTC") << QStringLiteral("2019-03-01T10:20:30Z");
+    QTest::newRow("leap day") << QStringLiteral("2020-02-29T23:59:59");
+    QTest::newRow("no leap day") << QStringLiteral("2019-02-29T23:59:59");
+    QTest::newRow("invalid month") << QStringLiteral("2019-13-01T10:20:30");
+    QTest::newRow("invalid minute") << QStringLiteral("2019-03-01T10:60:30");
+    QTest::newRow("end of day") << QStringLiteral("2019-03-01T24:00:00");
+    QTest::newRow("offset") << QStringLiteral("2019-03-01T10:20:30+02:00");
+    QTest::newRow("negative offset") << QStringLiteral("2019-03-01T10:20:30-05:30");
+    QTest::newRow("milliseconds") << QStringLiteral("2019-03-01T10:20:30.123");
+    QTest::newRow("no seconds") << QStringLiteral("2019-03-01T10:20");
+    QTest::newRow("date only") << QStringLiteral("2019-03-01");
+    QTest::newRow("space separator") << QStringLiteral("2019-03-01 10:20:30");
+    QTest::newRow("wrong suffix") << QStringLiteral("2019-03-01T10:20:30X");
+    QTest::newRow("letters") << QStringLiteral("2019-0a-01T10:20:30");
+    QTest::newRow("non-latin digits") << QStringLiteral("2019-03-01T10:20:3\u0663");
+    QTest::newRow("empty") << QString();
+}
+
+void DatesTests::testIsoDateTimeParsing()
+{
+    QFETCH(QString, string);
+    const QDateTime expected = QDateTime::fromString(string, Qt::ISODate);
+    const QDateTime parsed = Charm::dateTimeFromIsoString(string);
+    QCOMPARE(parsed.isValid(), expected.isValid());
+    QCOMPARE(parsed, expected);
+    QCOMPARE(parsed.timeSpec(), expected.timeSpec());
+}
+
+void DatesTests::testIsoDateTimeFormatting_data()
+{
+    QTest::addColumn<QDateTime>("dateTime");
+    const QDate date(2019, 3, 1);
+    const QTime time(10, 20, 30, 400);
+    QTest::newRow("local time") << QDateTime(date, time, Qt::LocalTime);
+    QTest::newRow("UTC") << QDateTime(date, time, Qt::UTC);
+    QTest::newRow("offset") << QDateTime(date, time, Qt::OffsetFromUTC, 7200);
+    QTest::newRow("first year") << QDateTime(QDate(1, 1, 1), time, Qt::UTC);
+    QTest::newRow("last year") << QDateTime(QDate(9999, 12, 31), time, Qt::UTC);
+    QTest::newRow("five digit year") << QDateTime(QDate(10000, 1, 1), time, Qt::UTC);
+    QTest::newRow("invalid") << QDateTime();
+}
+
+void DatesTests::testIsoDateTimeFormatting()
+{
+    QFETCH(QDateTime, dateTime);
+    QCOMPARE(Charm::dateTimeToIsoString(dateTime), dateTime.toString(Qt::ISODate));
+}
+
+namespace {
+QStringList isoBenchmarkStrings()
+{
+    QStringList strings;
+    QDateTime dateTime(QDate(2019, 1, 1), QTime(8, 0, 0), Qt::UTC);
+    for (int i = 0; i < 10000; ++i)
+        strings.append(dateTime.addSecs(i * 3607).toString(Qt::ISODate));
+    return strings;
+}
+}
+
+void DatesTests::benchmarkIsoDateTimeParsing_data()
+{
+    QTest::addColumn<bool>("useQt");
+    QTest::newRow("QDateTime::fromString") << true;
+    QTest::newRow("Charm::dateTimeFromIsoString") << false;
+}
+
+void DatesTests::benchmarkIsoDateTimeParsing()
+{
+    QFETCH(bool, useQt);
+    const QStringList strings = isoBenchmarkStrings();
+    QBENCHMARK {
+        Q_FOREACH (const QString &string, strings) {
+            const QDateTime dateTime = useQt ? QDateTime::fromString(string, Qt::ISODate)
+                                       : Charm::dateTimeFromIsoString(string);
+            QVERIFY(dateTime.isValid());
+        }
+    }
+}
+
+void DatesTests::benchmarkIsoDateTimeFormatting_data()
+{
+    QTest::addColumn<bool>("useQt");
+    QTest::newRow("QDateTime::toString") << true;
+    QTest::newRow("Charm::dateTimeToIsoString") << false;
+}
+
+void DatesTests::benchmarkIsoDateTimeFormatting()
+{
+    QFETCH(bool, useQt);
+    QList<QDateTime> dateTimes;
+    Q_FOREACH (const QString &string, isoBenchmarkStrings())
+        dateTimes.append(QDateTime::fromString(string, Qt::ISODate));
+    QBENCHMARK {
+        Q_FOREACH (const QDateTime &dateTime, dateTimes) {
+            const QString string = useQt ? dateTime.toString(Qt::ISODate)
+                                   : Charm::dateTimeToIsoString(dateTime);
+            QVERIFY(!string.isEmpty());
+        }
+    }
+}
+
 QTEST_MAIN(DatesTests)
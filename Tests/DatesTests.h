@@ -38,6 +38,16 @@ private Q_SLOTS:
     void testNumberOfWeeksInYear();
     void testWeekDifference_data();
     void testWeekDifference();
+    void testIsoDateTimeRoundTrip_data();
+    void testIsoDateTimeRoundTrip();
+    void testIsoDateTimeParsing_data();
+    void testIsoDateTimeParsing();
+    void testIsoDateTimeFormatting_data();
+    void testIsoDateTimeFormatting();
+    void benchmarkIsoDateTimeParsing_data();
+    void benchmarkIsoDateTimeParsing();
+    void benchmarkIsoDateTimeFormatting_data();
+    void benchmarkIsoDateTimeFormatting();
 };
 
 #endif
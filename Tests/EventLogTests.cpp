@@ -0,0 +1,208 @@
+/*
+  EventLogTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EventLogTests.h"
+
+#include "Core/EventLog.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QtTest/QtTest>
+
+namespace {
+Event testEvent(EventId id, int minutes)
+{
+    Event event;
+    event.setId(id);
+    event.setUserId(1);
+    event.setReportId(42);
+    event.setTaskId(1000 + id);
+    event.setComment(QStringLiteral("Event %1").arg(id));
+    const QDateTime start(QDate(2019, 5, 6), QTime(9, 0), Qt::UTC);
+    event.setStartDateTime(start);
+    event.setEndDateTime(start.addSecs(60 * minutes));
+    return event;
+}
+}
+
+void EventLogTests::initTestCase()
+{
+    QVERIFY(m_directory.isValid());
+}
+
+void EventLogTests::makeModifyDeleteEventsTest()
+{
+    EventLog log(logFile(QStringLiteral("events.log")));
+    QVERIFY2(log.open(), qPrintable(log.errorString()));
+    QVERIFY(log.getAllEvents().isEmpty());
+
+    Event event1 = log.makeEvent();
+    Event event2 = log.makeEvent();
+    QVERIFY(event1.isValid());
+    QVERIFY(event2.isValid());
+    QVERIFY(event1.id() != event2.id());
+
+    Event modified = testEvent(event1.id(), 30);
+    QVERIFY(log.modifyEvent(modified));
+    QCOMPARE(log.getEvent(event1.id()), modified);
+
+    QVERIFY(log.deleteEvent(event2));
+    QVERIFY(!log.getEvent(event2.id()).isValid());
+    QCOMPARE(log.getAllEvents().size(), 1);
+
+    // events that do not exist cannot be modified:
+    QVERIFY(!log.modifyEvent(testEvent(4711, 10)));
+}
+
+void EventLogTests::reopenTest()
+{
+    const QString fileName = logFile(QStringLiteral("reopen.log"));
+    EventList events;
+    {
+        EventLog log(fileName);
+        QVERIFY(log.open());
+        for (int i = 0; i < 10; ++i) {
+            Event event = testEvent(log.makeEvent().id(), i);
+            // update the end time a few times, like for a running event:
+            for (int minutes = 1; minutes <= 3; ++minutes) {
+                event.setEndDateTime(event.startDateTime().addSecs(60 * (i + minutes)));
+                QVERIFY(log.modifyEvent(event));
+            }
+            events << event;
+        }
+        Event withoutTimes = log.makeEvent();
+        withoutTimes.setComment(QStringLiteral("no start, no end"));
+        QVERIFY(log.modifyEvent(withoutTimes));
+        events << withoutTimes;
+        QVERIFY(log.deleteEvent(events.takeFirst()));
+    }
+
+    EventLog log(fileName);
+    QVERIFY2(log.open(), qPrintable(log.errorString()));
+    QCOMPARE(log.getAllEvents(), events);
+    // new events do not reuse the ids of existing ones:
+    QVERIFY(log.makeEvent().id() > events.last().id());
+}
+
+void EventLogTests::tornRecordTest()
+{
+    const QString fileName = logFile(QStringLiteral("torn.log"));
+    Event event;
+    {
+        EventLog log(fileName);
+        QVERIFY(log.open());
+        event = testEvent(log.makeEvent().id(), 10);
+        QVERIFY(log.modifyEvent(event));
+        Event later(event);
+        later.setEndDateTime(event.endDateTime().addSecs(600));
+        QVERIFY(log.modifyEvent(later));
+    }
+
+    // cut the last record in half, as if the write had been interrupted:
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    const qint64 sizeBefore = file.size();
+    QVERIFY(file.resize(sizeBefore - 5));
+    file.close();
+
+    {
+        EventLog log(fileName);
+        QVERIFY(log.open());
+        QCOMPARE(log.getAllEvents().size(), 1);
+        QCOMPARE(log.getEvent(event.id()), event);
+        // the log is usable after the incomplete record has been dropped:
+        QVERIFY(log.modifyEvent(event));
+    }
+
+    // a corrupted record is detected by its checksum:
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(file.size() - 1));
+    QVERIFY(file.putChar('\xff'));
+    file.close();
+    EventLog log(fileName);
+    QVERIFY(log.open());
+    QCOMPARE(log.getAllEvents().size(), 1);
+}
+
+void EventLogTests::compactionTest()
+{
+    const QString fileName = logFile(QStringLiteral("compaction.log"));
+    EventLog log(fileName);
+    QVERIFY(log.open());
+    Event event = testEvent(log.makeEvent().id(), 0);
+    for (int i = 0; i < 500; ++i) {
+        event.setEndDateTime(event.startDateTime().addSecs(60 * i));
+        QVERIFY(log.modifyEvent(event));
+    }
+    QCOMPARE(log.obsoleteRecords(), 500);
+    const qint64 sizeBefore = QFileInfo(fileName).size();
+
+    QVERIFY(log.compact());
+    QCOMPARE(log.obsoleteRecords(), 0);
+    QVERIFY(QFileInfo(fileName).size() < sizeBefore / 100);
+    QCOMPARE(log.getEvent(event.id()), event);
+
+    // the log stays writable after compaction, and compacts itself eventually:
+    for (int i = 0; i < 2000; ++i) {
+        event.setEndDateTime(event.startDateTime().addSecs(60 * i));
+        QVERIFY(log.modifyEvent(event));
+    }
+    QVERIFY(log.obsoleteRecords() <= 1000);
+
+    EventLog reopened(fileName);
+    QVERIFY(reopened.open());
+    QCOMPARE(reopened.getAllEvents(), EventList() << event);
+}
+
+void EventLogTests::setAllEventsTest()
+{
+    EventLog log(logFile(QStringLiteral("setall.log")));
+    QVERIFY(log.open());
+    log.makeEvent();
+
+    const EventList events = EventList() << testEvent(3, 10) << testEvent(7, 20);
+    QVERIFY(log.setAllEvents(events));
+    QCOMPARE(log.getAllEvents(), events);
+    QCOMPARE(log.makeEvent().id(), 8);
+
+    QVERIFY(log.deleteAllEvents());
+    QVERIFY(log.getAllEvents().isEmpty());
+}
+
+void EventLogTests::invalidFileTest()
+{
+    const QString fileName = logFile(QStringLiteral("invalid.log"));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("SQLite format 3");
+    file.close();
+
+    EventLog log(fileName);
+    QVERIFY(!log.open());
+    QVERIFY(!log.errorString().isEmpty());
+}
+
+QString EventLogTests::logFile(const QString &name) const
+{
+    return m_directory.filePath(name);
+}
+
+QTEST_MAIN(EventLogTests)
@@ -0,0 +1,250 @@
+/*
+  GzipDeviceTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "GzipDeviceTests.h"
+
+#include "Core/GzipDevice.h"
+
+#include <QBuffer>
+#include <QtTest/QtTest>
+
+namespace {
+// XML-like text that compresses about as well as a database export:
+QByteArray sampleData(int size)
+{
+    QByteArray data;
+    data.reserve(size + 200);
+    for (int i = 0; data.size() < size; ++i) {
+        data += "    <event id=\"" + QByteArray::number(i) + "\" taskid=\""
+                + QByteArray::number(i % 997) + "\" start=\"2019-05-06T09:"
+                + QByteArray::number(i % 60).rightJustified(2, '0')
+                + ":00Z\" end=\"2019-05-06T10:00:00Z\">Comment " + QByteArray::number(i * 7919)
+                + "</event>\n";
+    }
+    data.resize(size);
+    return data;
+}
+
+QByteArray compress(const QByteArray &data)
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    GzipDevice device(&buffer, GzipDevice::GzipCompression);
+    if (!device.open(QIODevice::WriteOnly) || device.write(data) != data.size())
+        return QByteArray();
+    device.close();
+    return buffer.data();
+}
+
+QByteArray decompress(QByteArray data, bool *ok = nullptr)
+{
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    GzipDevice device(&buffer);
+    bool success = device.open(QIODevice::ReadOnly);
+    QByteArray result;
+    char chunk[4096];
+    while (success && !device.atEnd()) {
+        const qint64 read = device.read(chunk, sizeof(chunk));
+        if (read < 0)
+            success = false;
+        else
+            result.append(chunk, static_cast<int>(read));
+    }
+    if (ok)
+        *ok = success;
+    return result;
+}
+
+// a device that accepts no data, like a full disk:
+class FullDevice : public QIODevice
+{
+protected:
+    qint64 readData(char *, qint64) override
+    {
+        return -1;
+    }
+
+    qint64 writeData(const char *, qint64) override
+    {
+        setErrorString(QStringLiteral("No space left on device"));
+        return -1;
+    }
+};
+}
+
+void GzipDeviceTests::initTestCase()
+{
+    if (!GzipDevice::isCompressionSupported())
+        QSKIP("This build does not support compression");
+}
+
+void GzipDeviceTests::roundTripTest_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("small") << QByteArray("<charmreport/>\n");
+    QTest::newRow("1MB") << sampleData(1024 * 1024);
+    // larger than the internal buffers, with bytes that do not compress:
+    QByteArray noise(300 * 1024, Qt::Uninitialized);
+    quint32 seed = 42;
+    for (int i = 0; i < noise.size(); ++i) {
+        seed = seed * 1103515245 + 12345;
+        noise[i] = static_cast<char>(seed >> 24);
+    }
+    QTest::newRow("noise") << noise;
+}
+
+void GzipDeviceTests::roundTripTest()
+{
+    QFETCH(QByteArray, data);
+    QByteArray compressed = compress(data);
+    QVERIFY(!compressed.isEmpty());
+
+    bool ok = false;
+    QCOMPARE(decompress(compressed, &ok), data);
+    QVERIFY(ok);
+
+    // reading everything at once works through the device buffer:
+    QBuffer input(&compressed);
+    QVERIFY(input.open(QIODevice::ReadOnly));
+    GzipDevice device(&input);
+    QVERIFY(GzipDevice::isCompressed(&input));
+    QVERIFY(device.open(QIODevice::ReadOnly));
+    QCOMPARE(device.compression(), GzipDevice::GzipCompression);
+    QCOMPARE(device.readAll(), data);
+    QVERIFY(device.atEnd());
+}
+
+void GzipDeviceTests::passThroughTest()
+{
+    const QByteArray data = sampleData(100 * 1024);
+
+    // without compression, the data is written unchanged:
+    QBuffer output;
+    QVERIFY(output.open(QIODevice::WriteOnly));
+    GzipDevice writer(&output);
+    QVERIFY(writer.open(QIODevice::WriteOnly));
+    QCOMPARE(writer.write(data), qint64(data.size()));
+    writer.close();
+    QCOMPARE(output.data(), data);
+
+    // and plain data is read unchanged:
+    QBuffer input(&output.buffer());
+    QVERIFY(input.open(QIODevice::ReadOnly));
+    QVERIFY(!GzipDevice::isCompressed(&input));
+    GzipDevice reader(&input);
+    QVERIFY(reader.open(QIODevice::ReadOnly));
+    QCOMPARE(reader.compression(), GzipDevice::NoCompression);
+    QCOMPARE(reader.readAll(), data);
+    QVERIFY(reader.atEnd());
+}
+
+void GzipDeviceTests::compressionForFileNameTest()
+{
+    QCOMPARE(GzipDevice::compressionForFileName(QStringLiteral("tasks.xml")),
+             GzipDevice::NoCompression);
+    QCOMPARE(GzipDevice::compressionForFileName(QStringLiteral("tasks.xml.gz")),
+             GzipDevice::GzipCompression);
+    QCOMPARE(GzipDevice::compressionForFileName(QStringLiteral("Week 19.charmreport.GZ")),
+             GzipDevice::GzipCompression);
+    QCOMPARE(GzipDevice::compressionForFileName(QStringLiteral("gz")),
+             GzipDevice::NoCompression);
+}
+
+void GzipDeviceTests::truncatedInputTest()
+{
+    const QByteArray data = sampleData(256 * 1024);
+    const QByteArray compressed = compress(data);
+    QVERIFY(compressed.size() > 100);
+
+    // a stream cut off in the middle, or right before the trailer, is an error:
+    const int sizes[] = { 10, compressed.size() / 2, compressed.size() - 4 };
+    for (int size : sizes) {
+        bool ok = true;
+        const QByteArray result = decompress(compressed.left(size), &ok);
+        QVERIFY2(!ok, qPrintable(QString::number(size)));
+        QVERIFY(data.startsWith(result));
+    }
+}
+
+void GzipDeviceTests::corruptInputTest()
+{
+    QByteArray compressed = compress(sampleData(64 * 1024));
+    // damage the deflate stream behind the header:
+    for (int i = 20; i < 60; ++i)
+        compressed[i] = static_cast<char>(~compressed.at(i));
+    bool ok = true;
+    decompress(compressed, &ok);
+    QVERIFY(!ok);
+}
+
+void GzipDeviceTests::commitErrorTest()
+{
+    // the end of the stream is written when the device is closed, and may fail:
+    FullDevice output;
+    QVERIFY(output.open(QIODevice::WriteOnly));
+    GzipDevice device(&output, GzipDevice::GzipCompression);
+    QVERIFY(device.open(QIODevice::WriteOnly));
+    QVERIFY(!device.commit());
+    QVERIFY(!device.isOpen());
+    QCOMPARE(device.errorString(), QStringLiteral("No space left on device"));
+}
+
+void GzipDeviceTests::compressionBenchmark_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::newRow("1MB") << 1024 * 1024;
+    QTest::newRow("16MB") << 16 * 1024 * 1024;
+}
+
+void GzipDeviceTests::compressionBenchmark()
+{
+    QFETCH(int, size);
+    const QByteArray data = sampleData(size);
+    QByteArray compressed;
+    QBENCHMARK {
+        compressed = compress(data);
+    }
+    QVERIFY(compressed.size() < data.size());
+    qDebug("%d bytes compressed to %d bytes (%.1f%%)", data.size(), compressed.size(),
+           100.0 * compressed.size() / data.size());
+}
+
+void GzipDeviceTests::decompressionBenchmark_data()
+{
+    compressionBenchmark_data();
+}
+
+void GzipDeviceTests::decompressionBenchmark()
+{
+    QFETCH(int, size);
+    const QByteArray data = sampleData(size);
+    const QByteArray compressed = compress(data);
+    QByteArray result;
+    QBENCHMARK {
+        result = decompress(compressed);
+    }
+    QCOMPARE(result.size(), data.size());
+}
+
+QTEST_MAIN(GzipDeviceTests)
@@ -23,11 +23,15 @@
 
 #include "ImportExportTests.h"
 
+#include "Core/Configuration.h"
 #include "Core/Controller.h"
 #include "Core/Task.h"
 #include "Core/CharmDataModel.h"
+#include "Core/GzipDevice.h"
+#include "Core/SqlStorage.h"
 #include "Charm/Commands/CommandImportFromXml.h"
 
+#include <QBuffer>
 #include <QtDebug>
 #include <QString>
 #include <QtTest/QtTest>
@@ -85,6 +89,276 @@ void ImportExportTests::importExportTest()
 //    }
 }
 
+void ImportExportTests::streamingExportTest()
+{
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    importDatabase(filename);
+    QSharedPointer<CharmDataModel> databaseStep1(model()->clone());
+
+    QBuffer streamed;
+    QVERIFY(streamed.open(QIODevice::WriteOnly));
+    QVERIFY(controller()->exportDatabaseToXml(&streamed).isEmpty());
+    streamed.close();
+
+    // the streamed export contains the same elements as the document based one:
+    QDomDocument streamedDoc;
+    QVERIFY(streamedDoc.setContent(streamed.data()));
+    const QDomDocument exportDoc = controller()->exportDatabasetoXml();
+    QCOMPARE(streamedDoc.documentElement().attribute(QStringLiteral("version")),
+             exportDoc.documentElement().attribute(QStringLiteral("version")));
+    QCOMPARE(streamedDoc.elementsByTagName(Task::tagName()).count(),
+             exportDoc.elementsByTagName(Task::tagName()).count());
+    QCOMPARE(streamedDoc.elementsByTagName(Event::tagName()).count(),
+             exportDoc.elementsByTagName(Event::tagName()).count());
+
+    // and imports back into the same database:
+    QVERIFY(controller()->importDatabaseFromXml(streamedDoc).isEmpty());
+    QCOMPARE(*databaseStep1.data(), *model());
+}
+
+void ImportExportTests::streamingImportTest()
+{
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    importDatabase(filename);
+    QSharedPointer<CharmDataModel> databaseStep1(model()->clone());
+
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    qint64 lastBytesRead = 0;
+    int progressCalls = 0;
+    const QString error = controller()->importDatabaseFromXml(&file, [&](qint64 bytesRead,
+                                                                        qint64 bytesTotal) {
+        QCOMPARE(bytesTotal, file.size());
+        QVERIFY(bytesRead >= lastBytesRead);
+        lastBytesRead = bytesRead;
+        ++progressCalls;
+    });
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+    QVERIFY(progressCalls > 0);
+    QCOMPARE(lastBytesRead, file.size());
+    QCOMPARE(*databaseStep1.data(), *model());
+}
+
+void ImportExportTests::streamingImportInvalidFileTest()
+{
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    importDatabase(filename);
+    QSharedPointer<CharmDataModel> databaseStep1(model()->clone());
+
+    // a truncated export fails to import, and leaves the database unchanged:
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QBuffer truncated;
+    truncated.setData(file.readAll().left(file.size() * 2 / 3));
+    QVERIFY(truncated.open(QIODevice::ReadOnly));
+    QVERIFY(!controller()->importDatabaseFromXml(&truncated).isEmpty());
+    QCOMPARE(*databaseStep1.data(), *model());
+}
+
+void ImportExportTests::archivedEventsImportTest()
+{
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    importDatabase(filename);
+    SqlStorage *storage = controller()->storage();
+    const EventList events = storage->getAllEvents();
+    QVERIFY(!events.isEmpty());
+    QDateTime first = events.first().startDateTime();
+    QDateTime last = events.first().endDateTime();
+    Q_FOREACH (const Event &event, events) {
+        first = qMin(first, event.startDateTime());
+        last = qMax(last, event.endDateTime());
+    }
+
+    // the export includes the archived events:
+    QVERIFY(storage->archiveEvents(last.addDays(1)));
+    QVERIFY(storage->getAllEvents().isEmpty());
+    QBuffer exported;
+    QVERIFY(exported.open(QIODevice::ReadWrite));
+    QVERIFY(controller()->exportDatabaseToXml(&exported).isEmpty());
+
+    // importing it replaces the archive, the events are not read twice:
+    exported.seek(0);
+    const QString error = controller()->importDatabaseFromXml(&exported);
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+    QVERIFY(!storage->archiveCutoff().isValid());
+    QCOMPARE(storage->getAllEvents().size(), events.size());
+    QCOMPARE(storage->getAllEvents(SqlStorage::AllEvents).size(), events.size());
+    QCOMPARE(storage->getEventsInRange(first, last.addDays(1)).size(), events.size());
+    QFile::remove(QFileInfo(databasePath()).absoluteFilePath() + QStringLiteral("-archive"));
+}
+
+void ImportExportTests::compressedExportImportTest()
+{
+    if (!GzipDevice::isCompressionSupported())
+        QSKIP("This build does not support compression");
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    importDatabase(filename);
+    QSharedPointer<CharmDataModel> databaseStep1(model()->clone());
+
+    QBuffer plain;
+    QVERIFY(plain.open(QIODevice::WriteOnly));
+    QVERIFY(controller()->exportDatabaseToXml(&plain).isEmpty());
+    QBuffer compressed;
+    QVERIFY(compressed.open(QIODevice::WriteOnly));
+    {
+        GzipDevice device(&compressed, GzipDevice::GzipCompression);
+        QVERIFY(device.open(QIODevice::WriteOnly));
+        QVERIFY(controller()->exportDatabaseToXml(&device).isEmpty());
+    }
+    QVERIFY(compressed.size() < plain.size());
+    compressed.close();
+
+    // the compressed export is detected and imports into the same database:
+    QVERIFY(compressed.open(QIODevice::ReadOnly));
+    GzipDevice device(&compressed);
+    QVERIFY(device.open(QIODevice::ReadOnly));
+    QCOMPARE(device.compression(), GzipDevice::GzipCompression);
+    const QString error = controller()->importDatabaseFromXml(&device);
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+    QCOMPARE(*databaseStep1.data(), *model());
+}
+
+void ImportExportTests::binaryExportImportTest()
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 12, 0)
+    QSKIP("The binary export format requires Qt 5.12");
+#endif
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    importDatabase(filename);
+    QSharedPointer<CharmDataModel> databaseStep1(model()->clone());
+
+    QBuffer binary;
+    QVERIFY(binary.open(QIODevice::ReadWrite));
+    QVERIFY(controller()->exportDatabaseToBinary(&binary).isEmpty());
+    QBuffer xml;
+    QVERIFY(xml.open(QIODevice::WriteOnly));
+    QVERIFY(controller()->exportDatabaseToXml(&xml).isEmpty());
+    QVERIFY(binary.size() < xml.size());
+
+    binary.seek(0);
+    QVERIFY(Controller::isBinaryDatabaseExport(&binary));
+    int progressCalls = 0;
+    const QString error = controller()->importDatabaseFromBinary(&binary, [&](qint64, qint64) {
+        ++progressCalls;
+    });
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+    QVERIFY(progressCalls > 0);
+    QCOMPARE(*databaseStep1.data(), *model());
+}
+
+void ImportExportTests::binaryImportInvalidFileTest()
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 12, 0)
+    QSKIP("The binary export format requires Qt 5.12");
+#endif
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    importDatabase(filename);
+    QSharedPointer<CharmDataModel> databaseStep1(model()->clone());
+
+    // XML is not mistaken for a binary export:
+    QFile xml(filename);
+    QVERIFY(xml.open(QIODevice::ReadOnly));
+    QVERIFY(!Controller::isBinaryDatabaseExport(&xml));
+    QVERIFY(!controller()->importDatabaseFromBinary(&xml).isEmpty());
+    QCOMPARE(*databaseStep1.data(), *model());
+
+    // a truncated export fails to import, and leaves the database unchanged:
+    QBuffer binary;
+    QVERIFY(binary.open(QIODevice::WriteOnly));
+    QVERIFY(controller()->exportDatabaseToBinary(&binary).isEmpty());
+    binary.close();
+    QBuffer truncated;
+    truncated.setData(binary.data().left(binary.data().size() * 2 / 3));
+    QVERIFY(truncated.open(QIODevice::ReadOnly));
+    QVERIFY(!controller()->importDatabaseFromBinary(&truncated).isEmpty());
+    QCOMPARE(*databaseStep1.data(), *model());
+}
+
+void ImportExportTests::deltaExportImportTest()
+{
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    importDatabase(filename);
+    QSharedPointer<CharmDataModel> databaseStep1(model()->clone());
+    QBuffer full;
+    QVERIFY(full.open(QIODevice::ReadWrite));
+    QVERIFY(controller()->exportDatabaseToXml(&full).isEmpty());
+    const qint64 since = controller()->storage()->lastChange();
+    QVERIFY(since > 0);
+
+    // add a task and an event, modify and delete existing events:
+    const TaskList tasks = controller()->storage()->getAllTasks();
+    const EventList events = controller()->storage()->getAllEvents();
+    QVERIFY(tasks.size() > 1);
+    QVERIFY(events.size() > 2);
+    TaskId maxTaskId = 0;
+    Q_FOREACH (const Task &task, tasks)
+        maxTaskId = qMax(maxTaskId, task.id());
+    Task task(maxTaskId + 1, QStringLiteral("Delta Task"), tasks.first().id());
+    QVERIFY(controller()->addTask(task));
+    Event event = controller()->makeEvent(task);
+    QVERIFY(event.isValid());
+    event.setComment(QStringLiteral("Delta Event"));
+    event.setStartDateTime(QDateTime(QDate(2019, 5, 6), QTime(9, 0)));
+    event.setEndDateTime(QDateTime(QDate(2019, 5, 6), QTime(11, 30)));
+    QVERIFY(controller()->modifyEvent(event));
+    Event modified = events.first();
+    modified.setComment(QStringLiteral("Modified after the export"));
+    QVERIFY(controller()->modifyEvent(modified));
+    QVERIFY(controller()->deleteEvent(events.last()));
+    controller()->updateModelEventsAndTasks();
+    QSharedPointer<CharmDataModel> databaseStep2(model()->clone());
+
+    QBuffer delta;
+    QVERIFY(delta.open(QIODevice::ReadWrite));
+    qint64 lastChange = 0;
+    QVERIFY(controller()->exportDeltaToXml(&delta, since, &lastChange).isEmpty());
+    QCOMPARE(lastChange, controller()->storage()->lastChange());
+    QVERIFY(lastChange > since);
+    QVERIFY(delta.size() < full.size());
+
+    // a delta is not mistaken for a complete export:
+    delta.seek(0);
+    QVERIFY(!controller()->importDatabaseFromXml(&delta).isEmpty());
+    QCOMPARE(*databaseStep2.data(), *model());
+
+    // applying the delta to the exported state reproduces the changes:
+    full.seek(0);
+    QVERIFY(controller()->importDatabaseFromXml(&full).isEmpty());
+    QCOMPARE(*databaseStep1.data(), *model());
+    delta.seek(0);
+    const QString error = controller()->importDeltaFromXml(&delta);
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+    QCOMPARE(*databaseStep2.data(), *model());
+
+    // applying it again changes nothing, the events are matched by their origin:
+    const int eventCount = controller()->storage()->getAllEvents().size();
+    delta.seek(0);
+    QVERIFY(controller()->importDeltaFromXml(&delta).isEmpty());
+    QCOMPARE(controller()->storage()->getAllEvents().size(), eventCount);
+    QCOMPARE(*databaseStep2.data(), *model());
+
+    // also in another installation, the delta names the installation of every event:
+    const quint32 installationId = CONFIGURATION.installationId;
+    CONFIGURATION.installationId = installationId + 1;
+    delta.seek(0);
+    QVERIFY(controller()->importDeltaFromXml(&delta).isEmpty());
+    CONFIGURATION.installationId = installationId;
+    QCOMPARE(controller()->storage()->getAllEvents().size(), eventCount);
+    QCOMPARE(*databaseStep2.data(), *model());
+
+    // the watermark is kept in the database:
+    QVERIFY(controller()->setDeltaWatermark(lastChange));
+    QCOMPARE(controller()->deltaWatermark(), lastChange);
+}
+
 void ImportExportTests::importBenchmark()
 {
     const QString filename = QStringLiteral(
@@ -94,6 +368,17 @@ void ImportExportTests::importBenchmark()
     }
 }
 
+void ImportExportTests::streamingImportBenchmark()
+{
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    QBENCHMARK {
+        QFile file(filename);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QVERIFY(controller()->importDatabaseFromXml(&file).isEmpty());
+    }
+}
+
 void ImportExportTests::exportBenchmark()
 {
     const QString filename = QStringLiteral(
@@ -109,6 +394,19 @@ void ImportExportTests::exportBenchmark()
     }
 }
 
+void ImportExportTests::streamingExportBenchmark()
+{
+    const QString filename = QStringLiteral(
+        ":/importExportTest/Data/test-database-export.charmdatabaseexport");
+    const QString localFileName(QStringLiteral("ImportExportTests-temp.charmdatabaseexport"));
+    importDatabase(filename);
+    QBENCHMARK {
+        QFile outfile(localFileName);
+        QVERIFY(outfile.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        QVERIFY(controller()->exportDatabaseToXml(&outfile).isEmpty());
+    }
+}
+
 void ImportExportTests::cleanupTestCase()
 {
     destroy();
@@ -36,8 +36,18 @@ public:
 private Q_SLOTS:
     void initTestCase();
     void importExportTest();
+    void streamingExportTest();
+    void streamingImportTest();
+    void streamingImportInvalidFileTest();
+    void archivedEventsImportTest();
+    void compressedExportImportTest();
+    void binaryExportImportTest();
+    void binaryImportInvalidFileTest();
+    void deltaExportImportTest();
     void importBenchmark();
+    void streamingImportBenchmark();
     void exportBenchmark();
+    void streamingExportBenchmark();
     void cleanupTestCase();
 
 private:
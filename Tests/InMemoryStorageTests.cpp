@@ -0,0 +1,79 @@
+/*
+  InMemoryStorageTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "InMemoryStorageTests.h"
+
+#include "Core/CharmConstants.h"
+#include "Core/CharmDataModel.h"
+#include "Core/Controller.h"
+#include "Core/SqlStorage.h"
+#include "Core/TaskTreeItem.h"
+
+#include <QFileInfo>
+#include <QtTest/QtTest>
+
+InMemoryStorageTests::InMemoryStorageTests()
+    : TestApplication(QStringLiteral("./InMemoryStorageTestDatabase.db"),
+                      CHARM_SQLITE_MEMORY_BACKEND_DESCRIPTOR)
+{
+}
+
+void InMemoryStorageTests::initTestCase()
+{
+    initialize();
+}
+
+void InMemoryStorageTests::descriptionTest()
+{
+    QCOMPARE(controller()->storage()->description(), tr("in-memory database"));
+    QVERIFY(controller()->storage()->getUser(testUserId()).isValid());
+    // the configured database file is not used:
+    QVERIFY(!QFileInfo::exists(databasePath()));
+}
+
+void InMemoryStorageTests::createModifyTasksAndEventsTest()
+{
+    // the complete stack works on the in-memory database:
+    Task task(1000, QStringLiteral("Task 1"));
+    QVERIFY(controller()->addTask(task));
+    QCOMPARE(controller()->storage()->getAllTasks().size(), 1);
+    QVERIFY(model()->taskTreeItem(task.id()).task() == task);
+
+    Event event = controller()->makeEvent(task);
+    QVERIFY(event.isValid());
+    event.setComment(QStringLiteral("In memory"));
+    QVERIFY(controller()->modifyEvent(event));
+    QCOMPARE(controller()->storage()->getEvent(event.id()).comment(), event.comment());
+    QCOMPARE(model()->eventForId(event.id()).comment(), event.comment());
+
+    QVERIFY(controller()->deleteEvent(event));
+    QVERIFY(controller()->deleteTask(task));
+    QVERIFY(controller()->storage()->getAllEvents().isEmpty());
+    QVERIFY(model()->taskTreeItem(0).childCount() == 0);
+    QVERIFY(!QFileInfo::exists(databasePath()));
+}
+
+void InMemoryStorageTests::cleanupTestCase()
+{
+    destroy();
+}
+
+QTEST_MAIN(InMemoryStorageTests)
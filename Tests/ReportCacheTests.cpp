@@ -0,0 +1,110 @@
+/*
+  ReportCacheTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportCacheTests.h"
+
+#include "Charm/Reports/ReportCache.h"
+
+#include <QTextDocument>
+#include <QtTest/QtTest>
+
+namespace {
+ReportCache::Entry makeEntry(const QString &text, int *finishedCount = nullptr)
+{
+    ReportCache::Entry entry;
+    entry.document.reset(new QTextDocument(text));
+    entry.finished = [finishedCount]() {
+        if (finishedCount)
+            ++*finishedCount;
+    };
+    return entry;
+}
+}
+
+void ReportCacheTests::testFindInsertedReport()
+{
+    ReportCache cache;
+    int finished = 0;
+    cache.insert(QStringLiteral("weekly/1"), 1, makeEntry(QStringLiteral("Week 1"), &finished));
+    cache.insert(QStringLiteral("weekly/2"), 1, makeEntry(QStringLiteral("Week 2")));
+    QCOMPARE(cache.size(), 2);
+
+    QVERIFY(cache.contains(QStringLiteral("weekly/1"), 1));
+    const ReportCache::Entry entry = cache.find(QStringLiteral("weekly/1"), 1);
+    QVERIFY(entry.document);
+    QCOMPARE(entry.document->toPlainText(), QStringLiteral("Week 1"));
+    entry.finished();
+    QCOMPARE(finished, 1);
+
+    QVERIFY(!cache.find(QStringLiteral("monthly/1"), 1).document);
+    QVERIFY(!cache.contains(QStringLiteral("monthly/1"), 1));
+}
+
+void ReportCacheTests::testOtherRevisionIsDropped()
+{
+    ReportCache cache;
+    cache.insert(QStringLiteral("weekly/1"), 1, makeEntry(QStringLiteral("Week 1")));
+    QVERIFY(!cache.contains(QStringLiteral("weekly/1"), 2));
+    // the report is out of date, once the model has changed:
+    QVERIFY(!cache.find(QStringLiteral("weekly/1"), 2).document);
+    QCOMPARE(cache.size(), 0);
+    QVERIFY(!cache.find(QStringLiteral("weekly/1"), 1).document);
+
+    cache.insert(QStringLiteral("weekly/1"), 2, makeEntry(QStringLiteral("Week 1, updated")));
+    QCOMPARE(cache.find(QStringLiteral("weekly/1"), 2).document->toPlainText(),
+             QStringLiteral("Week 1, updated"));
+}
+
+void ReportCacheTests::testLeastRecentlyUsedReportIsEvicted()
+{
+    ReportCache cache(3);
+    cache.insert(QStringLiteral("week 1"), 1, makeEntry(QStringLiteral("1")));
+    cache.insert(QStringLiteral("week 2"), 1, makeEntry(QStringLiteral("2")));
+    cache.insert(QStringLiteral("week 3"), 1, makeEntry(QStringLiteral("3")));
+    // going back to week 1 makes week 2 the least recently used one:
+    QVERIFY(cache.find(QStringLiteral("week 1"), 1).document);
+    cache.insert(QStringLiteral("week 4"), 1, makeEntry(QStringLiteral("4")));
+
+    QCOMPARE(cache.size(), 3);
+    QVERIFY(cache.contains(QStringLiteral("week 1"), 1));
+    QVERIFY(!cache.contains(QStringLiteral("week 2"), 1));
+    QVERIFY(cache.contains(QStringLiteral("week 3"), 1));
+    QVERIFY(cache.contains(QStringLiteral("week 4"), 1));
+
+    cache.clear();
+    QCOMPARE(cache.size(), 0);
+}
+
+void ReportCacheTests::testShownDocumentOutlivesCache()
+{
+    QSharedPointer<QTextDocument> shown;
+    {
+        ReportCache cache(1);
+        cache.insert(QStringLiteral("week 1"), 1, makeEntry(QStringLiteral("1")));
+        shown = cache.find(QStringLiteral("week 1"), 1).document;
+        cache.insert(QStringLiteral("week 2"), 1, makeEntry(QStringLiteral("2")));
+        QVERIFY(!cache.contains(QStringLiteral("week 1"), 1));
+    }
+    QVERIFY(shown);
+    QCOMPARE(shown->toPlainText(), QStringLiteral("1"));
+}
+
+QTEST_MAIN(ReportCacheTests)
@@ -0,0 +1,183 @@
+/*
+  ReportGeneratorTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportGeneratorTests.h"
+
+#include "Charm/Reports/ReportGenerator.h"
+
+#include "Core/CharmDataModel.h"
+
+#include <QSemaphore>
+#include <QTextDocument>
+#include <QtTest/QtTest>
+
+namespace {
+CharmDataModel *makeModel(int numberOfEvents)
+{
+    auto model = new CharmDataModel;
+    model->setAllTasks(TaskList() << Task(1, QStringLiteral("Task")));
+    EventList events;
+    for (int i = 1; i <= numberOfEvents; ++i) {
+        Event event;
+        event.setId(i);
+        event.setTaskId(1);
+        event.setComment(QStringLiteral("Event %1").arg(i));
+        events << event;
+    }
+    model->setAllEvents(events);
+    return model;
+}
+}
+
+void ReportGeneratorTests::testReportIsBuiltInWorkerThread()
+{
+    QScopedPointer<CharmDataModel> model(makeModel(3));
+    ReportGenerator generator;
+    QThread *buildThread = nullptr;
+    QScopedPointer<QTextDocument> document;
+    generator.start(model.data(), QString(), [&buildThread](const ReportGenerator::Request &request) {
+        buildThread = QThread::currentThread();
+        return QStringLiteral("<p>%1 events</p>").arg(request.model()->eventMap().size());
+    }, [&document](QTextDocument *result) {
+        document.reset(result);
+    });
+    QVERIFY(generator.isRunning());
+    QTRY_VERIFY(!document.isNull());
+    QVERIFY(!generator.isRunning());
+    QVERIFY(buildThread != nullptr);
+    QVERIFY(buildThread != QThread::currentThread());
+    QCOMPARE(document->toPlainText(), QStringLiteral("3 events"));
+    QCOMPARE(document->thread(), QThread::currentThread());
+}
+
+void ReportGeneratorTests::testReportUsesSnapshot()
+{
+    QScopedPointer<CharmDataModel> model(makeModel(3));
+    ReportGenerator generator;
+    QSemaphore modified;
+    QString html;
+    generator.start(model.data(), QString(), [&modified](const ReportGenerator::Request &request) {
+        modified.acquire();
+        return QString::number(request.model()->eventMap().size());
+    }, [&html](QTextDocument *result) {
+        html = result->toPlainText();
+        delete result;
+    });
+    // changes after the report was requested do not show up in it:
+    model->clearEvents();
+    modified.release();
+    QTRY_VERIFY(!html.isEmpty());
+    QCOMPARE(html, QStringLiteral("3"));
+}
+
+void ReportGeneratorTests::testArchivedEventsAreAdded()
+{
+    QScopedPointer<CharmDataModel> model(makeModel(2));
+    Event archived;
+    archived.setId(10);
+    archived.setTaskId(1);
+    // events that are in the model already are not added twice:
+    const EventList archivedEvents = EventList() << archived << model->eventForId(1);
+    ReportGenerator generator;
+    QString html;
+    QThread *readingThread = nullptr;
+    generator.start(model.data(), QString(), [](const ReportGenerator::Request &request) {
+        return QString::number(request.model()->eventMap().size());
+    }, [&html](QTextDocument *result) {
+        html = result->toPlainText();
+        delete result;
+    }, [archivedEvents, &readingThread]() {
+        readingThread = QThread::currentThread();
+        return archivedEvents;
+    });
+    QTRY_VERIFY(!html.isEmpty());
+    QCOMPARE(html, QStringLiteral("3"));
+    // the events are read in the worker thread, not in the thread that requested the report:
+    QVERIFY(readingThread != nullptr);
+    QVERIFY(readingThread != QThread::currentThread());
+    // the model itself is not changed:
+    QCOMPARE(model->eventMap().size(), 2);
+}
+
+void ReportGeneratorTests::testNewerReportCancelsOlder()
+{
+    QScopedPointer<CharmDataModel> model(makeModel(1));
+    ReportGenerator generator;
+    QSemaphore started;
+    QAtomicInt firstCanceled;
+    QStringList received;
+    generator.start(model.data(), QString(), [&](const ReportGenerator::Request &request) {
+        started.release();
+        while (!request.isCanceled())
+            QThread::msleep(1);
+        firstCanceled.storeRelease(1);
+        return QStringLiteral("first");
+    }, [&received](QTextDocument *result) {
+        received << result->toPlainText();
+        delete result;
+    });
+    started.acquire();
+    generator.start(model.data(), QString(), [](const ReportGenerator::Request &) {
+        return QStringLiteral("second");
+    }, [&received](QTextDocument *result) {
+        received << result->toPlainText();
+        delete result;
+    });
+    QTRY_COMPARE(received, QStringList() << QStringLiteral("second"));
+    QCOMPARE(firstCanceled.loadAcquire(), 1);
+
+    // a canceled report is not received:
+    generator.start(model.data(), QString(), [](const ReportGenerator::Request &) {
+        return QStringLiteral("third");
+    }, [&received](QTextDocument *result) {
+        received << result->toPlainText();
+        delete result;
+    });
+    generator.cancel();
+    QVERIFY(!generator.isRunning());
+    QTest::qWait(100);
+    QCOMPARE(received, QStringList() << QStringLiteral("second"));
+}
+
+void ReportGeneratorTests::testDestroyWhileBuilding()
+{
+    QScopedPointer<CharmDataModel> model(makeModel(1));
+    QSemaphore started;
+    bool received = false;
+    {
+        ReportGenerator generator;
+        generator.start(model.data(), QString(), [&started](const ReportGenerator::Request &request) {
+            started.release();
+            while (!request.isCanceled())
+                QThread::msleep(1);
+            return QString();
+        }, [&received](QTextDocument *result) {
+            received = true;
+            delete result;
+        });
+        started.acquire();
+    }
+    // the generator waited for the canceled report:
+    QTest::qWait(100);
+    QVERIFY(!received);
+}
+
+QTEST_MAIN(ReportGeneratorTests)
@@ -0,0 +1,144 @@
+/*
+  ReportHtmlWriterTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportHtmlWriterTests.h"
+
+#include "Charm/Reports/ReportHtmlWriter.h"
+
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextTable>
+#include <QtTest/QtTest>
+
+void ReportHtmlWriterTests::testReportStructure()
+{
+    ReportHtmlWriter html;
+    html.startReport(QStringLiteral("Title"));
+    html.writeTextElement(QStringLiteral("h3"), QStringLiteral("Subtitle"));
+    html.writeNavigationLinks(QStringLiteral("Back"), QStringLiteral("Forward"));
+    const QString result = html.endReport();
+
+    QVERIFY(result.startsWith(QLatin1String("<!DOCTYPE html>")));
+    QVERIFY(result.contains(QLatin1String("<body><h1>Title</h1><h3>Subtitle</h3>")));
+    QVERIFY(result.contains(QLatin1String("<a href=\"Previous\">Back</a>")));
+    QVERIFY(result.contains(QLatin1String("<a href=\"Next\">Forward</a>")));
+    // all elements are closed:
+    QVERIFY(result.endsWith(QLatin1String("</body></html>")));
+}
+
+void ReportHtmlWriterTests::testTextIsEscaped()
+{
+    ReportHtmlWriter html;
+    html.startReport(QStringLiteral("<Previous Week>"));
+    html.startElement(QStringLiteral("p"));
+    html.writeAttribute(QStringLiteral("title"), QStringLiteral("\"quoted\" & <tagged>"));
+    html.writeText(QStringLiteral("a < b && c > d"));
+    const QString result = html.endReport();
+    QVERIFY(result.contains(QLatin1String("<h1>&lt;Previous Week&gt;</h1>")));
+    QVERIFY(result.contains(QLatin1String("&quot;quoted&quot; &amp; &lt;tagged&gt;")));
+
+    QTextDocument document;
+    document.setHtml(result);
+    QCOMPARE(document.toPlainText(), QStringLiteral("<Previous Week>\na < b && c > d"));
+}
+
+void ReportHtmlWriterTests::testTableLayout()
+{
+    ReportHtmlWriter html;
+    html.startReport(QStringLiteral("Table"));
+    html.startTable();
+    html.startRow(QStringLiteral("header_row"));
+    html.writeHeaderCell(QStringLiteral("Task"));
+    html.writeHeaderCell(QStringLiteral("Total"));
+    html.endElement();
+    for (int i = 0; i < 3; ++i) {
+        html.startRow(i % 2 ? QStringLiteral("alternate_row") : QString());
+        html.writeCell(QStringLiteral("Task %1").arg(i), QStringLiteral("left"));
+        html.writeCell(QString::number(i));
+        html.endElement();
+    }
+    const QString result = html.endReport();
+    QVERIFY(result.contains(QLatin1String("<tr class=\"header_row\"><th>Task</th><th>Total</th></tr>")));
+    QVERIFY(result.contains(QLatin1String("<tr><td align=\"left\">Task 0</td><td>0</td></tr>")));
+    QVERIFY(result.contains(QLatin1String("<tr class=\"alternate_row\">")));
+
+    QTextDocument document;
+    document.setHtml(result);
+    QTextCursor cursor(&document);
+    cursor.movePosition(QTextCursor::NextBlock);
+    QTextTable *table = cursor.currentTable();
+    QVERIFY(table);
+    QCOMPARE(table->rows(), 4);
+    QCOMPARE(table->columns(), 2);
+    QCOMPARE(table->cellAt(3, 0).firstCursorPosition().block().text(), QStringLiteral("Task 2"));
+}
+
+void ReportHtmlWriterTests::testTableHeader()
+{
+    // the rows of the table header are the header rows of the document table:
+    ReportHtmlWriter html;
+    html.startReport(QStringLiteral("Table"));
+    html.startTable();
+    html.startTableHeader();
+    for (int i = 0; i < 2; ++i) {
+        html.startRow(QStringLiteral("header_row"));
+        html.writeHeaderCell(QStringLiteral("Header %1").arg(i));
+        html.endElement();
+    }
+    html.endElement();
+    html.startRow();
+    html.writeCell(QStringLiteral("Row"));
+    html.endElement();
+    const QString result = html.endReport();
+    QVERIFY(result.contains(QLatin1String("<thead><tr class=\"header_row\">")));
+
+    QTextDocument document;
+    document.setHtml(result);
+    QTextCursor cursor(&document);
+    cursor.movePosition(QTextCursor::NextBlock);
+    QTextTable *table = cursor.currentTable();
+    QVERIFY(table);
+    QCOMPARE(table->rows(), 3);
+    QCOMPARE(table->format().headerRowCount(), 2);
+}
+
+void ReportHtmlWriterTests::writeReportBenchmark()
+{
+    // the size of a yearly report with a hundred tasks:
+    const int rows = 100;
+    const int columns = 14;
+    QBENCHMARK {
+        ReportHtmlWriter html(2048 + 100 * rows * columns);
+        html.startReport(QStringLiteral("Benchmark"));
+        html.startTable();
+        for (int row = 0; row < rows; ++row) {
+            html.startRow(row % 2 ? QStringLiteral("alternate_row") : QString());
+            for (int column = 0; column < columns; ++column)
+                html.writeCell(QStringLiteral("%1:%2").arg(row).arg(column),
+                               QStringLiteral("center"));
+            html.endElement();
+        }
+        QTextDocument document;
+        document.setHtml(html.endReport());
+    }
+}
+
+QTEST_MAIN(ReportHtmlWriterTests)
@@ -0,0 +1,102 @@
+/*
+  ReportPagesTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ReportPagesTests.h"
+
+#include "Charm/Reports/ReportPages.h"
+
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextFrame>
+#include <QTextTable>
+#include <QtTest/QtTest>
+
+namespace {
+QString tableHtml(const QString &name, int rows)
+{
+    QString html = QStringLiteral("<table><thead><tr><th>%1</th></tr></thead><tbody>").arg(name);
+    for (int row = 0; row < rows; ++row)
+        html += QStringLiteral("<tr><td>%1 %2</td></tr>").arg(name).arg(row);
+    return html + QStringLiteral("</tbody></table>");
+}
+
+QSharedPointer<QTextDocument> makeDocument(const QString &html)
+{
+    QSharedPointer<QTextDocument> document(new QTextDocument);
+    document->setHtml(QStringLiteral("<html><body><h3>Report</h3>%1</body></html>").arg(html));
+    return document;
+}
+
+QTextTable *table(const QSharedPointer<QTextDocument> &document, int index)
+{
+    return qobject_cast<QTextTable *>(document->rootFrame()->childFrames().value(index));
+}
+
+QString cellText(QTextTable *table, int row)
+{
+    return table->cellAt(row, 0).firstCursorPosition().block().text();
+}
+}
+
+void ReportPagesTests::testShortReportIsOnePage()
+{
+    const QSharedPointer<QTextDocument> document
+        = makeDocument(tableHtml(QStringLiteral("Row"), 10));
+    const ReportPages pages(document, 10);
+    QCOMPARE(pages.pageCount(), 1);
+    QCOMPARE(pages.page(0), document);
+
+    QCOMPARE(ReportPages().pageCount(), 1);
+}
+
+void ReportPagesTests::testLongestTableIsSplit()
+{
+    const QSharedPointer<QTextDocument> document
+        = makeDocument(tableHtml(QStringLiteral("Total"), 3)
+                       + tableHtml(QStringLiteral("Row"), 25));
+    const ReportPages pages(document, 10);
+    QCOMPARE(pages.pageCount(), 3);
+    QCOMPARE(pages.document(), document);
+
+    for (int index = 0; index < pages.pageCount(); ++index) {
+        const QSharedPointer<QTextDocument> page = pages.page(index);
+        QVERIFY(page != document);
+        const QString text = page->toPlainText();
+        // the rest of the report is on every page:
+        QVERIFY(text.contains(QStringLiteral("Report")));
+        QCOMPARE(table(page, 0)->rows(), 4);
+        QVERIFY(text.contains(QStringLiteral("Total 2")));
+        // the header of the split table, and its rows of the page:
+        const int rows = index < 2 ? 10 : 5;
+        QCOMPARE(table(page, 1)->rows(), 1 + rows);
+        QCOMPARE(cellText(table(page, 1), 0), QStringLiteral("Row"));
+        QCOMPARE(cellText(table(page, 1), 1), QStringLiteral("Row %1").arg(10 * index));
+        QCOMPARE(cellText(table(page, 1), rows),
+                 QStringLiteral("Row %1").arg(10 * index + rows - 1));
+    }
+
+    // the complete document is kept, and the pages are copied from it once:
+    QCOMPARE(table(document, 1)->rows(), 26);
+    QCOMPARE(pages.page(1), pages.page(1));
+}
+
+QTEST_MAIN(ReportPagesTests)
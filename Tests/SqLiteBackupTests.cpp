@@ -0,0 +1,144 @@
+/*
+  SqLiteBackupTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SqLiteBackupTests.h"
+
+#include "Core/SqLiteBackup.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QtTest/QtTest>
+
+namespace {
+const QString SourceConnection = QStringLiteral("SqLiteBackupTests.source");
+const QString CheckConnection = QStringLiteral("SqLiteBackupTests.check");
+const int Rows = 1000;
+}
+
+void SqLiteBackupTests::initTestCase()
+{
+    QVERIFY(m_directory.isValid());
+    m_databaseFile = m_directory.filePath(QStringLiteral("charm.db"));
+
+    QSqlDatabase database = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), SourceConnection);
+    database.setDatabaseName(m_databaseFile);
+    QVERIFY(database.open());
+    QSqlQuery query(database);
+    QVERIFY(query.exec(QStringLiteral("CREATE TABLE Events (id INTEGER PRIMARY KEY, comment varchar(256));")));
+    QVERIFY(database.transaction());
+    query.prepare(QStringLiteral("INSERT INTO Events (comment) VALUES (:comment);"));
+    for (int i = 0; i < Rows; ++i) {
+        query.bindValue(QStringLiteral(":comment"), QStringLiteral("Event %1").arg(i));
+        QVERIFY(query.exec());
+    }
+    QVERIFY(database.commit());
+}
+
+void SqLiteBackupTests::testBackupOfDatabaseInUse()
+{
+    // keep a write transaction open while the backup runs, its changes must not be copied:
+    QSqlDatabase database = QSqlDatabase::database(SourceConnection);
+    QVERIFY(database.transaction());
+    QSqlQuery query(database);
+    QVERIFY(query.exec(QStringLiteral("INSERT INTO Events (comment) VALUES ('uncommitted');")));
+
+    const QString target = m_directory.filePath(QStringLiteral("backup.db"));
+    SqLiteBackup backup(m_databaseFile, target);
+    backup.setPagesPerStep(1);
+    backup.setStepInterval(0);
+    QVERIFY2(backup.copy(), qPrintable(backup.errorString()));
+    QVERIFY(database.rollback());
+
+    QVERIFY(QFile::exists(target));
+    QVERIFY(!QFile::exists(target + QStringLiteral(".part")));
+    QCOMPARE(rowCount(target), Rows);
+}
+
+void SqLiteBackupTests::testBackgroundBackup()
+{
+    const QString target = m_directory.filePath(QStringLiteral("background.db"));
+    SqLiteBackup backup(m_databaseFile, target);
+    backup.setPagesPerStep(2);
+    QSignalSpy progressSpy(&backup, SIGNAL(progress(int,int)));
+    QSignalSpy completedSpy(&backup, SIGNAL(completed(bool)));
+    backup.start();
+    QVERIFY(completedSpy.wait(10000));
+    QCOMPARE(completedSpy.first().first().toBool(), true);
+    QVERIFY(!progressSpy.isEmpty());
+    QCOMPARE(rowCount(target), Rows);
+}
+
+void SqLiteBackupTests::testFailedBackupKeepsTarget()
+{
+    const QString target = m_directory.filePath(QStringLiteral("kept.db"));
+    SqLiteBackup backup(m_databaseFile, target);
+    QVERIFY(backup.copy());
+
+    SqLiteBackup failing(m_directory.filePath(QStringLiteral("missing.db")), target);
+    QVERIFY(!failing.copy());
+    QVERIFY(!failing.errorString().isEmpty());
+    QCOMPARE(rowCount(target), Rows);
+}
+
+void SqLiteBackupTests::testRemoveOldSnapshots()
+{
+    const QDateTime start(QDate(2019, 1, 1), QTime(12, 0));
+    QVERIFY(!SqLiteBackup::lastSnapshotTime(m_databaseFile).isValid());
+    for (int i = 0; i < 5; ++i) {
+        const QString snapshot = SqLiteBackup::snapshotFileName(m_databaseFile, start.addDays(i));
+        SqLiteBackup backup(m_databaseFile, snapshot);
+        QVERIFY(backup.copy());
+    }
+    QCOMPARE(SqLiteBackup::snapshots(m_databaseFile).size(), 5);
+    QCOMPARE(SqLiteBackup::lastSnapshotTime(m_databaseFile), start.addDays(4));
+    QCOMPARE(SqLiteBackup::removeOldSnapshots(m_databaseFile, 2), 3);
+    for (int i = 0; i < 5; ++i) {
+        const QString snapshot = SqLiteBackup::snapshotFileName(m_databaseFile, start.addDays(i));
+        QCOMPARE(QFile::exists(snapshot), i >= 3);
+    }
+    QVERIFY(QFile::exists(m_databaseFile));
+}
+
+void SqLiteBackupTests::cleanupTestCase()
+{
+    QSqlDatabase::database(SourceConnection).close();
+    QSqlDatabase::removeDatabase(SourceConnection);
+}
+
+int SqLiteBackupTests::rowCount(const QString &databaseFile)
+{
+    int count = -1;
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), CheckConnection);
+        database.setDatabaseName(databaseFile);
+        if (database.open()) {
+            QSqlQuery query(database);
+            if (query.exec(QStringLiteral("SELECT COUNT(*) FROM Events;")) && query.next())
+                count = query.value(0).toInt();
+        }
+    }
+    QSqlDatabase::removeDatabase(CheckConnection);
+    return count;
+}
+
+QTEST_MAIN(SqLiteBackupTests)
@@ -0,0 +1,47 @@
+/*
+  SqLiteBackupTests.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SQLITEBACKUPTESTS_H
+#define SQLITEBACKUPTESTS_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+class SqLiteBackupTests : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void testBackupOfDatabaseInUse();
+    void testBackgroundBackup();
+    void testFailedBackupKeepsTarget();
+    void testRemoveOldSnapshots();
+    void cleanupTestCase();
+
+private:
+    int rowCount(const QString &databaseFile);
+
+    QTemporaryDir m_directory;
+    QString m_databaseFile;
+};
+
+#endif
@@ -0,0 +1,461 @@
+/*
+  SqLiteStorageBenchmarks.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SqLiteStorageBenchmarks.h"
+
+#include "Core/Configuration.h"
+#include "Core/Controller.h"
+#include "Core/EventLog.h"
+#include "Core/GzipDevice.h"
+#include "Core/SqlStorage.h"
+
+#include <QBuffer>
+#include <QDomDocument>
+#include <QFile>
+#include <QtTest/QtTest>
+
+namespace {
+const int TaskCount = 2000;
+// the length of the parent chains in the synthetic task tree:
+const int TaskTreeDepth = 20;
+const int DefaultSizes[] = { 10000, 100000, 1000000 };
+const QString EventLogFile = QStringLiteral("./SqLiteStorageBenchmarksEvents.log");
+
+QByteArray sizeTag(int size)
+{
+    if (size % 1000000 == 0)
+        return QByteArray::number(size / 1000000) + 'M';
+    if (size % 1000 == 0)
+        return QByteArray::number(size / 1000) + 'k';
+    return QByteArray::number(size);
+}
+}
+
+SqLiteStorageBenchmarks::SqLiteStorageBenchmarks()
+    : TestApplication(QStringLiteral("./SqLiteStorageBenchmarksDatabase.db"))
+{
+}
+
+void SqLiteStorageBenchmarks::initTestCase()
+{
+    const QByteArray sizes = qgetenv("CHARM_BENCHMARK_EVENTS");
+    if (sizes.isEmpty()) {
+        for (int size : DefaultSizes)
+            m_sizes << size;
+    } else {
+        Q_FOREACH (const QByteArray &size, sizes.split(',')) {
+            bool ok;
+            m_sizes << size.trimmed().toInt(&ok);
+            QVERIFY2(ok && m_sizes.last() > 0, "CHARM_BENCHMARK_EVENTS has to be a comma separated list of event counts");
+        }
+    }
+    initialize();
+}
+
+void SqLiteStorageBenchmarks::getAllEventsBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::getAllEventsBenchmark()
+{
+    QFETCH(int, events);
+    populate(events);
+    QBENCHMARK {
+        const EventList result = controller()->storage()->getAllEvents();
+        QCOMPARE(result.size(), events);
+    }
+}
+
+void SqLiteStorageBenchmarks::getAllTasksBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::getAllTasksBenchmark()
+{
+    QFETCH(int, events);
+    populate(events);
+    QBENCHMARK {
+        const TaskList result = controller()->storage()->getAllTasks();
+        QCOMPARE(result.size(), TaskCount);
+    }
+}
+
+void SqLiteStorageBenchmarks::makeEventBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::makeEventBenchmark()
+{
+    QFETCH(int, events);
+    populate(events);
+    QBENCHMARK {
+        QVERIFY(controller()->storage()->makeEvent().isValid());
+    }
+    // the database contains additional events now:
+    m_populatedSize = -1;
+}
+
+void SqLiteStorageBenchmarks::modifyEventBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::modifyEventBenchmark()
+{
+    QFETCH(int, events);
+    populate(events);
+    // the storage assigns new ids when populating the database:
+    Event event = controller()->storage()->getAllEvents().at(events / 2);
+    QVERIFY(event.isValid());
+    int counter = 0;
+    QBENCHMARK {
+        event.setComment(QStringLiteral("Modified %1").arg(++counter));
+        QVERIFY(controller()->storage()->modifyEvent(event));
+    }
+}
+
+void SqLiteStorageBenchmarks::setAllTasksBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::setAllTasksBenchmark()
+{
+    QFETCH(int, events);
+    populate(events);
+    // alternate between two task lists that differ in every tenth task:
+    TaskList taskLists[2] = { syntheticTasks(), syntheticTasks() };
+    for (int i = 0; i < taskLists[1].size(); i += 10)
+        taskLists[1][i].setName(taskLists[1][i].name() + QStringLiteral(" (renamed)"));
+    int current = 0;
+    QBENCHMARK {
+        current = 1 - current;
+        QVERIFY(controller()->storage()->setAllTasks(configuration()->user, taskLists[current]));
+    }
+}
+
+void SqLiteStorageBenchmarks::setAllTasksAndEventsBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::setAllTasksAndEventsBenchmark()
+{
+    QFETCH(int, events);
+    const TaskList tasks = syntheticTasks();
+    const EventList eventList = syntheticEvents(tasks, events);
+    QBENCHMARK_ONCE {
+        QVERIFY(controller()->storage()->setAllTasksAndEvents(configuration()->user, tasks,
+                                                              eventList).isEmpty());
+    }
+    m_populatedSize = events;
+}
+
+void SqLiteStorageBenchmarks::exportToXmlBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::exportToXmlBenchmark()
+{
+    QFETCH(int, events);
+    populate(events);
+    QBENCHMARK_ONCE {
+        const QByteArray data = controller()->exportDatabasetoXml().toByteArray(4);
+        QVERIFY(!data.isEmpty());
+    }
+}
+
+void SqLiteStorageBenchmarks::streamingExportToXmlBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::streamingExportToXmlBenchmark()
+{
+    QFETCH(int, events);
+    populate(events);
+    QBENCHMARK_ONCE {
+        QBuffer buffer;
+        QVERIFY(buffer.open(QIODevice::WriteOnly));
+        QVERIFY(controller()->exportDatabaseToXml(&buffer).isEmpty());
+        QVERIFY(!buffer.data().isEmpty());
+    }
+}
+
+void SqLiteStorageBenchmarks::importFromXmlBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::importFromXmlBenchmark()
+{
+    QFETCH(int, events);
+    populate(events);
+    const QByteArray data = controller()->exportDatabasetoXml().toByteArray(4);
+    QBENCHMARK_ONCE {
+        QDomDocument document;
+        QVERIFY(document.setContent(data));
+        QVERIFY(controller()->importDatabaseFromXml(document).isEmpty());
+    }
+    QCOMPARE(controller()->storage()->getAllEvents().size(), events);
+}
+
+void SqLiteStorageBenchmarks::streamingImportFromXmlBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::streamingImportFromXmlBenchmark()
+{
+    QFETCH(int, events);
+    populate(events);
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadWrite));
+    QVERIFY(controller()->exportDatabaseToXml(&buffer).isEmpty());
+    buffer.seek(0);
+    QBENCHMARK_ONCE {
+        QVERIFY(controller()->importDatabaseFromXml(&buffer).isEmpty());
+    }
+    QCOMPARE(controller()->storage()->getAllEvents().size(), events);
+}
+
+void SqLiteStorageBenchmarks::compressedExportToXmlBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::compressedExportToXmlBenchmark()
+{
+    if (!GzipDevice::isCompressionSupported())
+        QSKIP("This build does not support compression");
+    QFETCH(int, events);
+    populate(events);
+    QBuffer plain;
+    QVERIFY(plain.open(QIODevice::WriteOnly));
+    QVERIFY(controller()->exportDatabaseToXml(&plain).isEmpty());
+    QBuffer buffer;
+    QBENCHMARK_ONCE {
+        QVERIFY(buffer.open(QIODevice::WriteOnly));
+        GzipDevice device(&buffer, GzipDevice::GzipCompression);
+        QVERIFY(device.open(QIODevice::WriteOnly));
+        QVERIFY(controller()->exportDatabaseToXml(&device).isEmpty());
+        device.close();
+    }
+    qDebug("%d events: XML export %lld bytes, compressed %lld bytes (%.1f%%)", events,
+           plain.size(), buffer.size(), 100.0 * buffer.size() / plain.size());
+}
+
+void SqLiteStorageBenchmarks::compressedImportFromXmlBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::compressedImportFromXmlBenchmark()
+{
+    if (!GzipDevice::isCompressionSupported())
+        QSKIP("This build does not support compression");
+    QFETCH(int, events);
+    populate(events);
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    {
+        GzipDevice device(&buffer, GzipDevice::GzipCompression);
+        QVERIFY(device.open(QIODevice::WriteOnly));
+        QVERIFY(controller()->exportDatabaseToXml(&device).isEmpty());
+    }
+    buffer.close();
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    QBENCHMARK_ONCE {
+        GzipDevice device(&buffer);
+        QVERIFY(device.open(QIODevice::ReadOnly));
+        QVERIFY(controller()->importDatabaseFromXml(&device).isEmpty());
+    }
+    QCOMPARE(controller()->storage()->getAllEvents().size(), events);
+}
+
+void SqLiteStorageBenchmarks::exportToBinaryBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::exportToBinaryBenchmark()
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 12, 0)
+    QSKIP("The binary export format requires Qt 5.12");
+#endif
+    QFETCH(int, events);
+    populate(events);
+    QBENCHMARK_ONCE {
+        QBuffer buffer;
+        QVERIFY(buffer.open(QIODevice::WriteOnly));
+        QVERIFY(controller()->exportDatabaseToBinary(&buffer).isEmpty());
+        QVERIFY(!buffer.data().isEmpty());
+    }
+}
+
+void SqLiteStorageBenchmarks::importFromBinaryBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::importFromBinaryBenchmark()
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 12, 0)
+    QSKIP("The binary export format requires Qt 5.12");
+#endif
+    QFETCH(int, events);
+    populate(events);
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadWrite));
+    QVERIFY(controller()->exportDatabaseToBinary(&buffer).isEmpty());
+    buffer.seek(0);
+    QBENCHMARK_ONCE {
+        QVERIFY(controller()->importDatabaseFromBinary(&buffer).isEmpty());
+    }
+    QCOMPARE(controller()->storage()->getAllEvents().size(), events);
+}
+
+void SqLiteStorageBenchmarks::eventLogStartupBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::eventLogStartupBenchmark()
+{
+    QFETCH(int, events);
+    populateEventLog(events);
+    QBENCHMARK {
+        EventLog log(EventLogFile);
+        QVERIFY(log.open());
+        QCOMPARE(log.getAllEvents().size(), events);
+    }
+}
+
+void SqLiteStorageBenchmarks::eventLogMakeEventBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::eventLogMakeEventBenchmark()
+{
+    QFETCH(int, events);
+    populateEventLog(events);
+    EventLog log(EventLogFile);
+    QVERIFY(log.open());
+    QBENCHMARK {
+        QVERIFY(log.makeEvent().isValid());
+    }
+    // the log contains additional events now:
+    m_populatedEventLogSize = -1;
+}
+
+void SqLiteStorageBenchmarks::eventLogModifyEventBenchmark_data()
+{
+    addSizes();
+}
+
+void SqLiteStorageBenchmarks::eventLogModifyEventBenchmark()
+{
+    QFETCH(int, events);
+    populateEventLog(events);
+    EventLog log(EventLogFile);
+    QVERIFY(log.open());
+    Event event = log.getAllEvents().at(events / 2);
+    int counter = 0;
+    QBENCHMARK {
+        event.setComment(QStringLiteral("Modified %1").arg(++counter));
+        QVERIFY(log.modifyEvent(event));
+    }
+}
+
+void SqLiteStorageBenchmarks::cleanupTestCase()
+{
+    destroy();
+    QFile::remove(EventLogFile);
+}
+
+void SqLiteStorageBenchmarks::addSizes()
+{
+    QTest::addColumn<int>("events");
+    Q_FOREACH (int size, m_sizes)
+        QTest::newRow(sizeTag(size).constData()) << size;
+}
+
+void SqLiteStorageBenchmarks::populate(int eventCount)
+{
+    if (m_populatedSize == eventCount)
+        return;
+    const TaskList tasks = syntheticTasks();
+    const QString error = controller()->storage()->setAllTasksAndEvents(
+        configuration()->user, tasks, syntheticEvents(tasks, eventCount));
+    QVERIFY2(error.isEmpty(), qPrintable(error));
+    m_populatedSize = eventCount;
+}
+
+void SqLiteStorageBenchmarks::populateEventLog(int eventCount)
+{
+    if (m_populatedEventLogSize == eventCount)
+        return;
+    EventLog log(EventLogFile);
+    QVERIFY2(log.open(), qPrintable(log.errorString()));
+    QVERIFY2(log.setAllEvents(syntheticEvents(syntheticTasks(), eventCount)),
+             qPrintable(log.errorString()));
+    m_populatedEventLogSize = eventCount;
+}
+
+TaskList SqLiteStorageBenchmarks::syntheticTasks() const
+{
+    TaskList tasks;
+    tasks.reserve(TaskCount);
+    for (int i = 0; i < TaskCount; ++i) {
+        const TaskId id = 1000 + i;
+        // every task but the first of each chain is a child of the previous one:
+        const TaskId parent = i % TaskTreeDepth == 0 ? 0 : id - 1;
+        Task task(id, QStringLiteral("Task %1").arg(id), parent);
+        task.setSubscribed(i % 7 == 0);
+        tasks << task;
+    }
+    return tasks;
+}
+
+EventList SqLiteStorageBenchmarks::syntheticEvents(const TaskList &tasks, int eventCount) const
+{
+    EventList events;
+    events.reserve(eventCount);
+    const QDateTime start(QDate(2010, 1, 1), QTime(8, 0));
+    for (int i = 0; i < eventCount; ++i) {
+        Event event;
+        event.setId(i + 1);
+        event.setUserId(testUserId());
+        event.setTaskId(tasks[i % tasks.size()].id());
+        event.setComment(QStringLiteral("Event %1").arg(i));
+        event.setStartDateTime(start.addSecs(900 * i));
+        event.setEndDateTime(start.addSecs(900 * i + 600));
+        events << event;
+    }
+    return events;
+}
+
+QTEST_MAIN(SqLiteStorageBenchmarks)
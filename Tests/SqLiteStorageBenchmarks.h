@@ -0,0 +1,114 @@
+/*
+  SqLiteStorageBenchmarks.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SQLITESTORAGEBENCHMARKS_H
+#define SQLITESTORAGEBENCHMARKS_H
+
+#include "TestApplication.h"
+
+#include "Core/Event.h"
+#include "Core/Task.h"
+
+/** Benchmarks of the storage layer on synthetic databases, and of the event log
+    for comparison.
+    By default, every benchmark runs on databases with 10k, 100k and 1M events, the
+    environment variable CHARM_BENCHMARK_EVENTS selects other sizes (e.g. "10000,50000").
+    Use the QtTest output options for machine readable results, e.g.
+    "SqLiteStorageBenchmarks -o results.xml,xml" or "SqLiteStorageBenchmarks -csv". */
+class SqLiteStorageBenchmarks : public TestApplication
+{
+    Q_OBJECT
+
+public:
+    SqLiteStorageBenchmarks();
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void getAllEventsBenchmark_data();
+    void getAllEventsBenchmark();
+
+    void getAllTasksBenchmark_data();
+    void getAllTasksBenchmark();
+
+    void makeEventBenchmark_data();
+    void makeEventBenchmark();
+
+    void modifyEventBenchmark_data();
+    void modifyEventBenchmark();
+
+    void setAllTasksBenchmark_data();
+    void setAllTasksBenchmark();
+
+    void setAllTasksAndEventsBenchmark_data();
+    void setAllTasksAndEventsBenchmark();
+
+    void exportToXmlBenchmark_data();
+    void exportToXmlBenchmark();
+
+    void streamingExportToXmlBenchmark_data();
+    void streamingExportToXmlBenchmark();
+
+    void importFromXmlBenchmark_data();
+    void importFromXmlBenchmark();
+
+    void streamingImportFromXmlBenchmark_data();
+    void streamingImportFromXmlBenchmark();
+
+    void compressedExportToXmlBenchmark_data();
+    void compressedExportToXmlBenchmark();
+
+    void compressedImportFromXmlBenchmark_data();
+    void compressedImportFromXmlBenchmark();
+
+    void exportToBinaryBenchmark_data();
+    void exportToBinaryBenchmark();
+
+    void importFromBinaryBenchmark_data();
+    void importFromBinaryBenchmark();
+
+    // the same operations on the append-only event log, for comparison:
+    void eventLogStartupBenchmark_data();
+    void eventLogStartupBenchmark();
+
+    void eventLogMakeEventBenchmark_data();
+    void eventLogMakeEventBenchmark();
+
+    void eventLogModifyEventBenchmark_data();
+    void eventLogModifyEventBenchmark();
+
+    void cleanupTestCase();
+
+private:
+    void addSizes();
+    // fills the database with the synthetic tasks and @p eventCount events:
+    void populate(int eventCount);
+    // writes @p eventCount synthetic events into the event log file:
+    void populateEventLog(int eventCount);
+    TaskList syntheticTasks() const;
+    EventList syntheticEvents(const TaskList &tasks, int eventCount) const;
+
+    QList<int> m_sizes;
+    int m_populatedSize = -1;
+    int m_populatedEventLogSize = -1;
+};
+
+#endif
@@ -26,8 +26,10 @@
 #include "Core/User.h"
 #include "Core/CharmConstants.h"
 #include "Core/SqLiteStorage.h"
+#include "Core/SqlRaiiTransactor.h"
 
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
 #include <QDateTime>
 #include <QtTest/QtTest>
@@ -308,9 +310,245 @@ void SqLiteStorageTests::setGetMetaDataTest()
     QVERIFY(m_storage->getMetaData(Key2) == Value2);
 }
 
+void SqLiteStorageTests::setGetAllMetaDataTest()
+{
+    // depends on the keys stored in setGetMetaDataTest:
+    QHash<QString, QString> metaData;
+    metaData.insert(QStringLiteral("Key1"), QStringLiteral("Value1_2"));
+    metaData.insert(QStringLiteral("Key3"), QStringLiteral("Value3"));
+    QVERIFY(m_storage->setAllMetaData(metaData));
+
+    const QHash<QString, QString> allMetaData = m_storage->getAllMetaData();
+    QCOMPARE(allMetaData.value(QStringLiteral("Key1")), QStringLiteral("Value1_2"));
+    QCOMPARE(allMetaData.value(QStringLiteral("Key2")), QStringLiteral("Value2"));
+    QCOMPARE(allMetaData.value(QStringLiteral("Key3")), QStringLiteral("Value3"));
+    QCOMPARE(allMetaData.value(CHARM_DATABASE_VERSION_DESCRIPTOR),
+             QString::number(CHARM_DATABASE_VERSION));
+
+    // storing an unchanged value must not add the key a second time:
+    QVERIFY(m_storage->setMetaData(QStringLiteral("Key3"), QStringLiteral("Value3")));
+    QCOMPARE(m_storage->getAllMetaData().size(), allMetaData.size());
+}
+
+void SqLiteStorageTests::archiveEventsTest()
+{
+    QVERIFY(m_storage->deleteAllEvents());
+    QVERIFY(!m_storage->archiveCutoff().isValid());
+    Task task = m_storage->getAllTasks().first();
+
+    // two events before the cutoff, one after:
+    const QDateTime times[] = {
+        QDateTime(QDate(2010, 3, 1), QTime(9, 0), Qt::UTC),
+        QDateTime(QDate(2012, 3, 1), QTime(9, 0), Qt::UTC),
+        QDateTime(QDate(2016, 3, 1), QTime(9, 0), Qt::UTC)
+    };
+    for (const QDateTime &time : times) {
+        Event event = m_storage->makeEvent();
+        event.setTaskId(task.id());
+        event.setUserId(1);
+        event.setStartDateTime(time);
+        event.setEndDateTime(time.addSecs(3600));
+        QVERIFY(m_storage->modifyEvent(event));
+    }
+
+    const QDateTime cutoff(QDate(2014, 1, 1), QTime(0, 0), Qt::UTC);
+    QVERIFY(m_storage->archiveEvents(cutoff));
+    QCOMPARE(m_storage->archiveCutoff(), cutoff);
+    const EventList events = m_storage->getAllEvents();
+    QCOMPARE(events.size(), 1);
+    QCOMPARE(events.first().startDateTime(), times[2]);
+
+    // ranges crossing the cutoff include the archived events:
+    const EventList allEvents = m_storage->getEventsInRange(times[0], times[2].addDays(1));
+    QCOMPARE(allEvents.size(), 3);
+    for (int i = 0; i < 3; ++i)
+        QCOMPARE(allEvents[i].startDateTime(), times[i]);
+    const EventList archivedEvents = m_storage->getEventsInRange(times[1], cutoff);
+    QCOMPARE(archivedEvents.size(), 1);
+    QCOMPARE(archivedEvents.first().startDateTime(), times[1]);
+    QCOMPARE(m_storage->getEventsInRange(cutoff, times[2].addDays(1)).size(), 1);
+
+    // an earlier cutoff does not move the recorded cutoff back:
+    QVERIFY(m_storage->archiveEvents(cutoff.addYears(-1)));
+    QCOMPARE(m_storage->archiveCutoff(), cutoff);
+
+    // exports read the current and the archived events:
+    QCOMPARE(m_storage->getAllEvents(SqlStorage::AllEvents).size(), 3);
+    QCOMPARE(m_storage->getAllEvents(SqlStorage::ArchivedEvents).size(), 2);
+
+    // the ids of archived events are not reused, even after the newest event was archived:
+    const QDateTime laterCutoff(QDate(2017, 1, 1), QTime(0, 0), Qt::UTC);
+    QVERIFY(m_storage->archiveEvents(laterCutoff));
+    QVERIFY(m_storage->getAllEvents().isEmpty());
+    const Event newEvent = m_storage->makeEvent();
+    QVERIFY(newEvent.isValid());
+    QSet<int> ids;
+    Q_FOREACH (const Event &event, m_storage->getAllEvents(SqlStorage::AllEvents))
+        ids.insert(event.id());
+    QCOMPARE(ids.size(), 4);
+    QVERIFY(ids.contains(newEvent.id()));
+}
+
+void SqLiteStorageTests::changeTrackingTest()
+{
+    const qint64 start = m_storage->lastChange();
+    SqlStorage::ChangeSet changes;
+    QVERIFY(m_storage->getChangesSince(start, &changes));
+    QVERIFY(changes.tasks.isEmpty());
+    QVERIFY(changes.events.isEmpty());
+
+    Task task(4711, QStringLiteral("Changed-Task"));
+    QVERIFY(m_storage->addTask(task));
+    QVERIFY(m_storage->lastChange() > start);
+    Event event = m_storage->makeEvent();
+    event.setTaskId(task.id());
+    event.setUserId(1);
+    event.setComment(QStringLiteral("Changed-Event"));
+    QVERIFY(m_storage->modifyEvent(event));
+    Event deleted = m_storage->makeEvent();
+    QVERIFY(m_storage->deleteEvent(deleted));
+
+    QVERIFY(m_storage->getChangesSince(start, &changes));
+    QCOMPARE(changes.lastChange, m_storage->lastChange());
+    QCOMPARE(changes.tasks.size(), 1);
+    QCOMPARE(changes.tasks.first().name(), task.name());
+    QCOMPARE(changes.events.size(), 1);
+    QCOMPARE(changes.events.first().comment(), event.comment());
+    QCOMPARE(changes.deletedEvents, EventIdList() << deleted.id());
+    QVERIFY(changes.deletedTasks.isEmpty());
+
+    // deleting the task reports it, and its events, as deleted:
+    const qint64 beforeDelete = m_storage->lastChange();
+    QVERIFY(m_storage->deleteTask(task));
+    QVERIFY(m_storage->getChangesSince(beforeDelete, &changes));
+    QVERIFY(changes.tasks.isEmpty());
+    QVERIFY(changes.events.isEmpty());
+    QCOMPARE(changes.deletedTasks, TaskIdList() << task.id());
+    QCOMPARE(changes.deletedEvents, EventIdList() << event.id());
+
+    // nothing changed after the last change:
+    QVERIFY(m_storage->getChangesSince(m_storage->lastChange(), &changes));
+    QVERIFY(changes.tasks.isEmpty());
+    QVERIFY(changes.events.isEmpty());
+    QVERIFY(changes.deletedTasks.isEmpty());
+    QVERIFY(changes.deletedEvents.isEmpty());
+}
+
+void SqLiteStorageTests::setAllEventsTest()
+{
+    const Task task = m_storage->getAllTasks().first();
+    EventList events;
+    for (int id : { 100, 102 }) {
+        Event event;
+        event.setId(id);
+        event.setTaskId(task.id());
+        event.setUserId(1);
+        event.setComment(QStringLiteral("Restored-Event-%1").arg(id));
+        events << event;
+    }
+
+    // the events keep their ids, and are recorded as changed:
+    const qint64 start = m_storage->lastChange();
+    QVERIFY(m_storage->setAllEvents(events));
+    QCOMPARE(m_storage->getAllEvents().size(), 2);
+    QCOMPARE(m_storage->getEvent(102).comment(), events.last().comment());
+    SqlStorage::ChangeSet changes;
+    QVERIFY(m_storage->getChangesSince(start, &changes));
+    QCOMPARE(changes.events.size(), 2);
+    QVERIFY(!m_storage->archiveCutoff().isValid());
+
+    // new events continue after them:
+    QVERIFY(m_storage->makeEvent().id() > 102);
+}
+
+void SqLiteStorageTests::concurrentDeltasTest()
+{
+    const auto reconnect = [this](const QString &path) {
+        m_storage->disconnect();
+        delete m_storage;
+        m_storage = new SqLiteStorage;
+        m_configuration.localStorageDatabase = path;
+        return m_storage->connect(m_configuration);
+    };
+    const auto apply = [this](const SqlStorage::ChangeSet &changes) {
+        SqlRaiiTransactor transactor(m_storage->database());
+        return m_storage->applyChanges(m_configuration.user, changes, transactor)
+               && transactor.commit();
+    };
+    const auto makeEvent = [this](const QString &comment) {
+        Event event = m_storage->makeEvent();
+        event.setTaskId(m_storage->getAllTasks().first().id());
+        event.setUserId(1);
+        event.setComment(comment);
+        return m_storage->modifyEvent(event) ? event : Event();
+    };
+
+    // two copies of the database, both create an event after the watermark:
+    const qint64 watermark = m_storage->lastChange();
+    const QString copyPath = m_localPath + QStringLiteral("-copy");
+    QFile::remove(copyPath);
+    m_storage->disconnect();
+    QVERIFY(QFile::copy(m_localPath, copyPath));
+    QVERIFY(reconnect(m_localPath));
+    const quint32 installationId = CONFIGURATION.installationId;
+    CONFIGURATION.installationId = 1001;
+    const Event eventA = makeEvent(QStringLiteral("Event-A"));
+    QVERIFY(eventA.isValid());
+    SqlStorage::ChangeSet changesA;
+    QVERIFY(m_storage->getChangesSince(watermark, &changesA));
+    QCOMPARE(changesA.eventInstallations, QList<quint32>() << 1001);
+
+    QVERIFY(reconnect(copyPath));
+    CONFIGURATION.installationId = 1002;
+    const Event eventB = makeEvent(QStringLiteral("Event-B"));
+    QCOMPARE(eventB.id(), eventA.id());
+    const int eventCount = m_storage->getAllEvents().size();
+
+    // the event of the other copy is added with a new id, and does not replace the local one:
+    const qint64 beforeApply = m_storage->lastChange();
+    QVERIFY(apply(changesA));
+    QCOMPARE(m_storage->getEvent(eventB.id()).comment(), eventB.comment());
+    QCOMPARE(m_storage->getAllEvents().size(), eventCount + 1);
+    QVERIFY(apply(changesA));
+    QCOMPARE(m_storage->getAllEvents().size(), eventCount + 1);
+
+    // the delta of the copy names the added event by its origin:
+    SqlStorage::ChangeSet changesB;
+    QVERIFY(m_storage->getChangesSince(beforeApply, &changesB));
+    QCOMPARE(changesB.events.size(), 1);
+    QCOMPARE(changesB.events.first().id(), eventA.id());
+    QCOMPARE(changesB.events.first().comment(), eventA.comment());
+    QCOMPARE(changesB.eventInstallations, QList<quint32>() << 1001);
+    QVERIFY(m_storage->getChangesSince(watermark, &changesB));
+    QCOMPARE(changesB.events.size(), 2);
+
+    // applying it to the first copy adds the event of the second one only:
+    QVERIFY(reconnect(m_localPath));
+    const int eventCountA = m_storage->getAllEvents().size();
+    QVERIFY(apply(changesB));
+    QCOMPARE(m_storage->getAllEvents().size(), eventCountA + 1);
+    QCOMPARE(m_storage->getEvent(eventA.id()).comment(), eventA.comment());
+
+    // deletions are matched by the origin as well:
+    QVERIFY(m_storage->deleteEvent(eventA));
+    SqlStorage::ChangeSet deletion;
+    QVERIFY(m_storage->getChangesSince(m_storage->lastChange() - 1, &deletion));
+    QCOMPARE(deletion.deletedEvents, EventIdList() << eventA.id());
+    QCOMPARE(deletion.deletedEventInstallations, QList<quint32>() << 1001);
+    QVERIFY(reconnect(copyPath));
+    QVERIFY(apply(deletion));
+    QCOMPARE(m_storage->getEvent(eventB.id()).comment(), eventB.comment());
+    QCOMPARE(m_storage->getAllEvents().size(), eventCount);
+
+    CONFIGURATION.installationId = installationId;
+    QVERIFY(reconnect(m_localPath));
+    QVERIFY(QFile::remove(copyPath));
+}
+
 void SqLiteStorageTests::cleanupTestCase()
 {
     m_storage->disconnect();
+    QFile::remove(QFileInfo(m_localPath).absoluteFilePath() + QStringLiteral("-archive"));
     if (QDir::home().exists(m_localPath)) {
         bool result = QDir::home().remove(m_localPath);
         QVERIFY(result);
@@ -56,8 +56,18 @@ private Q_SLOTS:
 
     void setGetMetaDataTest();
 
+    void setGetAllMetaDataTest();
+
     void deleteTaskWithEventsTest();
 
+    void archiveEventsTest();
+
+    void changeTrackingTest();
+
+    void setAllEventsTest();
+
+    void concurrentDeltasTest();
+
     void cleanupTestCase();
 };
 
@@ -0,0 +1,93 @@
+/*
+  StorageThreadTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "StorageThreadTests.h"
+
+#include "Core/CharmExceptions.h"
+#include "Core/StorageThread.h"
+
+#include <QtTest/QtTest>
+
+void StorageThreadTests::testRunBlockingExecutesInStorageThread()
+{
+    StorageThread thread;
+    thread.start();
+    QThread *executingThread = nullptr;
+    thread.runBlocking([&]() {
+        executingThread = QThread::currentThread();
+    });
+    QCOMPARE(executingThread, static_cast<QThread *>(&thread));
+    thread.shutdown();
+    QVERIFY(thread.isFinished());
+}
+
+void StorageThreadTests::testQueuedCallsKeepTheirOrder()
+{
+    StorageThread thread;
+    QObject receiver;
+    thread.adopt(&receiver);
+    thread.start();
+
+    // the list is only modified in the storage thread:
+    QList<int> order;
+    connect(&receiver, &QObject::objectNameChanged, &receiver, [&order](const QString &name) {
+        order << name.toInt();
+    }, Qt::QueuedConnection);
+    for (int i = 0; i < 100; ++i) {
+        receiver.setObjectName(QString::number(2 * i));
+        thread.runBlocking([&order, i]() {
+            order << 2 * i + 1;
+        });
+    }
+    QCOMPARE(order.size(), 200);
+    for (int i = 0; i < order.size(); ++i)
+        QCOMPARE(order[i], i);
+    thread.shutdown();
+}
+
+void StorageThreadTests::testExceptionsArePropagated()
+{
+    StorageThread thread;
+    thread.start();
+    QVERIFY_EXCEPTION_THROWN(thread.runBlocking([]() {
+        throw TransactionException(QStringLiteral("storage failure"));
+    }), TransactionException);
+    // the thread keeps processing requests afterwards:
+    bool executed = false;
+    thread.runBlocking([&]() {
+        executed = true;
+    });
+    QVERIFY(executed);
+}
+
+void StorageThreadTests::testShutdownReturnsAdoptedObject()
+{
+    auto thread = new StorageThread;
+    QObject object;
+    thread->adopt(&object);
+    QCOMPARE(object.thread(), static_cast<QThread *>(thread));
+    thread->start();
+    thread->shutdown();
+    QCOMPARE(object.thread(), QThread::currentThread());
+    delete thread;
+}
+
+QTEST_MAIN(StorageThreadTests)
@@ -0,0 +1,115 @@
+/*
+  TaskFilterTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TaskFilterTests.h"
+
+#include "Core/CharmDataModel.h"
+#include "Core/TaskFilter.h"
+
+#include <QtTest/QtTest>
+
+namespace {
+void setUpTasks(CharmDataModel &model)
+{
+    TaskList tasks;
+    tasks << Task(1000, QStringLiteral("Task 1"))
+          << Task(1001, QStringLiteral("Task 1-1"), 1000)
+          << Task(1002, QStringLiteral("Task 1-2"), 1000)
+          << Task(2000, QStringLiteral("Task 2"))
+          << Task(2100, QStringLiteral("Task 2-1"), 2000)
+          << Task(2110, QStringLiteral("Task 2-1-1"), 2100)
+          << Task(2200, QStringLiteral("Task 2-2"), 2000)
+          << Task(2210, QStringLiteral("Task 2-2-1"), 2200)
+          << Task(3000, QStringLiteral("Task 3"));
+    model.setAllTasks(tasks);
+}
+
+QSet<TaskId> taskIds(const QString &ids)
+{
+    QSet<TaskId> result;
+    Q_FOREACH (const QString &id, ids.split(QLatin1Char(' '), QString::SkipEmptyParts))
+        result << id.toInt();
+    return result;
+}
+}
+
+void TaskFilterTests::acceptsTest_data()
+{
+    QTest::addColumn<QString>("included");
+    QTest::addColumn<QString>("excluded");
+    QTest::addColumn<QString>("accepted");
+
+    QTest::newRow("all") << QString() << QString()
+                         << QStringLiteral("1000 1001 1002 2000 2100 2110 2200 2210 3000");
+    QTest::newRow("one subtree") << QStringLiteral("2000") << QString()
+                                 << QStringLiteral("2000 2100 2110 2200 2210");
+    QTest::newRow("two subtrees") << QStringLiteral("1001 2200") << QString()
+                                  << QStringLiteral("1001 2200 2210");
+    QTest::newRow("nested roots") << QStringLiteral("2000 2100") << QString()
+                                  << QStringLiteral("2000 2100 2110 2200 2210");
+    QTest::newRow("excluded subtree") << QString() << QStringLiteral("2100")
+                                      << QStringLiteral("1000 1001 1002 2000 2200 2210 3000");
+    QTest::newRow("excluded in included") << QStringLiteral("2000") << QStringLiteral("2200 1000")
+                                          << QStringLiteral("2000 2100 2110");
+    QTest::newRow("excluded wins") << QStringLiteral("2100") << QStringLiteral("2000")
+                                   << QString();
+}
+
+void TaskFilterTests::acceptsTest()
+{
+    QFETCH(QString, included);
+    QFETCH(QString, excluded);
+    QFETCH(QString, accepted);
+
+    CharmDataModel model;
+    setUpTasks(model);
+    const TaskFilter filter(&model, taskIds(included), taskIds(excluded));
+    const QSet<TaskId> expected = taskIds(accepted);
+    Q_FOREACH (const Task &task, model.getAllTasks())
+        QCOMPARE(filter.accepts(task.id()), expected.contains(task.id()));
+    // tasks that are not in the tree can only be in the subtrees of no included roots:
+    QCOMPARE(filter.accepts(42), included.isEmpty());
+    QCOMPARE(filter.accepts(9999), included.isEmpty());
+}
+
+void TaskFilterTests::filteredTest()
+{
+    CharmDataModel model;
+    setUpTasks(model);
+    const TaskIdList eventTasks = TaskIdList() << 2210 << 1001 << 3000 << 2110 << 2200 << 1000;
+    EventList events;
+    for (int i = 0; i < eventTasks.size(); ++i) {
+        Event event;
+        event.setId(i + 1);
+        event.setTaskId(eventTasks.at(i));
+        events << event;
+    }
+    model.setAllEvents(events);
+    const EventIdList ids = EventIdList() << 1 << 2 << 3 << 4 << 5 << 6;
+
+    QCOMPARE(TaskFilter().filtered(&model, ids), ids);
+    // the order of the events is kept:
+    const TaskFilter filter(&model, taskIds(QStringLiteral("2000 1001")),
+                            taskIds(QStringLiteral("2100")));
+    QCOMPARE(filter.filtered(&model, ids), EventIdList() << 1 << 2 << 5);
+}
+
+QTEST_MAIN(TaskFilterTests)
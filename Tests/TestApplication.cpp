@@ -39,9 +39,16 @@ const int UserId = 1;
 const int InstallationId = 1;
 
 TestApplication::TestApplication(const QString &databasePath, QObject *parent)
+    : TestApplication(databasePath, CHARM_SQLITE_BACKEND_DESCRIPTOR, parent)
+{
+}
+
+TestApplication::TestApplication(const QString &databasePath, const QString &storageBackend,
+                                 QObject *parent)
     : QObject(parent)
     , m_configuration(&Configuration::instance())
     , m_localPath(databasePath)
+    , m_storageBackend(storageBackend)
 {
 }
 
@@ -85,12 +92,12 @@ void TestApplication::initialize()
     // ... make the controller:
     m_configuration->installationId = InstallationId;
     m_configuration->user.setId(UserId);
-    m_configuration->localStorageType = CHARM_SQLITE_BACKEND_DESCRIPTOR;
+    m_configuration->localStorageType = m_storageBackend;
     m_configuration->localStorageDatabase = m_localPath;
     m_configuration->newDatabase = true;
     m_controller = new Controller;
     // ... initialize the backend:
-    QVERIFY(m_controller->initializeBackEnd(CHARM_SQLITE_BACKEND_DESCRIPTOR));
+    QVERIFY(m_controller->initializeBackEnd(m_storageBackend));
     QVERIFY(m_controller->connectToBackend());
     // ... make the data model:
     m_model = new CharmDataModel;
@@ -36,6 +36,9 @@ class TestApplication : public QObject
     Q_OBJECT
 public:
     explicit TestApplication(const QString &databasePath, QObject *parent = nullptr);
+    // use the storage backend with the given descriptor, e.g. the in-memory one:
+    TestApplication(const QString &databasePath, const QString &storageBackend,
+                    QObject *parent = nullptr);
 
     void initialize();
     void destroy();
@@ -53,6 +56,7 @@ private:
     CharmDataModel *m_model = nullptr;
     Configuration *m_configuration;
     QString m_localPath;
+    QString m_storageBackend;
 };
 
 #endif // TESTAPPLICATION_H
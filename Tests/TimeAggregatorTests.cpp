@@ -0,0 +1,123 @@
+/*
+  TimeAggregatorTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TimeAggregatorTests.h"
+
+#include "Charm/Reports/TimeAggregator.h"
+
+#include "Core/CharmDataModel.h"
+
+#include <QtTest/QtTest>
+
+namespace {
+Event makeEvent(EventId id, TaskId taskId, const QDateTime &start, int minutes)
+{
+    Event event;
+    event.setId(id);
+    event.setTaskId(taskId);
+    event.setStartDateTime(start);
+    event.setEndDateTime(start.addSecs(minutes * 60));
+    return event;
+}
+}
+
+void TimeAggregatorTests::testBucketFunctions()
+{
+    // Friday, March 1st 2019:
+    const QDate first(2019, 3, 1);
+    const Event friday = makeEvent(1, 1, QDateTime(first, QTime(9, 0)), 60);
+    const Event monday = makeEvent(2, 1, QDateTime(first.addDays(3), QTime(9, 0)), 60);
+
+    QCOMPARE(TimeAggregator::dayOfWeek()(friday), 4);
+    QCOMPARE(TimeAggregator::dayOfWeek()(monday), 0);
+    QCOMPARE(TimeAggregator::weekOfMonth(first)(friday), 0);
+    QCOMPARE(TimeAggregator::weekOfMonth(first)(monday), 1);
+    QCOMPARE(TimeAggregator::monthOfYear()(friday), 2);
+    QCOMPARE(TimeAggregator::monthsSince(QDate(2018, 1, 1))(friday), 14);
+    QCOMPARE(TimeAggregator::monthsSince(QDate(2019, 4, 1))(friday), -1);
+}
+
+void TimeAggregatorTests::testSecondsAreSummedPerBucket()
+{
+    const QDateTime monday(QDate(2019, 3, 4), QTime(9, 0));
+    TimeAggregator aggregator(7, TimeAggregator::dayOfWeek());
+    aggregator.addEvent(makeEvent(1, 1, monday, 60));
+    aggregator.addEvent(makeEvent(2, 1, monday.addSecs(3600), 30));
+    aggregator.addEvent(makeEvent(3, 1, monday.addDays(2), 15));
+    aggregator.addEvent(makeEvent(4, 2, monday.addDays(6), 45));
+
+    const SecondsMap &secondsMap = aggregator.secondsMap();
+    QCOMPARE(secondsMap.size(), 2);
+    QCOMPARE(secondsMap.value(1), QVector<int>() << 90 * 60 << 0 << 15 * 60 << 0 << 0 << 0 << 0);
+    QCOMPARE(secondsMap.value(2), QVector<int>() << 0 << 0 << 0 << 0 << 0 << 0 << 45 * 60);
+
+    // events outside of the buckets are not counted:
+    TimeAggregator weeks(2, TimeAggregator::weekOfMonth(monday.date()));
+    weeks.addEvent(makeEvent(5, 1, monday.addDays(14), 60));
+    weeks.addEvent(makeEvent(6, 1, monday.addDays(-7), 60));
+    QVERIFY(weeks.secondsMap().isEmpty());
+}
+
+void TimeAggregatorTests::testSubtasksAreRolledUp()
+{
+    CharmDataModel model;
+    model.setAllTasks(TaskList()
+                      << Task(1, QStringLiteral("Task 1"))
+                      << Task(3, QStringLiteral("Task 1-3"), 1)
+                      << Task(2, QStringLiteral("Task 1-2"), 1)
+                      << Task(4, QStringLiteral("Task 1-2-4"), 2)
+                      << Task(5, QStringLiteral("Task 5")));
+
+    const QDate january(2019, 1, 15);
+    TimeAggregator aggregator(12, TimeAggregator::monthOfYear());
+    aggregator.addEvent(makeEvent(1, 4, QDateTime(january, QTime(9, 0)), 60));
+    aggregator.addEvent(makeEvent(2, 3, QDateTime(january.addMonths(1), QTime(9, 0)), 30));
+    aggregator.addEvent(makeEvent(3, 1, QDateTime(january, QTime(11, 0)), 15));
+    aggregator.addEvent(makeEvent(4, 5, QDateTime(january, QTime(13, 0)), 10));
+
+    const TimeSheetInfoList all = aggregator.taskWithSubTasks(&model, 0);
+    QCOMPARE(all.size(), 6);
+    // the root item first, then depth first by task id:
+    QCOMPARE(all[0].taskId, TaskId(0));
+    QCOMPARE(all[0].indentation, -1);
+    QCOMPARE(all[0].total(), (60 + 30 + 15 + 10) * 60);
+    const TaskIdList order = TaskIdList() << 0 << 1 << 2 << 4 << 3 << 5;
+    for (int i = 0; i < all.size(); ++i)
+        QCOMPARE(all[i].taskId, order[i]);
+
+    const TimeSheetInfoList subtree = aggregator.taskWithSubTasks(&model, 1);
+    QCOMPARE(subtree.size(), 4);
+    QCOMPARE(subtree[0].taskId, TaskId(1));
+    QCOMPARE(subtree[0].indentation, 0);
+    QVERIFY(subtree[0].aggregated);
+    QCOMPARE(subtree[0].seconds[0], (60 + 15) * 60);
+    QCOMPARE(subtree[0].seconds[1], 30 * 60);
+    QCOMPARE(subtree[1].taskId, TaskId(2));
+    QCOMPARE(subtree[1].indentation, 1);
+    QCOMPARE(subtree[1].total(), 60 * 60);
+    QCOMPARE(subtree[2].taskId, TaskId(4));
+    QCOMPARE(subtree[2].indentation, 2);
+    QVERIFY(!subtree[2].aggregated);
+    QCOMPARE(subtree[3].taskId, TaskId(3));
+    QCOMPARE(subtree[3].total(), 30 * 60);
+}
+
+QTEST_MAIN(TimeAggregatorTests)
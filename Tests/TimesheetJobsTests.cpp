@@ -0,0 +1,98 @@
+/*
+  TimesheetJobsTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TimesheetJobsTests.h"
+
+#include "Tools/TimesheetBatch/TimesheetJobs.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QtTest/QtTest>
+
+namespace {
+QString fileName(const TimesheetJob &job)
+{
+    return QFileInfo(job.fileName).fileName();
+}
+}
+
+void TimesheetJobsTests::testWeeklyJobs()
+{
+    // Wednesday, January 2nd to Monday, January 14th touches three weeks, the first one
+    // starts in the previous year:
+    const QList<TimesheetJob> jobs = timesheetJobs(WeeklyTimesheet, QDate(2019, 1, 2),
+                                                   QDate(2019, 1, 14), TaskIdList() << 0,
+                                                   QDir(), false);
+    QCOMPARE(jobs.size(), 3);
+    QCOMPARE(jobs.at(0).type, WeeklyTimesheet);
+    QCOMPARE(jobs.at(0).start, QDate(2018, 12, 31));
+    QCOMPARE(jobs.at(0).end, QDate(2019, 1, 7));
+    QCOMPARE(jobs.at(1).start, QDate(2019, 1, 7));
+    QCOMPARE(jobs.at(2).start, QDate(2019, 1, 14));
+    QCOMPARE(jobs.at(2).end, QDate(2019, 1, 21));
+    QCOMPARE(fileName(jobs.at(0)), QStringLiteral("WeeklyTimeSheet-2019-01.charmreport"));
+    QCOMPARE(fileName(jobs.at(2)), QStringLiteral("WeeklyTimeSheet-2019-03.charmreport"));
+
+    // a single day is one week:
+    QCOMPARE(timesheetJobs(WeeklyTimesheet, QDate(2019, 1, 6), QDate(2019, 1, 6),
+                           TaskIdList() << 0, QDir(), false).size(), 1);
+}
+
+void TimesheetJobsTests::testMonthlyJobs()
+{
+    const QList<TimesheetJob> jobs = timesheetJobs(MonthlyTimesheet, QDate(2018, 12, 31),
+                                                   QDate(2019, 2, 1), TaskIdList() << 0,
+                                                   QDir(), false);
+    QCOMPARE(jobs.size(), 3);
+    QCOMPARE(jobs.at(0).type, MonthlyTimesheet);
+    QCOMPARE(jobs.at(0).start, QDate(2018, 12, 1));
+    QCOMPARE(jobs.at(0).end, QDate(2019, 1, 1));
+    QCOMPARE(jobs.at(1).start, QDate(2019, 1, 1));
+    QCOMPARE(jobs.at(1).end, QDate(2019, 2, 1));
+    QCOMPARE(jobs.at(2).start, QDate(2019, 2, 1));
+    QCOMPARE(jobs.at(2).end, QDate(2019, 3, 1));
+    QCOMPARE(fileName(jobs.at(0)), QStringLiteral("MonthlyTimeSheet-2018-12.charmreport"));
+    QCOMPARE(fileName(jobs.at(2)), QStringLiteral("MonthlyTimeSheet-2019-02.charmreport"));
+}
+
+void TimesheetJobsTests::testJobsPerRootTask()
+{
+    const TaskIdList rootTasks = TaskIdList() << 0 << 42;
+    const QList<TimesheetJob> jobs = timesheetJobs(MonthlyTimesheet, QDate(2019, 1, 15),
+                                                   QDate(2019, 2, 15), rootTasks, QDir(), false);
+    QCOMPARE(jobs.size(), 4);
+    for (int i = 0; i < jobs.size(); ++i) {
+        QCOMPARE(jobs.at(i).rootTask, rootTasks.at(i % 2));
+        QCOMPARE(jobs.at(i).start, QDate(2019, 1 + i / 2, 1));
+    }
+    QCOMPARE(fileName(jobs.at(3)), QStringLiteral("MonthlyTimeSheet-2019-02-42.charmreport"));
+}
+
+void TimesheetJobsTests::testFileNames()
+{
+    const QDir directory(QStringLiteral("timesheets"));
+    QCOMPARE(timesheetFileName(directory, WeeklyTimesheet, 2019, 5, 0, false),
+             directory.filePath(QStringLiteral("WeeklyTimeSheet-2019-05.charmreport")));
+    QCOMPARE(timesheetFileName(directory, MonthlyTimesheet, 2019, 11, 7, true),
+             directory.filePath(QStringLiteral("MonthlyTimeSheet-2019-11-7.charmreport.gz")));
+}
+
+QTEST_MAIN(TimesheetJobsTests)
@@ -0,0 +1,185 @@
+/*
+  TimesheetXmlWriterTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TimesheetXmlWriterTests.h"
+
+#include "Charm/Reports/MonthlyTimesheetXmlWriter.h"
+#include "Charm/Reports/YearlyTimesheetXmlWriter.h"
+
+#include "Core/CharmDataModel.h"
+#include "Core/XmlSerialization.h"
+
+#include <QDomDocument>
+#include <QtTest/QtTest>
+
+namespace {
+Event makeEvent(EventId id, TaskId taskId, const QDateTime &start, int minutes,
+                const QString &comment = QString())
+{
+    Event event;
+    event.setId(id);
+    event.setTaskId(taskId);
+    event.setStartDateTime(start);
+    event.setEndDateTime(start.addSecs(minutes * 60));
+    event.setComment(comment);
+    return event;
+}
+
+EventList effortOf(const QByteArray &xml)
+{
+    QDomDocument document;
+    if (!document.setContent(xml))
+        return EventList();
+    EventList events;
+    const QDomElement effort
+        = XmlSerialization::reportElement(document).firstChildElement(QStringLiteral("effort"));
+    for (QDomElement element = effort.firstChildElement(Event::tagName()); !element.isNull();
+         element = element.nextSiblingElement(Event::tagName()))
+        events << Event::fromXml(element);
+    return events;
+}
+
+QByteArray monthlyTimesheet(const CharmDataModel *model, const EventList &events)
+{
+    MonthlyTimesheetXmlWriter timesheet;
+    timesheet.setDataModel(model);
+    timesheet.setYearOfMonth(2019);
+    timesheet.setMonthNumber(3);
+    timesheet.setNumberOfWeeks(5);
+    timesheet.setIncludeTaskList(false);
+    timesheet.setEvents(events);
+    return timesheet.saveToXml();
+}
+}
+
+void TimesheetXmlWriterTests::testEffortIsAggregatedByTaskAndDay()
+{
+    CharmDataModel model;
+    model.setAllTasks(TaskList()
+                      << Task(1, QStringLiteral("Task 1"))
+                      << Task(2, QStringLiteral("Task 2"), 1));
+
+    const QDate monday(2019, 3, 4);
+    const QDateTime morning(monday, QTime(9, 0));
+    const EventList events = EventList()
+                             << makeEvent(1, 2, morning, 60, QStringLiteral("a"))
+                             << makeEvent(2, 1, morning.addDays(1), 15)
+                             << makeEvent(3, 2, morning.addSecs(3600), 30)
+                             << makeEvent(4, 99, morning, 45, QStringLiteral("not a task"))
+                             << makeEvent(5, 2, morning.addSecs(7200), 30, QStringLiteral("b"));
+
+    const EventList effort = effortOf(monthlyTimesheet(&model, events));
+    QCOMPARE(effort.size(), 2);
+
+    // ordered by task and day, starting at midnight UTC:
+    QCOMPARE(effort[0].taskId(), TaskId(1));
+    QCOMPARE(effort[0].id(), EventId(-2));
+    QCOMPARE(effort[0].startDateTime().toUTC(),
+             QDateTime(monday.addDays(1), QTime(0, 0), Qt::UTC));
+    QCOMPARE(effort[0].duration(), 15 * 60);
+
+    QCOMPARE(effort[1].taskId(), TaskId(2));
+    QCOMPARE(effort[1].id(), EventId(-1));
+    QCOMPARE(effort[1].startDateTime().toUTC(), QDateTime(monday, QTime(0, 0), Qt::UTC));
+    QCOMPARE(effort[1].duration(), 120 * 60);
+    QCOMPARE(effort[1].comment(), QStringLiteral("a / b"));
+}
+
+void TimesheetXmlWriterTests::testYearlyEffortIsAggregatedByTaskAndMonth()
+{
+    CharmDataModel model;
+    model.setAllTasks(TaskList()
+                      << Task(1, QStringLiteral("Task 1"))
+                      << Task(2, QStringLiteral("Task 2"), 1));
+
+    const QDateTime morning(QDate(2019, 3, 4), QTime(9, 0));
+    const EventList events = EventList()
+                             << makeEvent(1, 2, morning, 60, QStringLiteral("a"))
+                             << makeEvent(2, 2, morning.addDays(20), 30, QStringLiteral("b"))
+                             << makeEvent(3, 2, morning.addDays(30), 15)
+                             << makeEvent(4, 1, morning.addMonths(12), 45);
+
+    YearlyTimesheetXmlWriter timesheet;
+    timesheet.setDataModel(&model);
+    timesheet.setFirstYear(2019);
+    timesheet.setNumberOfYears(2);
+    timesheet.setIncludeTaskList(false);
+    timesheet.setEvents(events);
+    const QByteArray xml = timesheet.saveToXml();
+
+    QDomDocument document;
+    QVERIFY(document.setContent(xml));
+    const QDomElement metadata = XmlSerialization::metadataElement(document);
+    QCOMPARE(metadata.firstChildElement(QStringLiteral("year")).text(), QStringLiteral("2019"));
+    QCOMPARE(metadata.firstChildElement(QStringLiteral("number-of-years")).text(),
+             QStringLiteral("2"));
+
+    // ordered by task and month, starting on the first of the month:
+    const EventList effort = effortOf(xml);
+    QCOMPARE(effort.size(), 3);
+    QCOMPARE(effort[0].taskId(), TaskId(1));
+    QCOMPARE(effort[0].startDateTime().toUTC(),
+             QDateTime(QDate(2020, 3, 1), QTime(0, 0), Qt::UTC));
+    QCOMPARE(effort[0].duration(), 45 * 60);
+    QCOMPARE(effort[1].taskId(), TaskId(2));
+    QCOMPARE(effort[1].startDateTime().toUTC(),
+             QDateTime(QDate(2019, 3, 1), QTime(0, 0), Qt::UTC));
+    QCOMPARE(effort[1].duration(), 90 * 60);
+    QCOMPARE(effort[1].comment(), QStringLiteral("a / b"));
+    QCOMPARE(effort[2].startDateTime().toUTC(),
+             QDateTime(QDate(2019, 4, 1), QTime(0, 0), Qt::UTC));
+    QCOMPARE(effort[2].duration(), 15 * 60);
+}
+
+void TimesheetXmlWriterTests::saveToXmlBenchmark()
+{
+    // a tree of 10000 tasks, 100 top level tasks with 99 subtasks each:
+    TaskList tasks;
+    for (int parent = 1; parent <= 100; ++parent) {
+        const TaskId parentId = parent * 100;
+        tasks << Task(parentId, QStringLiteral("Task %1").arg(parentId));
+        for (int child = 1; child < 100; ++child)
+            tasks << Task(parentId + child, QStringLiteral("Task %1").arg(parentId + child),
+                          parentId);
+    }
+    CharmDataModel model;
+    model.setAllTasks(tasks);
+
+    // a month of 100 events a day, spread over the tree:
+    EventList events;
+    EventId id = 1;
+    for (QDate day(2019, 3, 1); day.month() == 3; day = day.addDays(1)) {
+        const QDateTime morning(day, QTime(8, 0));
+        for (int i = 0; i < 100; ++i, ++id) {
+            const TaskId taskId = tasks[(id * 7919) % tasks.size()].id();
+            events << makeEvent(id, taskId, morning.addSecs(i * 5 * 60), 5,
+                                QStringLiteral("Comment %1").arg(i));
+        }
+    }
+
+    QByteArray xml;
+    QBENCHMARK {
+        xml = monthlyTimesheet(&model, events);
+    }
+    QVERIFY(!effortOf(xml).isEmpty());
+}
+
+QTEST_MAIN(TimesheetXmlWriterTests)
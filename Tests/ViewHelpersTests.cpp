@@ -0,0 +1,78 @@
+/*
+  ViewHelpersTests.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ViewHelpersTests.h"
+
+#include "Charm/ViewHelpers.h"
+#include "Core/CharmDataModel.h"
+
+#include <QtTest/QtTest>
+
+namespace {
+Event makeEvent(EventId id, TaskId taskId, const QDateTime &start, const QString &comment)
+{
+    Event event;
+    event.setId(id);
+    event.setTaskId(taskId);
+    event.setStartDateTime(start);
+    event.setEndDateTime(start.addSecs(3600));
+    event.setComment(comment);
+    return event;
+}
+}
+
+void ViewHelpersTests::sortEqualKeysTest()
+{
+    // events that are equal in all sort orders keep their order:
+    const QDateTime start(QDate(2019, 5, 6), QTime(9, 0));
+    CharmDataModel model;
+    EventIdList ids;
+    for (EventId id : { 4, 2, 3, 1 }) {
+        model.addEvent(makeEvent(id, 1, start, QStringLiteral("same")));
+        ids << id;
+    }
+    Charm::SortOrderList orders;
+    orders << Charm::SortOrder::StartTime << Charm::SortOrder::TaskId
+           << Charm::SortOrder::Comment;
+    QCOMPARE(Charm::eventIdsSortedBy(&model, ids, orders), ids);
+    QCOMPARE(Charm::eventIdsSortedBy(&model, ids, Charm::SortOrder::EndTime), ids);
+}
+
+void ViewHelpersTests::sortMixedKeysTest()
+{
+    // the later orders only decide between events that are equal in the earlier ones:
+    const QDateTime start(QDate(2019, 5, 6), QTime(9, 0));
+    CharmDataModel model;
+    model.addEvent(makeEvent(1, 2, start, QStringLiteral("b")));
+    model.addEvent(makeEvent(2, 1, start, QStringLiteral("b")));
+    model.addEvent(makeEvent(3, 1, start.addDays(-1), QStringLiteral("a")));
+    model.addEvent(makeEvent(4, 1, start, QStringLiteral("a")));
+    model.addEvent(makeEvent(5, 1, start, QStringLiteral("b")));
+    Charm::SortOrderList orders;
+    orders << Charm::SortOrder::StartTime << Charm::SortOrder::TaskId
+           << Charm::SortOrder::Comment;
+    const EventIdList ids = EventIdList() << 1 << 2 << 3 << 4 << 5;
+    QCOMPARE(Charm::eventIdsSortedBy(&model, ids, orders),
+             EventIdList() << 3 << 4 << 2 << 5 << 1);
+}
+
+QTEST_MAIN(ViewHelpersTests)
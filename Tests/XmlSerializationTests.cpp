@@ -28,9 +28,12 @@
 #include "Core/CharmConstants.h"
 #include "Core/CharmExceptions.h"
 #include "Core/Event.h"
+#include "Core/GzipDevice.h"
 #include "Core/XmlSerialization.h"
 
 #include <QDateTime>
+#include <QFile>
+#include <QTemporaryDir>
 #include <QtDebug>
 #include <QtTest/QtTest>
 
@@ -185,4 +188,34 @@ void XmlSerializationTests::testTaskExportImport()
     QVERIFY(importer.exportTime().isValid());
 }
 
+void XmlSerializationTests::testCompressedTaskExportImport()
+{
+    if (!GzipDevice::isCompressionSupported())
+        QSKIP("This build does not support compression");
+    TaskExport original;
+    original.readFrom(QStringLiteral(":/testTaskExportImport/Data/test-tasklistexport.xml"));
+
+    QTemporaryDir directory;
+    QVERIFY(directory.isValid());
+    const QString plainFile = directory.filePath(QStringLiteral("tasks.xml"));
+    const QString compressedFile = directory.filePath(QStringLiteral("tasks.xml.gz"));
+    TaskExport::writeTo(plainFile, original.tasks());
+    TaskExport::writeTo(compressedFile, original.tasks());
+
+    QFile file(compressedFile);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(GzipDevice::isCompressed(&file));
+    QVERIFY(file.size() < QFileInfo(plainFile).size());
+    file.close();
+
+    // both are read, whatever the file is called:
+    QVERIFY(QFile::rename(compressedFile, directory.filePath(QStringLiteral("compressed.xml"))));
+    TaskExport compressed;
+    compressed.readFrom(directory.filePath(QStringLiteral("compressed.xml")));
+    TaskExport plain;
+    plain.readFrom(plainFile);
+    QCOMPARE(plain.tasks().size(), original.tasks().size());
+    QCOMPARE(compressed.tasks(), plain.tasks());
+}
+
 QTEST_MAIN(XmlSerializationTests)
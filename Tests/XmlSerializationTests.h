@@ -41,6 +41,7 @@ private Q_SLOTS:
     void testTaskListSerialization();
     void testQDateTimeToFromString();
     void testTaskExportImport();
+    void testCompressedTaskExportImport();
 
 private:
     TaskList tasksToTest() const;
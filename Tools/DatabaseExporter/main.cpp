@@ -0,0 +1,277 @@
+/*
+  main.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/* This program exports the tasks and events of a Charm SQLite database,
+ * in the XML or the binary export format, and imports them back. The events can also be
+ * exported as comma or tab separated values, for spreadsheets.
+ */
+#include <iostream>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSqlQuery>
+#include <QStringList>
+
+#include "Core/CharmConstants.h"
+#include "Core/CharmDataModel.h"
+#include "Core/CharmExceptions.h"
+#include "Core/Configuration.h"
+#include "Core/Controller.h"
+#include "Core/CsvWriter.h"
+#include "Core/GzipDevice.h"
+#include "Core/SqlStorage.h"
+
+namespace {
+const QString BinaryExportSuffix(QStringLiteral("charmbinaryexport"));
+
+void usage()
+{
+    using namespace std;
+    cerr << "Usage:" << endl
+         << "  DatabaseExporter export <charm database> <export file>" << endl
+         << "      Export all tasks and events of the database. Files named *."
+         << qPrintable(BinaryExportSuffix) << " are written" << endl
+         << "      in the binary format, all others as XML. A trailing .gz compresses the" << endl
+         << "      export." << endl
+         << "  DatabaseExporter import <export file> <charm database>" << endl
+         << "      Replace the tasks and events in the database with the ones in the export," << endl
+         << "      which can be a XML or a binary export, compressed or not." << endl
+         << "  DatabaseExporter export-delta <charm database> <delta file>" << endl
+         << "      Export the tasks and events changed since the last delta export as XML," << endl
+         << "      and remember the exported changes in the database." << endl
+         << "  DatabaseExporter import-delta <delta file> <charm database>" << endl
+         << "      Apply a delta export to a copy of the database it was exported from." << endl
+         << "  DatabaseExporter export-csv <charm database> <csv file> [<from> <to>]" << endl
+         << "      Export the events, or those that start on the days from ... to (e.g." << endl
+         << "      2019-01-01 2019-12-31), as comma separated values. Files named *.tsv are" << endl
+         << "      tab separated. A trailing .gz compresses the export." << endl;
+}
+
+void connectController(Controller &controller, const QString &databaseFile)
+{
+    Configuration &configuration = Configuration::instance();
+    configuration.localStorageType = CHARM_SQLITE_BACKEND_DESCRIPTOR;
+    configuration.localStorageDatabase = databaseFile;
+    // do not verify the user, it is looked up below:
+    configuration.newDatabase = true;
+    if (!controller.initializeBackEnd(CHARM_SQLITE_BACKEND_DESCRIPTOR)
+        || !controller.connectToBackend())
+        throw CharmException(configuration.failureMessage);
+
+    // imported subscriptions belong to the first user of the database:
+    QSqlQuery query(controller.storage()->database());
+    query.prepare(QStringLiteral("SELECT user_id FROM Users ORDER BY id LIMIT 1;"));
+    if (SqlStorage::runQuery(query) && query.next())
+        configuration.user = controller.storage()->getUser(query.value(0).toInt());
+}
+
+void exportDatabase(const QString &databaseFile, const QString &exportFile)
+{
+    if (!QFileInfo::exists(databaseFile))
+        throw CharmException(QObject::tr("The database %1 does not exist.").arg(databaseFile));
+    Controller controller;
+    connectController(controller, databaseFile);
+
+    // a trailing .gz compresses the export, the suffix before it selects the format:
+    const GzipDevice::Compression compression = GzipDevice::compressionForFileName(exportFile);
+    QString formatFile = exportFile;
+    if (compression == GzipDevice::GzipCompression)
+        formatFile.chop(3);
+    QSaveFile file(exportFile);
+    if (!file.open(QIODevice::WriteOnly))
+        throw CharmException(file.errorString());
+    GzipDevice device(&file, compression);
+    if (!device.open(QIODevice::WriteOnly))
+        throw CharmException(device.errorString());
+    const QString error = QFileInfo(formatFile).suffix() == BinaryExportSuffix
+                          ? controller.exportDatabaseToBinary(&device)
+                          : controller.exportDatabaseToXml(&device);
+    if (!error.isEmpty())
+        throw CharmException(error);
+    if (!device.commit())
+        throw CharmException(device.errorString());
+    if (!file.commit())
+        throw CharmException(file.errorString());
+    controller.disconnectFromBackend();
+}
+
+void importDatabase(const QString &exportFile, const QString &databaseFile)
+{
+    QFile file(exportFile);
+    if (!file.open(QIODevice::ReadOnly))
+        throw CharmException(QObject::tr("Cannot open %1: %2").arg(exportFile, file.errorString()));
+    GzipDevice device(&file);
+    if (!device.open(QIODevice::ReadOnly))
+        throw CharmException(QObject::tr("Cannot open %1: %2").arg(exportFile, device.errorString()));
+    Controller controller;
+    connectController(controller, databaseFile);
+
+    const QString error = Controller::isBinaryDatabaseExport(&device)
+                          ? controller.importDatabaseFromBinary(&device)
+                          : controller.importDatabaseFromXml(&device);
+    if (!error.isEmpty())
+        throw CharmException(error);
+    controller.disconnectFromBackend();
+}
+
+void exportDelta(const QString &databaseFile, const QString &deltaFile)
+{
+    if (!QFileInfo::exists(databaseFile))
+        throw CharmException(QObject::tr("The database %1 does not exist.").arg(databaseFile));
+    Controller controller;
+    connectController(controller, databaseFile);
+
+    QSaveFile file(deltaFile);
+    if (!file.open(QIODevice::WriteOnly))
+        throw CharmException(file.errorString());
+    GzipDevice device(&file, GzipDevice::compressionForFileName(deltaFile));
+    if (!device.open(QIODevice::WriteOnly))
+        throw CharmException(device.errorString());
+    qint64 lastChange = 0;
+    const QString error = controller.exportDeltaToXml(&device, controller.deltaWatermark(),
+                                                      &lastChange);
+    if (!error.isEmpty())
+        throw CharmException(error);
+    if (!device.commit())
+        throw CharmException(device.errorString());
+    if (!file.commit())
+        throw CharmException(file.errorString());
+    // the next delta starts where this one ends, once it has been saved:
+    if (!controller.setDeltaWatermark(lastChange))
+        throw CharmException(QObject::tr("Cannot store the delta watermark in %1.").arg(databaseFile));
+    controller.disconnectFromBackend();
+}
+
+void importDelta(const QString &deltaFile, const QString &databaseFile)
+{
+    QFile file(deltaFile);
+    if (!file.open(QIODevice::ReadOnly))
+        throw CharmException(QObject::tr("Cannot open %1: %2").arg(deltaFile, file.errorString()));
+    GzipDevice device(&file);
+    if (!device.open(QIODevice::ReadOnly))
+        throw CharmException(QObject::tr("Cannot open %1: %2").arg(deltaFile, device.errorString()));
+    Controller controller;
+    connectController(controller, databaseFile);
+
+    const QString error = controller.importDeltaFromXml(&device);
+    if (!error.isEmpty())
+        throw CharmException(error);
+    controller.disconnectFromBackend();
+}
+
+void exportCsv(const QString &databaseFile, const QString &csvFile, const QDate &from,
+               const QDate &to)
+{
+    if (!QFileInfo::exists(databaseFile))
+        throw CharmException(QObject::tr("The database %1 does not exist.").arg(databaseFile));
+    Controller controller;
+    connectController(controller, databaseFile);
+
+    // the task names are looked up once, the events are streamed from the database:
+    CharmDataModel model;
+    model.setAllTasks(controller.storage()->getAllTasks());
+    QHash<TaskId, QString> taskNames;
+    Q_FOREACH (const Task &task, model.getAllTasks())
+        taskNames.insert(task.id(), model.fullTaskName(task));
+
+    QSaveFile file(csvFile);
+    if (!file.open(QIODevice::WriteOnly))
+        throw CharmException(file.errorString());
+    GzipDevice device(&file, GzipDevice::compressionForFileName(csvFile));
+    if (!device.open(QIODevice::WriteOnly))
+        throw CharmException(device.errorString());
+    CsvWriter writer(&device, CsvWriter::formatForFileName(csvFile));
+    writer.writeRow(CsvWriter::eventColumns());
+    const auto writeEvent = [&writer, &taskNames](const Event &event) {
+        writer.writeEvent(event, taskNames.value(event.taskId()));
+    };
+    bool eventsRead = false;
+    if (from.isValid()) {
+        eventsRead = controller.storage()->visitEventsInRange(QDateTime(from),
+                                                              QDateTime(to.addDays(1)),
+                                                              writeEvent);
+    } else {
+        eventsRead = controller.storage()->visitAllEvents(writeEvent, SqlStorage::AllEvents);
+    }
+    if (!eventsRead)
+        throw CharmException(QObject::tr("Cannot read the events of %1.").arg(databaseFile));
+    if (!writer.flush())
+        throw CharmException(writer.errorString());
+    if (!device.commit())
+        throw CharmException(device.errorString());
+    if (!file.commit())
+        throw CharmException(file.errorString());
+    controller.disconnectFromBackend();
+}
+
+QDate dateArgument(const QString &argument)
+{
+    const QDate date = QDate::fromString(argument, Qt::ISODate);
+    if (!date.isValid())
+        throw CharmException(QObject::tr("Cannot parse date \"%1\"").arg(argument));
+    return date;
+}
+}
+
+int main(int argc, char **argv)
+{
+    using namespace std;
+    QCoreApplication app(argc, argv);
+
+    const QStringList arguments = app.arguments();
+    // only the CSV export takes a range of dates:
+    const bool withRange = arguments.size() == 6
+                           && arguments.at(1) == QLatin1String("export-csv");
+    if (arguments.size() != 4 && !withRange) {
+        usage();
+        return 1;
+    }
+
+    try {
+        if (arguments.at(1) == QLatin1String("export")) {
+            exportDatabase(arguments.at(2), arguments.at(3));
+        } else if (arguments.at(1) == QLatin1String("import")) {
+            importDatabase(arguments.at(2), arguments.at(3));
+        } else if (arguments.at(1) == QLatin1String("export-delta")) {
+            exportDelta(arguments.at(2), arguments.at(3));
+        } else if (arguments.at(1) == QLatin1String("import-delta")) {
+            importDelta(arguments.at(2), arguments.at(3));
+        } else if (arguments.at(1) == QLatin1String("export-csv")) {
+            const QDate from = withRange ? dateArgument(arguments.at(4)) : QDate();
+            const QDate to = withRange ? dateArgument(arguments.at(5)) : QDate();
+            if (to < from)
+                throw CharmException(
+                          QObject::tr("The last day to export is before the first one."));
+            exportCsv(arguments.at(2), arguments.at(3), from, to);
+        } else {
+            usage();
+            return 1;
+        }
+    } catch (const CharmException &e) {
+        cerr << qPrintable(e.what()) << endl;
+        return 1;
+    }
+
+    return 0;
+}
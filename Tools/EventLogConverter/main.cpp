@@ -0,0 +1,119 @@
+/*
+  main.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* This program converts the events of a Charm SQLite database into an
+ * event log, and back.
+ */
+#include <iostream>
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QStringList>
+
+#include "Core/CharmConstants.h"
+#include "Core/CharmExceptions.h"
+#include "Core/Configuration.h"
+#include "Core/EventLog.h"
+#include "Core/SqLiteStorage.h"
+
+namespace {
+void usage()
+{
+    using namespace std;
+    cerr << "Usage:" << endl
+         << "  EventLogConverter export <charm database> <event log>" << endl
+         << "      Write all events of the database into the event log." << endl
+         << "  EventLogConverter import <event log> <charm database>" << endl
+         << "      Replace the events in the database with the ones in the event log." << endl;
+}
+
+void connectStorage(SqLiteStorage &storage, const QString &databaseFile)
+{
+    Configuration &configuration = Configuration::instance();
+    configuration.localStorageType = CHARM_SQLITE_BACKEND_DESCRIPTOR;
+    configuration.localStorageDatabase = databaseFile;
+    // do not verify the user, the tool works on all events of the database:
+    configuration.newDatabase = true;
+    if (!storage.connect(configuration))
+        throw CharmException(configuration.failureMessage);
+}
+
+void exportEvents(const QString &databaseFile, const QString &logFile)
+{
+    if (!QFileInfo::exists(databaseFile))
+        throw CharmException(QObject::tr("The database %1 does not exist.").arg(databaseFile));
+    SqLiteStorage storage;
+    connectStorage(storage, databaseFile);
+    const EventList events = storage.getAllEvents(SqlStorage::AllEvents);
+    storage.disconnect();
+
+    EventLog log(logFile);
+    if (!log.open() || !log.setAllEvents(events))
+        throw CharmException(log.errorString());
+    std::cout << "Exported " << events.size() << " events." << std::endl;
+}
+
+void importEvents(const QString &logFile, const QString &databaseFile)
+{
+    if (!QFileInfo::exists(logFile))
+        throw CharmException(QObject::tr("The event log %1 does not exist.").arg(logFile));
+    EventLog log(logFile);
+    if (!log.open())
+        throw CharmException(log.errorString());
+    const EventList events = log.getAllEvents();
+
+    SqLiteStorage storage;
+    connectStorage(storage, databaseFile);
+    // the event ids are kept, and the events are recorded as changed for delta exports:
+    if (!storage.setAllEvents(events))
+        throw CharmException(QObject::tr("Error replacing the events of the database."));
+    storage.disconnect();
+    std::cout << "Imported " << events.size() << " events." << std::endl;
+}
+}
+
+int main(int argc, char **argv)
+{
+    using namespace std;
+    QCoreApplication app(argc, argv);
+
+    const QStringList arguments = app.arguments();
+    if (arguments.size() != 4) {
+        usage();
+        return 1;
+    }
+
+    try {
+        if (arguments.at(1) == QLatin1String("export")) {
+            exportEvents(arguments.at(2), arguments.at(3));
+        } else if (arguments.at(1) == QLatin1String("import")) {
+            importEvents(arguments.at(2), arguments.at(3));
+        } else {
+            usage();
+            return 1;
+        }
+    } catch (const CharmException &e) {
+        cerr << qPrintable(e.what()) << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+  TimesheetJobs.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TimesheetJobs.h"
+
+#include <QDir>
+
+#include "Core/Dates.h"
+
+QString timesheetFileName(const QDir &outputDirectory, TimesheetType type, int year, int number,
+                          TaskId rootTask, bool compress)
+{
+    QString name = QStringLiteral("%1-%2-%3")
+                   .arg(type == WeeklyTimesheet ? QStringLiteral("WeeklyTimeSheet")
+                        : QStringLiteral("MonthlyTimeSheet"))
+                   .arg(year)
+                   .arg(number, 2, 10, QLatin1Char('0'));
+    if (rootTask != 0)
+        name += QStringLiteral("-%1").arg(rootTask);
+    name += QLatin1String(".charmreport");
+    if (compress)
+        name += QLatin1String(".gz");
+    return outputDirectory.filePath(name);
+}
+
+QList<TimesheetJob> timesheetJobs(TimesheetType type, const QDate &from, const QDate &to,
+                                  const TaskIdList &rootTasks, const QDir &outputDirectory,
+                                  bool compress)
+{
+    QList<TimesheetJob> jobs;
+    // the weeks or months that contain the days from ... to:
+    QDate start = type == WeeklyTimesheet ? Charm::weekDayInWeekOf(Qt::Monday, from)
+                  : QDate(from.year(), from.month(), 1);
+    while (start <= to) {
+        const QDate end = type == WeeklyTimesheet ? start.addDays(7) : start.addMonths(1);
+        int year = start.year();
+        const int number = type == WeeklyTimesheet ? start.weekNumber(&year) : start.month();
+        Q_FOREACH (TaskId rootTask, rootTasks) {
+            TimesheetJob job;
+            job.type = type;
+            job.start = start;
+            job.end = end;
+            job.rootTask = rootTask;
+            job.fileName = timesheetFileName(outputDirectory, type, year, number, rootTask,
+                                             compress);
+            jobs << job;
+        }
+        start = end;
+    }
+    return jobs;
+}
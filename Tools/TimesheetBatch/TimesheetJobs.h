@@ -0,0 +1,57 @@
+/*
+  TimesheetJobs.h
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TIMESHEETJOBS_H
+#define TIMESHEETJOBS_H
+
+#include <QDate>
+#include <QList>
+#include <QString>
+
+#include "Core/Task.h"
+
+class QDir;
+
+enum TimesheetType {
+    WeeklyTimesheet,
+    MonthlyTimesheet
+};
+
+/** One timesheet to generate. */
+struct TimesheetJob {
+    TimesheetType type = WeeklyTimesheet;
+    QDate start;
+    QDate end; // excluded
+    TaskId rootTask = {};
+    QString fileName;
+};
+
+/** The name of a timesheet file in @p outputDirectory, as suggested by the timesheet
+    reports, with the root task if there is one. */
+QString timesheetFileName(const QDir &outputDirectory, TimesheetType type, int year, int number,
+                          TaskId rootTask, bool compress);
+
+/** One job per root task for every week or month that contains days from @p from to @p to. */
+QList<TimesheetJob> timesheetJobs(TimesheetType type, const QDate &from, const QDate &to,
+                                  const TaskIdList &rootTasks, const QDir &outputDirectory,
+                                  bool compress);
+
+#endif
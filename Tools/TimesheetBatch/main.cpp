@@ -0,0 +1,298 @@
+/*
+  main.cpp
+
+  This file is part of Charm, a task-based time tracking application.
+
+  Copyright (C) 2019 Klarälvdalens Datakonsult AB, a KDAB Group company, info@kdab.com
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+/* This program generates weekly and monthly timesheets from a Charm SQLite database without
+ * the GUI. It writes the same .charmreport files as the timesheet reports, for all weeks or
+ * months in a range of dates and any number of root tasks, with a pool of worker threads.
+ */
+#include <iostream>
+
+#include <QAtomicInt>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSqlQuery>
+#include <QThread>
+#include <QThreadPool>
+
+#include "Charm/Reports/MonthlyTimesheetXmlWriter.h"
+#include "Charm/Reports/WeeklyTimesheetXmlWriter.h"
+
+#include "Core/CharmConstants.h"
+#include "Core/CharmDataModel.h"
+#include "Core/CharmExceptions.h"
+#include "Core/Configuration.h"
+#include "Core/Controller.h"
+#include "Core/Dates.h"
+#include "Core/GzipDevice.h"
+#include "Core/SqlStorage.h"
+
+#include "TimesheetJobs.h"
+
+namespace {
+QMutex outputMutex;
+
+void printError(const QString &message)
+{
+    // the workers report concurrently:
+    QMutexLocker locker(&outputMutex);
+    std::cerr << qPrintable(message) << std::endl;
+}
+
+void loadDatabase(CharmDataModel *model, const QString &databaseFile)
+{
+    if (!QFileInfo::exists(databaseFile))
+        throw CharmException(QObject::tr("The database %1 does not exist.").arg(databaseFile));
+
+    Configuration &configuration = Configuration::instance();
+    configuration.localStorageType = CHARM_SQLITE_BACKEND_DESCRIPTOR;
+    configuration.localStorageDatabase = databaseFile;
+    // do not verify the user, it is looked up below:
+    configuration.newDatabase = true;
+    Controller controller;
+    if (!controller.initializeBackEnd(CHARM_SQLITE_BACKEND_DESCRIPTOR)
+        || !controller.connectToBackend())
+        throw CharmException(configuration.failureMessage);
+
+    // the timesheets are written for the first user of the database:
+    QSqlQuery query(controller.storage()->database());
+    query.prepare(QStringLiteral("SELECT user_id FROM Users ORDER BY id LIMIT 1;"));
+    if (SqlStorage::runQuery(query) && query.next())
+        configuration.user = controller.storage()->getUser(query.value(0).toInt());
+
+    model->setAllTasks(controller.storage()->getAllTasks());
+    model->setAllEvents(controller.storage()->getAllEvents(SqlStorage::AllEvents));
+    controller.disconnectFromBackend();
+}
+
+/** Generates and saves one timesheet. The data model is only read, all jobs share it. */
+class TimesheetRunnable : public QRunnable
+{
+public:
+    TimesheetRunnable(const CharmDataModel *model, const TimesheetJob &job, QAtomicInt *failures)
+        : m_model(model)
+        , m_job(job)
+        , m_failures(failures)
+    {
+    }
+
+    void run() override
+    {
+        try {
+            saveTimesheet(generateTimesheet());
+        } catch (const CharmException &e) {
+            printError(QObject::tr("Cannot write %1: %2").arg(m_job.fileName, e.what()));
+            m_failures->ref();
+        }
+    }
+
+private:
+    QByteArray generateTimesheet() const
+    {
+        EventList events;
+        Q_FOREACH (EventId id, m_model->eventsThatStartInTimeFrame(m_job.start, m_job.end))
+            events.append(m_model->eventForId(id));
+
+        if (m_job.type == WeeklyTimesheet) {
+            WeeklyTimesheetXmlWriter timesheet;
+            int yearOfWeek = 0;
+            const int weekNumber = m_job.start.weekNumber(&yearOfWeek);
+            timesheet.setDataModel(m_model);
+            timesheet.setYear(yearOfWeek);
+            timesheet.setWeekNumber(weekNumber);
+            timesheet.setRootTask(m_job.rootTask);
+            timesheet.setEvents(events);
+            return timesheet.saveToXml();
+        } else {
+            MonthlyTimesheetXmlWriter timesheet;
+            timesheet.setDataModel(m_model);
+            timesheet.setYearOfMonth(m_job.start.year());
+            timesheet.setMonthNumber(m_job.start.month());
+            timesheet.setNumberOfWeeks(Charm::weekDifference(m_job.start,
+                                                             m_job.end.addDays(-1)) + 1);
+            timesheet.setRootTask(m_job.rootTask);
+            timesheet.setEvents(events);
+            return timesheet.saveToXml();
+        }
+    }
+
+    void saveTimesheet(const QByteArray &payload) const
+    {
+        QSaveFile file(m_job.fileName);
+        if (!file.open(QIODevice::WriteOnly))
+            throw CharmException(file.errorString());
+        GzipDevice device(&file, GzipDevice::compressionForFileName(m_job.fileName));
+        if (!device.open(QIODevice::WriteOnly))
+            throw CharmException(device.errorString());
+        if (device.write(payload) != payload.size())
+            throw CharmException(device.errorString());
+        if (!device.commit())
+            throw CharmException(device.errorString());
+        if (!file.commit())
+            throw CharmException(file.errorString());
+    }
+
+    const CharmDataModel *m_model;
+    const TimesheetJob m_job;
+    QAtomicInt *m_failures;
+};
+
+QDate dateOption(const QCommandLineParser &parser, const QCommandLineOption &option)
+{
+    const QString text = parser.value(option);
+    const QDate date = QDate::fromString(text, Qt::ISODate);
+    if (!date.isValid())
+        throw CharmException(QObject::tr("Cannot parse date \"%1\"").arg(text));
+    return date;
+}
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("TimesheetBatch"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        QStringLiteral("Generate weekly and monthly Charm timesheets from a Charm database."));
+    parser.addHelpOption();
+    const QCommandLineOption weeklyOption(QStringLiteral("weekly"),
+                                          QStringLiteral("Generate weekly timesheets."));
+    const QCommandLineOption monthlyOption(QStringLiteral("monthly"),
+                                           QStringLiteral("Generate monthly timesheets."));
+    const QCommandLineOption fromOption(QStringLiteral("from"),
+                                        QStringLiteral("The first day to report on, e.g. 2019-01-01."),
+                                        QStringLiteral("date"));
+    const QCommandLineOption toOption(QStringLiteral("to"),
+                                      QStringLiteral("The last day to report on, by default the first one."),
+                                      QStringLiteral("date"));
+    const QCommandLineOption taskOption(QStringLiteral("task"),
+                                        QStringLiteral("Report on the subtree of <task-id> only, can be given several times."),
+                                        QStringLiteral("task-id"));
+    const QCommandLineOption jobsOption(QStringLiteral("jobs"),
+                                        QStringLiteral("The number of timesheets generated in parallel."),
+                                        QStringLiteral("count"),
+                                        QString::number(QThread::idealThreadCount()));
+    const QCommandLineOption installationIdOption(QStringLiteral("installation-id"),
+                                                  QStringLiteral("The installation id written into the timesheets."),
+                                                  QStringLiteral("id"));
+    const QCommandLineOption compressOption(QStringLiteral("compress"),
+                                            QStringLiteral("Compress the timesheets with gzip."));
+    parser.addOption(weeklyOption);
+    parser.addOption(monthlyOption);
+    parser.addOption(fromOption);
+    parser.addOption(toOption);
+    parser.addOption(taskOption);
+    parser.addOption(jobsOption);
+    parser.addOption(installationIdOption);
+    parser.addOption(compressOption);
+    parser.addPositionalArgument(QStringLiteral("database"),
+                                 QStringLiteral("The Charm database to report on."));
+    parser.addPositionalArgument(QStringLiteral("directory"),
+                                 QStringLiteral("The directory the timesheets are written to."));
+    parser.process(app);
+
+    try {
+        const QStringList positionalArguments = parser.positionalArguments();
+        if (positionalArguments.size() != 2)
+            throw CharmException(QObject::tr("A database and an output directory are required."));
+        if (!parser.isSet(weeklyOption) && !parser.isSet(monthlyOption))
+            throw CharmException(QObject::tr("Select --weekly, --monthly or both."));
+        if (!parser.isSet(fromOption))
+            throw CharmException(QObject::tr("The first day to report on (--from) is required."));
+        const QDate from = dateOption(parser, fromOption);
+        const QDate to = parser.isSet(toOption) ? dateOption(parser, toOption) : from;
+        if (to < from)
+            throw CharmException(QObject::tr("The last day to report on is before the first one."));
+
+        TaskIdList rootTasks;
+        Q_FOREACH (const QString &value, parser.values(taskOption)) {
+            bool ok = false;
+            const TaskId task = value.toInt(&ok);
+            if (!ok || task < 0)
+                throw CharmException(QObject::tr("Invalid task id \"%1\"").arg(value));
+            rootTasks << task;
+        }
+        if (rootTasks.isEmpty())
+            rootTasks << 0;
+
+        bool ok = false;
+        const int threads = parser.value(jobsOption).toInt(&ok);
+        if (!ok || threads < 1)
+            throw CharmException(QObject::tr("Invalid number of jobs \"%1\"").arg(
+                                     parser.value(jobsOption)));
+        if (parser.isSet(installationIdOption)) {
+            CONFIGURATION.installationId = parser.value(installationIdOption).toUInt(&ok);
+            if (!ok)
+                throw CharmException(QObject::tr("Invalid installation id \"%1\"").arg(
+                                         parser.value(installationIdOption)));
+        }
+
+        const QDir outputDirectory(positionalArguments.at(1));
+        if (!outputDirectory.exists() && !QDir().mkpath(outputDirectory.path()))
+            throw CharmException(QObject::tr("Cannot create the directory %1.").arg(
+                                     outputDirectory.path()));
+        const bool compress = parser.isSet(compressOption);
+        if (compress && !GzipDevice::isCompressionSupported())
+            throw CharmException(QObject::tr("Compression is not supported by this build."));
+
+        QList<TimesheetJob> jobs;
+        if (parser.isSet(weeklyOption))
+            jobs << timesheetJobs(WeeklyTimesheet, from, to, rootTasks, outputDirectory, compress);
+        if (parser.isSet(monthlyOption))
+            jobs << timesheetJobs(MonthlyTimesheet, from, to, rootTasks, outputDirectory, compress);
+
+        // all workers read the same model, which is not modified while they run:
+        CharmDataModel model;
+        loadDatabase(&model, positionalArguments.at(0));
+        Q_FOREACH (TaskId rootTask, rootTasks) {
+            if (rootTask != 0 && !model.getTask(rootTask).isValid())
+                throw CharmException(QObject::tr("The task %1 does not exist.").arg(rootTask));
+        }
+
+        QAtomicInt failures;
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        Q_FOREACH (const TimesheetJob &job, jobs)
+            pool.start(new TimesheetRunnable(&model, job, &failures));
+        pool.waitForDone();
+
+        const int failed = failures.load();
+        if (failed > 0) {
+            printError(QObject::tr("%1 of %2 timesheets could not be written.").arg(failed).arg(
+                           jobs.size()));
+            return 1;
+        }
+        std::cout << qPrintable(QObject::tr("%1 timesheets written to %2.")
+                                .arg(jobs.size()).arg(outputDirectory.path())) << std::endl;
+    } catch (const CharmException &e) {
+        printError(e.what());
+        return 1;
+    }
+
+    return 0;
+}
@@ -29,6 +29,7 @@
 
 #include "Core/User.h"
 #include "Core/Event.h"
+#include "Core/GzipDevice.h"
 #include "Core/SqlRaiiTransactor.h"
 #include "Core/XmlSerialization.h"
 
@@ -81,8 +82,14 @@ void addTimesheet(const CommandLine &cmd)
         QString msg = QObject::tr("Cannot open file %1 for reading.").arg(cmd.filename());
         throw TimesheetProcessorException(msg);
     }
+    // compressed time sheets are decompressed on the fly:
+    GzipDevice device(&file);
+    if (!device.open(QIODevice::ReadOnly)) {
+        QString msg = QObject::tr("Cannot read file %1: %2").arg(cmd.filename(), device.errorString());
+        throw TimesheetProcessorException(msg);
+    }
     QDomDocument doc(QStringLiteral("timesheet"));
-    if (!doc.setContent(&file)) {
+    if (!doc.setContent(&device)) {
         QString msg = QObject::tr("Cannot read file %1.").arg(cmd.filename());
         throw TimesheetProcessorException(msg);
     }